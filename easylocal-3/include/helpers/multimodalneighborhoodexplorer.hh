@@ -795,8 +795,11 @@ namespace EasyLocal
         }
         
         // TODO: currently it starts from the selected neighborhood and searches for the first that has some move afterwards
+        // (the neighborhoods with bias 0 are disabled, so they are never drawn, not even as a fallback)
         for (size_t i = selected; i < modality; i++)
         {
+          if (bias[i] == 0.0)
+            continue;
           try
           {
             Impl::VTupleDispatcher<Solution, _Void_ConstSolution_Move, MoveTypeRefs, modality - 1>::execute_at(i, st, random_move_funcs, r_moves);
@@ -811,6 +814,8 @@ namespace EasyLocal
         // TODO: restarting from the first neighborhood if needed
         for (size_t i = 0; i < selected; i++)
         {
+          if (bias[i] == 0.0)
+            continue;
           try
           {
             Impl::VTupleDispatcher<Solution, _Void_ConstSolution_Move, MoveTypeRefs, modality - 1>::execute_at(i, st, random_move_funcs, r_moves);
@@ -33,6 +33,7 @@
 #include "runners/simulatedannealingtimebased.hh"
 #include "runners/simulatedannealingwithreheating.hh"
 #include "runners/simulatedannealingwithlearning.hh"
+#include "runners/paralleltempering.hh"
 #include "runners/greatdeluge.hh"
 #include "runners/tabusearch.hh"
 #include "runners/firstimprovementtabusearch.hh"
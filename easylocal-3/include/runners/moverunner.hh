@@ -44,6 +44,9 @@ protected:
   void UpdateBestState() override final;
   void UpdateStateCost();
 
+  void SaveRunState(std::ostream &os) const override;
+  void LoadRunState(std::istream &is) override;
+
   NeighborhoodExplorer<Input, Solution, Move, CostStructure> &ne; /**< A reference to the
                                                              attached neighborhood
                                                              explorer. */
@@ -68,6 +71,7 @@ void MoveRunner<Input, Solution, Move, CostStructure>::UpdateBestState()
 
     // so that idle iterations are printed correctly
     this->iteration_of_best = this->iteration;
+    this->NotifyNewBest();
     // FIXME: write out cost
 #if VERBOSE >= 1 
     std::cerr << "V1" << " new best: " << this->best_state_cost << std::endl;
@@ -85,6 +89,31 @@ template <class Input, class Solution, class Move, class CostStructure>
 void MoveRunner<Input, Solution, Move, CostStructure>::InitializeRun()
 {}
 
+/**
+     The biases of the neighborhoods are part of the run, since the adaptive runners change them.
+     */
+template <class Input, class Solution, class Move, class CostStructure>
+void MoveRunner<Input, Solution, Move, CostStructure>::SaveRunState(std::ostream &os) const
+{
+  Runner<Input, Solution, CostStructure>::SaveRunState(os);
+  std::vector<double> biases(ne.Modality());
+  for (size_t i = 0; i < biases.size(); i++)
+    biases[i] = ne.GetBias(i);
+  Serialization::Write(os, biases);
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+void MoveRunner<Input, Solution, Move, CostStructure>::LoadRunState(std::istream &is)
+{
+  Runner<Input, Solution, CostStructure>::LoadRunState(is);
+  std::vector<double> biases;
+  Serialization::Read(is, biases);
+  if (biases.size() != ne.Modality())
+    throw std::runtime_error("The checkpoint of runner " + this->name + " has a different number of neighborhoods");
+  for (size_t i = 0; i < biases.size(); i++)
+    ne.SetBias(i, biases[i]);
+}
+
 template <class Input, class Solution, class Move, class CostStructure>
 void MoveRunner<Input, Solution, Move, CostStructure>::TerminateRun()
 {}
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "runners/moverunner.hh"
+#include "helpers/solutionmanager.hh"
+#include "helpers/neighborhoodexplorer.hh"
+
+namespace EasyLocal
+{
+namespace Core
+{
+
+/** The Parallel Tempering (or replica exchange) runner keeps a number of
+ replicas of the state, each one at a fixed temperature of a geometric
+ ladder, and moves them concurrently (one thread per replica) with the
+ Metropolis criterion of Simulated Annealing.
+
+ After each round of steps, the replicas at neighboring temperatures
+ exchange their states with probability
+ min(1, exp((1/T_i - 1/T_j) (E_i - E_j))), so that the good states drift
+ towards the cold end of the ladder while the hot replicas keep
+ diversifying. The exchanges swap the pointers to the states, not the states.
+
+ An iteration of the runner is a round of steps of all the replicas
+ followed by the exchanges. The replicas but the coldest one run on worker
+ threads started once per run, which wait at a barrier for the next round.
+ The neighborhood explorer is shared by the threads, therefore it must be
+ thread-safe and draw its random values with Random (each replica has its
+ own engine, so the run does not depend on the scheduling of the threads).
+
+ When the temperatures are not given, the hottest one is the mean of the
+ worsening of 100 random moves from the initial state, and the coldest one
+ is a thousandth of it.
+
+ @ingroup Runners
+ */
+template <class Input, class Solution, class Move, class CostStructure = DefaultCostStructure<int>>
+class ParallelTempering : public MoveRunner<Input, Solution, Move, CostStructure>
+{
+public:
+  ParallelTempering(const Input &in, SolutionManager<Input, Solution, CostStructure> &e_sm,
+                    NeighborhoodExplorer<Input, Solution, Move, CostStructure> &e_ne,
+                    std::string name);
+  ~ParallelTempering();
+
+  /** Temperature of the i-th step of the ladder (0 is the coldest one). */
+  double Temperature(size_t i) const { return temperatures[i]; }
+
+  /** Ratio of the exchanges accepted between the steps i and i + 1 of the ladder. */
+  double ExchangeRatio(size_t i) const
+  {
+    return exchanges_attempted[i] > 0 ? static_cast<double>(exchanges_accepted[i]) / exchanges_attempted[i] : 0.0;
+  }
+protected:
+  void InitializeRun() override;
+  void TerminateRun() override;
+  void SelectMove() override;
+  void MakeMove() override;
+  bool StopCriterion() override;
+  void RunReplica(size_t i);
+  double SampleWorsening();
+  void StartWorkers();
+  void StopWorkers();
+  void Worker(size_t i);
+  bool MetropolisCriterion(const CostStructure &delta, double temperature) const;
+  bool Better(const CostStructure &c1, const CostStructure &c2) const;
+  virtual void PrintStatus(std::ostream &os) const;
+  void SaveRunState(std::ostream &os) const override;
+  // parameters
+  Parameter<unsigned int> replicas;
+  Parameter<double> min_temperature, max_temperature;
+  Parameter<unsigned int> steps_per_exchange;
+  // state of PT, indexed by the steps of the ladder
+  double run_min_temperature, run_max_temperature;
+  std::vector<double> temperatures;
+  std::vector<std::shared_ptr<Solution>> replica_states;
+  std::vector<CostStructure> replica_costs;
+  std::vector<std::mt19937> generators;
+  std::vector<unsigned long> exchanges_attempted, exchanges_accepted;
+  // results of the current round
+  unsigned int round_steps;
+  std::vector<std::shared_ptr<Solution>> round_best_states;
+  std::vector<CostStructure> round_best_costs;
+  std::vector<unsigned long> round_evaluations;
+  std::vector<std::exception_ptr> round_exceptions;
+  // the workers of the replicas 1, ..., replicas - 1, and the barrier of the rounds
+  std::vector<std::thread> workers;
+  std::mutex round_mutex;
+  std::condition_variable round_started, round_completed;
+  unsigned long round_number;
+  unsigned int replicas_running;
+  bool stop_workers;
+};
+
+/*************************************************************************
+ * Implementation
+ *************************************************************************/
+
+template <class Input, class Solution, class Move, class CostStructure>
+ParallelTempering<Input, Solution, Move, CostStructure>::ParallelTempering(const Input &in, SolutionManager<Input, Solution, CostStructure> &e_sm,
+                                                                         NeighborhoodExplorer<Input, Solution, Move, CostStructure> &e_ne,
+                                                                         std::string name)
+  : MoveRunner<Input, Solution, Move, CostStructure>(in, e_sm, e_ne, name), round_number(0), replicas_running(0), stop_workers(false)
+{
+  replicas("replicas", "Number of replicas (default: the number of hardware threads)", this->parameters);
+  min_temperature("min_temperature", "Temperature of the coldest replica (default: a thousandth of max_temperature)", this->parameters);
+  max_temperature("max_temperature", "Temperature of the hottest replica (default: the mean worsening of 100 random moves)", this->parameters);
+  steps_per_exchange("steps_per_exchange", "Number of steps of each replica between two exchange attempts", this->parameters);
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+ParallelTempering<Input, Solution, Move, CostStructure>::~ParallelTempering()
+{
+  // a run interrupted by an exception does not reach TerminateRun
+  StopWorkers();
+}
+
+/**
+ Builds the ladder of temperatures and the replicas, all of them start from
+ the initial state, and starts the workers.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::InitializeRun()
+{
+  MoveRunner<Input, Solution, Move, CostStructure>::InitializeRun();
+  StopWorkers();
+
+  if (!replicas.IsSet())
+    replicas = std::max(2u, std::thread::hardware_concurrency());
+  if (!steps_per_exchange.IsSet())
+    steps_per_exchange = 1000;
+
+  if (replicas == 0)
+    throw IncorrectParameterValue(replicas, "should be greater than zero");
+  if (steps_per_exchange == 0)
+    throw IncorrectParameterValue(steps_per_exchange, "should be greater than zero");
+  if (min_temperature.IsSet() && min_temperature <= 0.0)
+    throw IncorrectParameterValue(min_temperature, "should be greater than zero");
+  if (min_temperature.IsSet() && max_temperature.IsSet() && max_temperature < min_temperature)
+    throw IncorrectParameterValue(max_temperature, "should be greater than or equal to min_temperature");
+
+  // the temperatures computed are not written in the parameters, so that each run computes its own
+  run_max_temperature = max_temperature.IsSet() ? static_cast<double>(max_temperature) : SampleWorsening();
+  if (min_temperature.IsSet())
+    run_min_temperature = min_temperature;
+  else
+    run_min_temperature = run_max_temperature / 1000.0;
+  run_max_temperature = std::max(run_max_temperature, run_min_temperature);
+
+  temperatures.assign(replicas, run_min_temperature);
+  for (unsigned int i = 1; i < replicas; i++)
+    temperatures[i] = run_min_temperature * pow(run_max_temperature / run_min_temperature, static_cast<double>(i) / (replicas - 1));
+
+  replica_states.assign(1, this->p_current_state);
+  round_best_states.clear();
+  generators.clear();
+  for (unsigned int i = 0; i < replicas; i++)
+  {
+    if (i > 0)
+      replica_states.push_back(std::make_shared<Solution>(*this->p_current_state));
+    round_best_states.push_back(std::make_shared<Solution>(*this->p_current_state));
+    // the engines are seeded from the shared one, so that the run is repeatable
+    generators.emplace_back(Random::Uniform<unsigned int>(0, std::numeric_limits<unsigned int>::max()));
+  }
+  replica_costs.assign(replicas, this->current_state_cost);
+  round_best_costs.assign(replicas, this->best_state_cost);
+  round_evaluations.assign(replicas, 0);
+  round_exceptions.assign(replicas, nullptr);
+  exchanges_attempted.assign(replicas, 0);
+  exchanges_accepted.assign(replicas, 0);
+  StartWorkers();
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::TerminateRun()
+{
+  StopWorkers();
+  MoveRunner<Input, Solution, Move, CostStructure>::TerminateRun();
+}
+
+/**
+ The default of the hottest temperature: the mean worsening of 100 random
+ moves from the initial state, which is accepted with probability 1/e.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+double ParallelTempering<Input, Solution, Move, CostStructure>::SampleWorsening()
+{
+  const unsigned int samples = 100;
+  double worsening = 0.0;
+  unsigned int worsening_moves = 0;
+  for (unsigned int i = 0; i < samples; i++)
+  {
+    Move mv;
+    this->ne.RandomMove(*this->p_current_state, mv);
+    CostStructure delta = this->ne.DeltaCostFunctionComponents(*this->p_current_state, mv, this->weights);
+    if (delta.total > 0)
+    {
+      worsening += delta.total;
+      worsening_moves++;
+    }
+  }
+  return worsening_moves > 0 ? worsening / worsening_moves : 1.0;
+}
+
+/**
+ Starts a worker for each replica but the coldest one, which runs in the
+ thread of the runner.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::StartWorkers()
+{
+  round_number = 0;
+  replicas_running = 0;
+  stop_workers = false;
+  for (unsigned int i = 1; i < replicas; i++)
+    workers.emplace_back(&ParallelTempering::Worker, this, i);
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::StopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(round_mutex);
+    stop_workers = true;
+  }
+  round_started.notify_all();
+  for (std::thread &t : workers)
+    t.join();
+  workers.clear();
+}
+
+/**
+ The worker of the replica at the i-th step of the ladder runs its steps at
+ each round, until it is stopped.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::Worker(size_t i)
+{
+  unsigned long rounds_run = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(round_mutex);
+      round_started.wait(lock, [this, rounds_run]() { return stop_workers || round_number > rounds_run; });
+      if (stop_workers)
+        return;
+      rounds_run = round_number;
+    }
+    RunReplica(i);
+    {
+      std::lock_guard<std::mutex> lock(round_mutex);
+      if (--replicas_running == 0)
+        round_completed.notify_one();
+    }
+  }
+}
+
+/**
+ Runs a round of steps of all the replicas, each one in its own thread
+ (the coldest one in the thread of the runner), and collects their best states.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::SelectMove()
+{
+  // the last round uses only the remaining evaluations
+  unsigned long remaining_evaluations = this->max_evaluations - this->evaluations;
+  round_steps = static_cast<unsigned int>(std::min<unsigned long>(steps_per_exchange, (remaining_evaluations + replicas - 1) / replicas));
+  for (unsigned int i = 0; i < replicas; i++)
+  {
+    round_best_costs[i] = this->best_state_cost;
+    round_evaluations[i] = 0;
+    round_exceptions[i] = nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(round_mutex);
+    replicas_running = replicas - 1;
+    round_number++;
+  }
+  round_started.notify_all();
+  RunReplica(0);
+  {
+    std::unique_lock<std::mutex> lock(round_mutex);
+    round_completed.wait(lock, [this]() { return replicas_running == 0; });
+  }
+
+  for (unsigned int i = 0; i < replicas; i++)
+  {
+    this->evaluations += round_evaluations[i];
+    if (Better(round_best_costs[i], this->best_state_cost))
+    {
+      std::lock_guard<std::mutex> lock(this->best_state_mutex);
+      *this->p_best_state = *round_best_states[i];
+      this->best_state_cost = round_best_costs[i];
+      this->iteration_of_best = this->iteration;
+      this->NotifyNewBest();
+    }
+  }
+  for (unsigned int i = 0; i < replicas; i++)
+    if (round_exceptions[i])
+      std::rethrow_exception(round_exceptions[i]);
+
+  // the exchanges are always attempted
+  this->current_move.is_valid = true;
+}
+
+/**
+ The Metropolis steps of the replica at the i-th step of the ladder.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::RunReplica(size_t i)
+{
+  Random::ThreadGenerator generator(generators[i]);
+  Solution &st = *replica_states[i];
+  try
+  {
+    for (unsigned int s = 0; s < round_steps && !this->TimeoutExpired(); s++)
+    {
+      Move mv;
+      this->ne.RandomMove(st, mv);
+      CostStructure delta = this->ne.DeltaCostFunctionComponents(st, mv, this->weights);
+      round_evaluations[i]++;
+      if (delta <= 0 || MetropolisCriterion(delta, temperatures[i]))
+      {
+        this->ne.MakeMove(st, mv);
+        replica_costs[i] += delta;
+        if (Better(replica_costs[i], round_best_costs[i]))
+        {
+          *round_best_states[i] = st;
+          round_best_costs[i] = replica_costs[i];
+        }
+      }
+    }
+  }
+  catch (...)
+  {
+    round_exceptions[i] = std::current_exception();
+  }
+}
+
+/**
+ Attempts the exchanges between the neighboring replicas, alternating the
+ even and the odd pairs of the ladder at each round.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::MakeMove()
+{
+  for (size_t i = this->iteration % 2; i + 1 < replicas; i += 2)
+  {
+    exchanges_attempted[i]++;
+    double exponent = (1.0 / temperatures[i] - 1.0 / temperatures[i + 1]) * (replica_costs[i].total - replica_costs[i + 1].total);
+    if (exponent >= 0.0 || Random::Uniform<double>(0.0, 1.0) < exp(exponent))
+    {
+      std::swap(replica_states[i], replica_states[i + 1]);
+      std::swap(replica_costs[i], replica_costs[i + 1]);
+      exchanges_accepted[i]++;
+    }
+  }
+  this->p_current_state = replica_states[0];
+  this->current_state_cost = replica_costs[0];
+#if VERBOSE >= 1
+  std::cerr << "V1 ";
+  PrintStatus(std::cerr);
+  std::cerr << std::endl;
+#endif
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+bool ParallelTempering<Input, Solution, Move, CostStructure>::MetropolisCriterion(const CostStructure &delta, double temperature) const
+{
+  return delta < (-temperature * log(std::max(Random::Uniform<double>(0.0, 1.0), std::numeric_limits<double>::epsilon())));
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+bool ParallelTempering<Input, Solution, Move, CostStructure>::Better(const CostStructure &c1, const CostStructure &c2) const
+{
+  return LessThan(c1.violations, c2.violations) || (EqualTo(c1.violations, c2.violations) && LessThan(c1.total, c2.total));
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::PrintStatus(std::ostream &os) const
+{
+  os << "Status: (" << this->iteration << "|" << this->evaluations << ")"
+     << " OF = [";
+  for (unsigned int i = 0; i < replicas; i++)
+    os << (i > 0 ? " " : "") << replica_costs[i].total;
+  os << "/" << this->best_state_cost.total << "], exchanges = [";
+  for (unsigned int i = 0; i + 1 < replicas; i++)
+    os << (i > 0 ? " " : "") << ExchangeRatio(i);
+  os << "]";
+}
+
+/**
+ The replicas (and their engines) are not saved, so the runner cannot be checkpointed.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void ParallelTempering<Input, Solution, Move, CostStructure>::SaveRunState(std::ostream &os) const
+{
+  throw std::logic_error("Runner " + this->name + " does not support checkpoints");
+}
+
+/**
+ The search stops only when the evaluations are over (or at the timeout).
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+bool ParallelTempering<Input, Solution, Move, CostStructure>::StopCriterion()
+{
+  return false;
+}
+
+} // namespace Core
+} // namespace EasyLocal
@@ -1,16 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <stdexcept>
 #include <climits>
 #include <chrono>
 #include <condition_variable>
 #include <atomic>
 #include <typeinfo>
+#include <sstream>
 
 #include "helpers/solutionmanager.hh"
 #include "helpers/neighborhoodexplorer.hh"
 #include "utils/interruptible.hh"
 #include "utils/parameter.hh"
+#include "utils/random.hh"
+#include "utils/serialization.hh"
 #include "helpers/coststructure.hh"
 
 namespace EasyLocal
@@ -27,6 +31,56 @@ class AbstractTester;
 namespace Core
 {
 
+/** An observer of the runners, notified of each new best state. The
+     notification comes from the thread of the runner, while it holds its
+     best state, so the observer must be thread-safe and must return quickly.
+     @ingroup Helpers
+     */
+template <class Input, class Solution, class CostStructure>
+class RunnerObserver
+{
+public:
+  /** Called when the runner has found a new best state (also the initial one).
+       @param runner the name of the runner
+       @param best the new best state
+       @param cost its cost
+       @param iteration the iteration where it has been found
+       */
+  virtual void NotifyNewBest(const std::string &runner, const Solution &best, const CostStructure &cost, unsigned long iteration) = 0;
+  virtual ~RunnerObserver() {}
+};
+
+/** A checkpointer saves the state of a runner at regular intervals, and
+     restores it at the start of the run, so that an interrupted run can be
+     resumed exactly where it was. The runner serializes its own data (counters,
+     state of the strategy and of the random engine), while the checkpointer
+     serializes the current and the best states, and stores everything.
+     @ingroup Helpers
+     */
+template <class Input, class Solution, class CostStructure>
+class RunnerCheckpointer
+{
+public:
+  /** Number of iterations between two checkpoints (0: no checkpoints). */
+  virtual unsigned long Period() const = 0;
+
+  /** Called from the thread of the runner at the end of an iteration: the
+       checkpointer must copy what it needs and return quickly.
+       @param runner the name of the runner
+       @param data the serialized data of the runner
+       @param current the current state
+       @param best the best state
+       */
+  virtual void Save(const std::string &runner, const std::string &data, const Solution &current, const Solution &best) = 0;
+
+  /** Called at the start of the run, after its initialization.
+       @return false if there is no checkpoint to resume, otherwise the arguments are filled with its content
+       */
+  virtual bool Load(const std::string &runner, std::string &data, Solution &current, Solution &best) = 0;
+
+  virtual ~RunnerCheckpointer() {}
+};
+
 /** A class representing a single search strategy, e.g. hill climbing
      or simulated annealing. It must be loaded into a solver by using
      Solver::AddRunner() in order to be called correctly.
@@ -106,17 +160,44 @@ public:
   /** Name of the runner. */
   const std::string name;
 
-  /** Destructor, for inheritance. */
-  virtual ~Runner() {}
+  /** Destructor, the runner leaves the list of the runners. */
+  virtual ~Runner()
+  {
+    runners.erase(std::remove(runners.begin(), runners.end(), this), runners.end());
+  }
 
   /** Modality of this runner. */
   virtual size_t Modality() const = 0;
 
-  /** List of all runners that have been instantiated so far. For autoloading. */
-  static std::vector<Runner<Input, Solution, CostStructure> *> runners;
+  /** List of the runners alive in the calling thread. For autoloading. */
+  static thread_local std::vector<Runner<Input, Solution, CostStructure> *> runners;
 
   virtual std::shared_ptr<Solution> GetCurrentBestState() const;
 
+  /** Attaches an observer, notified of each new best state of the runner. */
+  void AttachObserver(RunnerObserver<Input, Solution, CostStructure> &o)
+  {
+    observers.push_back(&o);
+  }
+
+  /** Detaches an observer, which is no longer notified. */
+  void DetachObserver(RunnerObserver<Input, Solution, CostStructure> &o)
+  {
+    observers.erase(std::remove(observers.begin(), observers.end(), &o), observers.end());
+  }
+
+  /** Attaches a checkpointer, the run resumes from its checkpoint (if any) and saves the new ones. */
+  void AttachCheckpointer(RunnerCheckpointer<Input, Solution, CostStructure> &c)
+  {
+    checkpointer = &c;
+  }
+
+  /** Detaches the checkpointer, the next runs take no checkpoints. */
+  void DetachCheckpointer()
+  {
+    checkpointer = nullptr;
+  }
+
 protected:
   /** Constructor.
        @param i a reference to the input
@@ -211,6 +292,22 @@ protected:
           If the vector is empty (default), it is assumed all weigths to be 1.0. */
   std::vector<double> weights;
 
+  /** Notifies the observers of the best state (to be called when it changes, holding best_state_mutex). */
+  void NotifyNewBest() const;
+
+  /** The observers of the new best states. */
+  std::vector<RunnerObserver<Input, Solution, CostStructure> *> observers;
+
+  /** Writes the data needed to continue the run (the states apart). Redefinition intended,
+       the redefinitions must write the data of the superclass first. */
+  virtual void SaveRunState(std::ostream &os) const;
+
+  /** Reads the data written by SaveRunState, once the run has been initialized. */
+  virtual void LoadRunState(std::istream &is);
+
+  /** The checkpointer of the run, if any. */
+  RunnerCheckpointer<Input, Solution, CostStructure> *checkpointer;
+
 private:
   /** Stores the move and updates the related data. */
   virtual void UpdateBestState() = 0;
@@ -220,6 +317,12 @@ private:
 
   /** Actions that must be done at the end of the search. */
   CostStructure TerminateRun(Solution&);
+
+  /** Hands the data of the run to the checkpointer. */
+  void SaveCheckpoint();
+
+  /** Continues the run from the checkpoint, if there is one. */
+  void LoadCheckpoint();
 };
 
 /*************************************************************************
@@ -227,12 +330,12 @@ private:
      *************************************************************************/
 
 template <class Input, class Solution, class CostStructure>
-std::vector<Runner<Input, Solution, CostStructure> *> Runner<Input, Solution, CostStructure>::runners;
+thread_local std::vector<Runner<Input, Solution, CostStructure> *> Runner<Input, Solution, CostStructure>::runners;
 
 template <class Input, class Solution, class CostStructure>
 Runner<Input, Solution, CostStructure>::Runner(const Input &in, SolutionManager<Input, Solution, CostStructure> &sm, std::string name)
     : // Parameters
-  CommandLineParameters::Parametrized(name, typeid(this).name()), name(name), no_acceptable_move_found(false), in(in), sm(sm), weights(0)
+  CommandLineParameters::Parametrized(name, typeid(this).name()), name(name), no_acceptable_move_found(false), in(in), sm(sm), weights(0), checkpointer(nullptr)
 {
   // Add to the list of all runners
     runners.push_back(this);
@@ -245,6 +348,8 @@ template <class Input, class Solution, class CostStructure>
 CostStructure Runner<Input, Solution, CostStructure>::Go(Solution&s)
 {
   InitializeRun(s);
+  if (checkpointer != nullptr)
+    LoadCheckpoint();
   while (!MaxEvaluationsExpired() && !StopCriterion() && !LowerBoundReached() && !this->TimeoutExpired())
   {
     PrepareIteration();
@@ -264,6 +369,8 @@ CostStructure Runner<Input, Solution, CostStructure>::Go(Solution&s)
       break;
     }
     CompleteIteration();
+    if (checkpointer != nullptr && checkpointer->Period() > 0 && iteration % checkpointer->Period() == 0)
+      SaveCheckpoint();
   }
 
   return TerminateRun(s);
@@ -297,6 +404,8 @@ void Runner<Input, Solution, CostStructure>::InitializeRun(Solution&s)
   p_current_state = std::make_shared<Solution>(s); // creates the current state object by copying the content of s
   best_state_cost = current_state_cost = sm.CostFunctionComponents(s);
   InitializeRun();
+  std::lock_guard<std::mutex> lock(best_state_mutex);
+  NotifyNewBest();
 }
 
 template <class Input, class Solution, class CostStructure>
@@ -307,6 +416,68 @@ CostStructure Runner<Input, Solution, CostStructure>::TerminateRun(Solution&s)
   return best_state_cost;
 }
 
+template <class Input, class Solution, class CostStructure>
+void Runner<Input, Solution, CostStructure>::NotifyNewBest() const
+{
+  for (RunnerObserver<Input, Solution, CostStructure> *o : observers)
+    o->NotifyNewBest(name, *p_best_state, best_state_cost, iteration_of_best);
+}
+
+/**
+     The runner writes its counters and the state of the random engine of its thread
+     (as text, the only portable representation of the engines).
+     */
+template <class Input, class Solution, class CostStructure>
+void Runner<Input, Solution, CostStructure>::SaveRunState(std::ostream &os) const
+{
+  Serialization::Write(os, iteration);
+  Serialization::Write(os, iteration_of_best);
+  Serialization::Write(os, evaluations);
+  std::ostringstream engine;
+  engine << Random::GetGenerator();
+  Serialization::Write(os, engine.str());
+}
+
+template <class Input, class Solution, class CostStructure>
+void Runner<Input, Solution, CostStructure>::LoadRunState(std::istream &is)
+{
+  Serialization::Read(is, iteration);
+  Serialization::Read(is, iteration_of_best);
+  Serialization::Read(is, evaluations);
+  std::string engine;
+  Serialization::Read(is, engine);
+  std::istringstream engine_is(engine);
+  engine_is >> Random::GetGenerator();
+  if (!engine_is)
+    throw std::runtime_error("Incorrect state of the random engine in the checkpoint of runner " + name);
+}
+
+template <class Input, class Solution, class CostStructure>
+void Runner<Input, Solution, CostStructure>::SaveCheckpoint()
+{
+  std::ostringstream os;
+  SaveRunState(os);
+  checkpointer->Save(name, os.str(), *p_current_state, *p_best_state);
+}
+
+/**
+     The costs of the states are recomputed, the data of the run is restored
+     last, so that it overrides what the initialization has done.
+     */
+template <class Input, class Solution, class CostStructure>
+void Runner<Input, Solution, CostStructure>::LoadCheckpoint()
+{
+  std::string data;
+  std::lock_guard<std::mutex> lock(best_state_mutex);
+  if (!checkpointer->Load(name, data, *p_current_state, *p_best_state))
+    return;
+  current_state_cost = sm.CostFunctionComponents(*p_current_state);
+  best_state_cost = sm.CostFunctionComponents(*p_best_state);
+  std::istringstream is(data);
+  LoadRunState(is);
+  NotifyNewBest();
+}
+
 template <class Input, class Solution, class CostStructure>
 bool Runner<Input, Solution, CostStructure>::LowerBoundReached() const
 {
@@ -3,6 +3,10 @@
 #include <cmath>
 #include <stdexcept>
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
 
 #include "runners/moverunner.hh"
 #include "helpers/solutionmanager.hh"
@@ -37,16 +41,19 @@ public:
                      std::string name);
 protected:
   void InitializeRun() override;
+  void TerminateRun() override;
   void UpdateIterationCounter();
   void SelectMove() override;
   void CompleteMove() override;
   void CompleteIteration() override;
-  bool MetropolisCriterion() const;
+  bool MetropolisCriterion();
   virtual bool CoolingNeeded() const; 
   virtual void ApplyCooling();
   bool StopCriterion() override;
   void ComputeStartTemperature();
   virtual void PrintStatus(std::ostream& os) const;
+  void SaveRunState(std::ostream &os) const override;
+  void LoadRunState(std::istream &is) override;
   // parameters
   Parameter<bool> compute_start_temperature;
   Parameter<double> start_temperature, min_temperature;
@@ -54,15 +61,26 @@ protected:
   Parameter<double> cooling_rate;
   Parameter<unsigned int> max_neighbors_sampled;
   Parameter<unsigned int> max_neighbors_accepted;  
+  Parameter<unsigned int> acceptance_table_size;
   // state of SA
   double temperature; /**< The current temperature. */
   unsigned int current_max_neighbors_sampled; // initially set to the max value, recomputed based on saved iterations by cut-off
   
   size_t neighbors_sampled, neighbors_accepted;  
-  unsigned residual_temperatures, residual_iterations;
+  unsigned residual_temperatures;
+  unsigned long residual_iterations;
   int number_of_temperatures;
   int total_number_of_temperatures;
   double temperature_range;
+  // acceptance table: acceptance_thresholds[d] = exp(-d/T) 2^32, valid if acceptance_stamps[d] is the stamp of the current temperature
+  std::vector<uint64_t> acceptance_thresholds;
+  std::vector<unsigned int> acceptance_stamps;
+  unsigned int acceptance_stamp;
+  double acceptance_temperature;
+  // the parameters computed by a run are computed again by the next ones, and the temperatures moved along a run are restored at
+  // its end, so that the runner can be run more times (e.g., on the windows of a rolling horizon)
+  bool start_temperature_computed, max_neighbors_sampled_computed, max_neighbors_accepted_computed;
+  double run_start_temperature, run_min_temperature;
 };
   
   /*************************************************************************
@@ -76,7 +94,8 @@ template <class Input, class Solution, class Move, class CostStructure>
 SimulatedAnnealing<Input, Solution, Move, CostStructure>::SimulatedAnnealing(const Input &in, SolutionManager<Input, Solution, CostStructure> &e_sm,
                                        NeighborhoodExplorer<Input, Solution, Move, CostStructure> &e_ne,
                                        std::string name) 
-  : MoveRunner<Input, Solution, Move, CostStructure>(in, e_sm, e_ne, name)
+  : MoveRunner<Input, Solution, Move, CostStructure>(in, e_sm, e_ne, name),
+    start_temperature_computed(false), max_neighbors_sampled_computed(false), max_neighbors_accepted_computed(false)
 {
   compute_start_temperature("compute_start_temperature", "Should the runner compute the initial temperature?", this->parameters);
   start_temperature("start_temperature", "Starting temperature", this->parameters);
@@ -85,6 +104,7 @@ SimulatedAnnealing<Input, Solution, Move, CostStructure>::SimulatedAnnealing(con
   max_neighbors_sampled("max_neighbors_sampled", "Maximum number of neighbors sampled at each temp.", this->parameters);
   max_neighbors_accepted("max_neighbors_accepted", "Maximum number of neighbors accepted at each temp.", this->parameters);
   neighbors_accepted_ratio("neighbors_accepted_ratio", "Ratio of neighbors accepted", this->parameters);
+  acceptance_table_size("acceptance_table_size", "Number of integer deltas whose acceptance probability is tabulated at each temperature (0: no table)", this->parameters);
 }
 
 /**
@@ -101,14 +121,17 @@ void SimulatedAnnealing<Input, Solution, Move, CostStructure>::InitializeRun()
 
   if (!neighbors_accepted_ratio.IsSet() && !max_neighbors_accepted.IsSet())
      neighbors_accepted_ratio = 1.0;  
+
+  if (!acceptance_table_size.IsSet())
+    acceptance_table_size = 0;
   
   if (cooling_rate <= 0.0 || cooling_rate >= 1.0)
     throw IncorrectParameterValue(cooling_rate, "should be a value in the interval ]0, 1[");
     
-  if (max_neighbors_sampled.IsSet() && this->max_evaluations.IsSet()) 
+  if (max_neighbors_sampled.IsSet() && !max_neighbors_sampled_computed && this->max_evaluations.IsSet()) 
     throw IncorrectParameterValue(max_neighbors_sampled, "should not be set explicitly when max_evaluations is set explicitly, as it is computed");
 
-  if (max_neighbors_accepted.IsSet() && neighbors_accepted_ratio.IsSet()) 
+  if (max_neighbors_accepted.IsSet() && !max_neighbors_accepted_computed && neighbors_accepted_ratio.IsSet()) 
     throw IncorrectParameterValue(max_neighbors_accepted, "should not be set explicitly when neighbors_accepted_ratio is set explicitly, as it is computed");
 
   if (!max_neighbors_sampled.IsSet() && !this->max_evaluations.IsSet()) 
@@ -116,9 +139,10 @@ void SimulatedAnnealing<Input, Solution, Move, CostStructure>::InitializeRun()
 
   if (compute_start_temperature)
     {
-      if (start_temperature.IsSet())
+      if (start_temperature.IsSet() && !start_temperature_computed)
          throw IncorrectParameterValue(start_temperature, "should not be assigned, as it is computed");
       ComputeStartTemperature();
+      start_temperature_computed = true;
      }
 
   if (start_temperature < min_temperature)
@@ -126,24 +150,35 @@ void SimulatedAnnealing<Input, Solution, Move, CostStructure>::InitializeRun()
   if (min_temperature <= 0.0)
     throw IncorrectParameterValue(min_temperature, "should be greater than zero");
 
+  run_start_temperature = start_temperature;
+  run_min_temperature = min_temperature;
   temperature = start_temperature;
   temperature_range = start_temperature / min_temperature;
   total_number_of_temperatures = static_cast<unsigned>(ceil(-log(temperature_range) / log(cooling_rate)));      
   if (this->max_evaluations.IsSet())
     { // Compute max_neighbors_sampled from max_evaluations
-      max_neighbors_sampled = static_cast<unsigned>(this->max_evaluations / total_number_of_temperatures);
+      // clamped, as the time-based variant sets an unbounded number of evaluations
+      max_neighbors_sampled = static_cast<unsigned>(std::min<unsigned long>(this->max_evaluations / total_number_of_temperatures, std::numeric_limits<unsigned int>::max()));
+      max_neighbors_sampled_computed = true;
     }
 
   // max_neighbors_sampled is fixed (and used for cut-off), its current value changes due to saved iterations
   current_max_neighbors_sampled = max_neighbors_sampled;
 
-  if (!max_neighbors_accepted.IsSet())
-    max_neighbors_accepted = static_cast<unsigned>(max_neighbors_sampled * neighbors_accepted_ratio);
+  if (!max_neighbors_accepted.IsSet() || max_neighbors_accepted_computed)
+    {
+      max_neighbors_accepted = static_cast<unsigned>(max_neighbors_sampled * neighbors_accepted_ratio);
+      max_neighbors_accepted_computed = true;
+    }
     
   // initialize dynamic counters
   neighbors_sampled = 0;
   neighbors_accepted = 0;
   number_of_temperatures = 1;
+  acceptance_thresholds.assign(acceptance_table_size, 0);
+  acceptance_stamps.assign(acceptance_table_size, 0);
+  acceptance_stamp = 0;
+  acceptance_temperature = 0.0;
 }
 
 template <class Input, class Solution, class Move, class CostStructure>
@@ -200,11 +235,35 @@ void SimulatedAnnealing<Input, Solution, Move, CostStructure>::PrintStatus(std::
 }
 
 /**
- SA acceptance criterion
+ SA acceptance criterion. For integer costs, the worsening deltas below
+ acceptance_table_size are accepted by comparing a 32-bit draw with the
+ threshold exp(-delta/T) 2^32, computed once per delta and temperature,
+ which saves the logarithm and the floating point draw of each test.
  */
 template <class Input, class Solution, class Move, class CostStructure>
-bool SimulatedAnnealing<Input, Solution, Move, CostStructure>::MetropolisCriterion() const
+bool SimulatedAnnealing<Input, Solution, Move, CostStructure>::MetropolisCriterion()
 {
+  typedef typename CostStructure::CFtype CFtype;
+  // the weighted costs are compared as doubles
+  if (std::is_integral<CFtype>::value && this->weights.empty() && this->current_move.cost.total > 0 && this->current_move.cost.total < static_cast<CFtype>(acceptance_thresholds.size()))
+  {
+    if (acceptance_temperature != this->temperature)
+    {
+      acceptance_temperature = this->temperature;
+      if (++acceptance_stamp == 0) // the stamps wrapped around
+      {
+        std::fill(acceptance_stamps.begin(), acceptance_stamps.end(), 0);
+        acceptance_stamp = 1;
+      }
+    }
+    size_t d = static_cast<size_t>(this->current_move.cost.total);
+    if (acceptance_stamps[d] != acceptance_stamp)
+    {
+      acceptance_thresholds[d] = static_cast<uint64_t>(exp(-static_cast<double>(d) / this->temperature) * 4294967296.0);
+      acceptance_stamps[d] = acceptance_stamp;
+    }
+    return static_cast<uint64_t>(Random::GetGenerator()()) < acceptance_thresholds[d];
+  }
   return this->current_move.cost < (-this->temperature * log(std::max(Random::Uniform<double>(0.0, 1.0), std::numeric_limits<double>::epsilon())));
 }
 
@@ -233,6 +292,18 @@ void SimulatedAnnealing<Input, Solution, Move, CostStructure>::CompleteIteration
     ApplyCooling();
 }
 
+/**
+ Restores the temperatures of the schedule given to the run, which are lowered
+ (or raised by the reheats) along the run.
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void SimulatedAnnealing<Input, Solution, Move, CostStructure>::TerminateRun()
+{
+  MoveRunner<Input, Solution, Move, CostStructure>::TerminateRun();
+  start_temperature = run_start_temperature;
+  min_temperature = run_min_temperature;
+}
+
 template <class Input, class Solution, class Move, class CostStructure>
 bool SimulatedAnnealing<Input, Solution, Move, CostStructure>::CoolingNeeded() const
 {
@@ -247,7 +318,7 @@ void SimulatedAnnealing<Input, Solution, Move, CostStructure>::ApplyCooling()
     { // we have saved some iterations thanks to the cut-off: they are 
       // redistributed to the remaining temperatures
       residual_iterations = this->max_evaluations - this->evaluations;
-      current_max_neighbors_sampled = residual_iterations/residual_temperatures;
+      current_max_neighbors_sampled = static_cast<unsigned>(std::min<unsigned long>(residual_iterations/residual_temperatures, std::numeric_limits<unsigned int>::max()));
       // NOTE: the number of accepted moves depends on the initial number of sampled, NOT from the current one
     }
 
@@ -269,6 +340,48 @@ void SimulatedAnnealing<Input, Solution, Move, CostStructure>::ApplyCooling()
 } 
 
 
+/**
+ The schedule of the temperatures, including the parameters recomputed along
+ the run (the acceptance table is not saved, it is refilled on demand).
+ */
+template <class Input, class Solution, class Move, class CostStructure>
+void SimulatedAnnealing<Input, Solution, Move, CostStructure>::SaveRunState(std::ostream &os) const
+{
+  MoveRunner<Input, Solution, Move, CostStructure>::SaveRunState(os);
+  Serialization::Write(os, temperature);
+  Serialization::Write(os, static_cast<double>(min_temperature));
+  Serialization::Write(os, static_cast<unsigned int>(max_neighbors_sampled));
+  Serialization::Write(os, static_cast<unsigned int>(max_neighbors_accepted));
+  Serialization::Write(os, current_max_neighbors_sampled);
+  Serialization::Write(os, neighbors_sampled);
+  Serialization::Write(os, neighbors_accepted);
+  Serialization::Write(os, number_of_temperatures);
+  Serialization::Write(os, total_number_of_temperatures);
+  Serialization::Write(os, temperature_range);
+}
+
+template <class Input, class Solution, class Move, class CostStructure>
+void SimulatedAnnealing<Input, Solution, Move, CostStructure>::LoadRunState(std::istream &is)
+{
+  MoveRunner<Input, Solution, Move, CostStructure>::LoadRunState(is);
+  double d;
+  unsigned int u;
+  Serialization::Read(is, temperature);
+  Serialization::Read(is, d);
+  min_temperature = d;
+  Serialization::Read(is, u);
+  max_neighbors_sampled = u;
+  Serialization::Read(is, u);
+  max_neighbors_accepted = u;
+  Serialization::Read(is, current_max_neighbors_sampled);
+  Serialization::Read(is, neighbors_sampled);
+  Serialization::Read(is, neighbors_accepted);
+  Serialization::Read(is, number_of_temperatures);
+  Serialization::Read(is, total_number_of_temperatures);
+  Serialization::Read(is, temperature_range);
+  acceptance_temperature = 0.0;
+}
+
   /**
      The search stops when a low temperature has reached.
   */
@@ -1,268 +1,223 @@
-// #pragma once
+#pragma once
 
-// #include <chrono>
-// #include <cmath>
-// #include "runners/simulatedannealingtimebased.hh"
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include "runners/simulatedannealing.hh"
 
-// namespace EasyLocal
-// {
-//   namespace Core
-//   {
-//     struct LearningData
-//     {
-//       int improving = 0, sideways = 0, accepted = 0, evaluated = 0;
-//       double global_improvement = 0.0;
-//       std::chrono::nanoseconds global_evaluation_time;
-//     };
+namespace EasyLocal
+{
+  namespace Core
+  {
+    /** Statistics collected for each neighborhood of a multimodal explorer along a batch of iterations. */
+    struct LearningData
+    {
+      int improving = 0, sideways = 0, accepted = 0, evaluated = 0;
+      double global_improvement = 0.0;
+      std::chrono::nanoseconds global_evaluation_time = std::chrono::nanoseconds(0);
+    };
 
-//     template <class Input, class Solution, class Move, class CostStructure = DefaultCostStructure<int>>
-//     class SimulatedAnnealingWithLearning : public SimulatedAnnealingTimeBased<Input, Solution, Move, CostStructure>
-//     {
-//     public:
-//       SimulatedAnnealingWithLearning(const Input &in, SolutionManager<Input, Solution, CostStructure> &sm,
-//                                     NeighborhoodExplorer<Input, Solution, Move, CostStructure> &ne,
-//                                     std::string name) : SimulatedAnnealingTimeBased<Input, Solution, Move, CostStructure>(in, sm, ne, name)
-//       {
-//         learning_data.resize(ne.Modality());
-//         learning_rate = 0.05;        // higher values imply faster learning
-//         min_threshold = 0.05;        // probabilities are lower-bounded by this value
-//         time_smoother = 1.0;                  // 0 = no time_smoother, 1 = linear, 2 = sqrt, 3 = log10
+    /** Simulated annealing with adaptive neighborhood selection.
 
-//       }
-//       void SetLearningRate(double r) {learning_rate = r;}
-//       void SetThreshold(double t) {min_threshold = t;}
-//       void SetTimeSmoother(double t) {time_smoother = t;} 
-//       void CompleteMove() override 
-//       {
-//         SimulatedAnnealingTimeBased<Input, Solution, Move, CostStructure>::CompleteMove();
-//         //size_t i = Impl::MoveDispatcher<decltype(this->current_move), this->ne.Modality() - 1>::get_first_active(this->current_move, 0);
-        
-//         int active_move_index = this->ne.GetActiveMove(this->current_move.move);
-//         CostStructure move_cost = this->current_move.cost;
-        
-//         learning_data[active_move_index].accepted++;
-//         if(move_cost.total < 0 )
-//           {
-//             learning_data[active_move_index].improving++;
-//             learning_data[active_move_index].global_improvement-=move_cost.total;  // Note: move_cost.total is negative when improving
-//           }
-//         else if(move_cost.total == 0 )
-//           learning_data[active_move_index].sideways++;    
-//         // update counters:
-//         //   - retrieve the active move (how?)
-//         //   - retrieve the delta_cost
-//         //   - update the learning data of the neighborhood
-//       }
+     The runner is meant to be used with a multimodal neighborhood explorer (e.g., a
+     SetUnionNeighborhoodExplorer): at the end of each temperature the biases of the neighborhoods
+     are updated by probability matching, using as reward the improvement obtained by each neighborhood
+     per unit of evaluation time. The quality of each neighborhood is an exponential moving average
+     of its (normalized) rewards, and the bias of every enabled neighborhood (the ones with a positive
+     bias at the start of the run) is lower-bounded by min_bias, so that none of them is ever switched
+     off. The neighborhoods with bias 0 are disabled and keep bias 0.
 
-//       virtual void ApplyLearning()
-//       {
-//             //vector<double> avg_improvement(this->ne.Modality(),0);
-//             std::vector<double> reward(this->ne.Modality(),0);
-//             //double total_avg_improvement = 0;
-//             double total_reward = 0;
-//     #if VERBOSE >= 1
-//             std::cerr << "V1 ";
-//             this->PrintStatus(std::cerr);
-//             std::cerr << ", time = " << std::chrono::duration_cast<std::chrono::milliseconds>(this->temperature_start_time-this->run_start).count()/1000.0;
-//             std::cerr << ", rates: (";
-//             double sum_rates = 0;
-//             for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//               {
-//                 std::cerr << "" << this->ne.GetBias(i) << (i < this->ne.Modality() -1 ? "/" : ") ");
-//                 sum_rates+=this->ne.GetBias(i);
-//               }
-//             std::cerr << "[" << sum_rates << "] ";
-//            std::cerr << "acceptance: (";
-//             for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//               {
-//                 std::cerr << "" << static_cast<double>(learning_data[i].accepted)/learning_data[i].evaluated << (i < this->ne.Modality() -1 ? "/" : ") ");
-//               }
-//     #elif VERBOSE >= 2
-//           if(this->number_of_temperatures == 1) //I print the header
-//           {
-//             std::cerr << "n_temp,"
-//                       << "time,"
-//                       << "temperature,"
-//                       << "sampled,"
-//                       << "accepted,"
-//                       << "acceptance,"
-//                       << "current_cost,"
-//                       << "best_cost,";
-//                       for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//                         std::cerr<< "rate_"<<i<<",";
-//                       std::cerr << "check,";  
-//                       for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//                         std::cerr<< "acceptance_"<<i<<",";
-//                       for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//                       {
-//                         std::cerr << "evaluated_"<<i<<","
-//                                   << "accepted_"<<i<<","
-//                                   << "improving_"<<i<<","
-//                                   << "sideways_"<<i<<","
-//                                   << "global_improvement_"<<i<<","
-//                                   << "avgtime_"<<i<<",";
-//                       }     
-//                       for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//                       {
-//                         std::cerr << "reward_"<<i<<"";
-//                         if(i < this->ne.Modality()-1)
-//                           std::cerr << ",";
-//                         else
-//                           std::cerr << std::endl;
-//                       }                
-//           }
-//           std::cerr << this->number_of_temperatures << ","
-//                     << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()- this->run_start).count()/1000.0 << ","
-//                     << this->Temperature() << ","
-//                     << this->neighbors_sampled << "," 
-//                     << this->neighbors_accepted << ","
-//                     << static_cast<double>(this->neighbors_accepted)/this->neighbors_sampled << ","
-//                     << this->current_state_cost.total << "," 
-//                     << this->best_state_cost.total << ",";
-//             double sum_rates = 0;
-//             for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//               {
-//                 std::cerr << this->ne.GetBias(i) << ",";
-//                 sum_rates+=this->ne.GetBias(i);
-//               }
-//             std::cerr << sum_rates << ",";
-//             for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//               {
-//                 std::cerr << static_cast<double>(learning_data[i].accepted)/learning_data[i].evaluated << ",";
-//               }
-//     #endif
-//             for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//               {
-//     #if VERBOSE == 1
-//                 std::cerr << i << "[" 
-//                           << learning_data[i].evaluated << "/"
-//                           << learning_data[i].accepted << "/"
-//                           << learning_data[i].improving << "/"
-//                           << learning_data[i].sideways << "/"
-//                           << learning_data[i].global_improvement << "/";
-//                           if(learning_data[i].accepted > 0)
-//                             std::cerr << learning_data[i].global_evaluation_time.count()/static_cast<double>(learning_data[i].accepted) << "] ";
-//                           else  
-//                             std::cerr << "nan" << "] ";
-//     #elif VERBOSE >= 2
-//                 std::cerr << learning_data[i].evaluated << ","
-//                           << learning_data[i].accepted << ","
-//                           << learning_data[i].improving << ","
-//                           << learning_data[i].sideways << ","
-//                           << learning_data[i].global_improvement << ",";
-//                           if(learning_data[i].accepted > 0)
-//                             std::cerr << learning_data[i].global_evaluation_time.count()/static_cast<double>(learning_data[i].accepted) << ",";
-//                           else  
-//                             std::cerr << "nan" << ",";
-//     #endif    
-                
+     @ingroup Runners
+     */
+    template <class Input, class Solution, class Move, class CostStructure = DefaultCostStructure<int>>
+    class SimulatedAnnealingWithLearning : public SimulatedAnnealing<Input, Solution, Move, CostStructure>
+    {
+    public:
+      SimulatedAnnealingWithLearning(const Input &in, SolutionManager<Input, Solution, CostStructure> &sm,
+                                     NeighborhoodExplorer<Input, Solution, Move, CostStructure> &ne,
+                                     std::string name) : SimulatedAnnealing<Input, Solution, Move, CostStructure>(in, sm, ne, name)
+      {
+        learning_rate("learning_rate", "Learning rate of the neighborhood qualities (higher values imply faster learning)", this->parameters);
+        min_bias("min_bias", "Lower bound of the probability of each neighborhood", this->parameters);
+        time_smoother("time_smoother", "Exponent of the evaluation time in the reward (0 = time is not considered, 1 = linear)", this->parameters);
+        learning_rate = 0.05;
+        min_bias = 0.05;
+        time_smoother = 1.0;
+      }
 
-//                 reward[i] = ComputeNHReward(i);
+      /** Returns the statistics collected in the current batch of iterations for neighborhood i */
+      const LearningData& GetLearningData(size_t i) const { return learning_data[i]; }
 
-//                 total_reward += reward[i];
-//               }
+    protected:
+      void InitializeRun() override
+      {
+        SimulatedAnnealing<Input, Solution, Move, CostStructure>::InitializeRun();
+        if (learning_rate < 0.0 || learning_rate > 1.0)
+          throw IncorrectParameterValue(learning_rate, "should be a value in the interval [0, 1]");
+        enabled.assign(this->ne.Modality(), false);
+        size_t enabled_neighborhoods = 0;
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+          if (this->ne.GetBias(i) > 0.0)
+          {
+            enabled[i] = true;
+            enabled_neighborhoods++;
+          }
+        if (enabled_neighborhoods == 0)
+          throw std::logic_error("Runner " + this->name + " needs at least one neighborhood with a positive bias");
+        if (min_bias < 0.0 || min_bias * enabled_neighborhoods >= 1.0)
+          throw IncorrectParameterValue(min_bias, "should be non negative and smaller than 1/(number of enabled neighborhoods)");
+        learning_data.assign(this->ne.Modality(), LearningData());
+        // the initial qualities are the (normalized) biases of the neighborhood explorer
+        double total_bias = 0.0;
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+          total_bias += this->ne.GetBias(i);
+        quality.resize(this->ne.Modality());
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+          quality[i] = this->ne.GetBias(i) / total_bias;
+        UpdateBiases();
+      }
 
-//             //I give the reward (reinforcement rule)
+      /** A move is randomly picked, and its generation and evaluation time is charged to its neighborhood. */
+      void SelectMove() override
+      {
+        auto start = std::chrono::steady_clock::now();
+        this->ne.RandomMove(*this->p_current_state, this->current_move.move);
+        this->current_move.cost = this->ne.DeltaCostFunctionComponents(*this->p_current_state, this->current_move.move, this->weights);
+        LearningData& data = learning_data[this->ne.GetActiveMove(this->current_move.move)];
+        data.global_evaluation_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        data.evaluated++;
+        this->neighbors_sampled++;
+        this->evaluations++;
+        this->current_move.is_valid = this->current_move.cost <= 0 || this->MetropolisCriterion();
+      }
 
-//     #if VERBOSE == 1
-//             std::cerr << "rewards: (";
-//     #endif
-//             double used_threshold = 0.0;
-//             std::vector<bool> applied_threshold(this->ne.Modality(),false);
-//             int how_many_threshold_applied = 0;
-//             for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//               {
-//                 if(total_reward > 0.0)
-//                   reward[i] = reward[i] / total_reward;
-//                 else
-//                   reward[i] = 1.0/this->ne.Modality();
-//     #if VERBOSE == 1
-//                 std::cerr << "" << reward[i] << (i < this->ne.Modality() -1 ? "/" : ") ");
-//     #elif VERBOSE >= 2
-//                 std::cerr << reward[i] << (i < this->ne.Modality() -1 ? "," : "");
-//     #endif 
-//                 if((1-learning_rate)*this->ne.GetBias(i) + learning_rate*reward[i] < min_threshold)
-//                   {
-//                     used_threshold+=(min_threshold-((1-learning_rate)*this->ne.GetBias(i) + learning_rate*reward[i]));
-//                     applied_threshold[i] = true;
-//                     this->ne.SetBias(i, min_threshold);
-//                     how_many_threshold_applied++;
-//                   }
-//                 else
-//                   {
-//                     this->ne.SetBias(i, (1-learning_rate)*this->ne.GetBias(i) + learning_rate*reward[i]);
-//                   }
-//                 learning_data[i].accepted = 0;
-//                 learning_data[i].improving = 0;
-//                 learning_data[i].sideways = 0;
-//                 learning_data[i].evaluated = 0;
-//                 learning_data[i].global_improvement = 0.0;
-//                 learning_data[i].global_evaluation_time = std::chrono::nanoseconds(0);
-//               }
-//             //I re balance the threshold
-//             if(how_many_threshold_applied > 0 && how_many_threshold_applied < static_cast<int>(this->ne.Modality()))
-//               {
-//                 for(unsigned int i = 0; i < this->ne.Modality(); i++)
-//                   if(!applied_threshold[i])
-//                     this->ne.SetBias(i, this->ne.GetBias(i) - used_threshold/(this->ne.Modality() - how_many_threshold_applied));
-//               }
+      void CompleteMove() override
+      {
+        SimulatedAnnealing<Input, Solution, Move, CostStructure>::CompleteMove();
+        LearningData& data = learning_data[this->ne.GetActiveMove(this->current_move.move)];
+        data.accepted++;
+        if (this->current_move.cost.total < 0)
+        {
+          data.improving++;
+          data.global_improvement -= this->current_move.cost.total; // move cost is negative when improving
+        }
+        else if (this->current_move.cost.total == 0)
+          data.sideways++;
+      }
 
-//     #if VERBOSE >= 1
-//             std::cerr << std::endl;
-//     #endif
-          
-//       }
+      /** The batch of learning is a temperature: before cooling the biases are updated and the learning data is reset. */
+      void CompleteIteration() override
+      {
+        if (this->CoolingNeeded())
+          ApplyLearning();
+        SimulatedAnnealing<Input, Solution, Move, CostStructure>::CompleteIteration();
+      }
 
+      virtual double ComputeNHReward(size_t i) const
+      {
+        const LearningData& data = learning_data[i];
+        if (data.global_improvement <= 0.0 || data.evaluated == 0)
+          return 0.0;
+        double time = std::max(static_cast<double>(data.global_evaluation_time.count()), 1.0);
+        return data.global_improvement / std::pow(time, time_smoother);
+      }
 
-//       void CompleteIteration() override 
-//       {
-//         if (this->CoolingNeeded()) // the batch is finished -> update probabilities and reset learning data
-//           ApplyLearning();
-//         SimulatedAnnealingTimeBased<Input, Solution, Move, CostStructure>::CompleteIteration();
-//       }
+      virtual void ApplyLearning()
+      {
+        std::vector<double> reward(this->ne.Modality(), 0.0);
+        double total_reward = 0.0;
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+        {
+          reward[i] = ComputeNHReward(i);
+          total_reward += reward[i];
+        }
+        // if nothing improved in this batch the qualities are left unchanged
+        if (total_reward > 0.0)
+        {
+          for (size_t i = 0; i < this->ne.Modality(); i++)
+            quality[i] = (1 - learning_rate) * quality[i] + learning_rate * reward[i] / total_reward;
+          UpdateBiases();
+        }
+#if VERBOSE >= 1
+        std::cerr << "V1 rates: (";
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+          std::cerr << this->ne.GetBias(i) << (i < this->ne.Modality() - 1 ? "/" : ") ");
+        std::cerr << "rewards: (";
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+          std::cerr << (total_reward > 0.0 ? reward[i] / total_reward : 0.0) << (i < this->ne.Modality() - 1 ? "/" : ")");
+        std::cerr << std::endl;
+#endif
+        learning_data.assign(this->ne.Modality(), LearningData());
+      }
 
+      /** The qualities and the statistics of the current batch (the biases are saved by the move runner). */
+      void SaveRunState(std::ostream &os) const override
+      {
+        SimulatedAnnealing<Input, Solution, Move, CostStructure>::SaveRunState(os);
+        Serialization::Write(os, quality);
+        Serialization::Write(os, static_cast<uint64_t>(learning_data.size()));
+        for (const LearningData& data : learning_data)
+        {
+          Serialization::Write(os, data.improving);
+          Serialization::Write(os, data.sideways);
+          Serialization::Write(os, data.accepted);
+          Serialization::Write(os, data.evaluated);
+          Serialization::Write(os, data.global_improvement);
+          Serialization::Write(os, static_cast<int64_t>(data.global_evaluation_time.count()));
+        }
+      }
 
-//       void SelectMove() override 
-//       {
-//         bool accepted = false;
-//         do
-//         {
-//           //          std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::high_resolution_clock::now(); 
-//           std::chrono::time_point<std::chrono::system_clock> start = std::chrono::high_resolution_clock::now(); 
-//           //          auto start = std::chrono::high_resolution_clock::now(); 
-//           this->ne.RandomMove(*this->p_current_state, this->current_move.move); //TO DO: ,this->weights);
-//           this->current_move.cost = this->ne.DeltaCostFunctionComponents(*this->p_current_state, this->current_move.move);
-//           this->current_move.is_valid = true;
-//           if (this->current_move.cost <= 0 || this->current_move.cost < (-this->temperature * log(std::max(Random::Uniform<double>(0.0, 1.0), std::numeric_limits<double>::epsilon()))))
-//           {
-//             accepted = true;
-//             //learning_data[this->ne.GetActiveMove(this->current_move.move)].global_evaluation_time+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::time_point<std::chrono::steady_clock>(std::chrono::high_resolution_clock::now())-start);
-//             learning_data[this->ne.GetActiveMove(this->current_move.move)].global_evaluation_time+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now()-start);
-//           }
-//           this->neighbors_sampled++;
-//           this->evaluations++;
-//           learning_data[this->ne.GetActiveMove(this->current_move.move)].evaluated++;
-//         } while(!accepted);
-//       }
+      void LoadRunState(std::istream &is) override
+      {
+        SimulatedAnnealing<Input, Solution, Move, CostStructure>::LoadRunState(is);
+        Serialization::Read(is, quality);
+        uint64_t size;
+        Serialization::Read(is, size);
+        if (quality.size() != this->ne.Modality() || size != this->ne.Modality())
+          throw std::runtime_error("The checkpoint of runner " + this->name + " has a different number of neighborhoods");
+        for (LearningData& data : learning_data)
+        {
+          int64_t time;
+          Serialization::Read(is, data.improving);
+          Serialization::Read(is, data.sideways);
+          Serialization::Read(is, data.accepted);
+          Serialization::Read(is, data.evaluated);
+          Serialization::Read(is, data.global_improvement);
+          Serialization::Read(is, time);
+          data.global_evaluation_time = std::chrono::nanoseconds(time);
+        }
+      }
 
-//       virtual double ComputeNHReward(unsigned int i)
-//       {
-//           double this_reward;
-//           if(learning_data[i].global_improvement > 0.0)
-//             // this_reward = (learning_data[i].global_improvement/learning_data[i].evaluated)
-//             //           /pow(learning_data[i].global_evaluation_time.count()/static_cast<double>(learning_data[i].accepted),1.0/time_smoother);
-//             this_reward = (learning_data[i].global_improvement/learning_data[i].evaluated)
-//                        /pow(learning_data[i].global_evaluation_time.count()/static_cast<double>(learning_data[i].accepted),time_smoother);
-//           else
-//             this_reward = 0;
-//           return this_reward;
-//       }
-//     protected:
-//       std::vector<LearningData> learning_data;
-//       double learning_rate; 
-//       double min_threshold;
-//       double time_smoother;
-//       // batch size is equal to max_neighbors_sampled in this version
-//     };
-//   }
-// }
+      /** Probability matching over the n enabled neighborhoods: p_i = min_bias + (1 - n * min_bias) * q_i / sum_j q_j
+       (the sum is over the enabled ones), and p_i = 0 for the disabled ones */
+      void UpdateBiases()
+      {
+        double total_quality = 0.0;
+        size_t enabled_neighborhoods = 0;
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+          if (enabled[i])
+          {
+            total_quality += quality[i];
+            enabled_neighborhoods++;
+          }
+        for (size_t i = 0; i < this->ne.Modality(); i++)
+        {
+          if (!enabled[i])
+          {
+            this->ne.SetBias(i, 0.0);
+            continue;
+          }
+          double q = total_quality > 0.0 ? quality[i] / total_quality : 1.0 / enabled_neighborhoods;
+          this->ne.SetBias(i, min_bias + (1.0 - enabled_neighborhoods * min_bias) * q);
+        }
+      }
+
+      // parameters
+      Parameter<double> learning_rate, min_bias, time_smoother;
+      // state
+      std::vector<LearningData> learning_data;
+      std::vector<double> quality;
+      std::vector<bool> enabled;
+    };
+  }
+}
@@ -40,6 +40,8 @@ namespace EasyLocal
       void CompleteMove();
       void InitializeRun();
       bool ReheatCondition();
+      void SaveRunState(std::ostream &os) const override;
+      void LoadRunState(std::istream &is) override;
       // additional parameters
       Parameter<double> first_reheat_ratio;
       Parameter<double> reheat_ratio;
@@ -47,6 +49,8 @@ namespace EasyLocal
       Parameter<unsigned int> max_reheats;
       unsigned int reheats;
       unsigned int first_descent_evaluations, other_descents_evaluations;
+      unsigned int expected_number_of_temperatures; /**< The number of temperatures of the current descent. */
+      double expected_min_temperature; /**< The final temperature of each descent (the base runner lowers min_temperature while there are evaluations left). */
     };
     /*************************************************************************
      * Implementation
@@ -57,6 +61,7 @@ namespace EasyLocal
     {
       SimulatedAnnealing<Input, Solution, Move, CostStructure>::InitializeRun();
       reheats = 0;
+      expected_min_temperature = this->min_temperature;
       
       if (max_reheats > 0)
       {
@@ -75,6 +80,7 @@ namespace EasyLocal
           throw IncorrectParameterValue(first_descent_evaluations_share, "should be a value in the interval ]0, 1]");
         
         this->max_neighbors_sampled = ceil(this->max_neighbors_sampled * first_descent_evaluations_share);
+        this->current_max_neighbors_sampled = this->max_neighbors_sampled;
         first_descent_evaluations = this->max_evaluations * first_descent_evaluations_share;
         other_descents_evaluations = (this->max_evaluations - first_descent_evaluations) / max_reheats;
       }
@@ -97,14 +103,22 @@ namespace EasyLocal
         else if (max_reheats > 1)
           this->start_temperature = this->start_temperature * reheat_ratio;
         //     }
-        this->expected_number_of_temperatures = -log(this->start_temperature / this->expected_min_temperature) / log(this->cooling_rate);
+        expected_number_of_temperatures = std::max(1.0, ceil(-log(this->start_temperature / expected_min_temperature) / log(this->cooling_rate)));
         
-        this->max_neighbors_sampled = other_descents_evaluations / this->expected_number_of_temperatures;
+        this->max_neighbors_sampled = other_descents_evaluations / expected_number_of_temperatures;
+        this->current_max_neighbors_sampled = this->max_neighbors_sampled;
         this->max_neighbors_accepted = this->max_neighbors_sampled;
         reheats++;
         
         // std::cerr << reheats << " " << this->max_neighbors_sampled << " " << this->max_neighbors_accepted  << " " << this->start_temperature << " " << this->temperature << std::endl;
         this->temperature = this->start_temperature;
+        // the new descent restarts the schedule of the base runner: the evaluations saved by the cut-off are redistributed over
+        // the temperatures of this descent and of the following ones
+        this->min_temperature = expected_min_temperature;
+        this->number_of_temperatures = 1;
+        this->total_number_of_temperatures = 1 + expected_number_of_temperatures * (max_reheats - reheats + 1);
+        this->neighbors_sampled = 0;
+        this->neighbors_accepted = 0;
       }
     }
     
@@ -116,6 +130,29 @@ namespace EasyLocal
       return this->evaluations >= first_descent_evaluations + other_descents_evaluations * reheats;
     }
     
+    /**
+     The descents done so far, the start temperature is lowered at each reheat.
+     */
+    template <class Input, class Solution, class Move, class CostStructure>
+    void SimulatedAnnealingWithReheating<Input, Solution, Move, CostStructure>::SaveRunState(std::ostream &os) const
+    {
+      SimulatedAnnealing<Input, Solution, Move, CostStructure>::SaveRunState(os);
+      Serialization::Write(os, static_cast<double>(this->start_temperature));
+      Serialization::Write(os, reheats);
+      Serialization::Write(os, expected_number_of_temperatures);
+    }
+    
+    template <class Input, class Solution, class Move, class CostStructure>
+    void SimulatedAnnealingWithReheating<Input, Solution, Move, CostStructure>::LoadRunState(std::istream &is)
+    {
+      SimulatedAnnealing<Input, Solution, Move, CostStructure>::LoadRunState(is);
+      double d;
+      Serialization::Read(is, d);
+      this->start_temperature = d;
+      Serialization::Read(is, reheats);
+      Serialization::Read(is, expected_number_of_temperatures);
+    }
+    
     /**
      The search stops when a low temperature has reached.
      */
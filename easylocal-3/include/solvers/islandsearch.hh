@@ -0,0 +1,308 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "helpers/solutionmanager.hh"
+#include "solvers/localsearch.hh"
+#include "runners/runner.hh"
+
+namespace EasyLocal
+{
+
+namespace Core
+{
+
+/** A single-slot mailbox for the solutions migrating between two concurrent
+ runners. Sending and receiving never block: a message is exchanged
+ atomically with the slot, so whoever takes it out owns it, and a message
+ not yet received is replaced by the newer one.
+ */
+template <class Solution, class CostStructure>
+class Mailbox
+{
+public:
+    struct Message
+    {
+        Solution solution;
+        CostStructure cost;
+    };
+
+    Mailbox() : message(nullptr) {}
+    ~Mailbox() { delete message.load(); }
+    Mailbox(const Mailbox &) = delete;
+    Mailbox &operator=(const Mailbox &) = delete;
+
+    /** Leaves a copy of the solution in the mailbox. */
+    void Send(const Solution &s, const CostStructure &cost)
+    {
+        delete message.exchange(new Message{s, cost});
+    }
+
+    /** Takes the last solution sent, if any (otherwise returns a null pointer). */
+    std::unique_ptr<Message> Receive()
+    {
+        return std::unique_ptr<Message>(message.exchange(nullptr));
+    }
+
+protected:
+    std::atomic<Message *> message;
+};
+
+/** The interface through which the island search connects the islands of its ring. */
+template <class Solution, class CostStructure>
+class MigrationEndpoint
+{
+public:
+    typedef Mailbox<Solution, CostStructure> MailboxType;
+    virtual void Connect(MailboxType *inbox, MailboxType *outbox) = 0;
+    virtual ~MigrationEndpoint() {}
+};
+
+/** Turns a runner into an island of an IslandSearch: every migration_period
+ iterations the island sends its best state to the next island of the ring
+ (if it has improved since the last migration), and adopts the state received
+ from the previous one if it is better than its current state.
+ @ingroup Solvers
+ */
+template <class BaseRunner>
+class Island
+: public BaseRunner,
+public MigrationEndpoint<typename BaseRunner::SolutionType, typename BaseRunner::CostStructureType>
+{
+public:
+    typedef Mailbox<typename BaseRunner::SolutionType, typename BaseRunner::CostStructureType> MailboxType;
+
+    /** Takes the same arguments of the constructor of the runner. */
+    template <typename... Args>
+    Island(Args &&... args)
+    : BaseRunner(std::forward<Args>(args)...), inbox(nullptr), outbox(nullptr), migrations_adopted(0)
+    {
+        migration_period("migration_period", "Number of iterations between two migrations", this->parameters);
+        migration_period = 1000;
+    }
+
+    void Connect(MailboxType *i, MailboxType *o) override
+    {
+        inbox = i;
+        outbox = o;
+    }
+
+    /** Number of states received from the previous island and adopted in the last run. */
+    unsigned long MigrationsAdopted() const { return migrations_adopted; }
+
+protected:
+    void InitializeRun() override
+    {
+        BaseRunner::InitializeRun();
+        if (migration_period == 0)
+            throw IncorrectParameterValue(migration_period, "should be greater than zero");
+        sent_iteration_of_best = std::numeric_limits<unsigned long>::max();
+        migrations_adopted = 0;
+    }
+
+    void CompleteIteration() override
+    {
+        BaseRunner::CompleteIteration();
+        if (inbox == nullptr || this->iteration % migration_period != 0)
+            return;
+        // only the thread of the island writes its best state, so it can be read without locking
+        if (this->iteration_of_best != sent_iteration_of_best)
+        {
+            outbox->Send(*this->p_best_state, this->best_state_cost);
+            sent_iteration_of_best = this->iteration_of_best;
+        }
+        std::unique_ptr<typename MailboxType::Message> m = inbox->Receive();
+        if (m && m->cost < this->current_state_cost)
+        {
+            *this->p_current_state = m->solution;
+            this->current_state_cost = m->cost;
+            this->UpdateBestState();
+            migrations_adopted++;
+        }
+    }
+
+    Parameter<unsigned int> migration_period;
+    MailboxType *inbox, *outbox;
+    unsigned long sent_iteration_of_best;
+    unsigned long migrations_adopted;
+};
+
+/** The Island Search solver runs its islands concurrently, each one in its
+ own thread and with its own random engine, starting from the same initial
+ state. The islands form a ring along which their best states migrate,
+ through lock-free mailboxes. It is the concurrent counterpart of the
+ Token Ring Search, which passes the state from a runner to the next one.
+
+ The islands run the whole search, so the parameters are those of each
+ runner. The helpers shared by the islands must be thread-safe and draw
+ their random values with Random.
+ @ingroup Solvers
+ */
+template <class Input, class Solution, class CostStructure = DefaultCostStructure<int>>
+class IslandSearch
+: public LocalSearch<Input, Solution, CostStructure>
+{
+public:
+    typedef Runner<Input, Solution, CostStructure> RunnerType;
+    typedef Mailbox<Solution, CostStructure> MailboxType;
+    IslandSearch(const Input &in,
+                 SolutionManager<Input, Solution, CostStructure> &sm,
+                 std::string name);
+    template <class BaseRunner>
+    void AddIsland(Island<BaseRunner> &r);
+    void Print(std::ostream &os = std::cout) const;
+    void ReadParameters(std::istream &is = std::cin, std::ostream &os = std::cout);
+
+protected:
+    void Go();
+    void AtTimeoutExpired();
+    void ResetTimeout();
+    virtual std::shared_ptr<Solution> GetCurrentState() const;
+
+    std::vector<RunnerType *> p_runners; /**< pointers to the managed runners. */
+    std::vector<MigrationEndpoint<Solution, CostStructure> *> p_islands; /**< the same runners, as islands. */
+    std::vector<std::unique_ptr<MailboxType>> mailboxes; /**< mailboxes[i] is the inbox of the i-th island. */
+};
+
+/*************************************************************************
+ * Implementation
+ *************************************************************************/
+
+template <class Input, class Solution, class CostStructure>
+IslandSearch<Input, Solution, CostStructure>::IslandSearch(const Input &in,
+                                                           SolutionManager<Input, Solution, CostStructure> &sm,
+                                                           std::string name)
+: LocalSearch<Input, Solution, CostStructure>(in, sm, name)
+{}
+
+template <class Input, class Solution, class CostStructure>
+void IslandSearch<Input, Solution, CostStructure>::ReadParameters(std::istream &is, std::ostream &os)
+{
+    os << "Island Solver: " << this->name << " parameters" << std::endl;
+    unsigned int i = 0;
+    for (auto &r : p_runners)
+    {
+        os << "Island [" << i++ << "]: " << std::endl;
+        r->ReadParameters(is, os);
+    }
+}
+
+template <class Input, class Solution, class CostStructure>
+void IslandSearch<Input, Solution, CostStructure>::Print(std::ostream &os) const
+{
+    os << "Island Solver: " << this->name << std::endl;
+    unsigned int i = 0;
+    for (const RunnerType *p_r : p_runners)
+    {
+        os << "Island [" << i++ << "]: " << std::endl;
+        p_r->Print(os);
+    }
+    if (p_runners.size() == 0)
+        os << "<no island attached>" << std::endl;
+}
+
+/**
+ Adds an island to the ring, after the last one added.
+
+ @param r the new island
+ */
+template <class Input, class Solution, class CostStructure>
+template <class BaseRunner>
+void IslandSearch<Input, Solution, CostStructure>::AddIsland(Island<BaseRunner> &r)
+{
+    p_runners.push_back(&r);
+    p_islands.push_back(&r);
+}
+
+template <class Input, class Solution, class CostStructure>
+void IslandSearch<Input, Solution, CostStructure>::Go()
+{
+    if (p_runners.size() == 0)
+        // FIXME: add a more specific exception behavior
+        throw std::logic_error("No island set in object " + this->name);
+
+    size_t n = p_runners.size();
+    mailboxes.clear();
+    for (size_t i = 0; i < n; i++)
+        mailboxes.push_back(std::make_unique<MailboxType>());
+    for (size_t i = 0; i < n; i++)
+        p_islands[i]->Connect(mailboxes[i].get(), mailboxes[(i + 1) % n].get());
+
+    // the engines are seeded from the shared one, so that each island is repeatable (until the first migration)
+    std::vector<std::mt19937> generators;
+    for (size_t i = 0; i < n; i++)
+        generators.emplace_back(Random::Uniform<unsigned int>(0, std::numeric_limits<unsigned int>::max()));
+
+    std::vector<Solution> states(n, *this->p_current_state);
+    std::vector<CostStructure> costs(n);
+    std::vector<std::exception_ptr> exceptions(n);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n; i++)
+        threads.emplace_back([this, i, &generators, &states, &costs, &exceptions]() {
+            Random::ThreadGenerator generator(generators[i]);
+            try
+            {
+                costs[i] = p_runners[i]->Go(states[i]);
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+        });
+    for (std::thread &t : threads)
+        t.join();
+    for (size_t i = 0; i < n; i++)
+        p_islands[i]->Connect(nullptr, nullptr);
+    for (size_t i = 0; i < n; i++)
+        if (exceptions[i])
+            std::rethrow_exception(exceptions[i]);
+
+    size_t best = 0;
+    for (size_t i = 1; i < n; i++)
+        if (costs[i] < costs[best])
+            best = i;
+    *this->p_current_state = states[best];
+    this->current_state_cost = costs[best];
+    *this->p_best_state = *this->p_current_state;
+    this->best_state_cost = this->current_state_cost;
+}
+
+template <class Input, class Solution, class CostStructure>
+void IslandSearch<Input, Solution, CostStructure>::AtTimeoutExpired()
+{
+    for (auto &r : this->p_runners)
+        r->Interrupt();
+}
+
+template <class Input, class Solution, class CostStructure>
+void IslandSearch<Input, Solution, CostStructure>::ResetTimeout()
+{
+    Interruptible<int>::ResetTimeout();
+    for (auto &r : this->p_runners)
+        r->ResetTimeout();
+}
+
+template <class Input, class Solution, class CostStructure>
+std::shared_ptr<Solution> IslandSearch<Input, Solution, CostStructure>::GetCurrentState() const
+{
+    std::shared_ptr<Solution> best_state;
+    CostStructure best_cost;
+    for (const RunnerType *p_r : p_runners)
+    {
+        std::shared_ptr<Solution> state = p_r->GetCurrentBestState();
+        CostStructure cost = this->sm.CostFunctionComponents(*state);
+        if (!best_state || cost < best_cost)
+        {
+            best_state = state;
+            best_cost = cost;
+        }
+    }
+    return best_state;
+}
+} // namespace Core
+} // namespace EasyLocal
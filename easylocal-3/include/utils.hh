@@ -6,4 +6,5 @@
 #include "utils/types.hh"
 #include "utils/interruptible.hh"
 #include "utils/parameter.hh"
+#include "utils/serialization.hh"
 
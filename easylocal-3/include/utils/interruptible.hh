@@ -6,6 +6,9 @@
 #include <atomic>
 #include <thread>
 #include <condition_variable>
+#include <functional>
+
+#include "utils/random.hh"
 
 namespace EasyLocal
 {
@@ -48,7 +51,13 @@ public:
   Rtype SyncRun(std::chrono::milliseconds timeout, Args... args)
   {
     timeout_expired = false;
-    std::future<Rtype> result = std::async(std::launch::async, this->MakeFunction(), std::ref(args)...);
+    // the function draws its random values from the engine of the caller, which waits for it
+    std::mt19937* generator = &Random::GetGenerator();
+    std::function<Rtype(Args &...)> f = this->MakeFunction();
+    std::future<Rtype> result = std::async(std::launch::async, [generator, f](Args &... a) -> Rtype {
+      Random::ThreadGenerator thread_generator(*generator);
+      return f(a...);
+    }, std::ref(args)...);
 
     // If timeout is greater than zero
     if (timeout.count() != 0)
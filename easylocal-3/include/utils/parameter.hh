@@ -86,6 +86,12 @@ namespace EasyLocal
     public:
       
       virtual void CopyValue(const AbstractParameter &ap) = 0;
+      
+      /** Keeps the current value (or its absence) as the default one, restored by Reset(). */
+      virtual void KeepAsDefault() = 0;
+      
+      /** Restores the default value kept by KeepAsDefault(), the parameter is not set if there is none. */
+      virtual void Reset() = 0;
     };
     
     /** Exception called whenever a needed parameter hasn't been set. */
@@ -122,6 +128,12 @@ namespace EasyLocal
         OverallParameters().push_back(this);
       }
       
+      /** Destructor, the box leaves the list of the parameter boxes. */
+      ~ParameterBox()
+      {
+        OverallParameters().remove(this);
+      }
+      
       void FromJSON(json parameters)
       {
         for (auto it = parameters.begin(); it != parameters.end(); ++it)
@@ -153,11 +165,10 @@ namespace EasyLocal
       const std::string prefix;
       /** Object to configure boost's parameter parser. */
       boost::program_options::options_description cl_options;
-      /** List of all parameter boxes that have been instantiated. */
-      
+      /** List of all parameter boxes alive in the calling thread: each thread parses its own command line (e.g., the runs of a batch). */
       static std::list<const ParameterBox *>& OverallParameters()
       {
-        static std::list<const ParameterBox*> overall_parameters;
+        static thread_local std::list<const ParameterBox*> overall_parameters;
         return overall_parameters;
       }
     };
@@ -229,6 +240,21 @@ namespace EasyLocal
         this->is_valid = tp.is_valid;
       }
       
+      /** @copydoc AbstractParameter::KeepAsDefault */
+      virtual void KeepAsDefault()
+      {
+        default_value = this->value;
+        default_set = this->is_set;
+      }
+      
+      /** @copydoc AbstractParameter::Reset */
+      virtual void Reset()
+      {
+        if (default_set)
+          this->value = default_value;
+        this->is_set = default_set;
+      }
+      
       /** Implicit cast. */
       operator T() const;
       
@@ -238,6 +264,12 @@ namespace EasyLocal
     protected:
       /** Actual value of the parameter. */
       T value;
+      
+      /** Value restored by Reset(), if default_set. */
+      T default_value;
+      
+      /** True if the parameter has a default value. */
+      bool default_set = false;
     };
     
     template <typename T>
@@ -535,25 +567,19 @@ namespace EasyLocal
         
         ~Parametrized()
         {
-          std::list<Parametrized*> overall_parametrized = OverallParametrized();
-          for (auto it = overall_parametrized.begin(); it != overall_parametrized.end(); ++it)
-          {
-            if (*it == this)
-            {
-              it = overall_parametrized.erase(it);
-              break;
-            }
-          }
+          OverallParametrized().remove(this);
         }
         
+        /** List of the parametrized objects alive in the calling thread. */
         static std::list<Parametrized*>& OverallParametrized()
         {
-          static std::list<Parametrized*> overall_parametrized;
+          static thread_local std::list<Parametrized*> overall_parametrized;
           return overall_parametrized;
         }
       };
       
-      static bool Parse(int argc, const char *argv[], bool check_unregistered = true, bool silent = false)
+      /** Parses the command line into the registered parameters; the unrecognized options and the help message are written on os. */
+      static bool Parse(int argc, const char *argv[], bool check_unregistered = true, bool silent = false, std::ostream &os = std::cout)
       {        
         boost::program_options::options_description cmdline_options(argv[0]);
         boost::program_options::variables_map vm;
@@ -567,10 +593,10 @@ namespace EasyLocal
         
         if (check_unregistered && unrecognized_options.size() > 0)
         {
-          std::cout << "Unrecognized options: ";
+          os << "Unrecognized options: ";
           for (const std::string &o : unrecognized_options)
-            std::cout << o << " ";
-          std::cout << std::endl
+            os << o << " ";
+          os << std::endl
           << "Run " << argv[0] << " --help for the allowed options" << std::endl;
           return false;
         }
@@ -580,7 +606,7 @@ namespace EasyLocal
         
         if (!silent && vm.count("help"))
         {
-          std::cout << cmdline_options << std::endl;
+          os << cmdline_options << std::endl;
           return false;
         }
         return true;
@@ -27,7 +27,7 @@ namespace EasyLocal
       static T Uniform(T a, T b)
       {
         std::uniform_int_distribution<T> d(a, b);
-        return d(GetInstance().g);
+        return d(GetGenerator());
       }
       
       /** Generates an uniform random float in [a, b].
@@ -38,29 +38,70 @@ namespace EasyLocal
       static T Uniform(T a, T b)
       {
         std::uniform_real_distribution<T> d(a, b);
-        return d(GetInstance().g);
+        return d(GetGenerator());
       }
       
-      /** Sets a new seed for the random engine. */
+      /** Sets a new seed for the engine of the calling thread (see GetGenerator). */
       static unsigned int SetSeed(unsigned int seed)
       {
-        Random& r = GetInstance();
-        r.g.seed(seed);
-        return r.seed = seed;
+        GetGenerator().seed(seed);
+        if (ThreadLocalGenerator() != nullptr)
+          return ThreadLocalSeed() = seed;
+        return GetInstance().seed = seed;
       }
       
+      /** The seed of the engine of the calling thread (if it has been set, for a ThreadGenerator). */
       static unsigned int GetSeed()
       {
-        return GetInstance().seed;
+        return ThreadLocalGenerator() != nullptr ? ThreadLocalSeed() : GetInstance().seed;
       }
       
       
+      /** The engine of the calling thread: the shared one, unless a ThreadGenerator is alive in the thread. */
       static std::mt19937& GetGenerator()
       {
-        return GetInstance().g;
+        std::mt19937* g = ThreadLocalGenerator();
+        return g != nullptr ? *g : GetInstance().g;
       }
       
+      /** While an object of this class is alive, the calling thread draws its values from the given engine instead of the shared one.
+       The shared engine is not thread-safe, so the threads that search concurrently (e.g., the replicas of a parallel runner) must have one each.
+       */
+      class ThreadGenerator
+      {
+      public:
+        ThreadGenerator(std::mt19937& g) : previous(ThreadLocalGenerator()), previous_seed(ThreadLocalSeed())
+        {
+          ThreadLocalGenerator() = &g;
+        }
+        
+        ~ThreadGenerator()
+        {
+          ThreadLocalGenerator() = previous;
+          ThreadLocalSeed() = previous_seed;
+        }
+        
+        ThreadGenerator(const ThreadGenerator&) = delete;
+        ThreadGenerator& operator=(const ThreadGenerator&) = delete;
+      private:
+        std::mt19937* previous;
+        unsigned int previous_seed;
+      };
+      
     private:
+      static std::mt19937*& ThreadLocalGenerator()
+      {
+        static thread_local std::mt19937* g = nullptr;
+        return g;
+      }
+      
+      static unsigned int& ThreadLocalSeed()
+      {
+        static thread_local unsigned int seed = 0;
+        return seed;
+      }
+      
+
       static Random& GetInstance() {
         static Random instance;
         return instance;
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace EasyLocal
+{
+
+  namespace Core
+  {
+
+    /** Compact binary serialization of the data of the runners (e.g., for the checkpoints).
+     The values are written with their in-memory representation, so the data can be read back
+     only by the same program on the same architecture. The containers are preceded by their size.
+     @ingroup Utils
+     */
+    namespace Serialization
+    {
+      template <typename T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type* = nullptr>
+      void Write(std::ostream& os, const T& value)
+      {
+        os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+      }
+
+      /** @throw std::runtime_error if the stream ends before the value */
+      template <typename T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type* = nullptr>
+      void Read(std::istream& is, T& value)
+      {
+        if (!is.read(reinterpret_cast<char*>(&value), sizeof(T)))
+          throw std::runtime_error("Serialized data truncated");
+      }
+
+      template <typename T1, typename T2>
+      void Write(std::ostream& os, const std::pair<T1, T2>& value);
+      template <typename T1, typename T2>
+      void Read(std::istream& is, std::pair<T1, T2>& value);
+      template <typename T>
+      void Write(std::ostream& os, const std::vector<T>& values);
+      template <typename T>
+      void Read(std::istream& is, std::vector<T>& values);
+      template <typename T>
+      void Write(std::ostream& os, const std::set<T>& values);
+      template <typename T>
+      void Read(std::istream& is, std::set<T>& values);
+
+      inline void Write(std::ostream& os, const std::string& value)
+      {
+        Write(os, static_cast<uint64_t>(value.size()));
+        os.write(value.data(), value.size());
+      }
+
+      inline void Read(std::istream& is, std::string& value)
+      {
+        uint64_t size;
+        Read(is, size);
+        value.resize(size);
+        if (size > 0 && !is.read(&value[0], size))
+          throw std::runtime_error("Serialized data truncated");
+      }
+
+      inline void Write(std::ostream& os, const std::vector<bool>& values)
+      {
+        Write(os, static_cast<uint64_t>(values.size()));
+        for (size_t i = 0; i < values.size(); i += 8)
+        {
+          uint8_t bits = 0;
+          for (size_t b = 0; b < 8 && i + b < values.size(); b++)
+            bits |= static_cast<uint8_t>(values[i + b]) << b;
+          Write(os, bits);
+        }
+      }
+
+      inline void Read(std::istream& is, std::vector<bool>& values)
+      {
+        uint64_t size;
+        Read(is, size);
+        values.assign(size, false);
+        for (size_t i = 0; i < size; i += 8)
+        {
+          uint8_t bits;
+          Read(is, bits);
+          for (size_t b = 0; b < 8 && i + b < size; b++)
+            values[i + b] = (bits >> b) & 1;
+        }
+      }
+
+      template <typename T1, typename T2>
+      void Write(std::ostream& os, const std::pair<T1, T2>& value)
+      {
+        Write(os, value.first);
+        Write(os, value.second);
+      }
+
+      template <typename T1, typename T2>
+      void Read(std::istream& is, std::pair<T1, T2>& value)
+      {
+        Read(is, value.first);
+        Read(is, value.second);
+      }
+
+      template <typename T>
+      void Write(std::ostream& os, const std::vector<T>& values)
+      {
+        Write(os, static_cast<uint64_t>(values.size()));
+        for (const T& value : values)
+          Write(os, value);
+      }
+
+      template <typename T>
+      void Read(std::istream& is, std::vector<T>& values)
+      {
+        uint64_t size;
+        Read(is, size);
+        values.clear();
+        values.reserve(size);
+        for (uint64_t i = 0; i < size; i++)
+        {
+          T value;
+          Read(is, value);
+          values.push_back(std::move(value));
+        }
+      }
+
+      template <typename T>
+      void Write(std::ostream& os, const std::set<T>& values)
+      {
+        Write(os, static_cast<uint64_t>(values.size()));
+        for (const T& value : values)
+          Write(os, value);
+      }
+
+      template <typename T>
+      void Read(std::istream& is, std::set<T>& values)
+      {
+        uint64_t size;
+        Read(is, size);
+        values.clear();
+        for (uint64_t i = 0; i < size; i++)
+        {
+          T value;
+          Read(is, value);
+          values.insert(values.end(), std::move(value));
+        }
+      }
+    } // namespace Serialization
+  } // namespace Core
+} // namespace EasyLocal
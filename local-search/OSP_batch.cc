@@ -0,0 +1,345 @@
+#include "OSP_batch.hh"
+#include <utils/json.hpp>
+#include <utils/random.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using EasyLocal::Core::Random;
+
+std::string OSP_JsonString(const std::string& text)
+{
+    std::ostringstream os;
+    os << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            os << '\\' << c;
+        }
+        else if (c == '\n')
+        {
+            os << "\\n";
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            os << ' ';
+        }
+        else
+        {
+            os << c;
+        }
+    }
+    os << '"';
+    return os.str();
+}
+
+// the options of a line of the manifest, split on the blanks as by a shell: the text between double or single quotes is a part of a
+// token (an empty one, if nothing else), a backslash outside the single quotes takes the next character as it is
+static std::vector<std::string> ManifestTokens(const std::string& text, int line)
+{
+    std::vector<std::string> tokens;
+    std::string token;
+    bool in_token = false;
+    char quote = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        char c = text[i];
+        if (c == '\\' && quote != '\'' && i + 1 < text.size())
+        {
+            token += text[++i];
+            in_token = true;
+        }
+        else if (quote != 0)
+        {
+            if (c == quote)
+            {
+                quote = 0;
+            }
+            else
+            {
+                token += c;
+            }
+        }
+        else if (c == '"' || c == '\'')
+        {
+            quote = c;
+            in_token = true;
+        }
+        else if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            if (in_token)
+            {
+                tokens.push_back(token);
+                token.clear();
+                in_token = false;
+            }
+        }
+        else
+        {
+            token += c;
+            in_token = true;
+        }
+    }
+    if (quote != 0)
+    {
+        throw std::invalid_argument("Unterminated quote in line " + std::to_string(line) + " of the manifest");
+    }
+    if (in_token)
+    {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+OSP_Batch::OSP_Batch(std::string manifest_file, std::string p)
+    : program(p)
+{
+    std::ifstream is(manifest_file);
+    if (!is)
+    {
+        throw std::invalid_argument("Cannot open the manifest " + manifest_file);
+    }
+    std::string text;
+    for (int line = 1; std::getline(is, text); ++line)
+    {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos || text[first] == '#')
+        {
+            continue;
+        }
+        runs.push_back(ManifestRun{line, ManifestTokens(text, line)});
+    }
+}
+
+static thread_local OSP_WorkerGraphs* current_graphs = nullptr;
+
+OSP_WorkerGraphs::OSP_WorkerGraphs()
+    : active(nullptr), built(0), previous(current_graphs)
+{
+    current_graphs = this;
+}
+
+OSP_WorkerGraphs::~OSP_WorkerGraphs()
+{
+    current_graphs = previous;
+}
+
+OSP_WorkerGraphs* OSP_WorkerGraphs::Current()
+{
+    return current_graphs;
+}
+
+OSP_WorkerGraphs::Entry& OSP_WorkerGraphs::Add(const std::string& key, const std::function<std::unique_ptr<OSP_RunnerGraph>()>& build)
+{
+    std::list<const ParameterBox*>& registered = ParameterBox::OverallParameters();
+    if (active != nullptr)
+    {
+        for (const ParameterBox* box : active->boxes)
+        {
+            registered.remove(box);
+        }
+        active = nullptr;
+    }
+    std::list<const ParameterBox*> before = registered;
+    Entry entry;
+    entry.graph = build();
+    // the boxes of the graph are the new ones, their values after the build are the ones restored at each reuse
+    for (const ParameterBox* box : registered)
+    {
+        if (std::find(before.begin(), before.end(), box) == before.end())
+        {
+            entry.boxes.push_back(box);
+            for (AbstractParameter* p : *box)
+            {
+                p->KeepAsDefault();
+            }
+        }
+    }
+    built++;
+    Entry& added = graphs.emplace(key, std::move(entry)).first->second;
+    active = &added;
+    return added;
+}
+
+void OSP_WorkerGraphs::Activate(Entry& entry)
+{
+    if (active != &entry)
+    {
+        std::list<const ParameterBox*>& registered = ParameterBox::OverallParameters();
+        if (active != nullptr)
+        {
+            for (const ParameterBox* box : active->boxes)
+            {
+                registered.remove(box);
+            }
+        }
+        registered.insert(registered.end(), entry.boxes.begin(), entry.boxes.end());
+        active = &entry;
+    }
+    for (const ParameterBox* box : entry.boxes)
+    {
+        for (AbstractParameter* p : *box)
+        {
+            p->Reset();
+        }
+    }
+}
+
+unsigned int OSP_Batch::Run(const OSP_RunFunction& run, unsigned int workers, std::ostream& results)
+{
+    std::atomic<size_t> next(0);
+    std::atomic<unsigned int> failed(0);
+    std::vector<std::thread> threads;
+    for (unsigned int w = 0; w < std::max(1u, workers); ++w)
+    {
+        threads.emplace_back([this, &run, &results, &next, &failed]()
+        {
+            std::mt19937 engine;
+            Random::ThreadGenerator generator(engine);
+            OSP_WorkerGraphs graphs;
+            for (size_t k = next++; k < runs.size(); k = next++)
+            {
+                const ManifestRun& r = runs[k];
+                std::string output, error;
+                int exit_code = OSP_RunOnWorker(run, program, r.arguments, nullptr, output, error);
+                if (exit_code != 0)
+                {
+                    failed++;
+                }
+                std::lock_guard<std::mutex> lock(results_mutex);
+                results << "{\"line\": " << r.line << ", \"exit_code\": " << exit_code << ", \"result\": " << OSP_JsonResult(output);
+                if (!error.empty())
+                {
+                    results << ", \"error\": " << OSP_JsonString(error);
+                }
+                results << "}" << std::endl;
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    return failed;
+}
+
+int OSP_RunOnWorker(const OSP_RunFunction& run, const std::string& program, const std::vector<std::string>& arguments,
+    const OSP_SharedOutput* solutions, std::string& output, std::string& error)
+{
+    std::vector<const char*> argv = {program.c_str()};
+    for (const std::string& a : arguments)
+    {
+        argv.push_back(a.c_str());
+    }
+    std::ostringstream os, messages;
+    int exit_code;
+    // the explorers of the previous run of the worker are gone, or kept in a runner graph that runs on states of its own
+    OSP_Output::ResetDontLookBitsSets();
+    try
+    {
+        exit_code = run((int) argv.size(), argv.data(), os, messages, solutions);
+    }
+    catch (const std::exception& e)
+    {
+        exit_code = 1;
+        error = e.what();
+    }
+    output = os.str();
+    std::string text = messages.str();
+    text.erase(std::find_if(text.rbegin(), text.rend(), [](char c) { return !std::isspace(static_cast<unsigned char>(c)); }).base(), text.end());
+    if (exit_code != 0 && error.empty())
+    {
+        error = text.empty() ? "The run failed with exit code " + std::to_string(exit_code) : text;
+    }
+    else if (!text.empty())
+    {
+        std::cerr << text << std::endl;
+    }
+    return exit_code;
+}
+
+std::string OSP_JsonResult(const std::string& output)
+{
+    // the line breaks of the output are only spaces between the tokens
+    std::string value = output;
+    std::replace_if(value.begin(), value.end(), [](char c) { return c == '\n' || c == '\r'; }, ' ');
+    value.erase(std::find_if(value.rbegin(), value.rend(), [](char c) { return !std::isspace(static_cast<unsigned char>(c)); }).base(), value.end());
+    if (value.empty())
+    {
+        value = "null";
+    }
+    else if (!nlohmann::json::accept(value))
+    {
+        value = OSP_JsonString(value);
+    }
+    return value;
+}
+
+OSP_Input OSP_InstanceCache::Instance(const std::string& file_name)
+{
+    return *Cached(file_name, [&file_name]() { return std::make_shared<const OSP_Input>(file_name); });
+}
+
+std::string OSP_InstanceCache::InlineInstance(const std::string& text)
+{
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = inline_names.find(text);
+        if (it == inline_names.end())
+        {
+            it = inline_names.emplace(text, "inline:" + std::to_string(inline_names.size() + 1)).first;
+        }
+        name = it->second;
+    }
+    Cached(name, [&text]()
+    {
+        std::istringstream is(text);
+        return std::make_shared<const OSP_Input>(is);
+    });
+    return name;
+}
+
+std::shared_ptr<const OSP_Input> OSP_InstanceCache::Cached(const std::string& name, const std::function<std::shared_ptr<const OSP_Input>()>& read)
+{
+    std::promise<std::shared_ptr<const OSP_Input>> reading;
+    std::shared_future<std::shared_ptr<const OSP_Input>> instance;
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = instances.find(name);
+        if (it == instances.end())
+        {
+            it = instances.emplace(name, reading.get_future().share()).first;
+            first = true;
+        }
+        instance = it->second;
+    }
+    // the instance is read without the lock, the other runs that need it wait for it
+    if (first)
+    {
+        try
+        {
+            reading.set_value(read());
+        }
+        catch (...)
+        {
+            // the runs waiting for it get the error, the next ones read it again
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                instances.erase(name);
+            }
+            reading.set_exception(std::current_exception());
+        }
+    }
+    return instance.get();
+}
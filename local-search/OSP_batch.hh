@@ -0,0 +1,115 @@
+#pragma once
+
+#include "OSP_data.hh"
+#include "OSP_stream.hh"
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// the body of a run: its options (argv[0] is the program), the stream of its output, the stream of its diagnostics (never the standard
+// output, that holds the results of the other runs) and the shared output of its improving solutions (nullptr if they are not sent), it
+// returns the exit code
+typedef std::function<int(int argc, const char* argv[], std::ostream& os, std::ostream& messages, const OSP_SharedOutput* solutions)> OSP_RunFunction;
+
+// runs the body on the calling worker thread, with the options after the program; the output of the run is returned in output, and
+// the message of its exception (if any, the exit code is then 1) in error, otherwise the diagnostics of a failed run. The diagnostics
+// of a run that succeeds (as its warnings) go to the standard error
+int OSP_RunOnWorker(const OSP_RunFunction& run, const std::string& program, const std::vector<std::string>& arguments,
+    const OSP_SharedOutput* solutions, std::string& output, std::string& error);
+// the output of a run as a JSON value (the outputs that are not valid JSON, as the solutions of the constructive methods, become
+// strings; nothing is written if the run has its output file, so it is null)
+std::string OSP_JsonResult(const std::string& output);
+std::string OSP_JsonString(const std::string& text);
+
+// the instances read by the runs of a process: each one is read once, by the first run that asks for it (the others wait for it), and
+// each run gets its copy. The instances that cannot be read are not kept, so a later run tries again
+class OSP_InstanceCache
+{
+public:
+    // a copy of the instance (a run may change it)
+    OSP_Input Instance(const std::string& file_name);
+    // the name under which the text of an instance in the dzn format is cached (the same text has the same name)
+    std::string InlineInstance(const std::string& text);
+private:
+    std::shared_ptr<const OSP_Input> Cached(const std::string& name, const std::function<std::shared_ptr<const OSP_Input>()>& read);
+    std::mutex mutex;
+    std::map<std::string, std::shared_future<std::shared_ptr<const OSP_Input>>> instances;
+    std::map<std::string, std::string> inline_names;
+};
+
+// the objects built by a run to solve an instance with a method (cost components, explorers, runners, solvers and their parameters),
+// kept by the worker for its next runs with the same key
+class OSP_RunnerGraph
+{
+public:
+    virtual ~OSP_RunnerGraph() = default;
+};
+
+// the runner graphs of a worker thread, one for each key (as the instance and the method of the runs): a run builds its graph only if
+// the worker has none with its key, otherwise it takes the one left by a previous run, with the parameters of its boxes back to their
+// values after the build. Only the parameter boxes of the graph in use are registered, so that the graphs can have runners with the
+// same names. The graphs of a worker are installed for its thread while the object is alive, they are destroyed with it
+class OSP_WorkerGraphs
+{
+public:
+    OSP_WorkerGraphs();
+    ~OSP_WorkerGraphs();
+    // the graphs of the calling thread, nullptr if it is not a worker (a run alone builds its own graph)
+    static OSP_WorkerGraphs* Current();
+    // the graph of the key, built by build if there is none yet (a build that throws leaves nothing behind)
+    template <class Graph>
+    Graph& Use(const std::string& key, const std::function<std::unique_ptr<Graph>()>& build);
+    unsigned int Built() const { return built; }
+private:
+    struct Entry
+    {
+        std::unique_ptr<OSP_RunnerGraph> graph;
+        std::vector<const ParameterBox*> boxes; // the ones registered by the build
+    };
+    Entry& Add(const std::string& key, const std::function<std::unique_ptr<OSP_RunnerGraph>()>& build);
+    void Activate(Entry& entry);
+    std::map<std::string, Entry> graphs;
+    Entry* active;
+    unsigned int built;
+    OSP_WorkerGraphs* previous;
+};
+
+template <class Graph>
+Graph& OSP_WorkerGraphs::Use(const std::string& key, const std::function<std::unique_ptr<Graph>()>& build)
+{
+    auto it = graphs.find(key);
+    Entry& entry = it != graphs.end() ? it->second : Add(key, [&build]() -> std::unique_ptr<OSP_RunnerGraph> { return build(); });
+    Activate(entry);
+    return static_cast<Graph&>(*entry.graph);
+}
+
+// batch mode: the runs of a manifest in a single process, on a pool of worker threads. Each line of the manifest holds the command
+// line options of a run (--main::instance, --main::seed, --metaheuristic::method, the parameters of the method, ...; the empty lines
+// and the ones starting with # are skipped), quoted as in a shell when they hold blanks. A free worker takes the next run, so the long runs do not hold the others back; each
+// worker has its own random engine (seeded by each run, so a run gives the same result as alone), its own registry of the
+// parameters and its own runner graphs. The instances are read once and shared by the runs. Each run writes a JSON line on the results, as soon as it ends
+class OSP_Batch
+{
+public:
+    OSP_Batch(std::string manifest_file, std::string program);
+    // runs all the manifest and returns the number of runs failed (with an exit code other than 0 or an exception)
+    unsigned int Run(const OSP_RunFunction& run, unsigned int workers, std::ostream& results);
+    OSP_InstanceCache& Instances() { return instances; }
+    unsigned int Runs() const { return (unsigned int) runs.size(); }
+private:
+    struct ManifestRun
+    {
+        int line; // in the manifest, from 1
+        std::vector<std::string> arguments;
+    };
+    std::string program;
+    std::vector<ManifestRun> runs;
+    OSP_InstanceCache instances;
+    std::mutex results_mutex;
+};
@@ -0,0 +1,309 @@
+#include "OSP_cache.hh"
+
+OSP_DeltaCache::OSP_DeltaCache(size_t size)
+    : mask(0), lookups(0), hits(0)
+{
+    if (size > 0)
+    {
+        size_t rounded_size = 1;
+        while (rounded_size < size)
+        {
+            rounded_size *= 2;
+        }
+        entries = std::vector<Entry>(rounded_size);
+        mask = rounded_size - 1;
+        Clear();
+    }
+}
+
+void OSP_DeltaCache::Clear()
+{
+    for (Entry& entry : entries)
+    {
+        // an empty entry matches only the check ~0 xor the hash of zero words, i.e. practically never
+        entry.check.store(~0ULL, std::memory_order_relaxed);
+        for (std::atomic<int64_t>& word : entry.words)
+        {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void OSP_DeltaCache::ClearCounters()
+{
+    lookups = 0;
+    hits = 0;
+}
+
+uint64_t OSP_DeltaCache::Mix(uint64_t h, uint64_t x)
+{
+    // one round of splitmix64 on the combination
+    x += h * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+bool OSP_DeltaCache::Find(const MoveKey& key, size_t components, DefaultCostStructure<long>& delta) const
+{
+    lookups.fetch_add(1, std::memory_order_relaxed);
+    const Entry& entry = entries[key.index & mask];
+    int64_t words[Words];
+    uint64_t check = entry.check.load(std::memory_order_acquire);
+    uint64_t h = 0;
+    for (int i = 0; i < Words; ++i)
+    {
+        words[i] = entry.words[i].load(std::memory_order_relaxed);
+        h = Mix(h, (uint64_t) words[i]);
+    }
+    if ((check ^ h) != key.check)
+    {
+        return false;
+    }
+    hits.fetch_add(1, std::memory_order_relaxed);
+    delta = DefaultCostStructure<long>(words[0], words[1], words[2], std::vector<long>(words + 3, words + 3 + components));
+    return true;
+}
+
+void OSP_DeltaCache::Insert(const MoveKey& key, const DefaultCostStructure<long>& delta)
+{
+    Entry& entry = entries[key.index & mask];
+    int64_t words[Words] = {};
+    words[0] = delta.total;
+    words[1] = delta.violations;
+    words[2] = delta.objective;
+    for (size_t i = 0; i < delta.all_components.size() && i < (size_t) MaxComponents; ++i)
+    {
+        words[3 + i] = delta.all_components[i];
+    }
+    uint64_t h = 0;
+    for (int i = 0; i < Words; ++i)
+    {
+        entry.words[i].store(words[i], std::memory_order_relaxed);
+        h = Mix(h, (uint64_t) words[i]);
+    }
+    entry.check.store(key.check ^ h, std::memory_order_release);
+}
+
+std::ostream& operator<<(std::ostream& os, const OSP_DeltaCache& c)
+{
+    os << "{\"size\": " << c.entries.size() << ", "
+        << "\"lookups\": " << c.Lookups() << ", "
+        << "\"hits\": " << c.Hits() << ", "
+        << "\"hit_ratio\": " << (c.Lookups() > 0 ? (double) c.Hits() / c.Lookups() : 0.0) << "}";
+    return os;
+}
+
+int AffectedMachines(const OSP_Output& st, const SwapConsecutiveBatchesMove& mv, int machines[])
+{
+    machines[0] = mv.machine;
+    return 1;
+}
+
+int AffectedMachines(const OSP_Output& st, const BatchToNewPositionMove& mv, int machines[])
+{
+    machines[0] = mv.machine;
+    return 1;
+}
+
+int AffectedMachines(const OSP_Output& st, const JobToExistingBatch& mv, int machines[])
+{
+    machines[0] = mv.old_machine;
+    machines[1] = mv.new_machine;
+    return 2;
+}
+
+int AffectedMachines(const OSP_Output& st, const JobToNewBatch& mv, int machines[])
+{
+    machines[0] = mv.old_position.first;
+    machines[1] = mv.new_position.first;
+    return 2;
+}
+
+int AffectedMachines(const OSP_Output& st, const BatchToNewMachine& mv, int machines[])
+{
+    machines[0] = mv.old_machine_position.first;
+    machines[1] = mv.new_machine_position.first;
+    return 2;
+}
+
+int AffectedMachines(const OSP_Output& st, const SwapBatches& mv, int machines[])
+{
+    machines[0] = mv.machine;
+    return 1;
+}
+
+int AffectedMachines(const OSP_Output& st, const InvertBatchesInMachine& mv, int machines[])
+{
+    machines[0] = mv.machine;
+    return 1;
+}
+
+int AffectedMachines(const OSP_Output& st, const SwapJobsBetweenBatches& mv, int machines[])
+{
+    machines[0] = mv.position_1.first;
+    machines[1] = mv.position_2.first;
+    return 2;
+}
+
+int AffectedMachines(const OSP_Output& st, const MergeBatches& mv, int machines[])
+{
+    machines[0] = mv.source_position.first;
+    machines[1] = mv.target_position.first;
+    return 2;
+}
+
+int AffectedMachines(const OSP_Output& st, const SplitBatch& mv, int machines[])
+{
+    machines[0] = mv.position.first;
+    return 1;
+}
+
+int AffectedMachines(const OSP_Output& st, const EjectionChain& mv, int machines[])
+{
+    // the jobs of the chain leave their current machines
+    for (int i = 0; i < mv.length; ++i)
+    {
+        machines[2 * i] = st.GetJobToBatchPosition(mv.jobs[i]).first;
+        machines[2 * i + 1] = mv.targets[i].first;
+    }
+    return 2 * mv.length;
+}
+
+int AffectedMachines(const OSP_Output& st, const ResequenceBatches& mv, int machines[])
+{
+    machines[0] = mv.machine;
+    return 1;
+}
+
+int AffectedMachines(const OSP_Output& st, const RegroupBatches& mv, int machines[])
+{
+    machines[0] = mv.machine;
+    return 1;
+}
+
+int MoveFields(const SwapConsecutiveBatchesMove& mv, int64_t fields[])
+{
+    fields[0] = mv.machine;
+    fields[1] = mv.position_1;
+    fields[2] = mv.position_2;
+    return 3;
+}
+
+int MoveFields(const BatchToNewPositionMove& mv, int64_t fields[])
+{
+    fields[0] = mv.machine;
+    fields[1] = mv.old_position;
+    fields[2] = mv.new_position;
+    return 3;
+}
+
+int MoveFields(const JobToExistingBatch& mv, int64_t fields[])
+{
+    fields[0] = mv.job;
+    fields[1] = mv.old_machine;
+    fields[2] = mv.old_position;
+    fields[3] = mv.new_machine;
+    fields[4] = mv.new_position;
+    return 5;
+}
+
+int MoveFields(const JobToNewBatch& mv, int64_t fields[])
+{
+    fields[0] = mv.job;
+    fields[1] = mv.old_position.first;
+    fields[2] = mv.old_position.second;
+    fields[3] = mv.new_position.first;
+    fields[4] = mv.new_position.second;
+    fields[5] = mv.is_alone;
+    return 6;
+}
+
+int MoveFields(const BatchToNewMachine& mv, int64_t fields[])
+{
+    fields[0] = (int64_t) mv.jobs_to_move;
+    fields[1] = mv.window_start;
+    fields[2] = mv.old_machine_position.first;
+    fields[3] = mv.old_machine_position.second;
+    fields[4] = mv.new_machine_position.first;
+    fields[5] = mv.new_machine_position.second;
+    return 6;
+}
+
+int MoveFields(const SwapBatches& mv, int64_t fields[])
+{
+    fields[0] = mv.machine;
+    fields[1] = mv.position_1;
+    fields[2] = mv.position_2;
+    return 3;
+}
+
+int MoveFields(const InvertBatchesInMachine& mv, int64_t fields[])
+{
+    fields[0] = mv.machine;
+    fields[1] = mv.position_1;
+    fields[2] = mv.position_2;
+    return 3;
+}
+
+int MoveFields(const SwapJobsBetweenBatches& mv, int64_t fields[])
+{
+    fields[0] = mv.job_1;
+    fields[1] = mv.position_1.first;
+    fields[2] = mv.position_1.second;
+    fields[3] = mv.job_2;
+    fields[4] = mv.position_2.first;
+    fields[5] = mv.position_2.second;
+    return 6;
+}
+
+int MoveFields(const MergeBatches& mv, int64_t fields[])
+{
+    fields[0] = mv.source_position.first;
+    fields[1] = mv.source_position.second;
+    fields[2] = mv.target_position.first;
+    fields[3] = mv.target_position.second;
+    return 4;
+}
+
+int MoveFields(const SplitBatch& mv, int64_t fields[])
+{
+    fields[0] = mv.position.first;
+    fields[1] = mv.position.second;
+    fields[2] = mv.split;
+    return 3;
+}
+
+int MoveFields(const EjectionChain& mv, int64_t fields[])
+{
+    // only the links of the chain, the entries past its length are not initialized
+    static_assert(1 + 3 * EjectionChain::MaxLength <= max_move_fields, "the fields of a chain fit");
+    fields[0] = mv.length;
+    for (int i = 0; i < mv.length; ++i)
+    {
+        fields[1 + 3 * i] = mv.jobs[i];
+        fields[2 + 3 * i] = mv.targets[i].first;
+        fields[3 + 3 * i] = mv.targets[i].second;
+    }
+    return 1 + 3 * mv.length;
+}
+
+int MoveFields(const ResequenceBatches& mv, int64_t fields[])
+{
+    fields[0] = mv.machine;
+    fields[1] = mv.first;
+    fields[2] = mv.length;
+    for (int i = 0; i < mv.length; ++i)
+    {
+        fields[3 + i] = mv.order[i];
+    }
+    return 3 + mv.length;
+}
+
+int MoveFields(const RegroupBatches& mv, int64_t fields[])
+{
+    fields[0] = mv.machine;
+    fields[1] = mv.first;
+    fields[2] = mv.length;
+    return 3;
+}
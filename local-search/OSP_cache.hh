@@ -0,0 +1,146 @@
+#pragma once
+
+#include "OSP_helpers.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <typeinfo>
+#include <vector>
+
+// bounded table from (move, fingerprints of the machines changed by the move) to the delta cost of the move: the cost of a machine
+// depends only on its batch sequence, so the same move on the same machine schedules has the same delta. The table is direct mapped
+// and lock free: an entry is written word by word together with a checksum, so a torn entry is read as a miss.
+// The keys are not stored in full: a key is two independent 64-bit hashes, one chooses the entry and the other one is checked on a
+// hit, so two different keys are confused with probability about 2^-64 per lookup. The fingerprints of the machines are 64-bit
+// hashes of their schedules too, so two different schedules are confused with about the same probability; the risk is accepted
+class OSP_DeltaCache
+{
+    // prints lookups, hits and hit ratio as a JSON object
+    friend std::ostream& operator<<(std::ostream& os, const OSP_DeltaCache& c);
+public:
+    static constexpr int MaxComponents = 4; // the deltas with more cost components are not cached
+    struct MoveKey
+    {
+        uint64_t index; // chooses the entry
+        uint64_t check; // compared on a hit
+    };
+    OSP_DeltaCache(size_t size); // the size is rounded up to a power of 2, 0 = no cache
+    bool Enabled() const { return !entries.empty(); }
+    bool Find(const MoveKey& key, size_t components, DefaultCostStructure<long>& delta) const;
+    void Insert(const MoveKey& key, const DefaultCostStructure<long>& delta);
+    void Clear(); // empties the entries, when the jobs change their meaning (the windows of the rolling horizon)
+    void ClearCounters(); // the lookups and hits start again from 0 (a new run of a kept runner graph)
+    unsigned long Lookups() const { return lookups; }
+    unsigned long Hits() const { return hits; }
+
+    // the key of a move is made of the neighborhood, the fields of the move (see MoveFields) and the fingerprints of the machines
+    // it changes
+    template <class Move>
+    static MoveKey Key(const OSP_Output& st, const Move& mv, uint64_t neighborhood);
+private:
+    static constexpr int Words = 3 + MaxComponents; // total, violations, objective and the components
+    struct alignas(64) Entry
+    {
+        std::atomic<uint64_t> check; // check of the key xor the hash of the words
+        std::atomic<int64_t> words[Words];
+    };
+    static uint64_t Mix(uint64_t h, uint64_t x);
+    std::vector<Entry> entries;
+    uint64_t mask;
+    mutable std::atomic<unsigned long> lookups, hits;
+};
+
+// machines whose schedule is changed by a move (with repetitions), at most max_affected_machines
+const int max_affected_machines = 2 * EjectionChain::MaxLength;
+int AffectedMachines(const OSP_Output& st, const SwapConsecutiveBatchesMove& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const BatchToNewPositionMove& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const JobToExistingBatch& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const JobToNewBatch& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const BatchToNewMachine& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const SwapBatches& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const InvertBatchesInMachine& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const SwapJobsBetweenBatches& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const MergeBatches& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const SplitBatch& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const EjectionChain& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const ResequenceBatches& mv, int machines[]);
+int AffectedMachines(const OSP_Output& st, const RegroupBatches& mv, int machines[]);
+
+// fields that make the delta of a move on given machine schedules (the padding and the unused entries of the arrays are left
+// out), at most max_move_fields
+const int max_move_fields = 3 + ResequenceBatches::MaxLength;
+int MoveFields(const SwapConsecutiveBatchesMove& mv, int64_t fields[]);
+int MoveFields(const BatchToNewPositionMove& mv, int64_t fields[]);
+int MoveFields(const JobToExistingBatch& mv, int64_t fields[]);
+int MoveFields(const JobToNewBatch& mv, int64_t fields[]);
+int MoveFields(const BatchToNewMachine& mv, int64_t fields[]);
+int MoveFields(const SwapBatches& mv, int64_t fields[]);
+int MoveFields(const InvertBatchesInMachine& mv, int64_t fields[]);
+int MoveFields(const SwapJobsBetweenBatches& mv, int64_t fields[]);
+int MoveFields(const MergeBatches& mv, int64_t fields[]);
+int MoveFields(const SplitBatch& mv, int64_t fields[]);
+int MoveFields(const EjectionChain& mv, int64_t fields[]);
+int MoveFields(const ResequenceBatches& mv, int64_t fields[]);
+int MoveFields(const RegroupBatches& mv, int64_t fields[]);
+
+template <class Move>
+OSP_DeltaCache::MoveKey OSP_DeltaCache::Key(const OSP_Output& st, const Move& mv, uint64_t neighborhood)
+{
+    // the two hashes differ by their seeds
+    MoveKey key = {Mix(0, neighborhood), Mix(0x5851F42D4C957F2DULL, neighborhood)};
+    int64_t fields[max_move_fields];
+    int n = MoveFields(mv, fields);
+    for (int i = 0; i < n; ++i)
+    {
+        key.index = Mix(key.index, (uint64_t) fields[i]);
+        key.check = Mix(key.check, (uint64_t) fields[i]);
+    }
+    int machines[max_affected_machines];
+    n = AffectedMachines(st, mv, machines);
+    for (int i = 0; i < n; ++i)
+    {
+        key.index = Mix(key.index, st.GetMachineFingerprint(machines[i]));
+        key.check = Mix(key.check, st.GetMachineFingerprint(machines[i]));
+    }
+    return key;
+}
+
+// the explorers that evaluate their moves through an OSP_DeltaCache (none if the cache is null)
+class OSP_CachedEvaluation
+{
+public:
+    void SetDeltaCache(OSP_DeltaCache* c) { delta_cache = c; }
+protected:
+    OSP_CachedEvaluation() : delta_cache(nullptr) {}
+    OSP_DeltaCache* delta_cache;
+};
+
+// wraps an OSP neighborhood explorer and looks up the delta costs in an OSP_DeltaCache before evaluating the moves
+template <class BaseNeighborhoodExplorer>
+class OSP_CachedNeighborhoodExplorer : public BaseNeighborhoodExplorer, public OSP_CachedEvaluation
+{
+public:
+    typedef typename BaseNeighborhoodExplorer::MoveType MoveType;
+    OSP_CachedNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm)
+        : BaseNeighborhoodExplorer(pin, psm) {}
+
+    DefaultCostStructure<long> DeltaCostFunctionComponents(const OSP_Output& st, const MoveType& mv, const std::vector<double>& weights = std::vector<double>(0)) const override
+    {
+        // the weighted deltas are not cached, the weights may change along the run
+        if (delta_cache == nullptr || !delta_cache->Enabled() || !weights.empty() || this->sm.CostComponents() > OSP_DeltaCache::MaxComponents)
+        {
+            return BaseNeighborhoodExplorer::DeltaCostFunctionComponents(st, mv, weights);
+        }
+        OSP_DeltaCache::MoveKey key = OSP_DeltaCache::Key(st, mv, typeid(BaseNeighborhoodExplorer).hash_code());
+        DefaultCostStructure<long> delta;
+        if (delta_cache->Find(key, this->sm.CostComponents(), delta))
+        {
+            return delta;
+        }
+        delta = BaseNeighborhoodExplorer::DeltaCostFunctionComponents(st, mv, weights);
+        delta_cache->Insert(key, delta);
+        return delta;
+    }
+};
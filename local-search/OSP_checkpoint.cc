@@ -0,0 +1,128 @@
+#include "OSP_checkpoint.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+OSP_Checkpointer::OSP_Checkpointer(std::string f_n, const OSP_Input& i, unsigned long p, bool r)
+    : file_name(f_n), in(i), period(p), resume(r), closing(false), written(0)
+{
+    writer = std::thread(&OSP_Checkpointer::Write, this);
+}
+
+OSP_Checkpointer::~OSP_Checkpointer()
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        closing = true;
+    }
+    pending_set.notify_one();
+    writer.join();
+}
+
+void OSP_Checkpointer::Save(const std::string& runner, const std::string& data, const OSP_Output& current, const OSP_Output& best)
+{
+    // the copy is made outside the lock, the writer may be busy with the previous snapshot meanwhile
+    std::unique_ptr<Snapshot> snapshot(new Snapshot{runner, data, current, best});
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending = std::move(snapshot);
+    }
+    pending_set.notify_one();
+}
+
+bool OSP_Checkpointer::Load(const std::string& runner, std::string& data, OSP_Output& current, OSP_Output& best)
+{
+    if (!resume)
+    {
+        return false;
+    }
+    // a checkpoint is resumed only once, by the first run
+    resume = false;
+    std::ifstream is(file_name, std::ios::binary);
+    if (!is)
+    {
+        return false;
+    }
+    uint32_t magic, version;
+    int jobs, machines, attributes, horizon;
+    std::string checkpoint_runner;
+    Serialization::Read(is, magic);
+    Serialization::Read(is, version);
+    if (magic != Magic || version != Version)
+    {
+        throw std::invalid_argument("The file " + file_name + " is not a checkpoint of this program");
+    }
+    Serialization::Read(is, jobs);
+    Serialization::Read(is, machines);
+    Serialization::Read(is, attributes);
+    Serialization::Read(is, horizon);
+    if (jobs != in.Jobs() || machines != in.Machines() || attributes != in.Attributes() || horizon != in.Horizon())
+    {
+        throw std::invalid_argument("The checkpoint " + file_name + " is of another instance");
+    }
+    Serialization::Read(is, checkpoint_runner);
+    if (checkpoint_runner != runner)
+    {
+        throw std::invalid_argument("The checkpoint " + file_name + " is of method " + checkpoint_runner + ", not of " + runner);
+    }
+    Serialization::Read(is, data);
+    current.Read(is);
+    best.Read(is);
+    return true;
+}
+
+void OSP_Checkpointer::Write()
+{
+    while (true)
+    {
+        std::unique_ptr<Snapshot> snapshot;
+        bool last;
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex);
+            pending_set.wait(lock, [this]() { return closing || pending; });
+            snapshot = std::move(pending);
+            last = closing;
+        }
+        if (snapshot)
+        {
+            WriteSnapshot(*snapshot);
+        }
+        if (last)
+        {
+            return;
+        }
+    }
+}
+
+void OSP_Checkpointer::WriteSnapshot(const Snapshot& s)
+{
+    // the writer cannot throw, a failed checkpoint leaves the previous one in place
+    std::string temporary_file_name = file_name + ".tmp";
+    {
+        std::ofstream os(temporary_file_name, std::ios::binary | std::ios::trunc);
+        Serialization::Write(os, Magic);
+        Serialization::Write(os, Version);
+        Serialization::Write(os, in.Jobs());
+        Serialization::Write(os, in.Machines());
+        Serialization::Write(os, in.Attributes());
+        Serialization::Write(os, in.Horizon());
+        Serialization::Write(os, s.runner);
+        Serialization::Write(os, s.data);
+        s.current.Write(os);
+        s.best.Write(os);
+        os.flush();
+        if (!os)
+        {
+            std::cerr << "Error: cannot write the checkpoint " << temporary_file_name << std::endl;
+            return;
+        }
+    }
+    if (std::rename(temporary_file_name.c_str(), file_name.c_str()) != 0)
+    {
+        std::cerr << "Error: cannot replace the checkpoint " << file_name << std::endl;
+        return;
+    }
+    written++;
+}
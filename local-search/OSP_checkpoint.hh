@@ -0,0 +1,46 @@
+#pragma once
+
+#include "OSP_helpers.hh"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// checkpoints of a run in a binary file. The runner hands its data and its states, which are only copied (the snapshot), then a
+// background thread writes them to a temporary file and renames it over the checkpoint, so that the file always holds a whole
+// checkpoint. A snapshot still to be written when the next one arrives is replaced by it
+class OSP_Checkpointer : public RunnerCheckpointer<OSP_Input,OSP_Output,DefaultCostStructure<long>>
+{
+public:
+    // resume: the run continues from the checkpoint in the file, if it exists (so the same command line serves the first run and
+    // the restarted ones), otherwise it starts from scratch
+    OSP_Checkpointer(std::string file_name, const OSP_Input& in, unsigned long period, bool resume);
+    ~OSP_Checkpointer(); // writes the pending snapshot
+    unsigned long Period() const override { return period; }
+    void Save(const std::string& runner, const std::string& data, const OSP_Output& current, const OSP_Output& best) override;
+    bool Load(const std::string& runner, std::string& data, OSP_Output& current, OSP_Output& best) override;
+    unsigned long Written() const { return written; }
+private:
+    struct Snapshot
+    {
+        std::string runner;
+        std::string data;
+        OSP_Output current, best;
+    };
+    void Write(); // body of the writer thread
+    void WriteSnapshot(const Snapshot& s);
+    static constexpr uint32_t Magic = 0x4f535043; // "OSPC"
+    static constexpr uint32_t Version = 1;
+    std::string file_name;
+    const OSP_Input& in;
+    unsigned long period;
+    bool resume;
+    std::unique_ptr<Snapshot> pending;
+    std::mutex pending_mutex;
+    std::condition_variable pending_set;
+    bool closing;
+    unsigned long written; // touched only by the writer thread (and read after it has been joined)
+    std::thread writer;
+};
@@ -1,11 +1,174 @@
 #include "OSP_data.hh"
+#include <utils/serialization.hh>
 
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <fstream>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <tuple>
 #include <cassert>
 
+namespace Serialization = EasyLocal::Core::Serialization;
+
+// the text between name= and the following ; in a file in the format of the instances, false if there is no such entry
+static bool DznEntry(const std::string& text, const std::string& name, std::string& value)
+{
+    for (size_t k = text.find(name); k != std::string::npos; k = text.find(name, k + 1))
+    {
+        // the name must be a whole one (latest_end is also the end of changed_latest_end)
+        size_t equal = text.find_first_not_of(" \t", k + name.size());
+        if ((k > 0 && (std::isalnum((unsigned char) text[k - 1]) || text[k - 1] == '_')) || equal == std::string::npos || text[equal] != '=')
+        {
+            continue;
+        }
+        size_t end = text.find(';', equal);
+        value = text.substr(equal + 1, end == std::string::npos ? std::string::npos : end - equal - 1);
+        return true;
+    }
+    return false;
+}
+
+// the integers of an entry (of its sets, separated by the closing braces)
+static std::vector<int> DznIntegers(const std::string& value)
+{
+    std::vector<int> integers;
+    const char* p = value.c_str();
+    while (*p != '\0')
+    {
+        if (std::isdigit((unsigned char) *p) || (*p == '-' && std::isdigit((unsigned char) p[1])))
+        {
+            char* end;
+            integers.push_back((int) std::strtol(p, &end, 10));
+            p = end;
+        }
+        else
+        {
+            ++p;
+        }
+    }
+    return integers;
+}
+
+static std::vector<std::set<int>> DznSets(const std::string& value)
+{
+    std::vector<std::set<int>> sets;
+    size_t begin = value.find('{');
+    while (begin != std::string::npos)
+    {
+        size_t end = value.find('}', begin);
+        std::vector<int> integers = DznIntegers(value.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+        sets.push_back(std::set<int>(integers.begin(), integers.end()));
+        begin = end == std::string::npos ? end : value.find('{', end);
+    }
+    return sets;
+}
+
+OSP_InstanceDelta::OSP_InstanceDelta(std::string file_name)
+{
+    std::ifstream is(file_name);
+    if (!is)
+    {
+        throw std::invalid_argument("Cannot open instance delta file " + file_name);
+    }
+    std::stringstream buffer;
+    buffer << is.rdbuf();
+    std::string text = buffer.str(), value;
+    if (DznEntry(text, "removed_jobs", value))
+    {
+        for (int j : DznIntegers(value))
+        {
+            removed_jobs.push_back(j - 1);
+        }
+    }
+    std::vector<int> changed_jobs, changed_latest_end;
+    if (DznEntry(text, "changed_jobs", value))
+    {
+        changed_jobs = DznIntegers(value);
+    }
+    if (DznEntry(text, "changed_latest_end", value))
+    {
+        changed_latest_end = DznIntegers(value);
+    }
+    if (changed_jobs.size() != changed_latest_end.size())
+    {
+        throw std::invalid_argument("The changed jobs and their latest ends differ in number in " + file_name);
+    }
+    for (size_t k = 0; k < changed_jobs.size(); ++k)
+    {
+        changed_latest_ends.push_back(std::make_pair(changed_jobs[k] - 1, changed_latest_end[k]));
+    }
+    if (!DznEntry(text, "added_jobs", value))
+    {
+        return;
+    }
+    std::vector<int> added = DznIntegers(value);
+    added_jobs.resize(added.empty() ? 0 : std::max(added[0], 0));
+    // each field of the added jobs, with the offset of the indices from 1
+    auto read_field = [&](const std::string& name, int Job::*field, int offset)
+    {
+        std::vector<int> values;
+        if (DznEntry(text, name, value))
+        {
+            values = DznIntegers(value);
+        }
+        if (values.size() != added_jobs.size())
+        {
+            throw std::invalid_argument("The entry " + name + " does not have a value for each added job in " + file_name);
+        }
+        for (size_t k = 0; k < added_jobs.size(); ++k)
+        {
+            added_jobs[k].*field = values[k] - offset;
+        }
+    };
+    read_field("earliest_start", &Job::earliest_start, 0);
+    read_field("latest_end", &Job::latest_end, 0);
+    read_field("min_time", &Job::min_time, 0);
+    read_field("max_time", &Job::max_time, 0);
+    read_field("size", &Job::size, 0);
+    read_field("attribute", &Job::attribute, 1);
+    std::vector<std::set<int>> eligible_machines;
+    if (DznEntry(text, "eligible_machine", value))
+    {
+        eligible_machines = DznSets(value);
+    }
+    if (eligible_machines.size() != added_jobs.size())
+    {
+        throw std::invalid_argument("The entry eligible_machine does not have a value for each added job in " + file_name);
+    }
+    for (size_t k = 0; k < added_jobs.size(); ++k)
+    {
+        for (int m : eligible_machines[k])
+        {
+            added_jobs[k].eligible_machines.insert(m - 1);
+        }
+    }
+}
+
+std::vector<int> OSP_InstanceDelta::NewJobIndices(int jobs) const
+{
+    std::vector<int> new_index(jobs, 0);
+    for (int j : removed_jobs)
+    {
+        if (j < 0 || j >= jobs)
+        {
+            throw std::invalid_argument("Removed job " + std::to_string(j + 1) + " is not a job of the instance");
+        }
+        new_index[j] = -1;
+    }
+    int kept = 0;
+    for (int j = 0; j < jobs; ++j)
+    {
+        if (new_index[j] != -1)
+        {
+            new_index[j] = kept++;
+        }
+    }
+    return new_index;
+}
+
 OSP_Input::OSP_Input(std::string file_name)
 {
     FileFormat ff = FindFileFormat(file_name);
@@ -17,6 +180,247 @@ OSP_Input::OSP_Input(std::string file_name)
     {
         throw std::invalid_argument("Method not implemented for file " + file_name);
     }
+    ComputeLowerBounds();
+}
+
+OSP_Input::OSP_Input(std::istream& is)
+{
+    ReadDznFormat(is);
+    ComputeLowerBounds();
+}
+
+OSP_Input::OSP_Input(const OSP_Input& in, const std::vector<int>& part_jobs, const std::vector<int>& part_machines, const std::vector<int>& ready_times, const std::vector<int>& states)
+    : OSP_Input(in)
+{
+    jobs = (int) part_jobs.size();
+    machines = (int) part_machines.size();
+    initial_state = states;
+    std::vector<int> machine_index(in.machines, -1);
+    min_cap.resize(machines);
+    max_cap.resize(machines);
+    m_a_s.resize(machines);
+    m_a_e.resize(machines);
+    for (int m = 0; m < machines; ++m)
+    {
+        int machine = part_machines[m];
+        machine_index[machine] = m;
+        min_cap[m] = in.min_cap[machine];
+        max_cap[m] = in.max_cap[machine];
+        m_a_e[m] = in.m_a_e[machine];
+        // the intervals keep their number and their ends, their starts move to the ready time: a batch starts at least a setup
+        // after both, as after the busy part of the machine (the intervals already ended become empty)
+        for (int s = 0; s < intervals; ++s)
+        {
+            m_a_s[m][s] = std::min(std::max(in.m_a_s[machine][s], ready_times[m]), in.m_a_e[machine][s]);
+        }
+    }
+    eligible_machine_set.assign(jobs, std::set<int>());
+    eligible_machine_matrix.assign(machines, std::vector<bool>(jobs, false));
+    earliest_start.resize(jobs);
+    latest_end.resize(jobs);
+    min_time.resize(jobs);
+    max_time.resize(jobs);
+    size.resize(jobs);
+    attribute.resize(jobs);
+    for (int j = 0; j < jobs; ++j)
+    {
+        int job = part_jobs[j];
+        for (int machine : in.eligible_machine_set[job])
+        {
+            if (machine_index[machine] != -1)
+            {
+                eligible_machine_set[j].insert(machine_index[machine]);
+                eligible_machine_matrix[machine_index[machine]][j] = true;
+            }
+        }
+        earliest_start[j] = in.earliest_start[job];
+        latest_end[j] = in.latest_end[job];
+        min_time[j] = in.min_time[job];
+        max_time[j] = in.max_time[job];
+        size[j] = in.size[job];
+        attribute[j] = in.attribute[job];
+    }
+    ComputeLowerBounds();
+}
+
+OSP_Input::OSP_Input(const OSP_Input& in, const OSP_InstanceDelta& delta)
+    : OSP_Input(in)
+{
+    std::vector<int> new_index = delta.NewJobIndices(in.jobs);
+    jobs = (int) (std::count_if(new_index.begin(), new_index.end(), [](int j) { return j != -1; }) + delta.added_jobs.size());
+    eligible_machine_set.assign(jobs, std::set<int>());
+    earliest_start.resize(jobs);
+    latest_end.resize(jobs);
+    min_time.resize(jobs);
+    max_time.resize(jobs);
+    size.resize(jobs);
+    attribute.resize(jobs);
+    for (int job = 0; job < in.jobs; ++job)
+    {
+        int j = new_index[job];
+        if (j != -1)
+        {
+            eligible_machine_set[j] = in.eligible_machine_set[job];
+            earliest_start[j] = in.earliest_start[job];
+            latest_end[j] = in.latest_end[job];
+            min_time[j] = in.min_time[job];
+            max_time[j] = in.max_time[job];
+            size[j] = in.size[job];
+            attribute[j] = in.attribute[job];
+        }
+    }
+    int j = jobs - (int) delta.added_jobs.size();
+    for (const OSP_InstanceDelta::Job& job : delta.added_jobs)
+    {
+        if (job.eligible_machines.empty() || *job.eligible_machines.begin() < 0 || *job.eligible_machines.rbegin() >= machines
+            || job.attribute < 0 || job.attribute >= attributes || job.min_time > job.max_time || job.size < 0)
+        {
+            throw std::invalid_argument("Added job " + std::to_string(j + 1) + " is not valid for the instance");
+        }
+        eligible_machine_set[j] = job.eligible_machines;
+        earliest_start[j] = job.earliest_start;
+        latest_end[j] = job.latest_end;
+        min_time[j] = job.min_time;
+        max_time[j] = job.max_time;
+        size[j] = job.size;
+        attribute[j] = job.attribute;
+        ++j;
+    }
+    for (const std::pair<int,int>& change : delta.changed_latest_ends)
+    {
+        if (change.first < 0 || change.first >= in.jobs || new_index[change.first] == -1)
+        {
+            throw std::invalid_argument("Changed job " + std::to_string(change.first + 1) + " is not a job of the instance");
+        }
+        latest_end[new_index[change.first]] = change.second;
+    }
+    eligible_machine_matrix.assign(machines, std::vector<bool>(jobs, false));
+    for (int k = 0; k < jobs; ++k)
+    {
+        for (int m : eligible_machine_set[k])
+        {
+            eligible_machine_matrix[m][k] = true;
+        }
+    }
+    // the bound of the instance files is the one of the jobs (rounded up in some use cases), it follows the jobs keeping the rounding
+    upper_bound_integer_objective += JobsUpperBound() - in.JobsUpperBound();
+    ComputeLowerBounds();
+}
+
+long OSP_Input::JobsUpperBound() const
+{
+    long max_setup_cost = 0, processing_time = 0;
+    for (const std::vector<int>& costs : setup_costs)
+    {
+        max_setup_cost = std::max(max_setup_cost, (long) *std::max_element(costs.begin(), costs.end()));
+    }
+    for (int j = 0; j < jobs; ++j)
+    {
+        processing_time += min_time[j];
+    }
+    return mult_factor_total_runtime * processing_time + (mult_factor_finished_toolate + mult_factor_total_setupcosts * max_setup_cost) * jobs;
+}
+
+long OSP_Input::LowerBoundObjective() const
+{
+    return mult_factor_total_setupcosts * lower_bound_setup_cost + mult_factor_finished_toolate * lower_bound_tardy_jobs
+        + mult_factor_total_runtime * lower_bound_processing_time;
+}
+
+void OSP_Input::ComputeLowerBounds()
+{
+    // the states a machine can be in before a batch: the attributes of the jobs and the initial states
+    std::vector<std::vector<int>> attribute_jobs(attributes);
+    for (int j = 0; j < jobs; ++j)
+    {
+        attribute_jobs[attribute[j]].push_back(j);
+    }
+    std::vector<bool> state(attributes, false), initial(attributes, false);
+    for (int a = 0; a < attributes; ++a)
+    {
+        state[a] = !attribute_jobs[a].empty();
+    }
+    for (int m = 0; m < machines; ++m)
+    {
+        state[initial_state[m]] = initial[initial_state[m]] = true;
+    }
+
+    lower_bound_setup_cost = 0;
+    lower_bound_processing_time = 0;
+    std::vector<int> min_setup_time(attributes, 0);
+    for (int a = 0; a < attributes; ++a)
+    {
+        if (attribute_jobs[a].empty())
+        {
+            continue;
+        }
+        // the batches of the attribute hold at most the largest capacity of their machines; the jobs split among the batches at will,
+        // in order of decreasing time, give the least batches and processing time
+        int capacity = 1;
+        for (int j : attribute_jobs[a])
+        {
+            for (int m : eligible_machine_set[j])
+            {
+                capacity = std::max(capacity, max_cap[m]);
+            }
+        }
+        std::vector<int>& sorted_jobs = attribute_jobs[a];
+        std::sort(sorted_jobs.begin(), sorted_jobs.end(), [this](int j1, int j2) { return min_time[j1] > min_time[j2]; });
+        long batches = 1, space = capacity;
+        lower_bound_processing_time += min_time[sorted_jobs[0]];
+        for (int j : sorted_jobs)
+        {
+            long left = size[j];
+            while (left > space)
+            {
+                left -= space;
+                space = capacity;
+                batches++;
+                lower_bound_processing_time += min_time[j];
+            }
+            space -= left;
+        }
+        // each batch comes after a state, and the first one of the attribute on its machine after another attribute or an initial state
+        int min_cost = std::numeric_limits<int>::max(), min_first_cost = std::numeric_limits<int>::max();
+        min_setup_time[a] = std::numeric_limits<int>::max();
+        for (int p = 0; p < attributes; ++p)
+        {
+            if (state[p])
+            {
+                min_cost = std::min(min_cost, setup_costs[p][a]);
+                min_setup_time[a] = std::min(min_setup_time[a], setup_times[p][a]);
+                if (p != a || initial[p])
+                {
+                    min_first_cost = std::min(min_first_cost, setup_costs[p][a]);
+                }
+            }
+        }
+        lower_bound_setup_cost += min_first_cost + (batches - 1) * min_cost;
+    }
+
+    // a job is tardy (or not scheduled) if alone, after the least setup, it ends late on all its machines
+    lower_bound_tardy_jobs = 0;
+    for (int j = 0; j < jobs; ++j)
+    {
+        int setup_time = min_setup_time[attribute[j]], earliest_end = horizon + 1;
+        for (int m : eligible_machine_set[j])
+        {
+            int start = std::max(earliest_start[j], setup_time);
+            for (int s = 0; s < intervals; ++s)
+            {
+                start = std::max(start, m_a_s[m][s] + setup_time);
+                if (start + min_time[j] <= m_a_e[m][s])
+                {
+                    earliest_end = std::min(earliest_end, start + min_time[j]);
+                    break;
+                }
+            }
+        }
+        if (earliest_end > latest_end[j])
+        {
+            lower_bound_tardy_jobs++;
+        }
+    }
 }
 
 FileFormat OSP_Input::FindFileFormat(std::string file_name) const
@@ -39,16 +443,20 @@ FileFormat OSP_Input::FindFileFormat(std::string file_name) const
 
 void OSP_Input::ReadDznFormat(std::string file_name)
 {
-    const int LEN = 256;
-    std::string tmp_str;
-    char tmp_char;
-    int tmp_int;
-        
     std::ifstream is(file_name);
     if (!is)
     {
         throw std::invalid_argument("Cannot open instance file " + file_name);
     }
+    ReadDznFormat(is);
+}
+
+void OSP_Input::ReadDznFormat(std::istream& is)
+{
+    const int LEN = 256;
+    std::string tmp_str;
+    char tmp_char;
+    int tmp_int;
     
     is.ignore(LEN,'=');
     is >> horizon;
@@ -395,8 +803,10 @@ void OSP_Input::ReadDznFormat(std::string file_name)
 //    std::cout << "running time bound: " << running_time_bound << std::endl;
 // #endif
     
-    is.close();
-    
+    if (!is)
+    {
+        throw std::invalid_argument("The instance is not complete, or not in the dzn format");
+    }
 }
 
 std::ostream& operator<<(std::ostream& os, const OSP_Input& in)
@@ -469,6 +879,12 @@ batches_per_machine(in.Machines(), 0),
 jobs_at_batch_position(in.Machines()),
 batch_characteristics(in.Machines()),
 batches_per_attribute(in.Attributes()),
+index_in_machines_with_batches(in.Machines(), -1),
+index_in_machines_with_more_batches(in.Machines(), -1),
+index_in_hot_jobs(in.Jobs(), -1),
+first_unscheduled_position(in.Machines(), 0),
+index_in_machines_with_unscheduled_batches(in.Machines(), -1),
+machine_fingerprints(in.Machines(), std::vector<uint64_t>(1, 0)),
 number_tardy_jobs(0),
 total_set_up_time(0),
 total_set_up_cost(0),
@@ -484,14 +900,82 @@ OSP_Output& OSP_Output::operator=(const OSP_Output& out)
     jobs_at_batch_position = out.jobs_at_batch_position;
     batch_characteristics = out.batch_characteristics;
     batches_per_attribute = out.batches_per_attribute;
+    machines_with_batches = out.machines_with_batches;
+    machines_with_more_batches = out.machines_with_more_batches;
+    index_in_machines_with_batches = out.index_in_machines_with_batches;
+    index_in_machines_with_more_batches = out.index_in_machines_with_more_batches;
+    hot_jobs = out.hot_jobs;
+    index_in_hot_jobs = out.index_in_hot_jobs;
+    first_unscheduled_position = out.first_unscheduled_position;
+    machines_with_unscheduled_batches = out.machines_with_unscheduled_batches;
+    index_in_machines_with_unscheduled_batches = out.index_in_machines_with_unscheduled_batches;
     number_tardy_jobs = out.number_tardy_jobs;
     total_set_up_time = out.total_set_up_time;
     total_set_up_cost = out.total_set_up_cost;
     cumulative_batch_processing_time = out.cumulative_batch_processing_time;
     not_scheduled_batches = out.not_scheduled_batches;
+    dont_look_machines = out.dont_look_machines;
+    dont_look_jobs = out.dont_look_jobs;
+    machine_fingerprints = out.machine_fingerprints;
     return *this;
 }
 
+void OSP_Output::Write(std::ostream& os) const
+{
+    Serialization::Write(os, job_to_batch_position);
+    Serialization::Write(os, batches_per_machine);
+    Serialization::Write(os, jobs_at_batch_position);
+    Serialization::Write(os, batch_characteristics);
+    Serialization::Write(os, batches_per_attribute);
+    Serialization::Write(os, machines_with_batches);
+    Serialization::Write(os, machines_with_more_batches);
+    Serialization::Write(os, index_in_machines_with_batches);
+    Serialization::Write(os, index_in_machines_with_more_batches);
+    Serialization::Write(os, hot_jobs);
+    Serialization::Write(os, index_in_hot_jobs);
+    Serialization::Write(os, first_unscheduled_position);
+    Serialization::Write(os, machines_with_unscheduled_batches);
+    Serialization::Write(os, index_in_machines_with_unscheduled_batches);
+    Serialization::Write(os, number_tardy_jobs);
+    Serialization::Write(os, total_set_up_time);
+    Serialization::Write(os, total_set_up_cost);
+    Serialization::Write(os, cumulative_batch_processing_time);
+    Serialization::Write(os, not_scheduled_batches);
+    Serialization::Write(os, dont_look_machines);
+    Serialization::Write(os, dont_look_jobs);
+    Serialization::Write(os, machine_fingerprints);
+}
+
+void OSP_Output::Read(std::istream& is)
+{
+    Serialization::Read(is, job_to_batch_position);
+    Serialization::Read(is, batches_per_machine);
+    if ((int) job_to_batch_position.size() != in.Jobs() || (int) batches_per_machine.size() != in.Machines())
+    {
+        throw std::invalid_argument("The state read is not a solution of this instance");
+    }
+    Serialization::Read(is, jobs_at_batch_position);
+    Serialization::Read(is, batch_characteristics);
+    Serialization::Read(is, batches_per_attribute);
+    Serialization::Read(is, machines_with_batches);
+    Serialization::Read(is, machines_with_more_batches);
+    Serialization::Read(is, index_in_machines_with_batches);
+    Serialization::Read(is, index_in_machines_with_more_batches);
+    Serialization::Read(is, hot_jobs);
+    Serialization::Read(is, index_in_hot_jobs);
+    Serialization::Read(is, first_unscheduled_position);
+    Serialization::Read(is, machines_with_unscheduled_batches);
+    Serialization::Read(is, index_in_machines_with_unscheduled_batches);
+    Serialization::Read(is, number_tardy_jobs);
+    Serialization::Read(is, total_set_up_time);
+    Serialization::Read(is, total_set_up_cost);
+    Serialization::Read(is, cumulative_batch_processing_time);
+    Serialization::Read(is, not_scheduled_batches);
+    Serialization::Read(is, dont_look_machines);
+    Serialization::Read(is, dont_look_jobs);
+    Serialization::Read(is, machine_fingerprints);
+}
+
 void OSP_Output::PopulateAllFromScratch()
 {
     // FIXME: check if this order is ok
@@ -511,6 +995,13 @@ void OSP_Output::PopulateAllFromScratch()
     // std::cout << "About to populate jobs at batch per attribute" << std::endl;
 // #endif
     PopulateBatchesPerAttribute();
+    // a new solution, nothing has been explored yet
+    dont_look_machines.clear();
+    dont_look_jobs.clear();
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        UpdateMachineFingerprint(m, 0);
+    }
     
     CalculateAllCostsFromScratch();
 }
@@ -529,6 +1020,109 @@ void OSP_Output::PopulateBatchesPerMachine()
             batches_per_machine[mach] = pos +1;
         }
     }
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        UpdateMachinesWithBatches(m);
+    }
+}
+
+// both lists are unordered, a machine is removed by moving the last one in its place
+// adds or removes e (a machine or a job) from a list whose positions are kept in index (-1 if e is not in the list)
+static void UpdateIndexedList(std::vector<int>& list, std::vector<int>& index, int e, bool belongs)
+{
+    if (belongs && index[e] == -1)
+    {
+        index[e] = (int) list.size();
+        list.push_back(e);
+    }
+    else if (!belongs && index[e] != -1)
+    {
+        int last = list.back();
+        list[index[e]] = last;
+        index[last] = index[e];
+        list.pop_back();
+        index[e] = -1;
+    }
+}
+
+void OSP_Output::UpdateMachinesWithBatches(int m)
+{
+    UpdateIndexedList(machines_with_batches, index_in_machines_with_batches, m, batches_per_machine[m] >= 1);
+    UpdateIndexedList(machines_with_more_batches, index_in_machines_with_more_batches, m, batches_per_machine[m] >= 2);
+}
+
+thread_local int OSP_Output::dont_look_bits_sets = 0;
+
+void OSP_Output::SetDontLookBitMachine(int set, int m) const
+{
+    if (set >= (int) dont_look_machines.size())
+    {
+        dont_look_machines.resize(set + 1, std::vector<bool>(in.Machines(), false));
+    }
+    dont_look_machines[set][m] = true;
+}
+
+void OSP_Output::SetDontLookBitJob(int set, int j) const
+{
+    if (set >= (int) dont_look_jobs.size())
+    {
+        dont_look_jobs.resize(set + 1, std::vector<bool>(in.Jobs(), false));
+    }
+    dont_look_jobs[set][j] = true;
+}
+
+void OSP_Output::MachineChangedFrom(int m, int p)
+{
+    ClearDontLookBits(m, p);
+    UpdateMachineFingerprint(m, p);
+}
+
+void OSP_Output::ClearDontLookBits(int m, int p)
+{
+    for (std::vector<bool>& bits : dont_look_machines)
+    {
+        bits[m] = false;
+    }
+    if (dont_look_jobs.empty())
+    {
+        return;
+    }
+    // the batches from p on have new start times (or new positions), so their jobs are looked at again
+    for (int q = std::max(p, 0); q < batches_per_machine[m]; ++q)
+    {
+        for (int j : jobs_at_batch_position[m][q])
+        {
+            for (std::vector<bool>& bits : dont_look_jobs)
+            {
+                bits[j] = false;
+            }
+        }
+    }
+}
+
+// the key of a job is a fixed pseudo-random number (splitmix64), so the fingerprints do not depend on the random seed
+static uint64_t JobFingerprint(int j)
+{
+    uint64_t x = (uint64_t) j + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+void OSP_Output::UpdateMachineFingerprint(int m, int p)
+{
+    // the batches before p keep their prefix, the others are rolled in again: a batch is the sum of the keys of its jobs
+    std::vector<uint64_t>& prefix = machine_fingerprints[m];
+    prefix.resize(batches_per_machine[m] + 1);
+    for (int q = std::max(p, 0); q < batches_per_machine[m]; ++q)
+    {
+        uint64_t batch = 0;
+        for (int j : jobs_at_batch_position[m][q])
+        {
+            batch += JobFingerprint(j);
+        }
+        prefix[q + 1] = (prefix[q] ^ batch) * 0x100000001B3ULL;
+    }
 }
 
 
@@ -583,8 +1177,11 @@ void OSP_Output::PopulateBatchesPerAttribute()
 
 Batch OSP_Output::CalculateBatchProperties(int m, int p)
 {
-    // retrieve the vector of jobs related to this batch
-    std::set<int> jobs = jobs_at_batch_position[m][p];
+    return CalculateBatchProperties(m, jobs_at_batch_position[m][p], p > 0 ? &batch_characteristics[m][p - 1] : nullptr);
+}
+
+Batch OSP_Output::CalculateBatchProperties(int m, const std::set<int>& jobs, const Batch* previous) const
+{
     if (jobs.size() == 0)
     {
         throw std::invalid_argument("jobs should be populated here");
@@ -616,13 +1213,12 @@ Batch OSP_Output::CalculateBatchProperties(int m, int p)
 #endif
     
     // get infos on the previous batch
-    int previous_pos = p - 1;
     int previous_attribute, previous_start_time, previous_end_time;
-    if (previous_pos > -1)
+    if (previous != nullptr)
     {
-        previous_attribute = batch_characteristics[m][previous_pos].attribute;
-        previous_start_time = batch_characteristics[m][previous_pos].start_time;
-        previous_end_time = batch_characteristics[m][previous_pos].end_time;
+        previous_attribute = previous->attribute;
+        previous_start_time = previous->start_time;
+        previous_end_time = previous->end_time;
     }
     else
     {
@@ -647,7 +1243,7 @@ Batch OSP_Output::CalculateBatchProperties(int m, int p)
     return {size, attribute, batch_processing_time, start_time, end_time, setup_cost, setup_time};
 }
 
-int OSP_Output::CalculateBatchStartTime(int machine, int earliest_start, int setup_time, int processing_time, int previous_end)
+int OSP_Output::CalculateBatchStartTime(int machine, int earliest_start, int setup_time, int processing_time, int previous_end) const
 {
     // check the earliest possible start
     if (previous_end + setup_time > earliest_start)
@@ -666,7 +1262,7 @@ int OSP_Output::CalculateBatchStartTime(int machine, int earliest_start, int set
     return start_in_machine;
 }
 
-int OSP_Output::CalculateEarliestSuitableMachineIntervalStart(int machine, int earliest_start, int setup_time, int processing_time)
+int OSP_Output::CalculateEarliestSuitableMachineIntervalStart(int machine, int earliest_start, int setup_time, int processing_time) const
 {
     int interval_index = -1;
     int earliest_start_in_interval = earliest_start;
@@ -749,13 +1345,23 @@ void OSP_Output::CalculateNumberOfTardyJobs()
             Batch batch = batch_characteristics[m][p];
             if (batch.start_time <= in.Horizon())
             {
-                std::set<int> jobs = jobs_at_batch_position[m][p];
+                const std::set<int>& jobs = jobs_at_batch_position[m][p];
                 for (int job : jobs)
                 {
-                    if (in.LatestEndJob(job) < batch.end_time)
+                    bool tardy = in.LatestEndJob(job) < batch.end_time;
+                    if (tardy)
                     {
                         number_tardy_jobs += 1;
                     }
+                    UpdateIndexedList(hot_jobs, index_in_hot_jobs, job, tardy);
+                }
+            }
+            else
+            {
+                // the jobs in batches past the horizon are hot as well
+                for (int job : jobs_at_batch_position[m][p])
+                {
+                    UpdateIndexedList(hot_jobs, index_in_hot_jobs, job, true);
                 }
             }
         }
@@ -783,21 +1389,120 @@ void OSP_Output::CalculateNotScheduledBatches()
     not_scheduled_batches = 0;
     for (int m = 0; m < in.Machines(); ++m)
     {
+        // once a batch is past the horizon, all the following ones on the machine are
+        first_unscheduled_position[m] = batches_per_machine[m];
         for (int p = 0; p < batches_per_machine[m]; ++p)
         {
             Batch batch = batch_characteristics[m][p];
             if (batch.start_time > in.Horizon())
             {
                 not_scheduled_batches += jobs_at_batch_position[m][p].size();
+                first_unscheduled_position[m] = std::min(first_unscheduled_position[m], p);
             }
         }
+        UpdateIndexedList(machines_with_unscheduled_batches, index_in_machines_with_unscheduled_batches, m, first_unscheduled_position[m] < batches_per_machine[m]);
     }
 }
 
-void OSP_Output::CheckerForBatchCharacteristicsUpdate()
+MachineCosts OSP_Output::CalculateDeltaCosts(const std::vector<BatchChange>& changes) const
 {
-    // this is just to check you are modifying the entire batch_characteristics stucture
-    std::vector<std::vector<Batch>> to_debug_batch_characteristics;
+    MachineCosts delta = {0, 0, 0, 0, 0};
+    std::vector<const std::set<int>*> batches;
+    for (size_t c = 0; c < changes.size(); ++c)
+    {
+        // each machine is scheduled again once, with all its changes
+        int m = changes[c].machine;
+        bool scheduled = false;
+        for (size_t d = 0; d < c; ++d)
+        {
+            if (changes[d].machine == m)
+            {
+                scheduled = true;
+            }
+        }
+        if (scheduled)
+        {
+            continue;
+        }
+        // the batches before the first change keep their schedule
+        int first = batches_per_machine[m];
+        for (const BatchChange& change : changes)
+        {
+            if (change.machine == m)
+            {
+                first = std::min(first, change.new_batch ? change.position + 1 : change.position);
+            }
+        }
+        // the batches from the first change on, as the changes leave them
+        batches.clear();
+        for (int p = first - 1; p < batches_per_machine[m]; ++p)
+        {
+            if (p >= first)
+            {
+                const std::set<int>* jobs = &jobs_at_batch_position[m][p];
+                for (const BatchChange& change : changes)
+                {
+                    if (change.machine == m && change.position == p && !change.new_batch)
+                    {
+                        jobs = &change.jobs;
+                    }
+                }
+                if (!jobs->empty())
+                {
+                    batches.push_back(jobs);
+                }
+            }
+            for (const BatchChange& change : changes)
+            {
+                if (change.machine == m && change.position == p && change.new_batch)
+                {
+                    batches.push_back(&change.jobs);
+                }
+            }
+        }
+        // their costs in the new schedule, less the current ones
+        const Batch* previous = first > 0 ? &batch_characteristics[m][first - 1] : nullptr;
+        Batch batch;
+        for (const std::set<int>* jobs : batches)
+        {
+            batch = CalculateBatchProperties(m, *jobs, previous);
+            AddBatchCosts(delta, batch, *jobs, 1);
+            previous = &batch;
+        }
+        for (int p = first; p < batches_per_machine[m]; ++p)
+        {
+            AddBatchCosts(delta, batch_characteristics[m][p], jobs_at_batch_position[m][p], -1);
+        }
+    }
+    return delta;
+}
+
+void OSP_Output::AddBatchCosts(MachineCosts& costs, const Batch& batch, const std::set<int>& jobs, int sign) const
+{
+    // same definitions of the Calculate* methods of the costs
+    if (batch.start_time <= in.Horizon())
+    {
+        costs.set_up_time += sign * batch.setup_time;
+        costs.set_up_cost += sign * batch.setup_cost;
+        costs.batch_processing_time += sign * batch.batch_processing_time;
+        for (int job : jobs)
+        {
+            if (in.LatestEndJob(job) < batch.end_time)
+            {
+                costs.tardy_jobs += sign;
+            }
+        }
+    }
+    else
+    {
+        costs.not_scheduled_batches += sign * (long) jobs.size();
+    }
+}
+
+void OSP_Output::CheckerForBatchCharacteristicsUpdate()
+{
+    // this is just to check you are modifying the entire batch_characteristics stucture
+    std::vector<std::vector<Batch>> to_debug_batch_characteristics;
     to_debug_batch_characteristics.resize(in.Machines());
     for (int m = 0; m < in.Machines(); ++m)
     {
@@ -889,6 +1594,16 @@ void OSP_Output::CheckerForJobsAtBatchPositionUpdate()
     }
 }
 
+void OSP_Output::CheckerForFingerprintsUpdate()
+{
+    std::vector<std::vector<uint64_t>> updated_fingerprints = machine_fingerprints;
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        UpdateMachineFingerprint(m, 0);
+        assert(machine_fingerprints[m] == updated_fingerprints[m]);
+    }
+}
+
 void OSP_Output::CheckForNumberofBatchesUpdate()
 {
     std::vector<int> to_debug;
@@ -905,6 +1620,8 @@ void OSP_Output::CheckForNumberofBatchesUpdate()
     for (int m = 0; m < in.Machines(); ++m)
     {
         assert(to_debug[m] == batches_per_machine[m]);
+        assert((index_in_machines_with_batches[m] != -1) == (batches_per_machine[m] >= 1));
+        assert((index_in_machines_with_more_batches[m] != -1) == (batches_per_machine[m] >= 2));
     }
 }
 
@@ -944,12 +1661,15 @@ void OSP_Output::SwapBatchesSameMachine (int m, int p1, int p2)
         batch_characteristics[m][p] = CalculateBatchProperties(m, p);
     }
     
+    MachineChangedFrom(m, std::min(p1, p2));
+    
 #if !defined(NDEBUG)
     // this is just to check you are modifying the entire batch_characteristics stucture
     CheckerForBatchCharacteristicsUpdate();
     CheckerForBatchesPerAttributeUpdate();
     CheckerForJobsAtBatchPositionUpdate();
     CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
 #endif
 }
 
@@ -958,10 +1678,12 @@ void OSP_Output::InsertBatchToNewPosition (int m, int o_p, int n_p)
     // std::cout << o_p << "-->" << n_p << std::endl;
     if (o_p == n_p)
     {
+        MachineChangedFrom(m, o_p); // the batch may have just been appended to the machine
 #if !defined(NDEBUG)
         CheckerForBatchCharacteristicsUpdate();
         CheckerForBatchesPerAttributeUpdate();
         CheckForNumberofBatchesUpdate();
+        CheckerForFingerprintsUpdate();
 #endif
         return;
     }
@@ -1036,6 +1758,7 @@ void OSP_Output::InsertBatchToNewPosition (int m, int o_p, int n_p)
             // batches_per_attribute[n_a].insert(pos);
         }
     }
+    MachineChangedFrom(m, std::min(o_p, n_p));
     
 #if !defined(NDEBUG)
     // this is just to check you are modifying the entire batch_characteristics stucture
@@ -1043,6 +1766,7 @@ void OSP_Output::InsertBatchToNewPosition (int m, int o_p, int n_p)
     CheckerForBatchesPerAttributeUpdate();
     CheckerForJobsAtBatchPositionUpdate();
     CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
 #endif
 }
 
@@ -1111,6 +1835,88 @@ bool OSP_Output::IsJobCompatibleForBatch(int job, int machine, int position) con
     return true;
 }
 
+bool OSP_Output::IsJobCompatibleForBatchWithout(int job, int job_out, int machine, int position) const
+{
+    // same checks of IsJobCompatibleForBatch, but on the batch where job_out is replaced by job
+    if (job_to_batch_position[job].first == machine && job_to_batch_position[job].second == position)
+    {
+        return false;
+    }
+    if (!in.IsMachineEligible(machine, job))
+    {
+        return false;
+    }
+    const Batch& batch = batch_characteristics[machine][position];
+    if (in.AttributeJob(job) != batch.attribute)
+    {
+        return false;
+    }
+    if (batch.size - in.SizeJob(job_out) + in.SizeJob(job) > in.MaxCapacityMachine(machine))
+    {
+        return false;
+    }
+    // the processing time of the new batch (the largest minimal time) should not exceed any maximal time
+    int batch_processing_time = in.MinTimeJob(job);
+    int min_max_processing_time = in.MaxTimeJob(job);
+    for (int current : jobs_at_batch_position[machine][position])
+    {
+        if (current == job_out)
+        {
+            continue;
+        }
+        if (batch_processing_time < in.MinTimeJob(current))
+        {
+            batch_processing_time = in.MinTimeJob(current);
+        }
+        if (min_max_processing_time > in.MaxTimeJob(current))
+        {
+            min_max_processing_time = in.MaxTimeJob(current);
+        }
+    }
+    return batch_processing_time <= min_max_processing_time;
+}
+
+bool OSP_Output::IsBatchCompatibleForBatch(int source_machine, int source_position, int target_machine, int target_position) const
+{
+    if (source_machine == target_machine && source_position == target_position)
+    {
+        return false;
+    }
+    const Batch& source = batch_characteristics[source_machine][source_position];
+    const Batch& target = batch_characteristics[target_machine][target_position];
+    if (source.attribute != target.attribute)
+    {
+        return false;
+    }
+    if (source.size + target.size > in.MaxCapacityMachine(target_machine))
+    {
+        return false;
+    }
+    // the target machine should be eligible for all the jobs, and the processing time of the merged batch should not exceed any maximal time
+    int batch_processing_time = std::max(source.batch_processing_time, target.batch_processing_time);
+    for (int job : jobs_at_batch_position[source_machine][source_position])
+    {
+        if (!in.IsMachineEligible(target_machine, job) || in.MaxTimeJob(job) < batch_processing_time)
+        {
+            return false;
+        }
+    }
+    for (int job : jobs_at_batch_position[target_machine][target_position])
+    {
+        if (in.MaxTimeJob(job) < batch_processing_time)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OSP_Output::IsJobTardy(int job) const
+{
+    const Batch& batch = batch_characteristics[job_to_batch_position[job].first][job_to_batch_position[job].second];
+    return batch.start_time <= in.Horizon() && in.LatestEndJob(job) < batch.end_time;
+}
+
 void OSP_Output::InsertJobInExistingBatch(int job, std::pair<int, int> old_machine_position, std::pair<int, int> new_machine_position)
 {
     // two cases: the job is alone in the previous batch or the job is not alone
@@ -1142,6 +1948,7 @@ void OSP_Output::InsertJobInExistingBatch(int job, std::pair<int, int> old_machi
         jobs_at_batch_position[old_machine_position.first].resize(total_batches - 1);
         batch_characteristics[old_machine_position.first].resize(total_batches - 1);
         batches_per_machine[old_machine_position.first] = batches_per_machine[old_machine_position.first] - 1;
+        UpdateMachinesWithBatches(old_machine_position.first);
         total_batches = batches_per_machine[old_machine_position.first];
         for (int p = old_machine_position.second; p < total_batches; ++p)
         {
@@ -1168,12 +1975,15 @@ void OSP_Output::InsertJobInExistingBatch(int job, std::pair<int, int> old_machi
     {
         batch_characteristics[new_machine_position.first][p] = CalculateBatchProperties(new_machine_position.first, p);
     }
+    MachineChangedFrom(old_machine_position.first, old_machine_position.second);
+    MachineChangedFrom(new_machine_position.first, new_machine_position.second);
 #if !defined(NDEBUG)
     // this is just to check you are modifying the entire batch_characteristics stucture
     CheckerForBatchCharacteristicsUpdate();
     CheckerForBatchesPerAttributeUpdate();
     CheckerForJobsAtBatchPositionUpdate();
     CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
 #endif
 }
 
@@ -1216,6 +2026,7 @@ void OSP_Output::InsertJobToNewBatch (int job, std::pair<int,int> old_machine_po
             jobs_at_batch_position[old_machine_position.first].resize(total_batches - 1);
             batch_characteristics[old_machine_position.first].resize(total_batches - 1);
             batches_per_machine[old_machine_position.first] = batches_per_machine[old_machine_position.first] - 1;
+            UpdateMachinesWithBatches(old_machine_position.first);
             total_batches = batches_per_machine[old_machine_position.first];
             for (int p = old_machine_position.second; p < total_batches; ++p)
             {
@@ -1233,6 +2044,7 @@ void OSP_Output::InsertJobToNewBatch (int job, std::pair<int,int> old_machine_po
                 batch_characteristics[old_machine_position.first][p] = CalculateBatchProperties(old_machine_position.first, p);
             }
         }
+        MachineChangedFrom(old_machine_position.first, old_machine_position.second); // the new machine is taken care of by InsertBatchToNewPosition
         
         // at this point you need to update the new machine
         // you insert it at the end (everywhere!!)
@@ -1240,6 +2052,7 @@ void OSP_Output::InsertJobToNewBatch (int job, std::pair<int,int> old_machine_po
         jobs_at_batch_position[new_machine_position.first].resize(end_position + 1);
         jobs_at_batch_position[new_machine_position.first][end_position].insert(job);
         batches_per_machine[new_machine_position.first] = batches_per_machine[new_machine_position.first] + 1;
+        UpdateMachinesWithBatches(new_machine_position.first);
 #if !defined(NDEBUG)
         assert(batches_per_machine[new_machine_position.first] == (int) jobs_at_batch_position[new_machine_position.first].size());
 #endif
@@ -1259,10 +2072,11 @@ void OSP_Output::InsertJobToNewBatch (int job, std::pair<int,int> old_machine_po
     CheckerForBatchesPerAttributeUpdate();
     CheckerForJobsAtBatchPositionUpdate();
     CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
 #endif
 }
 
-void OSP_Output::InsertBatchToNewMachine (std::set<int> jobs_to_move, std::pair<int,int> old_position, std::pair<int,int> new_position)
+void OSP_Output::InsertBatchToNewMachine (const std::set<int>& jobs_to_move, std::pair<int,int> old_position, std::pair<int,int> new_position)
 {
     // if the two machines are equal, then this is a case where the move correspons to an insertion
     if (old_position.first == new_position.first)
@@ -1304,6 +2118,7 @@ void OSP_Output::InsertBatchToNewMachine (std::set<int> jobs_to_move, std::pair<
             jobs_at_batch_position[old_position.first].resize(total_batches - 1);
             batch_characteristics[old_position.first].resize(total_batches - 1);
             batches_per_machine[old_position.first] = batches_per_machine[old_position.first] - 1;
+            UpdateMachinesWithBatches(old_position.first);
             total_batches = batches_per_machine[old_position.first];
             for (int p = old_position.second; p < total_batches; ++p)
             {
@@ -1324,6 +2139,7 @@ void OSP_Output::InsertBatchToNewMachine (std::set<int> jobs_to_move, std::pair<
                 batch_characteristics[old_position.first][p] = CalculateBatchProperties(old_position.first, p);
             }
         }
+        MachineChangedFrom(old_position.first, old_position.second); // the new machine is taken care of by InsertBatchToNewPosition
         // now you add the new thing at the end of the machine
         // now you put it in the right place of a new machine
         int end_position = batches_per_machine[new_position.first];
@@ -1331,6 +2147,7 @@ void OSP_Output::InsertBatchToNewMachine (std::set<int> jobs_to_move, std::pair<
         jobs_at_batch_position[new_position.first][end_position].clear();
         jobs_at_batch_position[new_position.first][end_position] = jobs_to_move;
         batches_per_machine[new_position.first] = batches_per_machine[new_position.first] + 1;
+        UpdateMachinesWithBatches(new_position.first);
 #if !defined(NDEBUG)
         assert(batches_per_machine[new_position.first] == (int) jobs_at_batch_position[new_position.first].size());
 #endif
@@ -1352,6 +2169,153 @@ void OSP_Output::InsertBatchToNewMachine (std::set<int> jobs_to_move, std::pair<
     CheckerForBatchesPerAttributeUpdate();
     CheckerForJobsAtBatchPositionUpdate();
     CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
+#endif
+}
+
+void OSP_Output::ExchangeJobs(int job_1, int job_2)
+{
+    std::pair<int,int> machine_position_1 = job_to_batch_position[job_1];
+    std::pair<int,int> machine_position_2 = job_to_batch_position[job_2];
+    jobs_at_batch_position[machine_position_1.first][machine_position_1.second].erase(job_1);
+    jobs_at_batch_position[machine_position_1.first][machine_position_1.second].insert(job_2);
+    jobs_at_batch_position[machine_position_2.first][machine_position_2.second].erase(job_2);
+    jobs_at_batch_position[machine_position_2.first][machine_position_2.second].insert(job_1);
+    job_to_batch_position[job_1] = machine_position_2;
+    job_to_batch_position[job_2] = machine_position_1;
+    // the number of batches and their attributes do not change, only the characteristics from the two positions on
+    if (machine_position_1.first == machine_position_2.first)
+    {
+        int m = machine_position_1.first;
+        for (int p = std::min(machine_position_1.second, machine_position_2.second); p < batches_per_machine[m]; ++p)
+        {
+            batch_characteristics[m][p] = CalculateBatchProperties(m, p);
+        }
+    }
+    else
+    {
+        for (std::pair<int,int> machine_position : {machine_position_1, machine_position_2})
+        {
+            int m = machine_position.first;
+            for (int p = machine_position.second; p < batches_per_machine[m]; ++p)
+            {
+                batch_characteristics[m][p] = CalculateBatchProperties(m, p);
+            }
+        }
+    }
+    MachineChangedFrom(machine_position_1.first, machine_position_1.second);
+    MachineChangedFrom(machine_position_2.first, machine_position_2.second);
+#if !defined(NDEBUG)
+    // this is just to check you are modifying the entire batch_characteristics stucture
+    CheckerForBatchCharacteristicsUpdate();
+    CheckerForBatchesPerAttributeUpdate();
+    CheckerForJobsAtBatchPositionUpdate();
+    CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
+#endif
+}
+
+void OSP_Output::InsertBatchInExistingBatch(std::pair<int,int> source_position, std::pair<int,int> target_position)
+{
+    std::set<int> jobs_to_move = jobs_at_batch_position[source_position.first][source_position.second];
+    for (int j : jobs_to_move)
+    {
+        jobs_at_batch_position[target_position.first][target_position.second].insert(j);
+        job_to_batch_position[j] = target_position;
+    }
+    // the source batch is removed and the following ones are put forward (the target as well, if it follows on the same machine)
+    int attr = in.AttributeJob(*jobs_to_move.begin());
+    batches_per_attribute[attr].erase(source_position);
+    int total_batches = batches_per_machine[source_position.first];
+    for (int p = source_position.second; p < total_batches - 1; ++p)
+    {
+        std::set<int> jobs_to_anticipate = jobs_at_batch_position[source_position.first][p+1];
+        jobs_at_batch_position[source_position.first][p].clear();
+        jobs_at_batch_position[source_position.first][p] = jobs_to_anticipate;
+        for (int j : jobs_to_anticipate)
+        {
+            job_to_batch_position[j].second = p;
+        }
+        attr = in.AttributeJob(*jobs_to_anticipate.begin());
+        batches_per_attribute[attr].erase(std::make_pair(source_position.first, p+1));
+        batches_per_attribute[attr].insert(std::make_pair(source_position.first, p));
+    }
+    jobs_at_batch_position[source_position.first].resize(total_batches - 1);
+    batch_characteristics[source_position.first].resize(total_batches - 1);
+    batches_per_machine[source_position.first] = batches_per_machine[source_position.first] - 1;
+    UpdateMachinesWithBatches(source_position.first);
+    if (target_position.first == source_position.first && target_position.second > source_position.second)
+    {
+        target_position.second = target_position.second - 1;
+    }
+    // update the batch characteristics
+    if (target_position.first == source_position.first)
+    {
+        int m = source_position.first;
+        for (int p = std::min(source_position.second, target_position.second); p < batches_per_machine[m]; ++p)
+        {
+            batch_characteristics[m][p] = CalculateBatchProperties(m, p);
+        }
+    }
+    else
+    {
+        for (std::pair<int,int> machine_position : {source_position, target_position})
+        {
+            int m = machine_position.first;
+            for (int p = machine_position.second; p < batches_per_machine[m]; ++p)
+            {
+                batch_characteristics[m][p] = CalculateBatchProperties(m, p);
+            }
+        }
+    }
+    MachineChangedFrom(source_position.first, source_position.second);
+    MachineChangedFrom(target_position.first, target_position.second);
+#if !defined(NDEBUG)
+    // this is just to check you are modifying the entire batch_characteristics stucture
+    CheckerForBatchCharacteristicsUpdate();
+    CheckerForBatchesPerAttributeUpdate();
+    CheckerForJobsAtBatchPositionUpdate();
+    CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
+#endif
+}
+
+void OSP_Output::ExtractJobsToNextBatch(int m, int p, const std::set<int>& jobs_to_extract)
+{
+    int total_batches = batches_per_machine[m];
+    // the batches after p are postponed by one position
+    for (int q = total_batches; q > p + 1; --q)
+    {
+        int attr = batch_characteristics[m][q-1].attribute;
+        batches_per_attribute[attr].erase(std::make_pair(m, q-1));
+        batches_per_attribute[attr].insert(std::make_pair(m, q));
+        for (int j : jobs_at_batch_position[m][q-1])
+        {
+            job_to_batch_position[j].second = q;
+        }
+    }
+    for (int j : jobs_to_extract)
+    {
+        jobs_at_batch_position[m][p].erase(j);
+        job_to_batch_position[j].second = p + 1;
+    }
+    jobs_at_batch_position[m].insert(jobs_at_batch_position[m].begin() + p + 1, jobs_to_extract);
+    batches_per_attribute[in.AttributeJob(*jobs_to_extract.begin())].insert(std::make_pair(m, p + 1));
+    batches_per_machine[m] = batches_per_machine[m] + 1;
+    UpdateMachinesWithBatches(m);
+    batch_characteristics[m].resize(batches_per_machine[m]);
+    for (int q = p; q < batches_per_machine[m]; ++q)
+    {
+        batch_characteristics[m][q] = CalculateBatchProperties(m, q);
+    }
+    MachineChangedFrom(m, p);
+#if !defined(NDEBUG)
+    // this is just to check you are modifying the entire batch_characteristics stucture
+    CheckerForBatchCharacteristicsUpdate();
+    CheckerForBatchesPerAttributeUpdate();
+    CheckerForJobsAtBatchPositionUpdate();
+    CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
 #endif
 }
 
@@ -1391,13 +2355,49 @@ void OSP_Output::InverseBatchesInMachine(int m, int p_1, int p_2)
         {
             batch_characteristics[m][p] = CalculateBatchProperties(m, p);
         }
+        MachineChangedFrom(m, p_1);
+    }
+#if !defined(NDEBUG)
+    // this is just to check you are modifying the entire batch_characteristics stucture
+    CheckerForBatchCharacteristicsUpdate();
+    CheckerForBatchesPerAttributeUpdate();
+    CheckerForJobsAtBatchPositionUpdate();
+    CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
+#endif
+}
+
+void OSP_Output::ReorderBatchesInMachine(int m, int p, const int order[], int length)
+{
+    // remove the batches from the attribute
+    for (int i = 0; i < length; ++i)
+    {
+        batches_per_attribute[batch_characteristics[m][p + i].attribute].erase(std::make_pair(m, p + i));
+    }
+    std::vector<std::set<int>> jobs(jobs_at_batch_position[m].begin() + p, jobs_at_batch_position[m].begin() + p + length);
+    for (int i = 0; i < length; ++i)
+    {
+        jobs_at_batch_position[m][p + i] = jobs[order[i]];
+        std::pair<int,int> machine_position = std::make_pair(m, p + i);
+        for (int job : jobs_at_batch_position[m][p + i])
+        {
+            job_to_batch_position[job] = machine_position;
+        }
+        batches_per_attribute[in.AttributeJob(*jobs_at_batch_position[m][p + i].begin())].insert(machine_position);
     }
+    // update batch characteristics
+    for (int q = p; q < batches_per_machine[m]; ++q)
+    {
+        batch_characteristics[m][q] = CalculateBatchProperties(m, q);
+    }
+    MachineChangedFrom(m, p);
 #if !defined(NDEBUG)
     // this is just to check you are modifying the entire batch_characteristics stucture
     CheckerForBatchCharacteristicsUpdate();
     CheckerForBatchesPerAttributeUpdate();
     CheckerForJobsAtBatchPositionUpdate();
     CheckForNumberofBatchesUpdate();
+    CheckerForFingerprintsUpdate();
 #endif
 }
 
@@ -1693,29 +2693,34 @@ bool operator==(const Batch& b1, const Batch& b2)
 bool operator==(const BatchToNewMachine& m1, const BatchToNewMachine& m2)
 {
     return m1.jobs_to_move == m2.jobs_to_move
+        && m1.window_start == m2.window_start
         && m1.old_machine_position == m2.old_machine_position
         && m1.new_machine_position == m2.new_machine_position;
 }
 
 bool operator!=(const BatchToNewMachine& m1, const BatchToNewMachine& m2)
 {
-    return m1.jobs_to_move.size() != m2.jobs_to_move.size()
-        || m1.jobs_to_move != m2.jobs_to_move
-        || (m1.jobs_to_move == m2.jobs_to_move && m1.old_machine_position != m2.old_machine_position)
-        || (m1.jobs_to_move == m2.jobs_to_move && m1.old_machine_position == m2.old_machine_position && m1.new_machine_position != m2.new_machine_position);
+    return m1.jobs_to_move != m2.jobs_to_move
+        || m1.window_start != m2.window_start
+        || m1.old_machine_position != m2.old_machine_position
+        || m1.new_machine_position != m2.new_machine_position;
 }
 
 bool operator<(const BatchToNewMachine& m1, const BatchToNewMachine& m2)
 {
-    return m1.jobs_to_move.size() < m2.jobs_to_move.size();
+    return m1.NumberOfJobsToMove() < m2.NumberOfJobsToMove();
 }
 
 std::ostream& operator<<(std::ostream& os, const BatchToNewMachine& m)
 {
+    // the jobs are printed as indices in the old batch, since the move does not know the state
     os << "{ ";
-    for (int j : m.jobs_to_move)
+    for (int i = 0; i < BatchToNewMachine::MaxJobs; ++i)
     {
-        os << j << " ";
+        if (m.IsJobToMove(i))
+        {
+            os << m.window_start + i << " ";
+        }
     }
     os << " } : <" << m.old_machine_position.first << "," << m.old_machine_position.second << "> --> <" << m.new_machine_position.first
     << "," << m.new_machine_position.second << ">" << std::endl;
@@ -1727,6 +2732,316 @@ std::istream& operator>>(std::istream& is, BatchToNewMachine& mv)
     return is;
 }
 
+std::set<int> BatchToNewMachine::JobsToMove(const OSP_Output& st) const
+{
+    std::set<int> jobs;
+    const std::set<int>& batch_jobs = st.GetJobsAtBatchPosition(old_machine_position.first, old_machine_position.second);
+    int index = 0;
+    for (auto it = std::next(batch_jobs.begin(), window_start); it != batch_jobs.end() && index < MaxJobs; ++it, ++index)
+    {
+        if (IsJobToMove(index))
+        {
+            jobs.insert(jobs.end(), *it);
+        }
+    }
+    return jobs;
+}
+
+bool operator==(const SwapJobsBetweenBatches& m1, const SwapJobsBetweenBatches& m2)
+{
+    return m1.job_1 == m2.job_1
+        && m1.job_2 == m2.job_2;
+}
+
+bool operator!=(const SwapJobsBetweenBatches& m1, const SwapJobsBetweenBatches& m2)
+{
+    return m1.job_1 != m2.job_1
+        || m1.job_2 != m2.job_2;
+}
+
+bool operator<(const SwapJobsBetweenBatches& m1, const SwapJobsBetweenBatches& m2)
+{
+    return m1.job_1 < m2.job_1
+        || (m1.job_1 == m2.job_1 && m1.job_2 < m2.job_2);
+}
+
+std::ostream& operator<<(std::ostream& os, const SwapJobsBetweenBatches& m)
+{
+    os << m.job_1 << ": <" << m.position_1.first << "," << m.position_1.second << "> <--> "
+        << m.job_2 << ": <" << m.position_2.first << "," << m.position_2.second << ">" << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, SwapJobsBetweenBatches& m)
+{
+    return is;
+}
+
+bool operator==(const MergeBatches& m1, const MergeBatches& m2)
+{
+    return m1.source_position == m2.source_position
+        && m1.target_position == m2.target_position;
+}
+
+bool operator!=(const MergeBatches& m1, const MergeBatches& m2)
+{
+    return m1.source_position != m2.source_position
+        || m1.target_position != m2.target_position;
+}
+
+bool operator<(const MergeBatches& m1, const MergeBatches& m2)
+{
+    return std::pair<int,int>(m1.source_position) < std::pair<int,int>(m2.source_position)
+        || (m1.source_position == m2.source_position && std::pair<int,int>(m1.target_position) < std::pair<int,int>(m2.target_position));
+}
+
+std::ostream& operator<<(std::ostream& os, const MergeBatches& m)
+{
+    os << "<" << m.source_position.first << "," << m.source_position.second << "> --> <" << m.target_position.first << "," << m.target_position.second << ">" << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, MergeBatches& m)
+{
+    return is;
+}
+
+bool operator==(const SplitBatch& m1, const SplitBatch& m2)
+{
+    return m1.position == m2.position
+        && m1.split == m2.split;
+}
+
+bool operator!=(const SplitBatch& m1, const SplitBatch& m2)
+{
+    return m1.position != m2.position
+        || m1.split != m2.split;
+}
+
+bool operator<(const SplitBatch& m1, const SplitBatch& m2)
+{
+    return std::pair<int,int>(m1.position) < std::pair<int,int>(m2.position)
+        || (m1.position == m2.position && m1.split < m2.split);
+}
+
+std::ostream& operator<<(std::ostream& os, const SplitBatch& m)
+{
+    os << "<" << m.position.first << "," << m.position.second << "> split after " << m.split << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, SplitBatch& m)
+{
+    return is;
+}
+
+std::set<int> SplitBatch::JobsToNewBatch(const OSP_Output& st) const
+{
+    const std::set<int>& batch = st.GetJobsAtBatchPosition(position.first, position.second);
+    std::vector<int> jobs(batch.begin(), batch.end());
+    std::stable_sort(jobs.begin(), jobs.end(), [&st](int j1, int j2) { return st.LatestEndJob(j1) < st.LatestEndJob(j2); });
+    return std::set<int>(jobs.begin() + split, jobs.end());
+}
+
+bool operator==(const EjectionChain& m1, const EjectionChain& m2)
+{
+    if (m1.length != m2.length)
+    {
+        return false;
+    }
+    for (int i = 0; i < m1.length; ++i)
+    {
+        if (m1.jobs[i] != m2.jobs[i] || m1.targets[i] != m2.targets[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool operator!=(const EjectionChain& m1, const EjectionChain& m2)
+{
+    return !(m1 == m2);
+}
+
+bool operator<(const EjectionChain& m1, const EjectionChain& m2)
+{
+    if (m1.length != m2.length)
+    {
+        return m1.length < m2.length;
+    }
+    for (int i = 0; i < m1.length; ++i)
+    {
+        if (m1.jobs[i] != m2.jobs[i])
+        {
+            return m1.jobs[i] < m2.jobs[i];
+        }
+        if (m1.targets[i] != m2.targets[i])
+        {
+            return std::pair<int,int>(m1.targets[i]) < std::pair<int,int>(m2.targets[i]);
+        }
+    }
+    return false;
+}
+
+std::ostream& operator<<(std::ostream& os, const EjectionChain& m)
+{
+    for (int i = 0; i < m.length; ++i)
+    {
+        os << (i > 0 ? ", " : "") << m.jobs[i] << " --> <" << m.targets[i].first << "," << m.targets[i].second << ">";
+    }
+    os << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, EjectionChain& m)
+{
+    return is;
+}
+
+bool operator==(const RuinAndRecreate& m1, const RuinAndRecreate& m2)
+{
+    return m1.destroy == m2.destroy
+        && m1.machine == m2.machine
+        && m1.from == m2.from
+        && m1.size == m2.size;
+}
+
+bool operator!=(const RuinAndRecreate& m1, const RuinAndRecreate& m2)
+{
+    return !(m1 == m2);
+}
+
+bool operator<(const RuinAndRecreate& m1, const RuinAndRecreate& m2)
+{
+    return std::make_tuple(m1.destroy, m1.machine, m1.from, m1.size) < std::make_tuple(m2.destroy, m2.machine, m2.from, m2.size);
+}
+
+std::ostream& operator<<(std::ostream& os, const RuinAndRecreate& m)
+{
+    static const char* names[] = {"time window", "machine segment", "related jobs"};
+    os << names[m.destroy] << " <" << m.machine << "," << m.from << "> of " << m.size << " jobs" << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, RuinAndRecreate& m)
+{
+    return is;
+}
+
+std::vector<int> RuinAndRecreate::RemovedJobs(const OSP_Output& st) const
+{
+    std::vector<int> jobs;
+    if (destroy == RelatedJobs)
+    {
+        int attribute = st.AttributeJob(from), due_date = st.LatestEndJob(from);
+        for (int j = 0; j < st.Jobs(); ++j)
+        {
+            if (st.AttributeJob(j) == attribute)
+            {
+                jobs.push_back(j);
+            }
+        }
+        std::stable_sort(jobs.begin(), jobs.end(), [&st, due_date](int j1, int j2) { return std::abs(st.LatestEndJob(j1) - due_date) < std::abs(st.LatestEndJob(j2) - due_date); });
+        jobs.resize(std::min((int) jobs.size(), size));
+        return jobs;
+    }
+    // the batches of the window (of the segment), in order of start time
+    std::vector<std::pair<int,int>> batches;
+    for (int m = 0; m < st.Machines(); ++m)
+    {
+        if (destroy == MachineSegment && m != machine)
+        {
+            continue;
+        }
+        for (int p = (destroy == MachineSegment ? from : 0); p < st.GetBatchesPerMachine(m); ++p)
+        {
+            if (destroy == MachineSegment || st.GetBatchCharacteristics(m, p).start_time >= from)
+            {
+                batches.push_back(std::make_pair(m, p));
+            }
+        }
+    }
+    std::stable_sort(batches.begin(), batches.end(), [&st](const std::pair<int,int>& b1, const std::pair<int,int>& b2)
+        { return st.GetBatchCharacteristics(b1.first, b1.second).start_time < st.GetBatchCharacteristics(b2.first, b2.second).start_time; });
+    for (const std::pair<int,int>& b : batches)
+    {
+        for (int j : st.GetJobsAtBatchPosition(b.first, b.second))
+        {
+            if ((int) jobs.size() == size)
+            {
+                return jobs;
+            }
+            jobs.push_back(j);
+        }
+    }
+    return jobs;
+}
+
+bool operator==(const ResequenceBatches& m1, const ResequenceBatches& m2)
+{
+    return m1.machine == m2.machine
+        && m1.first == m2.first
+        && m1.length == m2.length
+        && std::equal(m1.order, m1.order + m1.length, m2.order);
+}
+
+bool operator!=(const ResequenceBatches& m1, const ResequenceBatches& m2)
+{
+    return !(m1 == m2);
+}
+
+bool operator<(const ResequenceBatches& m1, const ResequenceBatches& m2)
+{
+    return std::make_tuple(m1.machine, m1.first, m1.length) < std::make_tuple(m2.machine, m2.first, m2.length)
+        || (std::make_tuple(m1.machine, m1.first, m1.length) == std::make_tuple(m2.machine, m2.first, m2.length)
+            && std::lexicographical_compare(m1.order, m1.order + m1.length, m2.order, m2.order + m2.length));
+}
+
+std::ostream& operator<<(std::ostream& os, const ResequenceBatches& m)
+{
+    os << m.machine << ": " << m.first << " [";
+    for (int i = 0; i < m.length; ++i)
+    {
+        os << (i > 0 ? " " : "") << m.first + m.order[i];
+    }
+    os << "]" << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, ResequenceBatches& m)
+{
+    return is;
+}
+
+bool operator==(const RegroupBatches& m1, const RegroupBatches& m2)
+{
+    return m1.machine == m2.machine
+        && m1.first == m2.first
+        && m1.length == m2.length;
+}
+
+bool operator!=(const RegroupBatches& m1, const RegroupBatches& m2)
+{
+    return !(m1 == m2);
+}
+
+bool operator<(const RegroupBatches& m1, const RegroupBatches& m2)
+{
+    return std::make_tuple(m1.machine, m1.first, m1.length) < std::make_tuple(m2.machine, m2.first, m2.length);
+}
+
+std::ostream& operator<<(std::ostream& os, const RegroupBatches& m)
+{
+    os << m.machine << ": " << m.first << " -- " << m.first + m.length - 1 << " regrouped" << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, RegroupBatches& m)
+{
+    return is;
+}
+
 bool operator==(const SwapBatches& m1, const SwapBatches& m2)
 {
     return m1.machine == m2.machine
@@ -3,14 +3,44 @@
 #include <vector>
 #include <set>
 #include <iostream>
+#include <cstdint>
+#include <type_traits>
 
 enum class FileFormat { DZN, DAT, JSON };
 
+// changes of an instance while its solution is in use: the jobs that arrive, the ones cancelled and the ones whose due date moves.
+// The file has the format of the instances (indices from 1), all the entries are optional:
+//   removed_jobs=[..]; changed_jobs=[..]; changed_latest_end=[..];
+//   added_jobs=k; eligible_machine=[{..},..]; earliest_start=[..]; latest_end=[..]; min_time=[..]; max_time=[..]; size=[..]; attribute=[..];
+class OSP_InstanceDelta
+{
+public:
+    class Job
+    {
+    public:
+        std::set<int> eligible_machines;
+        int earliest_start, latest_end, min_time, max_time, size, attribute;
+    };
+    OSP_InstanceDelta() {}
+    OSP_InstanceDelta(std::string file_name);
+    // the index of each job in the instance after the delta, -1 if removed: the jobs kept are in their order, the added ones follow
+    std::vector<int> NewJobIndices(int jobs) const;
+    std::vector<Job> added_jobs;
+    std::vector<int> removed_jobs;
+    std::vector<std::pair<int,int>> changed_latest_ends; // the job and its new latest end
+};
+
 class OSP_Input
 {
     friend std::ostream& operator<<(std::ostream& os, const OSP_Input& bs);
 public:
     OSP_Input(std::string file_name);
+    OSP_Input(std::istream& is); // the text of an instance in the dzn format (e.g., sent to the server)
+    // part of an instance (a window of the rolling horizon, a region of a reoptimization): only the given jobs and machines (renumbered
+    // in that order, the jobs can go only on the given machines), which are busy until ready_times[m] and in state states[m]. The
+    // schedules of the part are the same as after the busy part of the whole instance
+    OSP_Input(const OSP_Input& in, const std::vector<int>& jobs, const std::vector<int>& machines, const std::vector<int>& ready_times, const std::vector<int>& states);
+    OSP_Input(const OSP_Input& in, const OSP_InstanceDelta& delta); // the instance after the delta
     
     // getters for plain numbers and counters
     int Machines() const { return machines; }
@@ -38,7 +68,7 @@ public:
     std::vector<std::vector<int>> SetupTimes() const { return setup_times; }
     
     // getters for jobs related characteristics
-    std::set<int> EligibleMachineSet(int j) const { return eligible_machine_set[j]; }
+    const std::set<int>& EligibleMachineSet(int j) const { return eligible_machine_set[j]; }
     bool IsMachineEligible(int m, int j) const { return eligible_machine_matrix[m][j]; }
     std::vector<std::vector<bool>> EligibleMachineMatrix() const { return eligible_machine_matrix; }
     int EarliestStartJob(int j) const { return earliest_start[j]; }
@@ -61,9 +91,18 @@ public:
     long MultFactorTotalSetUpCosts() const { return mult_factor_total_setupcosts; }
     
     long UpperBoundIntegerObjective() const { return upper_bound_integer_objective; }
+    
+    // lower bounds on the soft costs of the solutions that schedule all the batches (valid for each part instance, on its own jobs)
+    long LowerBoundTotalSetUpCost() const { return lower_bound_setup_cost; }
+    long LowerBoundTardyJobs() const { return lower_bound_tardy_jobs; }
+    long LowerBoundCumulativeBatchProcessingTime() const { return lower_bound_processing_time; }
+    long LowerBoundObjective() const; // the weighted sum of the three
 private:
     FileFormat FindFileFormat(std::string file_name) const;
     void ReadDznFormat(std::string file_name);
+    void ReadDznFormat(std::istream& is);
+    void ComputeLowerBounds();
+    long JobsUpperBound() const; // the cost of the jobs each alone in a tardy batch after the costliest setup
     
     int machines, jobs, attributes, intervals, horizon;
     std::vector<std::vector<int>> setup_costs, setup_times;
@@ -77,6 +116,7 @@ private:
     std::vector<int> size;
     std::vector<int> attribute;
     long upper_bound_integer_objective, mult_factor_total_runtime, mult_factor_finished_toolate, mult_factor_total_setuptimes, mult_factor_total_setupcosts, running_time_bound;
+    long lower_bound_setup_cost, lower_bound_tardy_jobs, lower_bound_processing_time;
 };
 
 class Batch
@@ -91,6 +131,28 @@ public:
     int setup_time;
 };
 
+class MachineCosts
+{
+    // the costs of some batches, as the cost components count them (or their variation)
+public:
+    long set_up_time;
+    long set_up_cost;
+    long tardy_jobs;
+    long batch_processing_time;
+    long not_scheduled_batches;
+};
+
+class BatchChange
+{
+    // a batch as a move would leave it: the jobs replace the ones of the batch in <machine,position> (the batch disappears if they
+    // are none), or with new_batch they go in a new batch right after the position
+public:
+    int machine;
+    int position;
+    std::set<int> jobs;
+    bool new_batch;
+};
+
 class OSP_Output
 {
     friend std::ostream& operator<<(std::ostream& os, const OSP_Output& out);
@@ -109,7 +171,7 @@ public:
     int MaxCapacityMachine(int m) const { return in.MaxCapacityMachine(m); }
     bool IsMachineEligible(int m, int j) const { return in.IsMachineEligible(m, j); }
     std::vector<std::vector<bool>> EligibleMachineMatrix() const { return in.EligibleMachineMatrix(); }
-    std::set<int> EligibleMachineSet(int j) const { return in.EligibleMachineSet(j); }
+    const std::set<int>& EligibleMachineSet(int j) const { return in.EligibleMachineSet(j); }
     int EarliestStartJob(int j) const { return in.EarliestStartJob(j); }
     int LatestEndJob(int j) const { return in.LatestEndJob(j); }
     int SizeJob(int j) const { return in.SizeJob(j); }
@@ -142,6 +204,11 @@ public:
     void PopulateBatchCharacteristics();
     void PopulateBatchesPerAttribute();
     
+    // binary dump of the whole state, for the checkpoints: the lists sampled by the random moves are included, since their order
+    // depends on the history of the moves
+    void Write(std::ostream& os) const;
+    void Read(std::istream& is); // the state must be of the same instance
+    
     // calculate from scratch the costs
     void CalculateAllCostsFromScratch();
     void CalculateTotalSetUpTime();
@@ -156,10 +223,14 @@ public:
     long GetNumberOfTardyJobs() const { return number_tardy_jobs; }
     long GetCumulativeBatchProcessingTime() const { return cumulative_batch_processing_time; }
     long GetNotScheduledBatches() const { return not_scheduled_batches; }
+    // the variation of the costs if the batches were changed as given, without changing the state: the schedule of a machine depends
+    // only on its batches, so only the changed machines are scheduled again, from their first changed batch on
+    MachineCosts CalculateDeltaCosts(const std::vector<BatchChange>& changes) const;
     
     Batch CalculateBatchProperties(int m, int p);
-    int CalculateBatchStartTime(int machine, int earliest_start, int setup_time, int processing_time, int previous_end);
-    int CalculateEarliestSuitableMachineIntervalStart(int machine, int earliest_start, int setup_time, int processing_time);
+    Batch CalculateBatchProperties(int m, const std::set<int>& jobs, const Batch* previous) const; // previous is nullptr for the first batch
+    int CalculateBatchStartTime(int machine, int earliest_start, int setup_time, int processing_time, int previous_end) const;
+    int CalculateEarliestSuitableMachineIntervalStart(int machine, int earliest_start, int setup_time, int processing_time) const;
     
     // modifiers
     void ModifyJobToBatchPosition(int job, int machine, int position) { job_to_batch_position[job] = std::make_pair(machine, position); }
@@ -168,18 +239,51 @@ public:
     void InsertBatchToNewPosition (int m, int o_p, int n_p); // this only modifies the solution data structure, then you need to do something for the costs...
     void InsertJobInExistingBatch(int job, std::pair<int,int> old_machine_position, std::pair<int,int> new_machine_position);
     void InsertJobToNewBatch (int job, std::pair<int,int> old_position, std::pair<int,int> new_position, bool is_alone);
-    void InsertBatchToNewMachine (std::set<int> jobs_to_move, std::pair<int,int> old_position, std::pair<int,int> new_position);
+    void InsertBatchToNewMachine (const std::set<int>& jobs_to_move, std::pair<int,int> old_position, std::pair<int,int> new_position);
+    void ExchangeJobs(int job_1, int job_2); // the two jobs must have the same attribute, so the batches keep their attributes
+    void InsertBatchInExistingBatch(std::pair<int,int> source_position, std::pair<int,int> target_position); // the source batch disappears
+    void ExtractJobsToNextBatch(int m, int p, const std::set<int>& jobs_to_extract); // the jobs go in a new batch in position p + 1
     void InverseBatchesInMachine(int m, int p_1, int p_2);
+    void ReorderBatchesInMachine(int m, int p, const int order[], int length); // position p + i gets the batch that was in position p + order[i]
     
     // checkers for moves
     bool IsJobCompatibleForBatch(int job, int machine, int position) const;
+    bool IsJobCompatibleForBatchWithout(int job, int job_out, int machine, int position) const; // job takes the place of job_out in the batch
+    bool IsBatchCompatibleForBatch(int source_machine, int source_position, int target_machine, int target_position) const; // all the jobs of the source can join the target
+    bool IsJobTardy(int job) const; // same definition of CalculateNumberOfTardyJobs
     
     // getters for solution components
     int GetBatchesPerMachine(int m) const { return batches_per_machine[m]; }
-    std::set<int> GetJobsAtBatchPosition (int m, int p) const { return jobs_at_batch_position[m][p]; }
+    // machines with at least one (two) batches, to sample them directly in the random moves
+    int NumberOfMachinesWithBatches() const { return (int) machines_with_batches.size(); }
+    int GetMachineWithBatches(int i) const { return machines_with_batches[i]; }
+    int NumberOfMachinesWithMoreBatches() const { return (int) machines_with_more_batches.size(); }
+    int GetMachineWithMoreBatches(int i) const { return machines_with_more_batches[i]; }
+    // hot jobs (tardy or in a batch past the horizon) and batches past the horizon, updated with the costs
+    int NumberOfHotJobs() const { return (int) hot_jobs.size(); }
+    int GetHotJob(int i) const { return hot_jobs[i]; }
+    int NumberOfMachinesWithUnscheduledBatches() const { return (int) machines_with_unscheduled_batches.size(); }
+    int GetMachineWithUnscheduledBatches(int i) const { return machines_with_unscheduled_batches[i]; }
+    int GetFirstUnscheduledPosition(int m) const { return first_unscheduled_position[m]; }
+    const std::set<int>& GetJobsAtBatchPosition (int m, int p) const { return jobs_at_batch_position[m][p]; }
     std::pair<int,int> GetJobToBatchPosition(int j) const { return job_to_batch_position[j]; }
     Batch GetBatchCharacteristics (int m, int p) const { return batch_characteristics[m][p]; }
-    std::set<std::pair<int,int>> GetBatchesPerAttribute(int a) const { return batches_per_attribute[a]; }
+    const std::set<std::pair<int,int>>& GetBatchesPerAttribute(int a) const { return batches_per_attribute[a]; }
+    
+    // don't-look bits of the exhaustive explorations, one set of bits for each explorer: the explorer sets the bit of a machine (job)
+    // once it has enumerated all its moves, the modifiers clear the bits of what they touch. The sets are numbered in the thread that
+    // builds the explorers, from its last reset (at the start of each run of a batch: the explorers built before are gone, or kept in
+    // a runner graph of the worker, whose runs have states of their own)
+    static int NewDontLookBitsSet() { return dont_look_bits_sets++; }
+    static void ResetDontLookBitsSets() { dont_look_bits_sets = 0; }
+    bool GetDontLookBitMachine(int set, int m) const { return set < (int) dont_look_machines.size() && dont_look_machines[set][m]; }
+    bool GetDontLookBitJob(int set, int j) const { return set < (int) dont_look_jobs.size() && dont_look_jobs[set][j]; }
+    void SetDontLookBitMachine(int set, int m) const;
+    void SetDontLookBitJob(int set, int j) const;
+    
+    // rolling fingerprint of the batch sequence of a machine, kept by the modifiers: the schedule (and the cost) of a machine
+    // depends only on its batch sequence, so equal fingerprints mean (up to collisions) equal schedules
+    uint64_t GetMachineFingerprint(int m) const { return machine_fingerprints[m][batches_per_machine[m]]; }
     
 private:
     // TODO: REMEMBER TO ADD TO THE POPULATION/UPDATION/= WHATEVER YOU PUT HERE
@@ -191,7 +295,29 @@ private:
     std::vector<std::vector<Batch>> batch_characteristics; // batch_characteristics[mach][pos] provides you with the information of the batch located in position pos in machine mach
     std::vector<std::set<std::pair<int,int>>> batches_per_attribute; // for every attribute, which are the batch with that attribute
     
+    // machines with batches_per_machine >= 1 (>= 2), with the position of each machine in the list (-1 if not there)
+    std::vector<int> machines_with_batches, machines_with_more_batches;
+    std::vector<int> index_in_machines_with_batches, index_in_machines_with_more_batches;
+    void UpdateMachinesWithBatches(int m); // to be called every time batches_per_machine[m] changes
+    
+    // maintained by CalculateNumberOfTardyJobs and CalculateNotScheduledBatches, the batches past the horizon are a suffix of each machine
+    std::vector<int> hot_jobs, index_in_hot_jobs;
+    std::vector<int> first_unscheduled_position;
+    std::vector<int> machines_with_unscheduled_batches, index_in_machines_with_unscheduled_batches;
+    
+    // the bits are only a memory of the explorations, not part of the solution, so they can be set on a const state
+    mutable std::vector<std::vector<bool>> dont_look_machines, dont_look_jobs; // dont_look_machines[set][m], empty until a set is used
+    static thread_local int dont_look_bits_sets;
+    void ClearDontLookBits(int m, int p); // machine m has changed from position p on, so have the jobs there
+    
+    std::vector<std::vector<uint64_t>> machine_fingerprints; // machine_fingerprints[m][p] is the fingerprint of the first p batches of m
+    void UpdateMachineFingerprint(int m, int p); // the batches of m from position p on have changed
+    
+    // to be called by every modifier, for each machine it changes, with the first position that has changed
+    void MachineChangedFrom(int m, int p);
+    
     // costs
+    void AddBatchCosts(MachineCosts& costs, const Batch& batch, const std::set<int>& jobs, int sign) const;
     long number_tardy_jobs, total_set_up_time, total_set_up_cost, cumulative_batch_processing_time;
     long not_scheduled_batches;
     
@@ -200,6 +326,20 @@ private:
     void CheckerForBatchesPerAttributeUpdate();
     void CheckerForJobsAtBatchPositionUpdate();
     void CheckForNumberofBatchesUpdate();
+    void CheckerForFingerprintsUpdate();
+};
+
+class MachinePosition
+{
+    // a <machine,position> pair for the moves: unlike std::pair it is trivially copyable
+    friend bool operator==(const MachinePosition& mp1, const MachinePosition& mp2) { return mp1.first == mp2.first && mp1.second == mp2.second; }
+    friend bool operator!=(const MachinePosition& mp1, const MachinePosition& mp2) { return !(mp1 == mp2); }
+public:
+    MachinePosition(int m = -1, int p = -1) { first = m; second = p; }
+    MachinePosition(const std::pair<int,int>& mp) { first = mp.first; second = mp.second; }
+    operator std::pair<int,int>() const { return std::make_pair(first, second); }
+    int first;
+    int second;
 };
 
 class SwapConsecutiveBatchesMove
@@ -241,14 +381,13 @@ class JobToExistingBatch
     friend std::ostream& operator<<(std::ostream& os, const JobToExistingBatch& m);
     friend std::istream& operator>>(std::istream& is, JobToExistingBatch& m);
 public:
-    JobToExistingBatch(int j = -1, int o_m = -1, int o_p = -1, int n_m = -1, int n_p = -1, std::set<std::pair<int,int>> o_p_b = {}) 
-        {job = j; old_machine = o_m; old_position = o_p; new_machine = n_m, new_position = n_p; other_possible_batches = o_p_b;}
+    JobToExistingBatch(int j = -1, int o_m = -1, int o_p = -1, int n_m = -1, int n_p = -1)
+        {job = j; old_machine = o_m; old_position = o_p; new_machine = n_m, new_position = n_p;}
     int job;
     int old_machine;
     int old_position;
-    int new_machine;
+    int new_machine; // the enumeration goes on from <new_machine,new_position> in batches_per_attribute order
     int new_position;
-    std::set<std::pair<int,int>> other_possible_batches;
 };
 
 class JobToNewBatch
@@ -260,11 +399,10 @@ class JobToNewBatch
     friend std::ostream& operator<<(std::ostream& os, const JobToNewBatch& m);
     friend std::istream& operator>>(std::istream& is, JobToNewBatch& m);
 public:
-    JobToNewBatch(int j = -1, std::pair<int,int> o_p = std::make_pair(-1,-1), std::pair<int,int> n_p = std::make_pair(-1,-1), std::set<int> m_t_n = {}, bool i_a = false) {job = j; old_position = o_p; new_position = n_p; machine_to_try_next = m_t_n; is_alone = i_a;}
+    JobToNewBatch(int j = -1, MachinePosition o_p = MachinePosition(), MachinePosition n_p = MachinePosition(), bool i_a = false) {job = j; old_position = o_p; new_position = n_p; is_alone = i_a;}
     int job;
-    std::pair<int,int> old_position;
-    std::pair<int,int> new_position;
-    std::set<int> machine_to_try_next;
+    MachinePosition old_position;
+    MachinePosition new_position; // the enumeration goes on with the eligible machines after new_position.first
     bool is_alone;
 };
 
@@ -276,11 +414,143 @@ class BatchToNewMachine
     friend std::ostream& operator<<(std::ostream& os, const BatchToNewMachine& m);
     friend std::istream& operator>>(std::istream& is, BatchToNewMachine& m);
 public:
-    BatchToNewMachine(std::set<int> j_t_m = {}, std::pair<int,int> o_m_p = std::make_pair(-1,-1), std::pair<int,int> n_m_p = std::make_pair(-1,-1))
-    {jobs_to_move = j_t_m; old_machine_position = o_m_p; new_machine_position = n_m_p;}
-    std::set<int> jobs_to_move;
-    std::pair<int,int> old_machine_position;
-    std::pair<int,int> new_machine_position;
+    BatchToNewMachine(uint64_t j_t_m = 0, MachinePosition o_m_p = MachinePosition(), MachinePosition n_m_p = MachinePosition(), int w_s = 0)
+    {jobs_to_move = j_t_m; old_machine_position = o_m_p; new_machine_position = n_m_p; window_start = w_s;}
+    // bit i is set if the (window_start + i)-th job (in increasing order) of the batch in old_machine_position is moved: the jobs of
+    // a move are taken in a window of MaxJobs jobs of the batch, which starts at 0 unless the batch is larger
+    static constexpr int MaxJobs = 64;
+    uint64_t jobs_to_move;
+    int window_start;
+    MachinePosition old_machine_position;
+    MachinePosition new_machine_position;
+    
+    int NumberOfJobsToMove() const { return __builtin_popcountll(jobs_to_move); }
+    bool IsJobToMove(int index) const { return index < MaxJobs && (jobs_to_move >> index) & 1ULL; }
+    void AddJobToMove(int index) { jobs_to_move |= (1ULL << index); }
+    // expand the mask into the set of jobs (it must be called on the state the move has been drawn from)
+    std::set<int> JobsToMove(const OSP_Output& st) const;
+};
+
+class SwapJobsBetweenBatches
+{
+    // select two jobs with the same attribute in different batches and exchange them
+    friend bool operator==(const SwapJobsBetweenBatches& m1, const SwapJobsBetweenBatches& m2);
+    friend bool operator!=(const SwapJobsBetweenBatches& m1, const SwapJobsBetweenBatches& m2);
+    friend bool operator<(const SwapJobsBetweenBatches& m1, const SwapJobsBetweenBatches& m2);
+    friend std::ostream& operator<<(std::ostream& os, const SwapJobsBetweenBatches& m);
+    friend std::istream& operator>>(std::istream& is, SwapJobsBetweenBatches& m);
+public:
+    SwapJobsBetweenBatches(int j_1 = -1, MachinePosition p_1 = MachinePosition(), int j_2 = -1, MachinePosition p_2 = MachinePosition())
+    { job_1 = j_1; position_1 = p_1; job_2 = j_2; position_2 = p_2; }
+    int job_1; // job_1 < job_2, the enumeration goes on from the pair <job_1,job_2>
+    MachinePosition position_1;
+    int job_2;
+    MachinePosition position_2;
+};
+
+class MergeBatches
+{
+    // move all the jobs of a batch into another batch with the same attribute
+    friend bool operator==(const MergeBatches& m1, const MergeBatches& m2);
+    friend bool operator!=(const MergeBatches& m1, const MergeBatches& m2);
+    friend bool operator<(const MergeBatches& m1, const MergeBatches& m2);
+    friend std::ostream& operator<<(std::ostream& os, const MergeBatches& m);
+    friend std::istream& operator>>(std::istream& is, MergeBatches& m);
+public:
+    MergeBatches(MachinePosition s_p = MachinePosition(), MachinePosition t_p = MachinePosition()) { source_position = s_p; target_position = t_p; }
+    MachinePosition source_position;
+    MachinePosition target_position; // the enumeration goes on from target_position in batches_per_attribute order
+};
+
+class SplitBatch
+{
+    // split a batch in two: the jobs are ordered by latest end, the first split ones stay, the others go in a new batch right after
+    friend bool operator==(const SplitBatch& m1, const SplitBatch& m2);
+    friend bool operator!=(const SplitBatch& m1, const SplitBatch& m2);
+    friend bool operator<(const SplitBatch& m1, const SplitBatch& m2);
+    friend std::ostream& operator<<(std::ostream& os, const SplitBatch& m);
+    friend std::istream& operator>>(std::istream& is, SplitBatch& m);
+public:
+    SplitBatch(MachinePosition p = MachinePosition(), int s = 0) { position = p; split = s; }
+    MachinePosition position;
+    int split;
+
+    // the jobs that go in the new batch (it must be called on the state the move has been drawn from)
+    std::set<int> JobsToNewBatch(const OSP_Output& st) const;
+};
+
+class EjectionChain
+{
+    // jobs[0] (a tardy job) goes in the batch targets[0], from which jobs[1] is ejected and goes in targets[1], and so on;
+    // the last job goes in its target without ejecting anything
+    friend bool operator==(const EjectionChain& m1, const EjectionChain& m2);
+    friend bool operator!=(const EjectionChain& m1, const EjectionChain& m2);
+    friend bool operator<(const EjectionChain& m1, const EjectionChain& m2);
+    friend std::ostream& operator<<(std::ostream& os, const EjectionChain& m);
+    friend std::istream& operator>>(std::istream& is, EjectionChain& m);
+public:
+    EjectionChain() { length = 0; }
+    static constexpr int MaxLength = 3;
+    int length;
+    int jobs[MaxLength];
+    MachinePosition targets[MaxLength];
+};
+
+class RuinAndRecreate
+{
+    // the jobs chosen by the destroy operator are taken out of their batches and reinserted by the repair of the
+    // ruin and recreate neighborhood; the move keeps only the parameters of the destroy, the jobs depend on the state
+    friend bool operator==(const RuinAndRecreate& m1, const RuinAndRecreate& m2);
+    friend bool operator!=(const RuinAndRecreate& m1, const RuinAndRecreate& m2);
+    friend bool operator<(const RuinAndRecreate& m1, const RuinAndRecreate& m2);
+    friend std::ostream& operator<<(std::ostream& os, const RuinAndRecreate& m);
+    friend std::istream& operator>>(std::istream& is, RuinAndRecreate& m);
+public:
+    // TimeWindow: the jobs of the batches that start from time from on (on any machine), in order of start time
+    // MachineSegment: the jobs of the batches of machine from position from on
+    // RelatedJobs: the jobs with the attribute of job from, in order of distance of their due date from the one of job from
+    enum Destroy { TimeWindow, MachineSegment, RelatedJobs };
+    RuinAndRecreate(Destroy d = TimeWindow, int m = -1, int f = -1, int s = 0) { destroy = d; machine = m; from = f; size = s; }
+    Destroy destroy;
+    int machine;
+    int from;
+    int size; // maximum number of jobs removed
+
+    // the jobs removed, in the order of the destroy (it must be called on the state the move has been drawn from)
+    std::vector<int> RemovedJobs(const OSP_Output& st) const;
+};
+
+class ResequenceBatches
+{
+    // the batches of a window of a machine are put in a new order (the best one, found by the resequencing neighborhood)
+    friend bool operator==(const ResequenceBatches& m1, const ResequenceBatches& m2);
+    friend bool operator!=(const ResequenceBatches& m1, const ResequenceBatches& m2);
+    friend bool operator<(const ResequenceBatches& m1, const ResequenceBatches& m2);
+    friend std::ostream& operator<<(std::ostream& os, const ResequenceBatches& m);
+    friend std::istream& operator>>(std::istream& is, ResequenceBatches& m);
+public:
+    ResequenceBatches(int mach = -1, int f = -1, int l = 0) { machine = mach; first = f; length = l; for (int i = 0; i < MaxLength; ++i) order[i] = i; }
+    static constexpr int MaxLength = 8;
+    int machine;
+    int first;
+    int length;
+    int order[MaxLength]; // position first + i gets the batch that was in position first + order[i]
+};
+
+class RegroupBatches
+{
+    // the batches of a segment of a machine are grouped by attribute, the groups in the order of the least setups (the batches
+    // of a group keep their order); the move keeps only the segment, the order depends on the state
+    friend bool operator==(const RegroupBatches& m1, const RegroupBatches& m2);
+    friend bool operator!=(const RegroupBatches& m1, const RegroupBatches& m2);
+    friend bool operator<(const RegroupBatches& m1, const RegroupBatches& m2);
+    friend std::ostream& operator<<(std::ostream& os, const RegroupBatches& m);
+    friend std::istream& operator>>(std::istream& is, RegroupBatches& m);
+public:
+    RegroupBatches(int mach = -1, int f = -1, int l = 0) { machine = mach; first = f; length = l; }
+    int machine;
+    int first;
+    int length;
 };
 
 class SwapBatches
@@ -312,3 +582,16 @@ public:
     int position_1;
     int position_2;
 };
+
+// moves are copied around a lot in the runners (EvaluatedMove, best move, tabu lists...), so they are kept as plain values
+static_assert(std::is_trivially_copyable<JobToExistingBatch>::value, "JobToExistingBatch must be trivially copyable");
+static_assert(std::is_trivially_copyable<JobToNewBatch>::value, "JobToNewBatch must be trivially copyable");
+static_assert(std::is_trivially_copyable<BatchToNewMachine>::value, "BatchToNewMachine must be trivially copyable");
+static_assert(std::is_trivially_copyable<SwapJobsBetweenBatches>::value, "SwapJobsBetweenBatches must be trivially copyable");
+static_assert(std::is_trivially_copyable<MergeBatches>::value, "MergeBatches must be trivially copyable");
+static_assert(std::is_trivially_copyable<SplitBatch>::value, "SplitBatch must be trivially copyable");
+static_assert(std::is_trivially_copyable<EjectionChain>::value, "EjectionChain must be trivially copyable");
+static_assert(std::is_trivially_copyable<RuinAndRecreate>::value, "RuinAndRecreate must be trivially copyable");
+static_assert(std::is_trivially_copyable<ResequenceBatches>::value, "ResequenceBatches must be trivially copyable");
+static_assert(std::is_trivially_copyable<RegroupBatches>::value, "RegroupBatches must be trivially copyable");
+static_assert(sizeof(JobToExistingBatch) <= 64 && sizeof(JobToNewBatch) <= 64 && sizeof(BatchToNewMachine) <= 64 && sizeof(SwapJobsBetweenBatches) <= 64 && sizeof(EjectionChain) <= 64 && sizeof(ResequenceBatches) <= 64, "moves must fit in a cache line");
@@ -2,6 +2,12 @@
 #include <map>
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
 
 // if indipendence is on, then the six moves are indipendent from on another
 
@@ -641,6 +647,370 @@ bool OSP_SolutionManager::CheckConsistency(const OSP_Output& st) const
     return true;
 }
 
+// the integers of the last array with the given key in a JSON text (the trailing commas of the output of the constructive methods are
+// accepted)
+static std::vector<int> ReadLastJSONArray(const std::string& text, const std::string& key)
+{
+    size_t key_position = text.rfind("\"" + key + "\"");
+    if (key_position == std::string::npos)
+    {
+        throw std::invalid_argument("No " + key + " in the solution file");
+    }
+    size_t i = text.find('[', key_position);
+    if (i == std::string::npos)
+    {
+        throw std::invalid_argument("No array for " + key + " in the solution file");
+    }
+    std::vector<int> values;
+    const char* p = text.c_str() + i + 1;
+    while (true)
+    {
+        while (*p == ' ' || *p == ',' || *p == '\n' || *p == '\r' || *p == '\t')
+        {
+            ++p;
+        }
+        if (*p == ']')
+        {
+            return values;
+        }
+        char* end;
+        long value = std::strtol(p, &end, 10);
+        if (end == p)
+        {
+            throw std::invalid_argument("Wrong array for " + key + " in the solution file");
+        }
+        values.push_back((int) value);
+        p = end;
+    }
+}
+
+int OSP_SolutionManager::WarmState(OSP_Output& st, const std::string& file_name) const
+{
+    std::ifstream is(file_name);
+    if (!is)
+    {
+        throw std::invalid_argument("Cannot open the solution file " + file_name);
+    }
+    std::stringstream buffer;
+    buffer << is.rdbuf();
+    std::string text = buffer.str();
+    std::vector<int> batch_for_job = ReadLastJSONArray(text, "batch_for_job");
+    std::vector<int> machine_for_job = ReadLastJSONArray(text, "machine_for_job");
+    if (batch_for_job.size() != machine_for_job.size())
+    {
+        throw std::invalid_argument("The arrays of the solution file " + file_name + " have different lengths");
+    }
+
+    // the batches of the file (1-based) that the jobs still fit in: same attribute, within the capacity and with a common processing
+    // time; the first jobs of a batch keep it, the others are left out
+    struct FileBatch
+    {
+        int attribute, size, min_time, max_time;
+    };
+    std::vector<std::map<int,FileBatch>> file_batches(in.Machines());
+    std::vector<int> left_out;
+    std::vector<std::pair<int,int>> job_to_file_batch(in.Jobs(), std::make_pair(-1, -1));
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        int m = j < (int) machine_for_job.size() ? machine_for_job[j] - 1 : -1;
+        int b = j < (int) batch_for_job.size() ? batch_for_job[j] - 1 : -1;
+        if (m < 0 || m >= in.Machines() || b < 0 || !in.IsMachineEligible(m, j))
+        {
+            left_out.push_back(j);
+            continue;
+        }
+        auto it = file_batches[m].find(b);
+        if (it == file_batches[m].end())
+        {
+            file_batches[m][b] = FileBatch{in.AttributeJob(j), in.SizeJob(j), in.MinTimeJob(j), in.MaxTimeJob(j)};
+        }
+        else
+        {
+            FileBatch& batch = it->second;
+            if (batch.attribute != in.AttributeJob(j) || batch.size + in.SizeJob(j) > in.MaxCapacityMachine(m)
+                || std::max(batch.min_time, in.MinTimeJob(j)) > std::min(batch.max_time, in.MaxTimeJob(j)))
+            {
+                left_out.push_back(j);
+                continue;
+            }
+            batch.size += in.SizeJob(j);
+            batch.min_time = std::max(batch.min_time, in.MinTimeJob(j));
+            batch.max_time = std::min(batch.max_time, in.MaxTimeJob(j));
+        }
+        job_to_file_batch[j] = std::make_pair(m, b);
+    }
+
+    // the batches of each machine keep their order, without the gaps
+    OSP_Output warm(in);
+    std::vector<std::map<int,int>> position_of_file_batch(in.Machines());
+    std::vector<int> batches(in.Machines(), 0);
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        for (const auto& batch : file_batches[m])
+        {
+            position_of_file_batch[m][batch.first] = batches[m]++;
+        }
+    }
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        if (job_to_file_batch[j].first != -1)
+        {
+            int m = job_to_file_batch[j].first;
+            warm.ModifyJobToBatchPosition(j, m, position_of_file_batch[m][job_to_file_batch[j].second]);
+        }
+    }
+    // the jobs left out go alone at the end of the eligible machine with the fewest batches
+    for (int j : left_out)
+    {
+        int best = -1;
+        for (int m : in.EligibleMachineSet(j))
+        {
+            if (best == -1 || batches[m] < batches[best])
+            {
+                best = m;
+            }
+        }
+        if (best == -1)
+        {
+            throw std::invalid_argument("Job " + std::to_string(j) + " has no eligible machine");
+        }
+        warm.ModifyJobToBatchPosition(j, best, batches[best]++);
+    }
+    warm.PopulateAllFromScratch();
+    st = warm;
+    return (int) left_out.size();
+}
+
+OSP_AttributeSequencer::OSP_AttributeSequencer(const OSP_Input& pin) : in(pin)
+{
+    int attributes = in.Attributes();
+    long max_setup_time = 0;
+    for (int a1 = 0; a1 < attributes; ++a1)
+    {
+        for (int a2 = 0; a2 < attributes; ++a2)
+        {
+            max_setup_time = std::max(max_setup_time, (long) in.SetUpTime(a1, a2));
+        }
+    }
+    time_range = max_setup_time * attributes + 1;
+    if (attributes > MaxExactAttributes)
+    {
+        return;
+    }
+    // Held-Karp from each start: the subsets are visited in increasing order, so before their supersets
+    int subsets = 1 << attributes;
+    path_weight.assign((size_t) attributes * subsets * attributes, std::numeric_limits<long>::max());
+    previous.assign(path_weight.size(), -1);
+    for (int start = 0; start < attributes; ++start)
+    {
+        auto index = [start, subsets, attributes](int subset, int last) { return ((size_t) start * subsets + subset) * attributes + last; };
+        for (int a = 0; a < attributes; ++a)
+        {
+            path_weight[index(1 << a, a)] = Weight(start, a);
+        }
+        for (int subset = 1; subset < subsets; ++subset)
+        {
+            for (int last = 0; last < attributes; ++last)
+            {
+                long weight = path_weight[index(subset, last)];
+                if (!(subset & (1 << last)) || weight == std::numeric_limits<long>::max())
+                {
+                    continue;
+                }
+                for (int a = 0; a < attributes; ++a)
+                {
+                    if (!(subset & (1 << a)) && weight + Weight(last, a) < path_weight[index(subset | (1 << a), a)])
+                    {
+                        path_weight[index(subset | (1 << a), a)] = weight + Weight(last, a);
+                        previous[index(subset | (1 << a), a)] = last;
+                    }
+                }
+            }
+        }
+    }
+}
+
+long OSP_AttributeSequencer::Weight(int a1, int a2) const
+{
+    return in.SetUpCost(a1, a2) * in.MultFactorTotalSetUpCosts() * time_range + in.SetUpTime(a1, a2);
+}
+
+std::vector<int> OSP_AttributeSequencer::Sequence(int start_attribute, const std::vector<bool>& present) const
+{
+    int attributes = in.Attributes();
+    std::vector<int> sequence;
+    if (attributes > MaxExactAttributes)
+    {
+        // nearest neighbour
+        std::vector<bool> left = present;
+        for (int current = start_attribute; ; )
+        {
+            int next = -1;
+            for (int a = 0; a < attributes; ++a)
+            {
+                if (left[a] && (next == -1 || Weight(current, a) < Weight(current, next)))
+                {
+                    next = a;
+                }
+            }
+            if (next == -1)
+            {
+                return sequence;
+            }
+            left[next] = false;
+            sequence.push_back(next);
+            current = next;
+        }
+    }
+    int subset = 0;
+    for (int a = 0; a < attributes; ++a)
+    {
+        if (present[a])
+        {
+            subset |= 1 << a;
+        }
+    }
+    if (subset == 0)
+    {
+        return sequence;
+    }
+    auto index = [start_attribute, attributes](int subset, int last) { return ((size_t) start_attribute * (1 << attributes) + subset) * attributes + last; };
+    int last = -1;
+    for (int a = 0; a < attributes; ++a)
+    {
+        if ((subset & (1 << a)) && (last == -1 || path_weight[index(subset, a)] < path_weight[index(subset, last)]))
+        {
+            last = a;
+        }
+    }
+    while (last != -1)
+    {
+        sequence.push_back(last);
+        int before = previous[index(subset, last)];
+        subset &= ~(1 << last);
+        last = before;
+    }
+    std::reverse(sequence.begin(), sequence.end());
+    return sequence;
+}
+
+void OSP_SolutionManagerGrouped::GreedyState(OSP_Output& st)
+{
+    // the jobs go to the eligible machine with the least work (processing time per unit of capacity), in earliest due date order
+    std::vector<int> jobs(st.Jobs());
+    for (int j = 0; j < st.Jobs(); ++j)
+    {
+        jobs[j] = j;
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [&st](int j1, int j2)
+        { return std::make_pair(st.LatestEndJob(j1), st.EarliestStartJob(j1)) < std::make_pair(st.LatestEndJob(j2), st.EarliestStartJob(j2)); });
+    std::vector<double> work(st.Machines(), 0.0);
+    std::vector<std::vector<int>> machine_jobs(st.Machines());
+    for (int j : jobs)
+    {
+        int best = -1;
+        for (int m : st.EligibleMachineSet(j))
+        {
+            if (best == -1 || work[m] < work[best])
+            {
+                best = m;
+            }
+        }
+        if (best == -1)
+        {
+            throw std::invalid_argument("Job " + std::to_string(j) + " has no eligible machine");
+        }
+        machine_jobs[best].push_back(j);
+        work[best] += (double) st.MinTimeJob(j) * st.SizeJob(j) / st.MaxCapacityMachine(best);
+    }
+    int most_jobs = 0;
+    for (const std::vector<int>& mj : machine_jobs)
+    {
+        most_jobs = std::max(most_jobs, (int) mj.size());
+    }
+
+    // the number of rounds of the cheapest solution (the same cost function of the local search)
+    long best_cost = std::numeric_limits<long>::max();
+    for (int rounds = 1; rounds <= std::max(1, std::min(max_rounds, most_jobs)); ++rounds)
+    {
+        OSP_Output trial(in);
+        BuildRounds(trial, machine_jobs, rounds);
+        long cost = HARD_WEIGHT * 2 * in.UpperBoundIntegerObjective() * trial.GetNotScheduledBatches()
+            + trial.GetTotalSetUpCost() * in.MultFactorTotalSetUpCosts() + trial.GetNumberOfTardyJobs() * in.MultFactorFinishedTooLate()
+            + trial.GetCumulativeBatchProcessingTime() * in.MultFactorTotalRunTime();
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            st = trial;
+        }
+    }
+}
+
+void OSP_SolutionManagerGrouped::BuildRounds(OSP_Output& st, const std::vector<std::vector<int>>& machine_jobs, int rounds) const
+{
+    // the batches being filled in a group: the jobs of a batch must share a processing time and must not make it end late, where the end
+    // is the earliest one in the shifts of the machine (without setups); a batch that already ends late takes the jobs that would end
+    // late anyway, as long as it stays in the horizon
+    struct OpenBatch
+    {
+        int position, size, processing_time, max_processing_time, earliest_start, latest_end;
+    };
+    auto earliest_end = [&st](int m, int earliest_start, int processing_time)
+    {
+        return st.CalculateBatchStartTime(m, earliest_start, 0, processing_time, 0) + processing_time;
+    };
+    for (int m = 0; m < st.Machines(); ++m)
+    {
+        const std::vector<int>& mj = machine_jobs[m];
+        int n = (int) mj.size(), position = 0, attribute = in.InitialStateMachine(m);
+        for (int r = 0; r < rounds; ++r)
+        {
+            std::vector<int> round(mj.begin() + (long) r * n / rounds, mj.begin() + (long) (r + 1) * n / rounds);
+            std::vector<bool> present(st.Attributes(), false);
+            for (int j : round)
+            {
+                present[st.AttributeJob(j)] = true;
+            }
+            for (int a : sequencer.Sequence(attribute, present))
+            {
+                std::vector<OpenBatch> group;
+                for (int j : round)
+                {
+                    if (st.AttributeJob(j) != a)
+                    {
+                        continue;
+                    }
+                    bool placed = false;
+                    int job_end = earliest_end(m, st.EarliestStartJob(j), st.MinTimeJob(j));
+                    for (OpenBatch& b : group)
+                    {
+                        int processing_time = std::max(b.processing_time, st.MinTimeJob(j));
+                        int max_processing_time = std::min(b.max_processing_time, st.MaxTimeJob(j));
+                        int earliest_start = std::max(b.earliest_start, st.EarliestStartJob(j));
+                        int latest_end = std::min(b.latest_end, st.LatestEndJob(j));
+                        int end = earliest_end(m, earliest_start, processing_time);
+                        if (b.size + st.SizeJob(j) <= st.MaxCapacityMachine(m) && processing_time <= max_processing_time
+                            && (end <= latest_end || (earliest_end(m, b.earliest_start, b.processing_time) > b.latest_end && job_end > st.LatestEndJob(j) && end <= st.Horizon())))
+                        {
+                            b = {b.position, b.size + st.SizeJob(j), processing_time, max_processing_time, earliest_start, latest_end};
+                            st.ModifyJobToBatchPosition(j, m, b.position);
+                            placed = true;
+                            break;
+                        }
+                    }
+                    if (!placed)
+                    {
+                        group.push_back({position, st.SizeJob(j), st.MinTimeJob(j), st.MaxTimeJob(j), st.EarliestStartJob(j), st.LatestEndJob(j)});
+                        st.ModifyJobToBatchPosition(j, m, position++);
+                    }
+                }
+                attribute = a;
+            }
+        }
+    }
+    st.PopulateAllFromScratch();
+}
+
 void OSP_TotalSetUpTime::PrintViolations(const OSP_Output& st, std::ostream& os) const
 {
     for(int m = 0; m < in.Machines(); ++m)
@@ -712,14 +1082,98 @@ void OSP_NotScheduledBatches::PrintViolations(const OSP_Output& st, std::ostream
     }
 }
 
+int OSP_FocusedSampling::RandomJob(const OSP_Output& st) const
+{
+    if (st.NumberOfHotJobs() > 0 && focus_probability > 0.0 && Random::Uniform<double>(0.0, 1.0) < focus_probability)
+    {
+        return st.GetHotJob(Random::Uniform<int>(0, st.NumberOfHotJobs() - 1));
+    }
+    return Random::Uniform<int>(0, st.Jobs() - 1);
+}
+
+bool OSP_FocusedSampling::RandomHotBatch(const OSP_Output& st, MachinePosition& position) const
+{
+    if (st.NumberOfMachinesWithUnscheduledBatches() == 0 || focus_probability == 0.0 || Random::Uniform<double>(0.0, 1.0) >= focus_probability)
+    {
+        return false;
+    }
+    position.first = st.GetMachineWithUnscheduledBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithUnscheduledBatches() - 1));
+    position.second = Random::Uniform<int>(st.GetFirstUnscheduledPosition(position.first), st.GetBatchesPerMachine(position.first) - 1);
+    return true;
+}
+
+bool OSP_DontLookBits::NextMachineToLook(const OSP_Output& st, int& machine) const
+{
+    if (machine >= 0 && dont_look_bits)
+    {
+        st.SetDontLookBitMachine(dont_look_bits_set, machine);
+    }
+    do
+    {
+        machine++;
+    }
+    while (machine < st.Machines() && dont_look_bits && st.GetDontLookBitMachine(dont_look_bits_set, machine));
+    return machine < st.Machines();
+}
+
+bool OSP_DontLookBits::NextJobToLook(const OSP_Output& st, int& job) const
+{
+    if (job >= 0 && dont_look_bits)
+    {
+        st.SetDontLookBitJob(dont_look_bits_set, job);
+    }
+    do
+    {
+        job++;
+    }
+    while (job < st.Jobs() && dont_look_bits && st.GetDontLookBitJob(dont_look_bits_set, job));
+    return job < st.Jobs();
+}
+
+bool OSP_DontLookBits::NextBatchPositionToLook(const OSP_Output& st, MachinePosition& position) const
+{
+    // the machine whose batches are being enumerated, -1 at the beginning or after a jump
+    int machine = position.second == -1 ? -1 : position.first;
+    while (NextBatchPosition(st, position))
+    {
+        if (position.first == machine)
+        {
+            return true;
+        }
+        if (machine != -1 && dont_look_bits)
+        {
+            st.SetDontLookBitMachine(dont_look_bits_set, machine);
+        }
+        machine = position.first;
+        if (!dont_look_bits || !st.GetDontLookBitMachine(dont_look_bits_set, machine))
+        {
+            return true;
+        }
+        // jump to the last batch of the machine, the next one will be on another machine
+        position.second = st.GetBatchesPerMachine(machine) - 1;
+        machine = -1;
+    }
+    if (machine != -1 && dont_look_bits)
+    {
+        st.SetDontLookBitMachine(dont_look_bits_set, machine);
+    }
+    return false;
+}
+
 void OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer::RandomMove(const OSP_Output& st, SwapConsecutiveBatchesMove& mv) const
 {
 // #if !defined(NDEBUG)
 //    std::cout << "OSP_SwapBatchesMoveNeighborhoodExplorer: In RandomMove" << std::endl;
 // #endif
-    do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const SwapConsecutiveBatchesMove& mv) const
@@ -745,24 +1199,11 @@ void OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer::AnyRandomMove(const OSP
     // #if !defined(NDEBUG)
     // std::cout << "OSP_SwapBatchesMoveNeighborhoodExplorer: In AnyRandomMove" << std::endl;
     // #endif
-    bool at_least_one = false;
-    for (int m = 0; m < st.Machines(); ++m)
-    {
-        if (st.GetBatchesPerMachine(m) > 1)
-        {
-            at_least_one = true;
-            break;
-        }
-    }
-    if (!at_least_one)
+    if (st.NumberOfMachinesWithMoreBatches() == 0)
     {
         throw EmptyNeighborhood();
     }
-    
-    do
-    {
-        mv.machine = Random::Uniform<int>(0,st.Machines()-1);
-    } while (st.GetBatchesPerMachine(mv.machine) <= 1);
+    mv.machine = st.GetMachineWithMoreBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithMoreBatches() - 1));
     
     // select a random position between 0 and position - 2, that will be the first position
     int batch_in_machine = st.GetBatchesPerMachine(mv.machine);
@@ -786,12 +1227,11 @@ void OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer::FirstMove(const OSP_Out
     mv.position_2 = -1;
     while(true)
     {
-        mv.machine = mv.machine + 1;
-        if (mv.machine >= st.Machines())
+        if (!NextMachineToLook(st, mv.machine))
         {
             throw EmptyNeighborhood();
         }
-        if (st.GetBatchesPerMachine(mv.machine) > 1 && mv.machine < st.Machines())
+        if (st.GetBatchesPerMachine(mv.machine) > 1)
         {
             mv.position_1 = 0;
             mv.position_2 = 1;
@@ -818,8 +1258,7 @@ bool OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer::NextMove(const OSP_Outp
     {
         while (true)
         {
-            mv.machine += 1;
-            if (mv.machine >= st.Machines())
+            if (!NextMachineToLook(st, mv.machine))
             {
                 return false;
             }
@@ -838,9 +1277,15 @@ bool OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer::NextMove(const OSP_Outp
 void OSP_BatchToNewPositionNeighborhoodExplorer::RandomMove(const OSP_Output& st, BatchToNewPositionMove& mv) const
 {
     // std::cout << "OSP_BatchToNewPositionNeighborhoodExplorer: In RandomMove" << std::endl;
-     do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool OSP_BatchToNewPositionNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const BatchToNewPositionMove& mv) const
@@ -866,30 +1311,29 @@ void OSP_BatchToNewPositionNeighborhoodExplorer::AnyRandomMove(const OSP_Output&
 // #if !defined(NDEBUG)
 //    std::cout << "OSP_BatchToNewPositionMoveNeighborhoodExplorer: In RandomMove" << std::endl;
 // #endif
-    bool at_least_one = false;
-
-    for (int m = 0; m < st.Machines(); ++m)
+    if (st.NumberOfMachinesWithMoreBatches() == 0)
     {
-        if (st.GetBatchesPerMachine(m) > 1)
-        {
-            at_least_one = true;
-            break;
-        }
+        throw EmptyNeighborhood();
     }
-    if (!at_least_one)
+    MachinePosition hot_batch;
+    if (RandomHotBatch(st, hot_batch) && st.GetBatchesPerMachine(hot_batch.first) > 1)
     {
-        throw EmptyNeighborhood();
+        mv.machine = hot_batch.first;
+        mv.old_position = hot_batch.second;
     }
-    do
+    else
     {
-        mv.machine = Random::Uniform<int>(0,st.Machines()-1);
-    } while (st.GetBatchesPerMachine(mv.machine) <= 1);
-    // select a random position
+        mv.machine = st.GetMachineWithMoreBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithMoreBatches() - 1));
+        // select a random position
+        mv.old_position = Random::Uniform<int>(0, st.GetBatchesPerMachine(mv.machine) - 1);
+    }
     int batch_in_machine = st.GetBatchesPerMachine(mv.machine);
-    mv.old_position = Random::Uniform<int>(0, batch_in_machine - 1);
-    do {
-        mv.new_position = Random::Uniform<int>(0, batch_in_machine - 1);
-    } while (mv.new_position == mv.old_position);
+    // any position but the old one
+    mv.new_position = Random::Uniform<int>(0, batch_in_machine - 2);
+    if (mv.new_position >= mv.old_position)
+    {
+        mv.new_position++;
+    }
 
 }
 
@@ -968,9 +1412,15 @@ bool OSP_BatchToNewPositionNeighborhoodExplorer::NextMove(const OSP_Output& st,
 void OSP_JobToExistingBatchNeighborhoodExplorer::RandomMove(const OSP_Output& st, JobToExistingBatch& mv) const
 {
     // std::cout << "OSP_JobToExistingBatchNeighborhoodExplorer: In RandomMove" << std::endl;
-    do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool OSP_JobToExistingBatchNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const JobToExistingBatch& mv) const
@@ -981,79 +1431,53 @@ bool OSP_JobToExistingBatchNeighborhoodExplorer::FeasibleMove(const OSP_Output&
 
 void OSP_JobToExistingBatchNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, JobToExistingBatch& mv) const
 {
-    std::set<int> job_to_scan;
-    for (int j = 0;  j < st.Jobs(); ++j)
+    // jobs are drawn at random, if none of them has a compatible batch, the jobs are scanned (from a random one) to be sure the neighborhood is empty
+    int first_job = Random::Uniform<int>(0, st.Jobs() - 1);
+    for (int k = 0; k < max_random_move_attempts + st.Jobs(); ++k)
     {
-        job_to_scan.insert(j);
+        int job = k < max_random_move_attempts ? RandomJob(st) : (first_job + k - max_random_move_attempts) % st.Jobs();
+        if (RandomCompatibleBatch(st, job, mv))
+        {
+            return;
+        }
     }
-    
-    while (job_to_scan.size() > 0)
+    throw EmptyNeighborhood();
+}
+
+bool OSP_JobToExistingBatchNeighborhoodExplorer::RandomCompatibleBatch(const OSP_Output& st, int job, JobToExistingBatch& mv) const
+{
+    const std::set<std::pair<int,int>>& batches = st.GetBatchesPerAttribute(st.AttributeJob(job));
+    int compatible_batches = 0;
+    for (std::pair<int,int> batch : batches)
     {
-        mv.job = -1;
-        mv.new_machine = -1;
-        mv.new_position = -1;
-        mv.old_machine = -1;
-        mv.old_position = -1;
-        mv.other_possible_batches.clear();
-        
-        // randomly select a job from job_to_scan
-        int k = Random::Uniform<int>(0, (int) job_to_scan.size() - 1);
-        for (int job : job_to_scan)
+        if (st.IsJobCompatibleForBatch(job, batch.first, batch.second))
         {
-            mv.job = job;
-            if (k == 0)
-            {
-                break;
-            }
-            k--;
+            compatible_batches++;
         }
-        // remove it from the set of job_to_scan
-        job_to_scan.erase(mv.job);
-        // update old machine and position
-        mv.old_machine = st.GetJobToBatchPosition(mv.job).first;
-        mv.old_position = st.GetJobToBatchPosition(mv.job).second;
-        
-        // retrieve feasible batches
-        int attribute = st.AttributeJob(mv.job);
-        mv.other_possible_batches = st.GetBatchesPerAttribute(attribute);
-        for (auto it = mv.other_possible_batches.begin(); it != mv.other_possible_batches.end();)
-        {
-            std::pair<int,int> current_batch = *it; // Get the batch from the iterator
-
-            if (!st.IsJobCompatibleForBatch(mv.job, current_batch.first, current_batch.second))
-            {
-                it = mv.other_possible_batches.erase(it); // Erase and get the next iterator
-            }
-            else
-            {
-                ++it; // Move to the next iterator
-            }
-        }
-        
-        // if feasible batches == 0
-            // continue
-        if (mv.other_possible_batches.size() == 0)
-        {
-            continue;
-        }
-        // retrieve a feasible bacth
-        int y = Random::Uniform<int>(0, (int)mv.other_possible_batches.size() - 1);
-        for (std::pair<int,int> batch : mv.other_possible_batches)
+    }
+    if (compatible_batches == 0)
+    {
+        return false;
+    }
+    mv.job = job;
+    mv.old_machine = st.GetJobToBatchPosition(job).first;
+    mv.old_position = st.GetJobToBatchPosition(job).second;
+    // retrieve a feasible batch
+    int y = Random::Uniform<int>(0, compatible_batches - 1);
+    for (std::pair<int,int> batch : batches)
+    {
+        if (st.IsJobCompatibleForBatch(job, batch.first, batch.second))
         {
-            mv.new_machine = batch.first;
-            mv.new_position = batch.second;
             if (y == 0)
             {
+                mv.new_machine = batch.first;
+                mv.new_position = batch.second;
                 break;
             }
             y--;
         }
-        // remove it from feasible bacthes
-        mv.other_possible_batches.erase(std::make_pair(mv.new_machine, mv.new_position));
-        return;
     }
-    
-    throw(EmptyNeighborhood());
+    return true;
 }
 
 void OSP_JobToExistingBatchNeighborhoodExplorer::MakeMove(OSP_Output& st, const JobToExistingBatch& mv) const
@@ -1070,95 +1494,77 @@ void OSP_JobToExistingBatchNeighborhoodExplorer::FirstMove(const OSP_Output& st,
     mv.job = -1;
     while(true)
     {
-        mv.job += 1;
-        if (mv.job >= st.Jobs())
+        if (!NextJobToLook(st, mv.job))
         {
             throw EmptyNeighborhood();
         }
         mv.old_machine = st.GetJobToBatchPosition(mv.job).first;
         mv.old_position = st.GetJobToBatchPosition(mv.job).second;
-        int attribute = st.AttributeJob(mv.job);
-        mv.other_possible_batches = st.GetBatchesPerAttribute(attribute);
-        for (auto it = mv.other_possible_batches.begin(); it != mv.other_possible_batches.end();)
+        mv.new_machine = -1;
+        mv.new_position = -1;
+        if (NextCompatibleBatch(st, mv))
         {
-            std::pair<int,int> current_batch = *it; // Get the batch from the iterator
+            break;
+        }
+    }
+}
 
-            if (!st.IsJobCompatibleForBatch(mv.job, current_batch.first, current_batch.second))
-            {
-                it = mv.other_possible_batches.erase(it); // Erase and get the next iterator
-            }
-            else
-            {
-                ++it; // Move to the next iterator
-            }
+bool OSP_JobToExistingBatchNeighborhoodExplorer::NextMove(const OSP_Output& st, JobToExistingBatch& mv) const
+{
+    if (NextCompatibleBatch(st, mv))
+    {
+        return true;
+    }
+    while(true)
+    {
+        if (!NextJobToLook(st, mv.job))
+        {
+            return false;
         }
-        if (mv.other_possible_batches.size() == 0)
+        mv.old_machine = st.GetJobToBatchPosition(mv.job).first;
+        mv.old_position = st.GetJobToBatchPosition(mv.job).second;
+        mv.new_machine = -1;
+        mv.new_position = -1;
+        if (NextCompatibleBatch(st, mv))
         {
-            continue;
+            return true;
         }
-        std::pair<int,int> new_machine_position = *mv.other_possible_batches.begin();
-        mv.other_possible_batches.erase(new_machine_position);
-        mv.new_machine = new_machine_position.first;
-        mv.new_position = new_machine_position.second;
-        break;
     }
 }
 
-bool OSP_JobToExistingBatchNeighborhoodExplorer::NextMove(const OSP_Output& st, JobToExistingBatch& mv) const
+bool OSP_JobToExistingBatchNeighborhoodExplorer::NextCompatibleBatch(const OSP_Output& st, JobToExistingBatch& mv) const
 {
-    if (!mv.other_possible_batches.empty())
+    // the batches of an attribute are ordered, so the current batch of the move is enough to know where to restart from
+    const std::set<std::pair<int,int>>& batches = st.GetBatchesPerAttribute(st.AttributeJob(mv.job));
+    auto it = batches.begin();
+    if (mv.new_machine != -1)
     {
-        std::pair<int,int> next_batch = *mv.other_possible_batches.begin();
-        mv.other_possible_batches.erase(next_batch);
-        mv.new_machine = next_batch.first;
-        mv.new_position = next_batch.second;
+        it = batches.upper_bound(std::make_pair(mv.new_machine, mv.new_position));
     }
-    else
+    for (; it != batches.end(); ++it)
     {
-        while(true)
+        if (st.IsJobCompatibleForBatch(mv.job, it->first, it->second))
         {
-            mv.job+=1;
-            if(mv.job >= st.Jobs())
-            {
-                return false;
-            }
-            mv.old_machine = st.GetJobToBatchPosition(mv.job).first;
-            mv.old_position = st.GetJobToBatchPosition(mv.job).second;
-            int attribute = st.AttributeJob(mv.job);
-            mv.other_possible_batches = st.GetBatchesPerAttribute(attribute);
-            for (auto it = mv.other_possible_batches.begin(); it != mv.other_possible_batches.end();)
-            {
-                std::pair<int,int> current_batch = *it; // Get the batch from the iterator
-
-                if (!st.IsJobCompatibleForBatch(mv.job, current_batch.first, current_batch.second))
-                {
-                    it = mv.other_possible_batches.erase(it); // Erase and get the next iterator
-                }
-                else
-                {
-                    ++it; // Move to the next iterator
-                }
-            }
-            if (mv.other_possible_batches.size() == 0)
-            {
-                continue;
-            }
-            std::pair<int,int> new_machine_position = *mv.other_possible_batches.begin();
-            mv.other_possible_batches.erase(new_machine_position);
-            mv.new_machine = new_machine_position.first;
-            mv.new_position = new_machine_position.second;
-            break;
+            mv.new_machine = it->first;
+            mv.new_position = it->second;
+            return true;
         }
     }
-    return true;
+    return false;
 }
 
 void OSP_JobToNewBatchNeighborhoodExplorer::RandomMove(const OSP_Output& st, JobToNewBatch& mv) const
 {
     // std::cout << "OSP_JobToNewBatchNeighborhoodExplorer: In RandomMove" << std::endl;
-    do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool OSP_JobToNewBatchNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const JobToNewBatch& mv) const
@@ -1184,18 +1590,17 @@ bool OSP_JobToNewBatchNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, c
 void OSP_JobToNewBatchNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, JobToNewBatch& mv) const
 {
     // randomly select one job
-    mv.machine_to_try_next.clear();
     mv.is_alone = false;
-    mv.job = Random::Uniform<int>(0, st.Jobs()-1);
+    mv.job = RandomJob(st);
     mv.old_position = st.GetJobToBatchPosition(mv.job);
     if (st.GetJobsAtBatchPosition(mv.old_position.first, mv.old_position.second).size() == 1)
     {
         mv.is_alone = true;
     }
     // randomly select one position
-    mv.machine_to_try_next = st.EligibleMachineSet(mv.job);
-    int index_machine = Random::Uniform<int> (0, (int) (mv.machine_to_try_next.size() - 1));
-    for (int machine : mv.machine_to_try_next)
+    const std::set<int>& eligible_machines = st.EligibleMachineSet(mv.job);
+    int index_machine = Random::Uniform<int> (0, (int) (eligible_machines.size() - 1));
+    for (int machine : eligible_machines)
     {
         mv.new_position.first = machine;
         if (index_machine == 0)
@@ -1204,7 +1609,6 @@ void OSP_JobToNewBatchNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st,
         }
         index_machine--;
     }
-    mv.machine_to_try_next.erase(mv.new_position.first);
     // if the machine has not enough space for the job --> this will be taken care by the feasibility checker
     if (mv.new_position.first == mv.old_position.first && mv.is_alone)
     {
@@ -1231,60 +1635,24 @@ void OSP_JobToNewBatchNeighborhoodExplorer::FirstMove(const OSP_Output& st, JobT
     mv.job = -1;
     while(true)
     {
-        mv.job += 1;
-        mv.is_alone = false;
-        if (mv.job >= st.Jobs())
+        if (!NextJobToLook(st, mv.job))
         {
             throw EmptyNeighborhood();
         }
-        mv.old_position = st.GetJobToBatchPosition(mv.job);
-        if (st.GetJobsAtBatchPosition(mv.old_position.first, mv.old_position.second).size() == 1)
-        {
-            mv.is_alone = true;
-        }
-        mv.machine_to_try_next = st.EligibleMachineSet(mv.job);
-        bool found_machine = false;
-        while(!found_machine)
+        StartEnumerationForJob(st, mv);
+        while (NextEligibleMachine(st, mv))
         {
-            if (mv.machine_to_try_next.size() > 0)
+            if (FirstPositionOnMachine(st, mv))
             {
-                mv.new_position.first = *mv.machine_to_try_next.begin();
-                mv.machine_to_try_next.erase(mv.new_position.first);
-                if (st.SizeJob(mv.job) <= st.MaxCapacityMachine(mv.new_position.first))
-                {
-                    found_machine = true;
-                }
-            }
-            else
-            {
-                break;
+                return;
             }
         }
-        if (!found_machine) // you may have not found the machine for the job, so you try with another job.
-        {
-            continue;
-        }
-        mv.new_position.second = 0;
-        if (mv.is_alone && mv.new_position == mv.old_position && st.GetBatchesPerMachine(mv.new_position.first) > 2)
-        {
-            mv.new_position.second = 2;
-            break;
-        }
-        else if (!mv.is_alone || (mv.is_alone && mv.new_position != mv.old_position))
-        {
-            break;
-        }
-        else
-        {
-            continue;
-        }
-        
+        // you may have not found the machine for the job, so you try with another job.
     }
 }
 
 bool OSP_JobToNewBatchNeighborhoodExplorer::NextMove(const OSP_Output& st, JobToNewBatch& mv) const
 {
-    bool found_machine = false;
     if ((mv.is_alone && mv.old_position.first != mv.new_position.first && mv.new_position.second < st.GetBatchesPerMachine(mv.new_position.first))
         || (mv.is_alone && mv.old_position.first == mv.new_position.first && mv.new_position.second < st.GetBatchesPerMachine(mv.new_position.first)-1)
         || (!mv.is_alone && mv.new_position.second < st.GetBatchesPerMachine(mv.new_position.first))) // go on in the same machine
@@ -1292,97 +1660,80 @@ bool OSP_JobToNewBatchNeighborhoodExplorer::NextMove(const OSP_Output& st, JobTo
         mv.new_position.second += 1;
         return true;
     }
-    else if (mv.machine_to_try_next.size() > 0) // begin with a new machine
+    // begin with a new machine
+    while (NextEligibleMachine(st, mv))
     {
-        while(!found_machine)
+        if (FirstPositionOnMachine(st, mv))
         {
-            if (mv.machine_to_try_next.size() > 0)
-            {
-                mv.new_position.first = *mv.machine_to_try_next.begin();
-                mv.machine_to_try_next.erase(mv.new_position.first);
-                if (st.SizeJob(mv.job) <= st.MaxCapacityMachine(mv.new_position.first))
-                {
-                    found_machine = true;
-                }
-            }
-            else
-            {
-                break;
-            }
-            if (found_machine) // you may have not found the machine for the job, so you try with another job.
-            {
-                mv.new_position.second = 0;
-                if (mv.is_alone && mv.new_position == mv.old_position && st.GetBatchesPerMachine(mv.new_position.first) > 2)
-                {
-                    mv.new_position.second = 2;
-                    return true;
-                }
-                else if (!mv.is_alone || (mv.is_alone && mv.new_position != mv.old_position))
-                {
-                    return true;
-                }
-            }
+            return true;
         }
     }
-    
-    if (!found_machine)
+    // begin with a new job
+    while (true)
     {
-        while (true)
+        if (!NextJobToLook(st, mv.job))
         {
-            mv.job += 1;
-            mv.is_alone = false;
-            if (mv.job >= st.Jobs())
-            {
-                return false;
-            }
-            mv.old_position = st.GetJobToBatchPosition(mv.job);
-            if (st.GetJobsAtBatchPosition(mv.old_position.first, mv.old_position.second).size() == 1)
-            {
-                mv.is_alone = true;
-            }
-            mv.machine_to_try_next = st.EligibleMachineSet(mv.job);
-            found_machine = false;
-            while(!found_machine)
-            {
-                if (mv.machine_to_try_next.size() > 0)
-                {
-                    mv.new_position.first = *mv.machine_to_try_next.begin();
-                    mv.machine_to_try_next.erase(mv.new_position.first);
-                    if (st.SizeJob(mv.job) <= st.MaxCapacityMachine(mv.new_position.first))
-                    {
-                        found_machine = true;
-                    }
-                }
-                else
-                {
-                    break;
-                }
-            }
-            if (!found_machine) // you may have not found the machine for the job, so you try with another job.
-            {
-                continue;
-            }
-            mv.new_position.second = 0;
-            if (mv.is_alone && mv.new_position == mv.old_position && st.GetBatchesPerMachine(mv.new_position.first) > 2)
-            {
-                mv.new_position.second = 2;
-                return true;
-            }
-            else if (!mv.is_alone || (mv.is_alone && mv.new_position != mv.old_position))
+            return false;
+        }
+        StartEnumerationForJob(st, mv);
+        while (NextEligibleMachine(st, mv))
+        {
+            if (FirstPositionOnMachine(st, mv))
             {
                 return true;
             }
         }
     }
+}
+
+void OSP_JobToNewBatchNeighborhoodExplorer::StartEnumerationForJob(const OSP_Output& st, JobToNewBatch& mv) const
+{
+    mv.old_position = st.GetJobToBatchPosition(mv.job);
+    mv.is_alone = st.GetJobsAtBatchPosition(mv.old_position.first, mv.old_position.second).size() == 1;
+    mv.new_position = MachinePosition(-1, -1);
+}
+
+bool OSP_JobToNewBatchNeighborhoodExplorer::NextEligibleMachine(const OSP_Output& st, JobToNewBatch& mv) const
+{
+    // machines are scanned in increasing order, so the current machine of the move is enough to know where to restart from
+    for (int m = mv.new_position.first + 1; m < st.Machines(); ++m)
+    {
+        if (st.IsMachineEligible(m, mv.job) && st.SizeJob(mv.job) <= st.MaxCapacityMachine(m))
+        {
+            mv.new_position.first = m;
+            return true;
+        }
+    }
     return false;
 }
 
+bool OSP_JobToNewBatchNeighborhoodExplorer::FirstPositionOnMachine(const OSP_Output& st, JobToNewBatch& mv) const
+{
+    mv.new_position.second = 0;
+    if (mv.is_alone && mv.new_position == mv.old_position)
+    {
+        if (st.GetBatchesPerMachine(mv.new_position.first) > 2)
+        {
+            mv.new_position.second = 2;
+            return true;
+        }
+        return false;
+    }
+    return true;
+}
+
 void OSP_BatchToNewMachineNeighborhoodExplorer::RandomMove(const OSP_Output& st, BatchToNewMachine& mv) const
 {
     // std::cout << "OSP_BatchToNewMachineNeighborhoodExplorer: In RandomMove" << std::endl;
-    do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool OSP_BatchToNewMachineNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const BatchToNewMachine& mv) const
@@ -1397,33 +1748,31 @@ bool OSP_BatchToNewMachineNeighborhoodExplorer::FeasibleMove(const OSP_Output& s
 
 void OSP_BatchToNewMachineNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, BatchToNewMachine& mv) const
 {
-    mv.jobs_to_move = {};
-    mv.old_machine_position = std::make_pair(-1,-1);
-    mv.new_machine_position = std::make_pair(-1,-1);
+    mv.jobs_to_move = 0;
+    mv.window_start = 0;
+    mv.old_machine_position = MachinePosition(-1,-1);
+    mv.new_machine_position = MachinePosition(-1,-1);
     // randomly select one machine position
-    int m;
-    do
+    if (st.NumberOfMachinesWithBatches() == 0)
     {
-        m = Random::Uniform<int> (0, (st.Machines() - 1));
-    } while (st.GetBatchesPerMachine(m) <= 0);
+        throw EmptyNeighborhood();
+    }
+    int m = st.GetMachineWithBatches(Random::Uniform<int> (0, st.NumberOfMachinesWithBatches() - 1));
     
     int p = Random::Uniform<int> (0, (st.GetBatchesPerMachine(m) - 1));
-    mv.old_machine_position = std::make_pair(m,p);
+    mv.old_machine_position = MachinePosition(m,p);
     // in that, select a job
-    std::set<int> possible_jobs = st.GetJobsAtBatchPosition(m, p);
-    int j_index = Random::Uniform<int> (0, (int) (possible_jobs.size() - 1));
-    int first_job;
-    for (int job : possible_jobs)
+    const std::set<int>& batch_jobs = st.GetJobsAtBatchPosition(m, p);
+    // the jobs are taken in a window of the batch, placed at random if the batch is larger
+    if ((int) batch_jobs.size() > BatchToNewMachine::MaxJobs)
     {
-        first_job = job;
-        if (j_index == 0)
-        {
-            break;
-        }
-        j_index--;
+        mv.window_start = Random::Uniform<int> (0, (int) batch_jobs.size() - BatchToNewMachine::MaxJobs);
     }
+    auto possible_jobs_begin = std::next(batch_jobs.begin(), mv.window_start);
+    int first_index = Random::Uniform<int> (0, std::min((int) batch_jobs.size(), BatchToNewMachine::MaxJobs) - 1);
+    int first_job = *std::next(possible_jobs_begin, first_index);
     // randomly select a machine (and a position) that is ok with that job (must be different from the one you are currently in)
-    std::set<int> eligible_machines =  st.EligibleMachineSet(first_job);
+    const std::set<int>& eligible_machines =  st.EligibleMachineSet(first_job);
     int j_machine = Random::Uniform<int> (0, (int) (eligible_machines.size() - 1));
     for (int machine : eligible_machines)
     {
@@ -1444,13 +1793,15 @@ void OSP_BatchToNewMachineNeighborhoodExplorer::AnyRandomMove(const OSP_Output&
     }
     // look if in the same batch, you have other jobs that are ok with that machine (you don't need to check the attribute or other things, because if they are together this means that they are compatible). But check the overall size
     int new_batch_size = st.SizeJob(first_job);
-    mv.jobs_to_move.insert(first_job);
-    for (int job : possible_jobs)
+    mv.AddJobToMove(first_index);
+    int index = 0;
+    for (auto it = possible_jobs_begin; it != batch_jobs.end() && index < BatchToNewMachine::MaxJobs; ++it, ++index)
     {
-        if (st.IsMachineEligible(mv.new_machine_position.first, job)
+        int job = *it;
+        if (index != first_index && st.IsMachineEligible(mv.new_machine_position.first, job)
             && new_batch_size + st.SizeJob(job) <= st.MaxCapacityMachine(mv.new_machine_position.first))
         {
-            mv.jobs_to_move.insert(job);
+            mv.AddJobToMove(index);
             new_batch_size = new_batch_size + st.SizeJob(job);
         }
     }
@@ -1459,7 +1810,7 @@ void OSP_BatchToNewMachineNeighborhoodExplorer::AnyRandomMove(const OSP_Output&
 void OSP_BatchToNewMachineNeighborhoodExplorer::MakeMove(OSP_Output& st, const BatchToNewMachine& mv) const
 {
     // update the data structures
-    st.InsertBatchToNewMachine(mv.jobs_to_move, mv.old_machine_position, mv.new_machine_position);
+    st.InsertBatchToNewMachine(mv.JobsToMove(st), mv.old_machine_position, mv.new_machine_position);
     
     // update the costs
     st.CalculateAllCostsFromScratch();
@@ -1480,9 +1831,15 @@ bool OSP_BatchToNewMachineNeighborhoodExplorer::NextMove(const OSP_Output& st, B
 void OSP_SwapBatchesNeighborhoodExplorer::RandomMove(const OSP_Output& st, SwapBatches& mv) const
 {
     // std::cout << "OSP_SwapBatchesNeighborhoodExplorer: In RandomMove" << std::endl;
-    do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool OSP_SwapBatchesNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const SwapBatches& mv) const
@@ -1503,23 +1860,11 @@ bool OSP_SwapBatchesNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, con
 void OSP_SwapBatchesNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, SwapBatches& mv) const
 {
     // randomly select a machine with more than one batch
-    bool at_least_one = false;
-    for (int m = 0; m < st.Machines(); ++m)
-    {
-        if (st.GetBatchesPerMachine(m) > 1)
-        {
-            at_least_one = true;
-            break;
-        }
-    }
-    if (!at_least_one)
+    if (st.NumberOfMachinesWithMoreBatches() == 0)
     {
         throw EmptyNeighborhood();
     }
-    do
-    {
-        mv.machine = Random::Uniform<int>(0,st.Machines()-1);
-    } while (st.GetBatchesPerMachine(mv.machine) <= 1);
+    mv.machine = st.GetMachineWithMoreBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithMoreBatches() - 1));
     // select a random position between 0 and position - 2, that will be the first position
     int batch_in_machine = st.GetBatchesPerMachine(mv.machine);
     mv.position_1 = Random::Uniform<int>(0, batch_in_machine - 2);
@@ -1550,9 +1895,15 @@ bool OSP_SwapBatchesNeighborhoodExplorer::NextMove(const OSP_Output& st, SwapBat
 void OSP_InvertBatchesInMachineNeighborhoodExplorer::RandomMove(const OSP_Output& st, InvertBatchesInMachine& mv) const
 {
     // std::cout << "OSP_InvertBatchesInMachineNeighborhoodExplorer: In RandomMove" << std::endl;
-    do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool OSP_InvertBatchesInMachineNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const InvertBatchesInMachine& mv) const
@@ -1569,23 +1920,11 @@ bool OSP_InvertBatchesInMachineNeighborhoodExplorer::FeasibleMove(const OSP_Outp
 void OSP_InvertBatchesInMachineNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, InvertBatchesInMachine& mv) const
 {
     // randomly select a machine with more than one batch
-    bool at_least_one = false;
-    for (int m = 0; m < st.Machines(); ++m)
-    {
-        if (st.GetBatchesPerMachine(m) > 1)
-        {
-            at_least_one = true;
-            break;
-        }
-    }
-    if (!at_least_one)
+    if (st.NumberOfMachinesWithMoreBatches() == 0)
     {
         throw EmptyNeighborhood();
     }
-    do
-    {
-        mv.machine = Random::Uniform<int>(0,st.Machines()-1);
-    } while (st.GetBatchesPerMachine(mv.machine) <= 1);
+    mv.machine = st.GetMachineWithMoreBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithMoreBatches() - 1));
     // select a random position between 0 and position - 2, that will be the first position
     int batch_in_machine = st.GetBatchesPerMachine(mv.machine);
     mv.position_1 = Random::Uniform<int>(0, batch_in_machine - 2);
@@ -1619,9 +1958,15 @@ bool OSP_InvertBatchesInMachineNeighborhoodExplorer::NextMove(const OSP_Output&
 void Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::RandomMove(const OSP_Output& st, BatchToNewMachine& mv) const
 {
     // std::cout << "OSP_BatchToNewMachineNeighborhoodExplorer: In RandomMove" << std::endl;
-    do {
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
         AnyRandomMove(st, mv);
-    } while (!FeasibleMove(st, mv));
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
 }
 
 bool Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const BatchToNewMachine& mv) const
@@ -1636,60 +1981,85 @@ bool Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::FeasibleMove(const OSP
 
 void Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, BatchToNewMachine& mv) const
 {
-    std::set<std::pair<int,int>> possible_batches;
+    std::vector<std::pair<int,int>> possible_batches;
     for(int m  = 0; m < st.Machines(); ++m)
     {
         for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
         {
             if (st.GetJobsAtBatchPosition(m, p).size() > 1)
             {
-                possible_batches.insert(std::make_pair(m,p));
+                possible_batches.push_back(std::make_pair(m,p));
             }
         }
     }
-    while(possible_batches.size() > 0)
+    // the first batch tried may be one past the horizon
+    int focused_index = -1;
+    MachinePosition hot_batch;
+    if (RandomHotBatch(st, hot_batch))
     {
-        mv.jobs_to_move = {};
-        mv.old_machine_position = std::make_pair(-1,-1);
-        mv.new_machine_position = std::make_pair(-1,-1);
-        int index_batch = Random::Uniform<int> (0, (int) (possible_batches.size() - 1));
-        for (std::pair<int,int> batch : possible_batches)
+        auto it = std::find(possible_batches.begin(), possible_batches.end(), std::pair<int,int>(hot_batch));
+        if (it != possible_batches.end())
         {
-            mv.old_machine_position = batch;
-            if (index_batch == 0)
-            {
-                break;
-            }
-            index_batch--;
+            focused_index = (int) (it - possible_batches.begin());
         }
-        possible_batches.erase(mv.old_machine_position);
-        std::set<int> jobs_to_analyse = st.GetJobsAtBatchPosition(mv.old_machine_position.first, mv.old_machine_position.second);
-        while(jobs_to_analyse.size() > 1)
-        {
-            mv.jobs_to_move = {};
-            mv.new_machine_position = std::make_pair(-1,-1);
-            int j_index = Random::Uniform<int> (0, (int) (jobs_to_analyse.size() - 1));
-            int first_job;
-            for (int job : jobs_to_analyse)
-            {
-                first_job = job;
-                if (j_index == 0)
+    }
+    std::vector<int> batch_jobs;
+    batch_jobs.reserve(BatchToNewMachine::MaxJobs);
+    while(possible_batches.size() > 0)
+    {
+        mv.jobs_to_move = 0;
+        mv.window_start = 0;
+        mv.old_machine_position = MachinePosition(-1,-1);
+        mv.new_machine_position = MachinePosition(-1,-1);
+        int index_batch = focused_index != -1 ? focused_index : Random::Uniform<int> (0, (int) (possible_batches.size() - 1));
+        focused_index = -1;
+        mv.old_machine_position = possible_batches[index_batch];
+        possible_batches[index_batch] = possible_batches.back();
+        possible_batches.pop_back();
+        // the jobs still to analyse are kept as a mask on a window of (at most MaxJobs) jobs of the batch, placed at random if the
+        // batch is larger
+        const std::set<int>& old_batch_jobs = st.GetJobsAtBatchPosition(mv.old_machine_position.first, mv.old_machine_position.second);
+        if ((int) old_batch_jobs.size() > BatchToNewMachine::MaxJobs)
+        {
+            mv.window_start = Random::Uniform<int> (0, (int) old_batch_jobs.size() - BatchToNewMachine::MaxJobs);
+        }
+        batch_jobs.assign(std::next(old_batch_jobs.begin(), mv.window_start), old_batch_jobs.end());
+        batch_jobs.resize(std::min((int) batch_jobs.size(), BatchToNewMachine::MaxJobs));
+        uint64_t jobs_to_analyse = batch_jobs.size() == 64 ? ~0ULL : ((1ULL << batch_jobs.size()) - 1);
+        while(__builtin_popcountll(jobs_to_analyse) > 1)
+        {
+            mv.jobs_to_move = 0;
+            mv.new_machine_position = MachinePosition(-1,-1);
+            int j_index = Random::Uniform<int> (0, __builtin_popcountll(jobs_to_analyse) - 1);
+            int first_index = -1;
+            for (int i = 0; i < (int) batch_jobs.size(); ++i)
+            {
+                if ((jobs_to_analyse >> i) & 1ULL)
                 {
-                    break;
+                    first_index = i;
+                    if (j_index == 0)
+                    {
+                        break;
+                    }
+                    j_index--;
                 }
-                j_index--;
             }
+            int first_job = batch_jobs[first_index];
             // randomly select a machine (and a position) that is ok with that job (must be different from the one you are currently in)
-            jobs_to_analyse.erase(first_job);
-            std::set<int> eligible_machines =  st.EligibleMachineSet(first_job);
-            eligible_machines.erase(mv.old_machine_position.first);
-            if (eligible_machines.size() == 0)
+            jobs_to_analyse &= ~(1ULL << first_index);
+            const std::set<int>& eligible_machines =  st.EligibleMachineSet(first_job);
+            int n_eligible_machines = (int) eligible_machines.size() - (int) eligible_machines.count(mv.old_machine_position.first);
+            if (n_eligible_machines == 0)
             {
                 continue;
             }
-            int j_machine = Random::Uniform<int> (0, (int) (eligible_machines.size() - 1));
+            int j_machine = Random::Uniform<int> (0, n_eligible_machines - 1);
             for (int selected_machine : eligible_machines)
             {
+                if (selected_machine == mv.old_machine_position.first)
+                {
+                    continue;
+                }
                 mv.new_machine_position.first = selected_machine;
                 if (j_machine == 0)
                  {
@@ -1706,30 +2076,21 @@ void Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::AnyRandomMove(const OS
                 mv.new_machine_position.second = Random::Uniform<int> (0, (int) (st.GetBatchesPerMachine(mv.new_machine_position.first)));
             }
             int new_batch_size = st.SizeJob(first_job);
-            mv.jobs_to_move.insert(first_job);
-            // jobs_to_analyse.erase(first_job);
-            for (int selected_job : jobs_to_analyse)
+            mv.AddJobToMove(first_index);
+            for (int i = 0; i < (int) batch_jobs.size(); ++i)
             {
-                if (selected_job != first_job && st.IsMachineEligible(mv.new_machine_position.first, selected_job)
+                int selected_job = batch_jobs[i];
+                if (((jobs_to_analyse >> i) & 1ULL) && st.IsMachineEligible(mv.new_machine_position.first, selected_job)
                   && new_batch_size + st.SizeJob(selected_job) <= st.MaxCapacityMachine(mv.new_machine_position.first))
                   {
-                      mv.jobs_to_move.insert(selected_job);
+                      mv.AddJobToMove(i);
                       new_batch_size = new_batch_size + st.SizeJob(selected_job);
                   }
             }
-            if (mv.jobs_to_move.size() > 1)
+            if (mv.NumberOfJobsToMove() > 1)
             {
-                for (int selected_job : mv.jobs_to_move)
-                {
-                    if (selected_job!=first_job)
-                        jobs_to_analyse.erase(selected_job);
-                }
                 return;
             }
-            else
-            {
-                continue;
-            }
         }
     }
     throw EmptyNeighborhood();
@@ -1738,7 +2099,7 @@ void Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::AnyRandomMove(const OS
 void Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::MakeMove(OSP_Output& st, const BatchToNewMachine& mv) const
 {
     // update the data structures
-    st.InsertBatchToNewMachine(mv.jobs_to_move, mv.old_machine_position, mv.new_machine_position);
+    st.InsertBatchToNewMachine(mv.JobsToMove(st), mv.old_machine_position, mv.new_machine_position);
     
     // update the costs
     st.CalculateAllCostsFromScratch();
@@ -1757,6 +2118,1125 @@ bool Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer::NextMove(const OSP_Out
 }
 
 
+void OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::RandomMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const
+{
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
+        AnyRandomMove(st, mv);
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
+}
+
+bool OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const SwapJobsBetweenBatches& mv) const
+{
+    if (mv.job_2 == -1 || st.AttributeJob(mv.job_1) != st.AttributeJob(mv.job_2))
+    {
+        return false;
+    }
+    // each job should fit in the batch of the other one
+    return st.IsJobCompatibleForBatchWithout(mv.job_2, mv.job_1, mv.position_1.first, mv.position_1.second)
+        && st.IsJobCompatibleForBatchWithout(mv.job_1, mv.job_2, mv.position_2.first, mv.position_2.second);
+}
+
+void OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const
+{
+    // randomly select a job, then a job in another batch with the same attribute
+    int job = RandomJob(st);
+    MachinePosition position = st.GetJobToBatchPosition(job);
+    const std::set<std::pair<int,int>>& batches = st.GetBatchesPerAttribute(st.AttributeJob(job));
+    mv.job_2 = -1;
+    if (batches.size() < 2)
+    {
+        // the job is the only one of its attribute: the move is discarded by FeasibleMove
+        mv.job_1 = job;
+        mv.position_1 = position;
+        return;
+    }
+    int y = Random::Uniform<int>(0, (int) batches.size() - 2);
+    std::pair<int,int> other_position;
+    for (std::pair<int,int> batch : batches)
+    {
+        if (batch == std::pair<int,int>(position))
+        {
+            continue;
+        }
+        if (y == 0)
+        {
+            other_position = batch;
+            break;
+        }
+        y--;
+    }
+    const std::set<int>& jobs = st.GetJobsAtBatchPosition(other_position.first, other_position.second);
+    int other_job = *std::next(jobs.begin(), Random::Uniform<int>(0, (int) jobs.size() - 1));
+    // the jobs are kept in increasing order, as in the enumeration
+    if (job < other_job)
+    {
+        mv = SwapJobsBetweenBatches(job, position, other_job, other_position);
+    }
+    else
+    {
+        mv = SwapJobsBetweenBatches(other_job, other_position, job, position);
+    }
+}
+
+void OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::MakeMove(OSP_Output& st, const SwapJobsBetweenBatches& mv) const
+{
+    // Update the data structures
+    st.ExchangeJobs(mv.job_1, mv.job_2);
+    // Update the costs
+    st.CalculateAllCostsFromScratch();
+}
+
+std::vector<BatchChange> OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::BatchChanges(const OSP_Output& st, const SwapJobsBetweenBatches& mv) const
+{
+    // each job takes the place of the other one
+    std::vector<BatchChange> changes = {
+        {mv.position_1.first, mv.position_1.second, st.GetJobsAtBatchPosition(mv.position_1.first, mv.position_1.second), false},
+        {mv.position_2.first, mv.position_2.second, st.GetJobsAtBatchPosition(mv.position_2.first, mv.position_2.second), false}};
+    changes[0].jobs.erase(mv.job_1);
+    changes[0].jobs.insert(mv.job_2);
+    changes[1].jobs.erase(mv.job_2);
+    changes[1].jobs.insert(mv.job_1);
+    return changes;
+}
+
+void OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::FirstMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const
+{
+    mv.job_1 = -1;
+    if (!NextJobToLook(st, mv.job_1))
+    {
+        throw EmptyNeighborhood();
+    }
+    mv.job_2 = mv.job_1;
+    if (!NextFeasiblePair(st, mv))
+    {
+        throw EmptyNeighborhood();
+    }
+}
+
+bool OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::NextMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const
+{
+    return NextFeasiblePair(st, mv);
+}
+
+bool OSP_SwapJobsBetweenBatchesNeighborhoodExplorer::NextFeasiblePair(const OSP_Output& st, SwapJobsBetweenBatches& mv) const
+{
+    while (true)
+    {
+        mv.job_2++;
+        if (mv.job_2 >= st.Jobs())
+        {
+            // the pairs are enumerated (and skipped) with their smaller job
+            if (!NextJobToLook(st, mv.job_1))
+            {
+                return false;
+            }
+            mv.job_2 = mv.job_1;
+            continue;
+        }
+        if (st.AttributeJob(mv.job_1) != st.AttributeJob(mv.job_2))
+        {
+            continue;
+        }
+        mv.position_1 = st.GetJobToBatchPosition(mv.job_1);
+        mv.position_2 = st.GetJobToBatchPosition(mv.job_2);
+        if (FeasibleMove(st, mv))
+        {
+            return true;
+        }
+    }
+}
+
+
+bool NextBatchPosition(const OSP_Output& st, MachinePosition& position)
+{
+    position.second++;
+    while (position.second >= st.GetBatchesPerMachine(position.first))
+    {
+        position.first++;
+        position.second = 0;
+        if (position.first >= st.Machines())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OSP_MergeBatchesNeighborhoodExplorer::RandomMove(const OSP_Output& st, MergeBatches& mv) const
+{
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
+        AnyRandomMove(st, mv);
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
+}
+
+bool OSP_MergeBatchesNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const MergeBatches& mv) const
+{
+    return st.IsBatchCompatibleForBatch(mv.source_position.first, mv.source_position.second, mv.target_position.first, mv.target_position.second);
+}
+
+void OSP_MergeBatchesNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, MergeBatches& mv) const
+{
+    // merges are seldom feasible, so the batches are scanned from a random one up to the first that can be merged somewhere
+    if (st.NumberOfMachinesWithBatches() == 0)
+    {
+        throw EmptyNeighborhood();
+    }
+    MachinePosition first_position;
+    if (!RandomHotBatch(st, first_position))
+    {
+        int machine = st.GetMachineWithBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithBatches() - 1));
+        first_position = MachinePosition(machine, Random::Uniform<int>(0, st.GetBatchesPerMachine(machine) - 1));
+    }
+    mv.source_position = first_position;
+    do
+    {
+        if (RandomCompatibleTarget(st, mv))
+        {
+            return;
+        }
+        if (!NextBatchPosition(st, mv.source_position))
+        {
+            mv.source_position = MachinePosition(0, -1);
+            NextBatchPosition(st, mv.source_position);
+        }
+    }
+    while (mv.source_position != first_position);
+    throw EmptyNeighborhood();
+}
+
+bool OSP_MergeBatchesNeighborhoodExplorer::RandomCompatibleTarget(const OSP_Output& st, MergeBatches& mv) const
+{
+    const std::set<std::pair<int,int>>& batches = st.GetBatchesPerAttribute(st.GetBatchCharacteristics(mv.source_position.first, mv.source_position.second).attribute);
+    int compatible_batches = 0;
+    for (std::pair<int,int> batch : batches)
+    {
+        if (st.IsBatchCompatibleForBatch(mv.source_position.first, mv.source_position.second, batch.first, batch.second))
+        {
+            compatible_batches++;
+        }
+    }
+    if (compatible_batches == 0)
+    {
+        return false;
+    }
+    int y = Random::Uniform<int>(0, compatible_batches - 1);
+    for (std::pair<int,int> batch : batches)
+    {
+        if (st.IsBatchCompatibleForBatch(mv.source_position.first, mv.source_position.second, batch.first, batch.second))
+        {
+            if (y == 0)
+            {
+                mv.target_position = batch;
+                break;
+            }
+            y--;
+        }
+    }
+    return true;
+}
+
+void OSP_MergeBatchesNeighborhoodExplorer::MakeMove(OSP_Output& st, const MergeBatches& mv) const
+{
+    // Update the data structures
+    st.InsertBatchInExistingBatch(mv.source_position, mv.target_position);
+    // Update the costs
+    st.CalculateAllCostsFromScratch();
+}
+
+std::vector<BatchChange> OSP_MergeBatchesNeighborhoodExplorer::BatchChanges(const OSP_Output& st, const MergeBatches& mv) const
+{
+    // the target gets the jobs of the source, which disappears
+    std::vector<BatchChange> changes = {
+        {mv.source_position.first, mv.source_position.second, std::set<int>(), false},
+        {mv.target_position.first, mv.target_position.second, st.GetJobsAtBatchPosition(mv.target_position.first, mv.target_position.second), false}};
+    const std::set<int>& source_jobs = st.GetJobsAtBatchPosition(mv.source_position.first, mv.source_position.second);
+    changes[1].jobs.insert(source_jobs.begin(), source_jobs.end());
+    return changes;
+}
+
+void OSP_MergeBatchesNeighborhoodExplorer::FirstMove(const OSP_Output& st, MergeBatches& mv) const
+{
+    mv.source_position = MachinePosition(0, -1);
+    while (NextBatchPositionToLook(st, mv.source_position))
+    {
+        mv.target_position = MachinePosition();
+        if (NextCompatibleTarget(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
+}
+
+bool OSP_MergeBatchesNeighborhoodExplorer::NextMove(const OSP_Output& st, MergeBatches& mv) const
+{
+    if (NextCompatibleTarget(st, mv))
+    {
+        return true;
+    }
+    while (NextBatchPositionToLook(st, mv.source_position))
+    {
+        mv.target_position = MachinePosition();
+        if (NextCompatibleTarget(st, mv))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OSP_MergeBatchesNeighborhoodExplorer::NextCompatibleTarget(const OSP_Output& st, MergeBatches& mv) const
+{
+    // the batches of an attribute are ordered, so the current target is enough to know where to restart from
+    const std::set<std::pair<int,int>>& batches = st.GetBatchesPerAttribute(st.GetBatchCharacteristics(mv.source_position.first, mv.source_position.second).attribute);
+    auto it = batches.begin();
+    if (mv.target_position.first != -1)
+    {
+        it = batches.upper_bound(mv.target_position);
+    }
+    for (; it != batches.end(); ++it)
+    {
+        if (st.IsBatchCompatibleForBatch(mv.source_position.first, mv.source_position.second, it->first, it->second))
+        {
+            mv.target_position = *it;
+            return true;
+        }
+    }
+    return false;
+}
+
+void OSP_SplitBatchNeighborhoodExplorer::RandomMove(const OSP_Output& st, SplitBatch& mv) const
+{
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
+        AnyRandomMove(st, mv);
+        if (FeasibleMove(st, mv))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
+}
+
+bool OSP_SplitBatchNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const SplitBatch& mv) const
+{
+    // both parts must be non empty, they respect capacity and processing times since they are subsets of a feasible batch
+    return mv.split >= 1 && mv.split < (int) st.GetJobsAtBatchPosition(mv.position.first, mv.position.second).size();
+}
+
+void OSP_SplitBatchNeighborhoodExplorer::AnyRandomMove(const OSP_Output& st, SplitBatch& mv) const
+{
+    if (st.NumberOfMachinesWithBatches() == 0)
+    {
+        throw EmptyNeighborhood();
+    }
+    int machine = st.GetMachineWithBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithBatches() - 1));
+    mv.position = MachinePosition(machine, Random::Uniform<int>(0, st.GetBatchesPerMachine(machine) - 1));
+    int jobs = (int) st.GetJobsAtBatchPosition(mv.position.first, mv.position.second).size();
+    // a batch with a single job cannot be split: the move is discarded by FeasibleMove
+    mv.split = jobs > 1 ? Random::Uniform<int>(1, jobs - 1) : 0;
+}
+
+void OSP_SplitBatchNeighborhoodExplorer::MakeMove(OSP_Output& st, const SplitBatch& mv) const
+{
+    // Update the data structures
+    st.ExtractJobsToNextBatch(mv.position.first, mv.position.second, mv.JobsToNewBatch(st));
+    // Update the costs
+    st.CalculateAllCostsFromScratch();
+}
+
+std::vector<BatchChange> OSP_SplitBatchNeighborhoodExplorer::BatchChanges(const OSP_Output& st, const SplitBatch& mv) const
+{
+    // the jobs that leave the batch go in a new batch right after it
+    std::vector<BatchChange> changes = {
+        {mv.position.first, mv.position.second, st.GetJobsAtBatchPosition(mv.position.first, mv.position.second), false},
+        {mv.position.first, mv.position.second, mv.JobsToNewBatch(st), true}};
+    for (int job : changes[1].jobs)
+    {
+        changes[0].jobs.erase(job);
+    }
+    return changes;
+}
+
+void OSP_SplitBatchNeighborhoodExplorer::FirstMove(const OSP_Output& st, SplitBatch& mv) const
+{
+    mv.position = MachinePosition(0, -1);
+    mv.split = 0;
+    if (!NextMove(st, mv))
+    {
+        throw EmptyNeighborhood();
+    }
+}
+
+bool OSP_SplitBatchNeighborhoodExplorer::NextMove(const OSP_Output& st, SplitBatch& mv) const
+{
+    mv.split++;
+    while (mv.position.second == -1 || !FeasibleMove(st, mv))
+    {
+        if (!NextBatchPositionToLook(st, mv.position))
+        {
+            return false;
+        }
+        mv.split = 1;
+    }
+    return true;
+}
+
+
+void OSP_EjectionChainNeighborhoodExplorer::RandomMove(const OSP_Output& st, EjectionChain& mv) const
+{
+    std::vector<int> tardy_jobs;
+    for (int j = 0; j < st.Jobs(); ++j)
+    {
+        if (st.IsJobTardy(j))
+        {
+            tardy_jobs.push_back(j);
+        }
+    }
+    if (tardy_jobs.empty())
+    {
+        throw EmptyNeighborhood();
+    }
+    // the tardy jobs are tried from a random one, up to the first one that starts at least a chain
+    int first = Random::Uniform<int>(0, (int) tardy_jobs.size() - 1);
+    int attempts = 0;
+    for (size_t k = 0; k < tardy_jobs.size() && attempts < max_random_move_attempts; ++k)
+    {
+        EjectionChain chain, best_chain;
+        DefaultCostStructure<long> best_cost;
+        int evaluations = 0;
+        chain.jobs[0] = tardy_jobs[(first + k) % tardy_jobs.size()];
+        ExtendChain(st, chain, 0, best_chain, best_cost, evaluations, attempts);
+        if (best_chain.length > 0)
+        {
+            mv = best_chain;
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
+}
+
+bool OSP_EjectionChainNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const EjectionChain& mv) const
+{
+    if (mv.length < 1 || mv.length > EjectionChain::MaxLength)
+    {
+        return false;
+    }
+    // the batches are all different, so each of them is checked on the current state
+    std::pair<int,int> source = st.GetJobToBatchPosition(mv.jobs[0]);
+    for (int i = 0; i < mv.length; ++i)
+    {
+        std::pair<int,int> target = mv.targets[i];
+        if (target == source || IsInChain(mv, i, target))
+        {
+            return false;
+        }
+        if (i == mv.length - 1)
+        {
+            if (!st.IsJobCompatibleForBatch(mv.jobs[i], target.first, target.second))
+            {
+                return false;
+            }
+        }
+        else if (st.GetJobToBatchPosition(mv.jobs[i+1]) != target
+            || st.GetJobsAtBatchPosition(target.first, target.second).size() < 2
+            || !st.IsJobCompatibleForBatchWithout(mv.jobs[i], mv.jobs[i+1], target.first, target.second))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OSP_EjectionChainNeighborhoodExplorer::MakeMove(OSP_Output& st, const EjectionChain& mv) const
+{
+    // the chain is applied from its end, so that each job finds its room already free; no batch disappears before the last
+    // insertion (the ejections are from batches with at least two jobs), so the positions of the targets are still valid
+    for (int i = mv.length - 1; i >= 0; --i)
+    {
+        st.InsertJobInExistingBatch(mv.jobs[i], st.GetJobToBatchPosition(mv.jobs[i]), mv.targets[i]);
+    }
+    // update the costs
+    st.CalculateAllCostsFromScratch();
+}
+
+std::vector<BatchChange> OSP_EjectionChainNeighborhoodExplorer::BatchChanges(const OSP_Output& st, const EjectionChain& mv) const
+{
+    // the batch of the first job loses it (and disappears if it is left empty), each target gets its job and loses the next one
+    std::vector<BatchChange> changes;
+    MachinePosition source = st.GetJobToBatchPosition(mv.jobs[0]);
+    changes.push_back({source.first, source.second, st.GetJobsAtBatchPosition(source.first, source.second), false});
+    changes.back().jobs.erase(mv.jobs[0]);
+    for (int i = 0; i < mv.length; ++i)
+    {
+        changes.push_back({mv.targets[i].first, mv.targets[i].second, st.GetJobsAtBatchPosition(mv.targets[i].first, mv.targets[i].second), false});
+        changes.back().jobs.insert(mv.jobs[i]);
+        if (i < mv.length - 1)
+        {
+            changes.back().jobs.erase(mv.jobs[i + 1]);
+        }
+    }
+    return changes;
+}
+
+void OSP_EjectionChainNeighborhoodExplorer::FirstMove(const OSP_Output& st, EjectionChain& mv) const
+{
+    // FIXME: implement me
+    throw std::invalid_argument("Method FirstMove not implemented yet.");
+}
+
+bool OSP_EjectionChainNeighborhoodExplorer::NextMove(const OSP_Output& st, EjectionChain& mv) const
+{
+    // FIXME: implement me
+    throw std::invalid_argument("Method NextMove not implemented yet.");
+    return false;
+}
+
+void OSP_EjectionChainNeighborhoodExplorer::ExtendChain(const OSP_Output& st, EjectionChain& chain, int level, EjectionChain& best_chain, DefaultCostStructure<long>& best_cost, int& evaluations, int& attempts) const
+{
+    int job = chain.jobs[level];
+    std::pair<int,int> source = st.GetJobToBatchPosition(chain.jobs[0]);
+    int end_time = st.GetBatchCharacteristics(st.GetJobToBatchPosition(job).first, st.GetJobToBatchPosition(job).second).end_time;
+    const std::set<std::pair<int,int>>& batches = st.GetBatchesPerAttribute(st.AttributeJob(job));
+    // the batches are tried in cyclic order from a random one
+    auto it = std::next(batches.begin(), Random::Uniform<int>(0, (int) batches.size() - 1));
+    for (size_t k = 0; k < batches.size(); ++k, ++it)
+    {
+        if (evaluations >= max_ejection_chains_evaluated || attempts >= max_random_move_attempts)
+        {
+            return;
+        }
+        if (it == batches.end())
+        {
+            it = batches.begin();
+        }
+        attempts++;
+        std::pair<int,int> target = *it;
+        // the tardy job must be anticipated, the ejected ones can go anywhere
+        if ((level == 0 && st.GetBatchCharacteristics(target.first, target.second).end_time >= end_time)
+            || target == source || IsInChain(chain, level, target))
+        {
+            continue;
+        }
+        chain.targets[level] = target;
+        if (st.IsJobCompatibleForBatch(job, target.first, target.second))
+        {
+            chain.length = level + 1;
+            DefaultCostStructure<long> cost = DeltaCostFunctionComponents(st, chain);
+            evaluations++;
+            if (best_chain.length == 0 || cost < best_cost)
+            {
+                best_chain = chain;
+                best_cost = cost;
+            }
+        }
+        else if (level + 1 < EjectionChain::MaxLength && st.GetJobsAtBatchPosition(target.first, target.second).size() > 1)
+        {
+            // the least urgent job whose ejection makes room for job
+            int ejected = -1;
+            for (int j : st.GetJobsAtBatchPosition(target.first, target.second))
+            {
+                if ((ejected == -1 || st.LatestEndJob(j) > st.LatestEndJob(ejected))
+                    && st.IsJobCompatibleForBatchWithout(job, j, target.first, target.second))
+                {
+                    ejected = j;
+                }
+            }
+            if (ejected != -1)
+            {
+                chain.jobs[level + 1] = ejected;
+                ExtendChain(st, chain, level + 1, best_chain, best_cost, evaluations, attempts);
+            }
+        }
+    }
+}
+
+bool OSP_EjectionChainNeighborhoodExplorer::IsInChain(const EjectionChain& chain, int level, std::pair<int,int> batch) const
+{
+    for (int i = 0; i < level; ++i)
+    {
+        if (chain.targets[i] == batch)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void OSP_RuinAndRecreateNeighborhoodExplorer::SetRuinSize(int min_jobs, int max_jobs)
+{
+    if (min_jobs < 1 || max_jobs < min_jobs)
+    {
+        throw std::invalid_argument("The ruin size should be at least one job and the maximum should not be below the minimum");
+    }
+    min_ruin_size = min_jobs;
+    max_ruin_size = max_jobs;
+}
+
+void OSP_RuinAndRecreateNeighborhoodExplorer::RandomMove(const OSP_Output& st, RuinAndRecreate& mv) const
+{
+    if (st.NumberOfMachinesWithBatches() == 0)
+    {
+        throw EmptyNeighborhood();
+    }
+    mv.destroy = static_cast<RuinAndRecreate::Destroy>(Random::Uniform<int>(RuinAndRecreate::TimeWindow, RuinAndRecreate::RelatedJobs));
+    mv.size = Random::Uniform<int>(min_ruin_size, max_ruin_size);
+    mv.machine = -1;
+    if (mv.destroy == RuinAndRecreate::RelatedJobs)
+    {
+        mv.from = RandomJob(st);
+        return;
+    }
+    // the window (the segment) starts from a random batch
+    MachinePosition batch;
+    if (!RandomHotBatch(st, batch))
+    {
+        batch.first = st.GetMachineWithBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithBatches() - 1));
+        batch.second = Random::Uniform<int>(0, st.GetBatchesPerMachine(batch.first) - 1);
+    }
+    if (mv.destroy == RuinAndRecreate::TimeWindow)
+    {
+        mv.from = st.GetBatchCharacteristics(batch.first, batch.second).start_time;
+    }
+    else
+    {
+        mv.machine = batch.first;
+        mv.from = batch.second;
+    }
+}
+
+bool OSP_RuinAndRecreateNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const RuinAndRecreate& mv) const
+{
+    if (mv.size < 1)
+    {
+        return false;
+    }
+    switch (mv.destroy)
+    {
+        case RuinAndRecreate::RelatedJobs:
+            return mv.from >= 0 && mv.from < st.Jobs();
+        case RuinAndRecreate::MachineSegment:
+            return mv.machine >= 0 && mv.machine < st.Machines() && mv.from >= 0 && mv.from < st.GetBatchesPerMachine(mv.machine);
+        default:
+            return !mv.RemovedJobs(st).empty();
+    }
+}
+
+void OSP_RuinAndRecreateNeighborhoodExplorer::MakeMove(OSP_Output& st, const RuinAndRecreate& mv) const
+{
+    std::vector<int> removed = mv.RemovedJobs(st);
+    SortForRepair(st, removed);
+    // ruin: each removed job goes alone in a batch at the end of its machine, so the room it leaves is free for the repair
+    // and the batches left empty disappear
+    for (int j : removed)
+    {
+        std::pair<int,int> position = st.GetJobToBatchPosition(j);
+        bool is_alone = st.GetJobsAtBatchPosition(position.first, position.second).size() == 1;
+        st.InsertJobToNewBatch(j, position, std::make_pair(position.first, st.GetBatchesPerMachine(position.first) - (is_alone ? 1 : 0)), is_alone);
+    }
+    Recreate(st, removed);
+    // update the costs
+    st.CalculateAllCostsFromScratch();
+}
+
+void OSP_RuinAndRecreateNeighborhoodExplorer::SortForRepair(const OSP_Output& st, std::vector<int>& jobs) const
+{
+    std::stable_sort(jobs.begin(), jobs.end(), [&st](int j1, int j2)
+        { return st.LatestEndJob(j1) < st.LatestEndJob(j2) || (st.LatestEndJob(j1) == st.LatestEndJob(j2) && st.SizeJob(j1) > st.SizeJob(j2)); });
+}
+
+void OSP_RuinAndRecreateNeighborhoodExplorer::Recreate(OSP_Output& st, std::vector<int> removed) const
+{
+    SortForRepair(st, removed);
+    std::vector<bool> pending(st.Jobs(), false);
+    for (int j : removed)
+    {
+        pending[j] = true;
+    }
+    for (int j : removed)
+    {
+        if (!pending[j])
+        {
+            continue; // it has filled the new batch of a previous job
+        }
+        pending[j] = false;
+        std::pair<int,int> target;
+        if (BestExistingBatch(st, j, pending, target))
+        {
+            st.InsertJobInExistingBatch(j, st.GetJobToBatchPosition(j), target);
+        }
+        else
+        {
+            st.InsertJobToNewBatch(j, st.GetJobToBatchPosition(j), NewBatchPosition(st, j), true);
+            FillNewBatch(st, j, removed, pending);
+        }
+    }
+}
+
+void OSP_RuinAndRecreateNeighborhoodExplorer::FirstMove(const OSP_Output& st, RuinAndRecreate& mv) const
+{
+    throw std::invalid_argument("Method FirstMove not implemented yet.");
+}
+
+bool OSP_RuinAndRecreateNeighborhoodExplorer::NextMove(const OSP_Output& st, RuinAndRecreate& mv) const
+{
+    throw std::invalid_argument("Method NextMove not implemented yet.");
+    return false;
+}
+
+bool OSP_RuinAndRecreateNeighborhoodExplorer::BestExistingBatch(const OSP_Output& st, int job, const std::vector<bool>& pending, std::pair<int,int>& target) const
+{
+    // the batches where the job ends in time come first, then the ones where it ends late (a new batch would delay the
+    // following ones)
+    bool found = false, best_late = false;
+    int best_end_time = 0;
+    for (const std::pair<int,int>& b : st.GetBatchesPerAttribute(st.AttributeJob(job)))
+    {
+        // the batches of the jobs still to reinsert are not targets
+        if (pending[*st.GetJobsAtBatchPosition(b.first, b.second).begin()] || !st.IsJobCompatibleForBatch(job, b.first, b.second))
+        {
+            continue;
+        }
+        const Batch& batch = st.GetBatchCharacteristics(b.first, b.second);
+        if (batch.start_time > st.Horizon() || st.EarliestStartJob(job) > batch.start_time) // the job would delay the batch
+        {
+            continue;
+        }
+        bool late = std::max(batch.end_time, batch.start_time + st.MinTimeJob(job)) > st.LatestEndJob(job);
+        if (!found || (!late && best_late) || (late == best_late && batch.end_time < best_end_time))
+        {
+            found = true;
+            best_late = late;
+            best_end_time = batch.end_time;
+            target = b;
+        }
+    }
+    return found;
+}
+
+std::pair<int,int> OSP_RuinAndRecreateNeighborhoodExplorer::NewBatchPosition(const OSP_Output& st, int job) const
+{
+    // on each eligible machine, the new batch goes before the first batch that starts after the job is available; the machine is
+    // the one where the batch can start first (the setup times are left to the evaluation of the move)
+    std::pair<int,int> current = st.GetJobToBatchPosition(job), best(-1, -1);
+    int best_start_time = 0;
+    for (int m : st.EligibleMachineSet(job))
+    {
+        int p = 0;
+        while (p < st.GetBatchesPerMachine(m) && (std::make_pair(m, p) == current || st.GetBatchCharacteristics(m, p).start_time < st.EarliestStartJob(job)))
+        {
+            ++p;
+        }
+        int previous = (p > 0 && std::make_pair(m, p - 1) == current) ? p - 2 : p - 1;
+        int start_time = std::max(st.EarliestStartJob(job), previous >= 0 ? st.GetBatchCharacteristics(m, previous).end_time : 0);
+        if (best.first == -1 || start_time < best_start_time)
+        {
+            best_start_time = start_time;
+            // on its own machine the batch of the job leaves its position, so the following ones are anticipated
+            best = std::make_pair(m, (m == current.first && p > current.second) ? p - 1 : p);
+        }
+    }
+    return best;
+}
+
+void OSP_RuinAndRecreateNeighborhoodExplorer::FillNewBatch(OSP_Output& st, int job, const std::vector<int>& removed, std::vector<bool>& pending) const
+{
+    // the same conditions of FillBatch (the candidates are already in earliest due date order): the jobs must not delay the batch
+    // and, unless the batch already ends late for the job that opened it, must not make it end late
+    for (int k : removed)
+    {
+        std::pair<int,int> target = st.GetJobToBatchPosition(job);
+        const Batch& batch = st.GetBatchCharacteristics(target.first, target.second);
+        if (pending[k]
+            && st.IsJobCompatibleForBatch(k, target.first, target.second)
+            && st.EarliestStartJob(k) <= batch.start_time
+            && (batch.end_time > st.LatestEndJob(job) || std::max(batch.end_time, batch.start_time + st.MinTimeJob(k)) <= st.LatestEndJob(job)))
+        {
+            pending[k] = false;
+            st.InsertJobInExistingBatch(k, st.GetJobToBatchPosition(k), target);
+        }
+    }
+}
+
+
+void OSP_ResequenceBatchesNeighborhoodExplorer::SetWindow(int w)
+{
+    if (w < 2 || w > ResequenceBatches::MaxLength)
+    {
+        throw std::invalid_argument("The resequencing window should be between 2 and " + std::to_string(ResequenceBatches::MaxLength) + " batches");
+    }
+    window = w;
+}
+
+void OSP_ResequenceBatchesNeighborhoodExplorer::RandomMove(const OSP_Output& st, ResequenceBatches& mv) const
+{
+    if (st.NumberOfMachinesWithMoreBatches() == 0)
+    {
+        throw EmptyNeighborhood();
+    }
+    // a random window of a random machine: each window has at most one move (its best order), and the search of the others would cost
+    // a dynamic program each, so the window where the current order is already the best one is an empty neighborhood
+    mv.machine = st.GetMachineWithMoreBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithMoreBatches() - 1));
+    mv.length = std::min(window, st.GetBatchesPerMachine(mv.machine));
+    mv.first = Random::Uniform<int>(0, st.GetBatchesPerMachine(mv.machine) - mv.length);
+    if (!BestOrder(st, mv))
+    {
+        throw EmptyNeighborhood();
+    }
+}
+
+bool OSP_ResequenceBatchesNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const ResequenceBatches& mv) const
+{
+    if (mv.machine < 0 || mv.machine >= st.Machines() || mv.length < 2 || mv.length > ResequenceBatches::MaxLength
+        || mv.first < 0 || mv.first + mv.length > st.GetBatchesPerMachine(mv.machine))
+    {
+        return false;
+    }
+    // the order must be a permutation of the window, other than the current one
+    bool identity = true;
+    std::vector<bool> seen(mv.length, false);
+    for (int i = 0; i < mv.length; ++i)
+    {
+        if (mv.order[i] < 0 || mv.order[i] >= mv.length || seen[mv.order[i]])
+        {
+            return false;
+        }
+        seen[mv.order[i]] = true;
+        identity = identity && mv.order[i] == i;
+    }
+    return !identity;
+}
+
+void OSP_ResequenceBatchesNeighborhoodExplorer::MakeMove(OSP_Output& st, const ResequenceBatches& mv) const
+{
+    // update the data structure of the solution
+    st.ReorderBatchesInMachine(mv.machine, mv.first, mv.order, mv.length);
+    // update the costs
+    st.CalculateAllCostsFromScratch();
+}
+
+void OSP_ResequenceBatchesNeighborhoodExplorer::FirstMove(const OSP_Output& st, ResequenceBatches& mv) const
+{
+    mv.machine = -1;
+    if (!NextMachineToLook(st, mv.machine))
+    {
+        throw EmptyNeighborhood();
+    }
+    mv.first = -1;
+    if (!NextMove(st, mv))
+    {
+        throw EmptyNeighborhood();
+    }
+#if !defined(NDEBUG)
+    assert(FeasibleMove(st, mv));
+#endif
+}
+
+bool OSP_ResequenceBatchesNeighborhoodExplorer::NextMove(const OSP_Output& st, ResequenceBatches& mv) const
+{
+    while (true)
+    {
+        while (NextWindow(st, mv))
+        {
+            if (BestOrder(st, mv))
+            {
+                return true;
+            }
+        }
+        if (!NextMachineToLook(st, mv.machine))
+        {
+            return false;
+        }
+        mv.first = -1;
+    }
+}
+
+bool OSP_ResequenceBatchesNeighborhoodExplorer::NextWindow(const OSP_Output& st, ResequenceBatches& mv) const
+{
+    int batches = st.GetBatchesPerMachine(mv.machine);
+    mv.length = std::min(window, batches);
+    mv.first++;
+    return mv.length > 1 && mv.first + mv.length <= batches;
+}
+
+bool OSP_ResequenceBatchesNeighborhoodExplorer::BestOrder(const OSP_Output& st, ResequenceBatches& mv) const
+{
+    const int m = mv.machine, f = mv.first, l = mv.length;
+    const int unscheduled = std::numeric_limits<int>::max(); // end time of the batches past the horizon (and of the ones after them)
+    int start_attribute = in.InitialStateMachine(m), start_end = 0;
+    if (f > 0)
+    {
+        const Batch& previous = st.GetBatchCharacteristics(m, f - 1);
+        if (previous.start_time > in.Horizon())
+        {
+            return false; // the whole window is past the horizon, in any order
+        }
+        start_attribute = previous.attribute;
+        start_end = previous.end_time;
+    }
+    // the data of the batches of the window and of the ones after it, as in CalculateBatchProperties
+    struct BatchData
+    {
+        int attribute, earliest_start, processing_time;
+        std::vector<int> latest_ends;
+    };
+    std::vector<BatchData> batches;
+    for (int p = f; p < st.GetBatchesPerMachine(m); ++p)
+    {
+        BatchData b = {st.GetBatchCharacteristics(m, p).attribute, 0, 0, {}};
+        for (int j : st.GetJobsAtBatchPosition(m, p))
+        {
+            b.earliest_start = std::max(b.earliest_start, in.EarliestStartJob(j));
+            b.processing_time = std::max(b.processing_time, in.MinTimeJob(j));
+            b.latest_ends.push_back(in.LatestEndJob(j));
+        }
+        batches.push_back(b);
+    }
+    // end time and cost of batch b after a batch of the given attribute and end time
+    auto place = [this, &st, &batches, m, unscheduled](int attribute, int end, int b, long& cost) {
+        const BatchData& batch = batches[b];
+        int start = unscheduled;
+        if (end != unscheduled)
+        {
+            start = st.CalculateBatchStartTime(m, batch.earliest_start, in.SetUpTime(attribute, batch.attribute), batch.processing_time, end);
+        }
+        if (start > in.Horizon())
+        {
+            cost += HARD_WEIGHT * 2 * in.UpperBoundIntegerObjective() * (long) batch.latest_ends.size();
+            return unscheduled;
+        }
+        end = start + batch.processing_time;
+        long tardy = std::count_if(batch.latest_ends.begin(), batch.latest_ends.end(), [end](int latest_end) { return latest_end < end; });
+        cost += in.SetUpCost(attribute, batch.attribute) * in.MultFactorTotalSetUpCosts() + tardy * in.MultFactorFinishedTooLate()
+            + batch.processing_time * in.MultFactorTotalRunTime();
+        return end;
+    };
+    // cost of the batches after the window
+    auto tail = [&place, &batches, l](int attribute, int end) {
+        long cost = 0;
+        for (int b = l; b < (int) batches.size(); ++b)
+        {
+            end = place(attribute, end, b, cost);
+            attribute = batches[b].attribute;
+        }
+        return cost;
+    };
+
+    long current_cost = 0;
+    int attribute = start_attribute, end = start_end;
+    for (int b = 0; b < l; ++b)
+    {
+        end = place(attribute, end, b, current_cost);
+        attribute = batches[b].attribute;
+    }
+    current_cost += tail(attribute, end);
+
+    // labels[s] are the Pareto optimal labels of the state s = subset * l + last batch of the window placed
+    struct Label
+    {
+        int end;
+        long cost;
+        int batch, parent; // parent is -1 for the first batch of the order
+    };
+    std::vector<Label> pool;
+    std::vector<std::vector<int>> labels((1 << l) * l);
+    auto add_label = [&pool, &labels](int s, const Label& label) {
+        std::vector<int>& front = labels[s];
+        for (int k : front)
+        {
+            if (pool[k].end <= label.end && pool[k].cost <= label.cost)
+            {
+                return;
+            }
+        }
+        front.erase(std::remove_if(front.begin(), front.end(), [&pool, &label](int k) { return label.end <= pool[k].end && label.cost <= pool[k].cost; }), front.end());
+        front.push_back((int) pool.size());
+        pool.push_back(label);
+    };
+    for (int b = 0; b < l; ++b)
+    {
+        long cost = 0;
+        int e = place(start_attribute, start_end, b, cost);
+        add_label((1 << b) * l + b, {e, cost, b, -1});
+    }
+    // the subsets are visited in increasing order, so before their supersets
+    for (int subset = 1; subset < (1 << l) - 1; ++subset)
+    {
+        for (int last = 0; last < l; ++last)
+        {
+            for (int k : labels[subset * l + last])
+            {
+                for (int b = 0; b < l; ++b)
+                {
+                    if (subset & (1 << b))
+                    {
+                        continue;
+                    }
+                    Label label = {0, pool[k].cost, b, k};
+                    label.end = place(batches[last].attribute, pool[k].end, b, label.cost);
+                    add_label((subset | (1 << b)) * l + b, label);
+                }
+            }
+        }
+    }
+    int best_label = -1;
+    long best_cost = current_cost;
+    for (int last = 0; last < l; ++last)
+    {
+        for (int k : labels[((1 << l) - 1) * l + last])
+        {
+            long cost = pool[k].cost + tail(batches[last].attribute, pool[k].end);
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_label = k;
+            }
+        }
+    }
+    if (best_label == -1)
+    {
+        return false;
+    }
+    for (int i = l - 1, k = best_label; i >= 0; --i, k = pool[k].parent)
+    {
+        mv.order[i] = pool[k].batch;
+    }
+    return true;
+}
+
+
+void OSP_RegroupBatchesNeighborhoodExplorer::RandomMove(const OSP_Output& st, RegroupBatches& mv) const
+{
+    if (st.NumberOfMachinesWithMoreBatches() == 0)
+    {
+        throw EmptyNeighborhood();
+    }
+    std::vector<int> order;
+    for (int attempt = 0; attempt < max_random_move_attempts; ++attempt)
+    {
+        mv.machine = st.GetMachineWithMoreBatches(Random::Uniform<int>(0, st.NumberOfMachinesWithMoreBatches() - 1));
+        int batches = st.GetBatchesPerMachine(mv.machine);
+        mv.first = Random::Uniform<int>(0, batches - 2);
+        mv.length = Random::Uniform<int>(2, batches - mv.first);
+        if (Regroup(st, mv, order))
+        {
+            return;
+        }
+    }
+    throw EmptyNeighborhood();
+}
+
+bool OSP_RegroupBatchesNeighborhoodExplorer::FeasibleMove(const OSP_Output& st, const RegroupBatches& mv) const
+{
+    std::vector<int> order;
+    return mv.machine >= 0 && mv.machine < st.Machines() && mv.first >= 0 && mv.length >= 2
+        && mv.first + mv.length <= st.GetBatchesPerMachine(mv.machine) && Regroup(st, mv, order);
+}
+
+void OSP_RegroupBatchesNeighborhoodExplorer::MakeMove(OSP_Output& st, const RegroupBatches& mv) const
+{
+    std::vector<int> order;
+    Regroup(st, mv, order);
+    // update the data structure of the solution
+    st.ReorderBatchesInMachine(mv.machine, mv.first, order.data(), mv.length);
+    // update the costs
+    st.CalculateAllCostsFromScratch();
+}
+
+void OSP_RegroupBatchesNeighborhoodExplorer::FirstMove(const OSP_Output& st, RegroupBatches& mv) const
+{
+    mv.machine = -1;
+    if (!NextMachineToLook(st, mv.machine))
+    {
+        throw EmptyNeighborhood();
+    }
+    mv.first = 0;
+    mv.length = 1;
+    if (!NextMove(st, mv))
+    {
+        throw EmptyNeighborhood();
+    }
+#if !defined(NDEBUG)
+    assert(FeasibleMove(st, mv));
+#endif
+}
+
+bool OSP_RegroupBatchesNeighborhoodExplorer::NextMove(const OSP_Output& st, RegroupBatches& mv) const
+{
+    // the segments of a machine by first position and then by length, skipping the ones already grouped
+    std::vector<int> order;
+    while (true)
+    {
+        int batches = st.GetBatchesPerMachine(mv.machine);
+        if (mv.first + mv.length < batches)
+        {
+            mv.length++;
+        }
+        else if (mv.first + 2 < batches)
+        {
+            mv.first++;
+            mv.length = 2;
+        }
+        else
+        {
+            if (!NextMachineToLook(st, mv.machine))
+            {
+                return false;
+            }
+            mv.first = 0;
+            mv.length = 1;
+            continue;
+        }
+        if (Regroup(st, mv, order))
+        {
+            return true;
+        }
+    }
+}
+
+bool OSP_RegroupBatchesNeighborhoodExplorer::Regroup(const OSP_Output& st, const RegroupBatches& mv, std::vector<int>& order) const
+{
+    int attribute = mv.first > 0 ? st.GetBatchCharacteristics(mv.machine, mv.first - 1).attribute : in.InitialStateMachine(mv.machine);
+    std::vector<bool> present(st.Attributes(), false);
+    for (int i = 0; i < mv.length; ++i)
+    {
+        present[st.GetBatchCharacteristics(mv.machine, mv.first + i).attribute] = true;
+    }
+    order.clear();
+    for (int a : sequencer.Sequence(attribute, present))
+    {
+        for (int i = 0; i < mv.length; ++i)
+        {
+            if (st.GetBatchCharacteristics(mv.machine, mv.first + i).attribute == a)
+            {
+                order.push_back(i);
+            }
+        }
+    }
+    for (int i = 0; i < mv.length; ++i)
+    {
+        if (order[i] != i)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
 void OSP_SolutionManagerRandom::RandomState(OSP_Output& st)
 {
     //throw std::invalid_argument("Method RandomState not implemented yet.");
@@ -4,12 +4,71 @@
 #include <easylocal.hh>
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <set>
 
 using namespace EasyLocal::Core;
 
+// maximum number of candidates drawn by a RandomMove before giving up with an EmptyNeighborhood
+const int max_random_move_attempts = 1000;
+// maximum number of complete chains evaluated by a RandomMove of the ejection chain neighborhood
+const int max_ejection_chains_evaluated = 20;
+
+
+// sampling of the jobs and batches of the random moves, biased towards the jobs that are tardy or past the horizon
+class OSP_FocusedSampling
+{
+public:
+    void SetFocusProbability(double f) { focus_probability = f; }
+    double GetFocusProbability() const { return focus_probability; }
+protected:
+    OSP_FocusedSampling() : focus_probability(0.0) {}
+    // with probability focus_probability a hot job (if any), otherwise any job
+    int RandomJob(const OSP_Output& st) const;
+    // with probability focus_probability a batch past the horizon (if any), otherwise false and the caller draws the batch as usual
+    bool RandomHotBatch(const OSP_Output& st, MachinePosition& position) const;
+    double focus_probability;
+};
+
+// don't-look bits of the exhaustive exploration: a machine (job) whose moves have all been enumerated by FirstMove/NextMove, i.e. in a
+// descent none of them was improving, is skipped by the following explorations until a modifier of the state touches it
+class OSP_DontLookBits
+{
+public:
+    void SetDontLookBits(bool active) { dont_look_bits = active; }
+    bool GetDontLookBits() const { return dont_look_bits; }
+protected:
+    OSP_DontLookBits() : dont_look_bits_set(OSP_Output::NewDontLookBitsSet()), dont_look_bits(true) {}
+    // move to the next machine (job) to look at, false at the end; the one left behind has been enumerated and gets its bit
+    bool NextMachineToLook(const OSP_Output& st, int& machine) const;
+    bool NextJobToLook(const OSP_Output& st, int& job) const;
+    // as NextBatchPosition, but the machines not to look at are jumped and the ones left behind get their bit
+    bool NextBatchPositionToLook(const OSP_Output& st, MachinePosition& position) const;
+    int dont_look_bits_set; // the set of bits of this explorer in the states
+    bool dont_look_bits;
+};
+
+// exact sequencing of the attributes: the setups depend only on the pairs of attributes, so the order of a set of attributes with the
+// least setups after a given one is the shortest Hamiltonian path over the setup matrices (setup costs first, then setup times). The
+// paths are precomputed by dynamic programming over the subsets of attributes, for all the starting attributes, when the attributes are
+// at most MaxExactAttributes; otherwise the order is built by nearest neighbour
+class OSP_AttributeSequencer
+{
+public:
+    OSP_AttributeSequencer(const OSP_Input& in);
+    static constexpr int MaxExactAttributes = 10;
+    // the attributes a with present[a], in the order of the least setups after start_attribute
+    std::vector<int> Sequence(int start_attribute, const std::vector<bool>& present) const;
+protected:
+    long Weight(int a1, int a2) const;
+    const OSP_Input& in;
+    long time_range; // the setup times of a path are below it, so they only break the ties of the setup costs
+    // for each start, subset of attributes and last attribute, the weight of the best path and the attribute before the last (-1 if none)
+    std::vector<long> path_weight;
+    std::vector<int> previous;
+};
 
 class OSP_SolutionManager : public SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>
 {
@@ -18,7 +77,14 @@ public:
     void RandomState(OSP_Output& st);
     void GreedyState(OSP_Output& st);
     bool CheckConsistency(const OSP_Output& st) const;
+    // the last solution of a file written by this program (the output of a constructive method or a solution stream), for a warm start.
+    // The jobs keep their batches when they still fit in (the instance may have changed), the others go alone in new batches at the end
+    // of the machines: their number is returned
+    int WarmState(OSP_Output& st, const std::string& file_name) const;
+    // no soft cost below the lower bounds of the instance (the cost components are the ones of main, with its weights)
+    bool LowerBoundReached(const DefaultCostStructure<long>& costs) const { return costs.violations == 0 && costs.objective <= in.LowerBoundObjective(); }
 protected:
+    OSP_SolutionManager(const OSP_Input & pin, std::string name) : SolutionManager<OSP_Input, OSP_Output, DefaultCostStructure<long>>(pin, name){}
     // methods for GreedyState
     int GetCurrentShiftOnMachine(int m, int time, int intervals, std::vector<int> availability_start_vector);
     std::map<int,int> GetSetupTimes (int next_attribute, std::set<int> available_machines, std::map<int,Batch>last_batch_assignement_on_machine, std::vector<int> batch_count_per_machine, std::vector<int> initial_status, std::vector<std::vector<int>> setup_times);
@@ -37,6 +103,7 @@ public:
     void RandomState(OSP_Output& st);
     void GreedyState(OSP_Output& st);
     bool CheckConsistency(const OSP_Output& st) const;
+    bool LowerBoundReached(const DefaultCostStructure<long>& costs) const { return costs.violations == 0 && costs.objective <= in.LowerBoundObjective(); }
 protected:
     // methods for GreedyState
     int GetCurrentShiftOnMachine(int m, int time, int intervals, std::vector<int> availability_start_vector);
@@ -44,6 +111,21 @@ protected:
     int FindBestMachine(int time, int processing_time, std::map<int,int> setup_time_for_machines, std::set<int> available_machines, std::map<int, std::pair<int, bool>> current_shift_dict, std::vector<std::vector<int>> end_shifts);
 };
 
+// greedy solution grouped by attribute, for the instances where the setups dominate: the jobs go to the eligible machine with the least
+// work, in earliest due date order; the jobs of each machine are split in rounds of consecutive due dates and in each round the batches
+// are grouped by attribute, the groups in the order of the least setups after the last attribute of the previous round. The number of
+// rounds is the one of the cheapest solution
+class OSP_SolutionManagerGrouped : public OSP_SolutionManager
+{
+public:
+    OSP_SolutionManagerGrouped(const OSP_Input & pin) : OSP_SolutionManager(pin, "OSP_SolutionManagerGrouped"), sequencer(pin) {}
+    void GreedyState(OSP_Output& st);
+protected:
+    static constexpr int max_rounds = 32;
+    void BuildRounds(OSP_Output& st, const std::vector<std::vector<int>>& machine_jobs, int rounds) const;
+    OSP_AttributeSequencer sequencer;
+};
+
 
 class  OSP_TotalSetUpTime: public CostComponent<OSP_Input,OSP_Output,long>
 {
@@ -85,7 +167,112 @@ public:
     void PrintViolations(const OSP_Output& st, std::ostream& os = std::cout) const;
 };
 
-class OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,SwapConsecutiveBatchesMove,DefaultCostStructure<long>>
+template <class Move>
+class OSP_BatchChangesNeighborhoodExplorer;
+
+// delta of a cost component of main for the moves of an OSP_BatchChangesNeighborhoodExplorer, its part of the variation of the costs
+template <class Move>
+class OSP_BatchChangesDeltaCost : public DeltaCostComponent<OSP_Input,OSP_Output,Move,long>
+{
+public:
+    OSP_BatchChangesDeltaCost(const OSP_Input & in, CostComponent<OSP_Input,OSP_Output,long>& cc, const OSP_BatchChangesNeighborhoodExplorer<Move>& ne, long MachineCosts::* cost)
+        : DeltaCostComponent<OSP_Input,OSP_Output,Move,long>(in, cc, "OSP_BatchChangesDelta" + cc.name), ne(ne), cost(cost) {}
+protected:
+    long ComputeDeltaCost(const OSP_Output& st, const Move& mv) const override { return ne.DeltaCosts(st, mv).*cost; }
+    const OSP_BatchChangesNeighborhoodExplorer<Move>& ne;
+    long MachineCosts::* cost;
+};
+
+// explorer of moves that only change some batches, as given by BatchChanges: the cost components of main are evaluated on the changed
+// machines alone (see OSP_Output::CalculateDeltaCosts), without the copy of the state of the default delta evaluation
+template <class Move>
+class OSP_BatchChangesNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,Move,DefaultCostStructure<long>>
+{
+public:
+    // the batches as the move leaves them
+    virtual std::vector<BatchChange> BatchChanges(const OSP_Output& st, const Move& mv) const = 0;
+    MachineCosts DeltaCosts(const OSP_Output& st, const Move& mv) const
+    {
+        if (evaluation.explorer != this || evaluation.st != &st || evaluation.mv != &mv)
+        {
+            return st.CalculateDeltaCosts(BatchChanges(st, mv));
+        }
+        if (!evaluation.done)
+        {
+            evaluation.delta = st.CalculateDeltaCosts(BatchChanges(st, mv));
+            evaluation.done = true;
+        }
+        return evaluation.delta;
+    }
+    
+    void AddCostComponent(CostComponent<OSP_Input,OSP_Output,long>& cc) override
+    {
+        long MachineCosts::* cost = nullptr;
+        if (dynamic_cast<OSP_TotalSetUpTime*>(&cc) != nullptr)
+        {
+            cost = &MachineCosts::set_up_time;
+        }
+        else if (dynamic_cast<OSP_TotalSetUpCost*>(&cc) != nullptr)
+        {
+            cost = &MachineCosts::set_up_cost;
+        }
+        else if (dynamic_cast<OSP_NumberOfTardyJobs*>(&cc) != nullptr)
+        {
+            cost = &MachineCosts::tardy_jobs;
+        }
+        else if (dynamic_cast<OSP_CumulativeBatchProcessingTime*>(&cc) != nullptr)
+        {
+            cost = &MachineCosts::batch_processing_time;
+        }
+        else if (dynamic_cast<OSP_NotScheduledBatches*>(&cc) != nullptr)
+        {
+            cost = &MachineCosts::not_scheduled_batches;
+        }
+        if (cost == nullptr)
+        {
+            // any other component is evaluated on a copy of the state
+            NeighborhoodExplorer<OSP_Input,OSP_Output,Move,DefaultCostStructure<long>>::AddCostComponent(cc);
+            return;
+        }
+        delta_costs.push_back(std::make_shared<OSP_BatchChangesDeltaCost<Move>>(this->in, cc, *this, cost));
+        this->AddDeltaCostComponent(*delta_costs.back());
+    }
+    
+    DefaultCostStructure<long> DeltaCostFunctionComponents(const OSP_Output& st, const Move& mv, const std::vector<double>& weights = std::vector<double>(0)) const override
+    {
+        // the delta cost components share one simulation of the move
+        evaluation = {this, &st, &mv, false, {0, 0, 0, 0, 0}};
+        DefaultCostStructure<long> delta;
+        try
+        {
+            delta = NeighborhoodExplorer<OSP_Input,OSP_Output,Move,DefaultCostStructure<long>>::DeltaCostFunctionComponents(st, mv, weights);
+        }
+        catch (...)
+        {
+            evaluation.explorer = nullptr;
+            throw;
+        }
+        evaluation.explorer = nullptr;
+        return delta;
+    }
+protected:
+    OSP_BatchChangesNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm, std::string name)
+        : NeighborhoodExplorer<OSP_Input,OSP_Output,Move,DefaultCostStructure<long>>(pin, psm, name) {}
+    std::vector<std::shared_ptr<OSP_BatchChangesDeltaCost<Move>>> delta_costs;
+    
+    // the move under evaluation in this thread, with its simulation once done
+    struct Evaluation
+    {
+        const OSP_BatchChangesNeighborhoodExplorer* explorer;
+        const OSP_Output* st;
+        const Move* mv;
+        bool done;
+        MachineCosts delta;
+    };
+    inline static thread_local Evaluation evaluation{nullptr, nullptr, nullptr, false, {0, 0, 0, 0, 0}};
+};
+
+class OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,SwapConsecutiveBatchesMove,DefaultCostStructure<long>>, public OSP_DontLookBits
 {
 public:
     OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,SwapConsecutiveBatchesMove,DefaultCostStructure<long>>(pin, psm, "OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer") {}
@@ -98,7 +285,7 @@ protected:
     void AnyRandomMove(const OSP_Output& st, SwapConsecutiveBatchesMove& mv) const;
 };
  
-class OSP_BatchToNewPositionNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,BatchToNewPositionMove,DefaultCostStructure<long>>
+class OSP_BatchToNewPositionNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,BatchToNewPositionMove,DefaultCostStructure<long>>, public OSP_FocusedSampling
 {
 public:
     OSP_BatchToNewPositionNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,BatchToNewPositionMove,DefaultCostStructure<long>>(pin, psm, "OSP_BatchToNewPositionNeighborhoodExplorer") {}
@@ -111,7 +298,7 @@ protected:
     void AnyRandomMove(const OSP_Output& st, BatchToNewPositionMove& mv) const;
 };
 
-class OSP_JobToExistingBatchNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,JobToExistingBatch,DefaultCostStructure<long>>
+class OSP_JobToExistingBatchNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,JobToExistingBatch,DefaultCostStructure<long>>, public OSP_FocusedSampling, public OSP_DontLookBits
 {
 public:
     OSP_JobToExistingBatchNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,JobToExistingBatch,DefaultCostStructure<long>>(pin, psm, "OSP_JobToExistingBatchNeighborhoodExplorer") {}
@@ -122,9 +309,11 @@ public:
     bool NextMove(const OSP_Output& st, JobToExistingBatch& mv) const override;
 protected:
     void AnyRandomMove(const OSP_Output& st, JobToExistingBatch& mv) const;
+    bool NextCompatibleBatch(const OSP_Output& st, JobToExistingBatch& mv) const; // moves <new_machine,new_position> to the next compatible batch
+    bool RandomCompatibleBatch(const OSP_Output& st, int job, JobToExistingBatch& mv) const; // false if the job has no compatible batch
 };
 
-class OSP_JobToNewBatchNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,JobToNewBatch,DefaultCostStructure<long>>
+class OSP_JobToNewBatchNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,JobToNewBatch,DefaultCostStructure<long>>, public OSP_FocusedSampling, public OSP_DontLookBits
 {
 public:
     OSP_JobToNewBatchNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,JobToNewBatch,DefaultCostStructure<long>>(pin, psm, "OSP_JobToNewBatchNeighborhoodExplorer") {}
@@ -135,6 +324,9 @@ public:
     bool NextMove(const OSP_Output& st, JobToNewBatch& mv) const override;
 protected:
     void AnyRandomMove(const OSP_Output& st, JobToNewBatch& mv) const;
+    void StartEnumerationForJob(const OSP_Output& st, JobToNewBatch& mv) const;
+    bool NextEligibleMachine(const OSP_Output& st, JobToNewBatch& mv) const; // moves new_position.first to the next machine able to host the job
+    bool FirstPositionOnMachine(const OSP_Output& st, JobToNewBatch& mv) const;
 };
 
 class OSP_BatchToNewMachineNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,BatchToNewMachine,DefaultCostStructure<long>>
@@ -150,7 +342,7 @@ protected:
     void AnyRandomMove(const OSP_Output& st, BatchToNewMachine& mv) const;
 };
 
-class Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,BatchToNewMachine,DefaultCostStructure<long>>
+class Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,BatchToNewMachine,DefaultCostStructure<long>>, public OSP_FocusedSampling
 {
 public:
     Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,BatchToNewMachine,DefaultCostStructure<long>>(pin, psm, "OSP_BatchToNewMachineNeighborhoodExplorer") {}
@@ -187,4 +379,135 @@ public:
     bool NextMove(const OSP_Output& st, InvertBatchesInMachine& mv) const override;
 protected:
     void AnyRandomMove(const OSP_Output& st, InvertBatchesInMachine& mv) const;
-};
\ No newline at end of file
+};
+class OSP_SwapJobsBetweenBatchesNeighborhoodExplorer : public OSP_BatchChangesNeighborhoodExplorer<SwapJobsBetweenBatches>, public OSP_FocusedSampling, public OSP_DontLookBits
+{
+public:
+    OSP_SwapJobsBetweenBatchesNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : OSP_BatchChangesNeighborhoodExplorer<SwapJobsBetweenBatches>(pin, psm, "OSP_SwapJobsBetweenBatchesNeighborhoodExplorer") {}
+    void RandomMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const override;
+    bool FeasibleMove(const OSP_Output& st, const SwapJobsBetweenBatches& mv) const override;
+    void MakeMove(OSP_Output& st, const SwapJobsBetweenBatches& mv) const override;
+    std::vector<BatchChange> BatchChanges(const OSP_Output& st, const SwapJobsBetweenBatches& mv) const override;
+    void FirstMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const override;
+    bool NextMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const override;
+protected:
+    void AnyRandomMove(const OSP_Output& st, SwapJobsBetweenBatches& mv) const;
+    bool NextFeasiblePair(const OSP_Output& st, SwapJobsBetweenBatches& mv) const; // moves <job_1,job_2> to the next feasible pair
+};
+
+class OSP_MergeBatchesNeighborhoodExplorer : public OSP_BatchChangesNeighborhoodExplorer<MergeBatches>, public OSP_FocusedSampling, public OSP_DontLookBits
+{
+public:
+    OSP_MergeBatchesNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : OSP_BatchChangesNeighborhoodExplorer<MergeBatches>(pin, psm, "OSP_MergeBatchesNeighborhoodExplorer") {}
+    void RandomMove(const OSP_Output& st, MergeBatches& mv) const override;
+    bool FeasibleMove(const OSP_Output& st, const MergeBatches& mv) const override;
+    void MakeMove(OSP_Output& st, const MergeBatches& mv) const override;
+    std::vector<BatchChange> BatchChanges(const OSP_Output& st, const MergeBatches& mv) const override;
+    void FirstMove(const OSP_Output& st, MergeBatches& mv) const override;
+    bool NextMove(const OSP_Output& st, MergeBatches& mv) const override;
+protected:
+    void AnyRandomMove(const OSP_Output& st, MergeBatches& mv) const;
+    bool NextCompatibleTarget(const OSP_Output& st, MergeBatches& mv) const; // moves target_position to the next batch able to receive the source
+    bool RandomCompatibleTarget(const OSP_Output& st, MergeBatches& mv) const; // false if the source cannot be merged anywhere
+};
+
+class OSP_SplitBatchNeighborhoodExplorer : public OSP_BatchChangesNeighborhoodExplorer<SplitBatch>, public OSP_DontLookBits
+{
+public:
+    OSP_SplitBatchNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : OSP_BatchChangesNeighborhoodExplorer<SplitBatch>(pin, psm, "OSP_SplitBatchNeighborhoodExplorer") {}
+    void RandomMove(const OSP_Output& st, SplitBatch& mv) const override;
+    bool FeasibleMove(const OSP_Output& st, const SplitBatch& mv) const override;
+    void MakeMove(OSP_Output& st, const SplitBatch& mv) const override;
+    std::vector<BatchChange> BatchChanges(const OSP_Output& st, const SplitBatch& mv) const override;
+    void FirstMove(const OSP_Output& st, SplitBatch& mv) const override;
+    bool NextMove(const OSP_Output& st, SplitBatch& mv) const override;
+protected:
+    void AnyRandomMove(const OSP_Output& st, SplitBatch& mv) const;
+};
+
+// moves <machine,position> to the next existing batch, in machine order (false at the end)
+bool NextBatchPosition(const OSP_Output& st, MachinePosition& position);
+
+class OSP_EjectionChainNeighborhoodExplorer : public OSP_BatchChangesNeighborhoodExplorer<EjectionChain>
+{
+public:
+    OSP_EjectionChainNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : OSP_BatchChangesNeighborhoodExplorer<EjectionChain>(pin, psm, "OSP_EjectionChainNeighborhoodExplorer") {}
+    // the random move is the best chain (by delta cost) among the ones built from a random tardy job
+    void RandomMove(const OSP_Output& st, EjectionChain& mv) const override;
+    bool FeasibleMove(const OSP_Output& st, const EjectionChain& mv) const override;
+    void MakeMove(OSP_Output& st, const EjectionChain& mv) const override;
+    std::vector<BatchChange> BatchChanges(const OSP_Output& st, const EjectionChain& mv) const override;
+    void FirstMove(const OSP_Output& st, EjectionChain& mv) const override;
+    bool NextMove(const OSP_Output& st, EjectionChain& mv) const override;
+protected:
+    // depth first construction of the chains from chain.jobs[level], bounded by the number of evaluations and of batches tried
+    void ExtendChain(const OSP_Output& st, EjectionChain& chain, int level, EjectionChain& best_chain, DefaultCostStructure<long>& best_cost, int& evaluations, int& attempts) const;
+    bool IsInChain(const EjectionChain& chain, int level, std::pair<int,int> batch) const;
+};
+
+// large neighborhood: the destroy operator removes up to a few tens of jobs (a time window, a segment of a machine or the jobs
+// related to a seed job) and the repair reinserts them one by one, in the order of FillBatch (earliest due date, then largest):
+// in the existing batch that ends first among the ones that take the job without delaying the batch or ending late, otherwise
+// in a new batch at the earliest start on an eligible machine, filled with the other removed jobs as FillBatch does
+class OSP_RuinAndRecreateNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,RuinAndRecreate,DefaultCostStructure<long>>, public OSP_FocusedSampling
+{
+public:
+    OSP_RuinAndRecreateNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,RuinAndRecreate,DefaultCostStructure<long>>(pin, psm, "OSP_RuinAndRecreateNeighborhoodExplorer"), min_ruin_size(5), max_ruin_size(20) {}
+    void SetRuinSize(int min_jobs, int max_jobs);
+    void RandomMove(const OSP_Output& st, RuinAndRecreate& mv) const override;
+    bool FeasibleMove(const OSP_Output& st, const RuinAndRecreate& mv) const override;
+    void MakeMove(OSP_Output& st, const RuinAndRecreate& mv) const override;
+    // the moves are only sampled
+    void FirstMove(const OSP_Output& st, RuinAndRecreate& mv) const override;
+    bool NextMove(const OSP_Output& st, RuinAndRecreate& mv) const override;
+    // the repair alone, e.g. for the jobs added to an instance: the jobs, each alone in a batch at the end of its machine, are reinserted
+    // in the order of FillBatch (the costs are not updated)
+    void Recreate(OSP_Output& st, std::vector<int> jobs) const;
+protected:
+    void SortForRepair(const OSP_Output& st, std::vector<int>& jobs) const; // earliest due date, then largest
+    // pending[j] is true for the removed jobs not yet reinserted, which are alone in their batches
+    bool BestExistingBatch(const OSP_Output& st, int job, const std::vector<bool>& pending, std::pair<int,int>& target) const;
+    std::pair<int,int> NewBatchPosition(const OSP_Output& st, int job) const;
+    void FillNewBatch(OSP_Output& st, int job, const std::vector<int>& removed, std::vector<bool>& pending) const;
+    int min_ruin_size, max_ruin_size;
+};
+
+// exact resequencing of a window of consecutive batches of a machine: the order of the batches that minimizes the cost of the
+// machine (the window and the batches after it) is found by dynamic programming over the subsets of the window and the last batch
+// placed, with the Pareto labels (end time, cost) of each state. The schedule after a batch depends only on its attribute and end time,
+// and an earlier end is never worse, so the labels dominated in both are dropped without losing the optimum. The moves of a machine
+// are the best orders of its windows, the ones where the current order is already the best are not moves
+class OSP_ResequenceBatchesNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,ResequenceBatches,DefaultCostStructure<long>>, public OSP_DontLookBits
+{
+public:
+    OSP_ResequenceBatchesNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,ResequenceBatches,DefaultCostStructure<long>>(pin, psm, "OSP_ResequenceBatchesNeighborhoodExplorer"), window(6) {}
+    void SetWindow(int w); // number of batches resequenced together, at most ResequenceBatches::MaxLength
+    void RandomMove(const OSP_Output& st, ResequenceBatches& mv) const override;
+    bool FeasibleMove(const OSP_Output& st, const ResequenceBatches& mv) const override;
+    void MakeMove(OSP_Output& st, const ResequenceBatches& mv) const override;
+    void FirstMove(const OSP_Output& st, ResequenceBatches& mv) const override;
+    bool NextMove(const OSP_Output& st, ResequenceBatches& mv) const override;
+protected:
+    // sets mv.order to the best order of the window of mv.machine from mv.first, false if the current order is the best one
+    bool BestOrder(const OSP_Output& st, ResequenceBatches& mv) const;
+    // sets mv.first and mv.length to the next window of mv.machine (the first one if mv.first is -1), false at the end of the machine
+    bool NextWindow(const OSP_Output& st, ResequenceBatches& mv) const;
+    int window;
+};
+
+// the segments of a machine regrouped by attribute as in OSP_SolutionManagerGrouped: the groups follow the order of the least setups after
+// the batch before the segment
+class OSP_RegroupBatchesNeighborhoodExplorer : public NeighborhoodExplorer<OSP_Input,OSP_Output,RegroupBatches,DefaultCostStructure<long>>, public OSP_DontLookBits
+{
+public:
+    OSP_RegroupBatchesNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm) : NeighborhoodExplorer<OSP_Input,OSP_Output,RegroupBatches,DefaultCostStructure<long>>(pin, psm, "OSP_RegroupBatchesNeighborhoodExplorer"), sequencer(pin) {}
+    void RandomMove(const OSP_Output& st, RegroupBatches& mv) const override;
+    bool FeasibleMove(const OSP_Output& st, const RegroupBatches& mv) const override;
+    void MakeMove(OSP_Output& st, const RegroupBatches& mv) const override;
+    void FirstMove(const OSP_Output& st, RegroupBatches& mv) const override;
+    bool NextMove(const OSP_Output& st, RegroupBatches& mv) const override;
+protected:
+    // the new order of the segment, as in ResequenceBatches; false if it is the current one
+    bool Regroup(const OSP_Output& st, const RegroupBatches& mv, std::vector<int>& order) const;
+    OSP_AttributeSequencer sequencer;
+};
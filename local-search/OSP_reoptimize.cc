@@ -0,0 +1,164 @@
+#include "OSP_reoptimize.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+OSP_Reoptimizer::OSP_Reoptimizer(OSP_Input& s_in, LocalSearch<OSP_Input,OSP_Output,DefaultCostStructure<long>>& s,
+    SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& p_sm, const OSP_RuinAndRecreateNeighborhoodExplorer& r, OSP_DeltaCache& d_c)
+    : search_in(s_in), solver(s), sm(p_sm), repair(r), delta_cache(d_c), region_jobs(0), region_machines(0)
+{}
+
+DefaultCostStructure<long> OSP_Reoptimizer::Update(OSP_Input& in, OSP_Output& st, const OSP_InstanceDelta& delta)
+{
+    // all that is needed of in and st is read before search_in changes, since they may be bound to it
+    OSP_Input updated(in, delta);
+    std::vector<int> new_index = delta.NewJobIndices(in.Jobs());
+    int machines = in.Machines(), region_start = std::numeric_limits<int>::max();
+    std::vector<bool> affected(machines, false);
+    auto touch = [&affected, &region_start](const OSP_Output& s, std::pair<int,int> position)
+    {
+        affected[position.first] = true;
+        region_start = std::min(region_start, s.GetBatchCharacteristics(position.first, position.second).start_time);
+    };
+    for (int j : delta.removed_jobs)
+    {
+        touch(st, st.GetJobToBatchPosition(j));
+    }
+    for (const std::pair<int,int>& change : delta.changed_latest_ends)
+    {
+        touch(st, st.GetJobToBatchPosition(change.first));
+    }
+    // the jobs kept stay in their batches, the batches left empty leave their positions to the following ones
+    std::vector<std::pair<int,int>> job_to_batch_position(updated.Jobs());
+    std::vector<int> batches(machines, 0);
+    for (int m = 0; m < machines; ++m)
+    {
+        for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
+        {
+            bool kept = false;
+            for (int j : st.GetJobsAtBatchPosition(m, p))
+            {
+                if (new_index[j] != -1)
+                {
+                    job_to_batch_position[new_index[j]] = std::make_pair(m, batches[m]);
+                    kept = true;
+                }
+            }
+            if (kept)
+            {
+                batches[m]++;
+            }
+        }
+    }
+    // the added jobs go alone at the end of an eligible machine, from where the repair inserts them
+    std::vector<int> added;
+    for (int j = updated.Jobs() - (int) delta.added_jobs.size(); j < updated.Jobs(); ++j)
+    {
+        if (updated.EligibleMachineSet(j).empty())
+        {
+            throw std::invalid_argument("Job " + std::to_string(j) + " has no eligible machine");
+        }
+        int m = *updated.EligibleMachineSet(j).begin();
+        job_to_batch_position[j] = std::make_pair(m, batches[m]++);
+        added.push_back(j);
+    }
+    search_in = updated;
+    OSP_Output inserted(search_in);
+    for (int j = 0; j < search_in.Jobs(); ++j)
+    {
+        inserted.ModifyJobToBatchPosition(j, job_to_batch_position[j].first, job_to_batch_position[j].second);
+    }
+    inserted.PopulateAllFromScratch();
+    repair.Recreate(inserted, added);
+    for (int j : added)
+    {
+        touch(inserted, inserted.GetJobToBatchPosition(j));
+    }
+
+    // the region: on each affected machine, the batches from the first one that starts at region_start on
+    std::vector<int> region_machine_list, region_job_list, ready_times, states, machine_index(machines, -1), frozen_batches(machines, 0);
+    for (int m = 0; m < machines; ++m)
+    {
+        if (!affected[m])
+        {
+            continue;
+        }
+        machine_index[m] = (int) region_machine_list.size();
+        region_machine_list.push_back(m);
+        int p = 0;
+        while (p < inserted.GetBatchesPerMachine(m) && inserted.GetBatchCharacteristics(m, p).start_time < region_start)
+        {
+            ++p;
+        }
+        frozen_batches[m] = p;
+        ready_times.push_back(p > 0 ? inserted.GetBatchCharacteristics(m, p - 1).end_time : 0);
+        states.push_back(p > 0 ? inserted.GetBatchCharacteristics(m, p - 1).attribute : updated.InitialStateMachine(m));
+        for (; p < inserted.GetBatchesPerMachine(m); ++p)
+        {
+            const std::set<int>& batch_jobs = inserted.GetJobsAtBatchPosition(m, p);
+            region_job_list.insert(region_job_list.end(), batch_jobs.begin(), batch_jobs.end());
+        }
+    }
+    for (int j = 0; j < updated.Jobs(); ++j)
+    {
+        job_to_batch_position[j] = inserted.GetJobToBatchPosition(j);
+    }
+    region_jobs = (int) region_job_list.size();
+    region_machines = (int) region_machine_list.size();
+#if !defined(NDEBUG)
+    std::vector<std::vector<int>> region_start_times(machines);
+#endif
+    if (region_jobs > 0)
+    {
+        search_in = OSP_Input(updated, region_job_list, region_machine_list, ready_times, states);
+        OSP_Output region_state(search_in);
+        for (int r = 0; r < region_jobs; ++r)
+        {
+            std::pair<int,int> position = job_to_batch_position[region_job_list[r]];
+            region_state.ModifyJobToBatchPosition(r, machine_index[position.first], position.second - frozen_batches[position.first]);
+        }
+        region_state.PopulateAllFromScratch();
+        // the jobs have been renumbered, so the cached evaluations are not valid any more
+        delta_cache.Clear();
+        OSP_Output best = solver.Resolve(region_state).output;
+        for (int r = 0; r < region_jobs; ++r)
+        {
+            int m = region_machine_list[best.GetJobToBatchPosition(r).first];
+            job_to_batch_position[region_job_list[r]] = std::make_pair(m, frozen_batches[m] + best.GetJobToBatchPosition(r).second);
+        }
+#if !defined(NDEBUG)
+        for (int m_r = 0; m_r < region_machines; ++m_r)
+        {
+            for (int p = 0; p < best.GetBatchesPerMachine(m_r); ++p)
+            {
+                region_start_times[region_machine_list[m_r]].push_back(best.GetBatchCharacteristics(m_r, p).start_time);
+            }
+        }
+#endif
+    }
+
+    // the whole solution
+    search_in = updated;
+    delta_cache.Clear();
+    in = updated;
+    OSP_Output updated_st(in);
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        updated_st.ModifyJobToBatchPosition(j, job_to_batch_position[j].first, job_to_batch_position[j].second);
+    }
+    updated_st.PopulateAllFromScratch();
+#if !defined(NDEBUG)
+    // the region instance schedules the batches as the whole instance
+    for (int m = 0; m < machines; ++m)
+    {
+        for (size_t p = 0; p < region_start_times[m].size(); ++p)
+        {
+            assert(updated_st.GetBatchCharacteristics(m, frozen_batches[m] + p).start_time == region_start_times[m][p]);
+        }
+    }
+#endif
+    st = updated_st;
+    return sm.CostFunctionComponents(st);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "OSP_helpers.hh"
+#include "OSP_cache.hh"
+
+#include <vector>
+
+// incremental update of a solution when its instance changes (OSP_InstanceDelta): the jobs kept stay in their batches (the batches
+// left empty disappear), the added jobs are inserted by the repair of the ruin and recreate, then the solver runs on the region of
+// the change only. The region is made of the machines of the jobs removed, added or changed, from the first batch touched on (the
+// batches before it and the other machines stay as they are): the costs are sums over the machines, so the region is optimized exactly
+// as a part of the whole solution, at the cost of its size. The solver and its helpers are bound to search_in, which holds the region
+// instance during the search and the whole instance after it
+class OSP_Reoptimizer
+{
+public:
+    OSP_Reoptimizer(OSP_Input& search_in, LocalSearch<OSP_Input,OSP_Output,DefaultCostStructure<long>>& solver,
+        SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm, const OSP_RuinAndRecreateNeighborhoodExplorer& repair,
+        OSP_DeltaCache& delta_cache);
+    // in and st (a solution built on in) become the instance after the delta and its updated solution, whose cost is returned
+    DefaultCostStructure<long> Update(OSP_Input& in, OSP_Output& st, const OSP_InstanceDelta& delta);
+    // size of the region of the last update
+    int RegionJobs() const { return region_jobs; }
+    int RegionMachines() const { return region_machines; }
+private:
+    OSP_Input& search_in;
+    LocalSearch<OSP_Input,OSP_Output,DefaultCostStructure<long>>& solver;
+    SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm;
+    const OSP_RuinAndRecreateNeighborhoodExplorer& repair;
+    OSP_DeltaCache& delta_cache;
+    int region_jobs, region_machines;
+};
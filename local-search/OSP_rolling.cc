@@ -0,0 +1,105 @@
+#include "OSP_rolling.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+
+OSP_RollingHorizon::OSP_RollingHorizon(OSP_Input& s_in, LocalSearch<OSP_Input,OSP_Output,DefaultCostStructure<long>>& s,
+    SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& p_sm, OSP_DeltaCache& d_c, int w, int o)
+    : search_in(s_in), in(s_in), solver(s), sm(p_sm), delta_cache(d_c), window(w), overlap(o), windows(0)
+{
+    if (window <= 0 || overlap < 0 || overlap >= window)
+    {
+        throw std::invalid_argument("The windows of the rolling horizon must be longer than their overlap");
+    }
+}
+
+SolverResult<OSP_Input,OSP_Output,DefaultCostStructure<long>> OSP_RollingHorizon::Solve()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    // the frozen part of the solution: the batches of the jobs, and where they leave the machines
+    std::vector<bool> frozen(in.Jobs(), false);
+    std::vector<std::pair<int,int>> job_to_batch_position(in.Jobs());
+    std::vector<int> frozen_batches(in.Machines(), 0), ready_times(in.Machines(), 0), states = in.InitialStatuses();
+#if !defined(NDEBUG)
+    std::vector<std::vector<int>> frozen_start_times(in.Machines());
+#endif
+    std::vector<int> machines(in.Machines());
+    std::iota(machines.begin(), machines.end(), 0);
+    int remaining = in.Jobs(), last_release = 0;
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        last_release = std::max(last_release, in.EarliestStartJob(j));
+    }
+    windows = 0;
+    for (int window_start = 0; remaining > 0; window_start += window - overlap)
+    {
+        int window_end = window_start + window, next_start = window_start + window - overlap;
+        bool last = window_end > last_release;
+        std::vector<int> jobs;
+        for (int j = 0; j < in.Jobs(); ++j)
+        {
+            if (!frozen[j] && (last || in.EarliestStartJob(j) < window_end))
+            {
+                jobs.push_back(j);
+            }
+        }
+        if (jobs.empty())
+        {
+            continue;
+        }
+        // the jobs of the previous window are renumbered, so the cached evaluations are not valid any more
+        search_in = OSP_Input(in, jobs, machines, ready_times, states);
+        delta_cache.Clear();
+        OSP_Output window_solution = solver.Solve().output;
+        windows++;
+        for (int m = 0; m < in.Machines(); ++m)
+        {
+            for (int p = 0; p < window_solution.GetBatchesPerMachine(m); ++p)
+            {
+                const std::set<int>& batch_jobs = window_solution.GetJobsAtBatchPosition(m, p);
+                Batch batch = window_solution.GetBatchCharacteristics(m, p);
+                if (!last && (batch.start_time > in.Horizon() || std::any_of(batch_jobs.begin(), batch_jobs.end(),
+                    [&](int j) { return in.EarliestStartJob(jobs[j]) >= next_start; })))
+                {
+                    break;
+                }
+                for (int j : batch_jobs)
+                {
+                    job_to_batch_position[jobs[j]] = std::make_pair(m, frozen_batches[m]);
+                    frozen[jobs[j]] = true;
+                    remaining--;
+                }
+                frozen_batches[m]++;
+#if !defined(NDEBUG)
+                frozen_start_times[m].push_back(batch.start_time);
+#endif
+                ready_times[m] = batch.end_time;
+                states[m] = batch.attribute;
+            }
+        }
+    }
+    // stitch the windows
+    search_in = in;
+    delta_cache.Clear();
+    OSP_Output out(search_in);
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        out.ModifyJobToBatchPosition(j, job_to_batch_position[j].first, job_to_batch_position[j].second);
+    }
+    out.PopulateAllFromScratch();
+#if !defined(NDEBUG)
+    // the window instances schedule the batches as the whole instance
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        for (int p = 0; p < frozen_batches[m]; ++p)
+        {
+            assert(out.GetBatchCharacteristics(m, p).start_time == frozen_start_times[m][p]);
+        }
+    }
+#endif
+    double running_time = std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1>>>(std::chrono::high_resolution_clock::now() - start).count();
+    return SolverResult<OSP_Input,OSP_Output,DefaultCostStructure<long>>(out, sm.CostFunctionComponents(out), running_time);
+}
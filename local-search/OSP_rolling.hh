@@ -0,0 +1,30 @@
+#pragma once
+
+#include "OSP_helpers.hh"
+#include "OSP_cache.hh"
+
+#include <vector>
+
+// rolling horizon decomposition for the huge instances: the horizon is split in overlapping windows of the release times, and the
+// jobs released in a window (and not frozen yet) are optimized by the solver on a window instance, whose machines start where the
+// frozen batches leave them. After each window the batches of the machines are frozen up to the first one with a job released in
+// the next window (or not scheduled), their other jobs go on to the next window; the last window freezes everything. The solver and
+// its helpers are bound to search_in, which holds the window instances, so the memory and the cost of the moves depend only on the
+// size of the windows
+class OSP_RollingHorizon
+{
+public:
+    OSP_RollingHorizon(OSP_Input& search_in, LocalSearch<OSP_Input,OSP_Output,DefaultCostStructure<long>>& solver,
+        SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm, OSP_DeltaCache& delta_cache, int window, int overlap);
+    // the frozen batches of all the windows, as a solution of the whole instance (search_in is the whole instance again)
+    SolverResult<OSP_Input,OSP_Output,DefaultCostStructure<long>> Solve();
+    int Windows() const { return windows; } // windows solved by the last Solve (the ones without jobs are skipped)
+private:
+    OSP_Input& search_in;
+    const OSP_Input in; // the whole instance
+    LocalSearch<OSP_Input,OSP_Output,DefaultCostStructure<long>>& solver;
+    SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm;
+    OSP_DeltaCache& delta_cache;
+    int window, overlap;
+    int windows;
+};
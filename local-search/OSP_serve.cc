@@ -0,0 +1,202 @@
+#include "OSP_serve.hh"
+#include <utils/json.hpp>
+#include <utils/random.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using EasyLocal::Core::Random;
+
+OSP_Server::OSP_Server(std::string p, const std::vector<std::string>& command_line)
+    : program(p)
+{
+    SetOptions(default_options, command_line);
+    default_options.erase(std::remove_if(default_options.begin(), default_options.end(),
+        [](const std::pair<std::string, std::vector<std::string>>& o) { return o.first.compare(0, 9, "--serve::") == 0; }), default_options.end());
+}
+
+void OSP_Server::SetOptions(Options& options, const std::vector<std::string>& tokens)
+{
+    // each option is followed by its values, up to the next option
+    for (const std::string& token : tokens)
+    {
+        if (token.compare(0, 2, "--") == 0)
+        {
+            auto it = std::find_if(options.begin(), options.end(), [&token](const std::pair<std::string, std::vector<std::string>>& o) { return o.first == token; });
+            if (it != options.end())
+            {
+                options.erase(it);
+            }
+            options.emplace_back(token, std::vector<std::string>());
+        }
+        else if (!options.empty())
+        {
+            options.back().second.push_back(token);
+        }
+        else
+        {
+            throw std::invalid_argument("The value " + token + " is not preceded by an option");
+        }
+    }
+}
+
+unsigned int OSP_Server::Serve(const OSP_RunFunction& run, unsigned int workers, std::istream& requests, std::ostream& responses)
+{
+    std::deque<std::string> queue;
+    bool closed = false;
+    std::mutex queue_mutex;
+    std::condition_variable queue_changed;
+    std::atomic<unsigned int> failed(0);
+    std::vector<std::thread> threads;
+    for (unsigned int w = 0; w < std::max(1u, workers); ++w)
+    {
+        threads.emplace_back([this, &run, &responses, &queue, &closed, &queue_mutex, &queue_changed, &failed]()
+        {
+            std::mt19937 engine;
+            Random::ThreadGenerator generator(engine);
+            OSP_WorkerGraphs graphs;
+            while (true)
+            {
+                std::string request;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_changed.wait(lock, [&queue, &closed]() { return closed || !queue.empty(); });
+                    if (queue.empty())
+                    {
+                        return;
+                    }
+                    request = std::move(queue.front());
+                    queue.pop_front();
+                }
+                if (!Solve(run, request, responses))
+                {
+                    failed++;
+                }
+            }
+        });
+    }
+    // the requests are queued as they come, a free worker takes the oldest one
+    std::string line;
+    while (std::getline(requests, line))
+    {
+        if (std::all_of(line.begin(), line.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)); }))
+        {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            queue.push_back(line);
+        }
+        queue_changed.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        closed = true;
+    }
+    queue_changed.notify_all();
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    return failed;
+}
+
+bool OSP_Server::Solve(const OSP_RunFunction& run, const std::string& text, std::ostream& responses)
+{
+    static const std::set<std::string> fields = {"id", "instance", "instance_dzn", "method", "seed", "max_evaluations", "timeout", "warm_start", "options", "stream", "preload"};
+    auto value = [](const nlohmann::json& v) { return v.is_string() ? v.get<std::string>() : v.dump(); };
+    std::string id = "null", output, error;
+    int exit_code = 1;
+    try
+    {
+        nlohmann::json request = nlohmann::json::parse(text);
+        if (!request.is_object())
+        {
+            throw std::invalid_argument("The request is not a JSON object");
+        }
+        if (request.count("id"))
+        {
+            id = request["id"].dump();
+        }
+        for (auto it = request.begin(); it != request.end(); ++it)
+        {
+            if (fields.count(it.key()) == 0)
+            {
+                throw std::invalid_argument("Unknown field " + it.key() + " of the request");
+            }
+        }
+        if (request.count("instance") + request.count("instance_dzn") != 1)
+        {
+            throw std::invalid_argument("The request should give either the instance or the instance_dzn");
+        }
+        std::string instance = request.count("instance") ? request["instance"].get<std::string>() : instances.InlineInstance(request["instance_dzn"].get<std::string>());
+        if (request.value("preload", false))
+        {
+            instances.Instance(instance);
+            std::lock_guard<std::mutex> lock(responses_mutex);
+            responses << "{\"id\": " << id << ", \"event\": \"loaded\", \"instance\": " << OSP_JsonString(instance) << "}" << std::endl;
+            return true;
+        }
+
+        Options options = default_options;
+        if (request.count("options"))
+        {
+            SetOptions(options, request["options"].get<std::vector<std::string>>());
+        }
+        SetOptions(options, {"--main::instance", instance});
+        if (request.count("method"))
+        {
+            SetOptions(options, {"--metaheuristic::method", value(request["method"])});
+        }
+        auto method = std::find_if(options.begin(), options.end(), [](const std::pair<std::string, std::vector<std::string>>& o) { return o.first == "--metaheuristic::method"; });
+        std::string method_name = method != options.end() && !method->second.empty() ? method->second[0] : "";
+        if (request.count("seed"))
+        {
+            SetOptions(options, {"--main::seed", value(request["seed"])});
+        }
+        if (request.count("max_evaluations"))
+        {
+            if (method_name.empty())
+            {
+                throw std::invalid_argument("The max_evaluations of the request need its method");
+            }
+            SetOptions(options, {"--" + method_name + "::max_evaluations", value(request["max_evaluations"])});
+        }
+        if (request.count("timeout"))
+        {
+            // the islands have their own solver
+            SetOptions(options, {method_name == "SA_islands" ? "--OSP_island_solver::timeout" : "--OSP_solver::timeout", value(request["timeout"])});
+        }
+        if (request.count("warm_start"))
+        {
+            SetOptions(options, {"--main::warm_start", value(request["warm_start"])});
+        }
+        std::vector<std::string> arguments;
+        for (const std::pair<std::string, std::vector<std::string>>& o : options)
+        {
+            arguments.push_back(o.first);
+            arguments.insert(arguments.end(), o.second.begin(), o.second.end());
+        }
+        OSP_SharedOutput solutions{responses, responses_mutex, "\"id\": " + id + ", \"event\": \"improvement\", "};
+        exit_code = OSP_RunOnWorker(run, program, arguments, request.value("stream", false) ? &solutions : nullptr, output, error);
+    }
+    catch (const std::exception& e)
+    {
+        error = e.what();
+    }
+    std::lock_guard<std::mutex> lock(responses_mutex);
+    responses << "{\"id\": " << id << ", \"event\": \"result\", \"exit_code\": " << exit_code << ", \"result\": " << OSP_JsonResult(output);
+    if (!error.empty())
+    {
+        responses << ", \"error\": " << OSP_JsonString(error);
+    }
+    responses << "}" << std::endl;
+    return exit_code == 0;
+}
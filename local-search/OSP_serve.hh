@@ -0,0 +1,42 @@
+#pragma once
+
+#include "OSP_batch.hh"
+
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// server mode: a process that stays up and solves the requests it reads, one JSON object per line, on a pool of worker threads (as
+// the batch mode, each worker has its own random engine and registry of the parameters, and the instances are read once and kept for
+// the life of the server). The fields of a request are:
+//   id: any JSON value, echoed in the responses to the request
+//   instance: the instance file (or the name returned by a preload), or instance_dzn: the text of the instance in the dzn format
+//   method, seed, max_evaluations (of the method), timeout (in seconds), warm_start (a solution file): the main options of the run
+//   options: an array of further command line options of the run (e.g., ["--SA_all::cooling_rate", "0.99"])
+//   stream: if true, each new best solution is sent as soon as it is found
+//   preload: if true, the instance is only read into the cache (to save the time of the first request that uses it)
+// The options of the command line of the server (other than --serve::workers) are the defaults of all the requests, the options of a
+// request replace them. Each request gets its responses, one JSON line each, on the output of the server: the improvements
+// ({"id": ..., "event": "improvement", ...} as in the solution stream), then {"id": ..., "event": "result", "exit_code": ...,
+// "result": ...} or {"id": ..., "event": "loaded", "instance": ...} for a preload. The responses of different requests interleave
+class OSP_Server
+{
+public:
+    OSP_Server(std::string program, const std::vector<std::string>& command_line);
+    // solves the requests until the end of their stream (the ones already read are solved), returns the number of failed requests
+    unsigned int Serve(const OSP_RunFunction& run, unsigned int workers, std::istream& requests, std::ostream& responses);
+    OSP_InstanceCache& Instances() { return instances; }
+private:
+    // the options of a run: the name of each option and its values
+    typedef std::vector<std::pair<std::string, std::vector<std::string>>> Options;
+    static void SetOptions(Options& options, const std::vector<std::string>& tokens);
+    // solves a request and writes its responses, returns whether it succeeded
+    bool Solve(const OSP_RunFunction& run, const std::string& request, std::ostream& responses);
+    std::string program;
+    Options default_options;
+    OSP_InstanceCache instances;
+    std::mutex responses_mutex;
+};
@@ -0,0 +1,125 @@
+#include "OSP_stream.hh"
+
+#include <stdexcept>
+
+OSP_SolutionStream::OSP_SolutionStream(std::string file_name, const SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm)
+    : file(file_name, std::ios::app), os(file), os_mutex(nullptr), closing(false), has_best(false), written(0), start(std::chrono::steady_clock::now())
+{
+    if (!file)
+    {
+        throw std::invalid_argument("Cannot open the solution stream " + file_name);
+    }
+    for (size_t i = 0; i < sm.CostComponents(); ++i)
+    {
+        component_names.push_back(sm.GetCostComponent(i).name);
+    }
+    writer = std::thread(&OSP_SolutionStream::Write, this);
+}
+
+OSP_SolutionStream::OSP_SolutionStream(const OSP_SharedOutput& output, const SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm)
+    : os(output.os), os_mutex(&output.mutex), fields(output.fields), closing(false), has_best(false), written(0), start(std::chrono::steady_clock::now())
+{
+    for (size_t i = 0; i < sm.CostComponents(); ++i)
+    {
+        component_names.push_back(sm.GetCostComponent(i).name);
+    }
+    writer = std::thread(&OSP_SolutionStream::Write, this);
+}
+
+OSP_SolutionStream::~OSP_SolutionStream()
+{
+    {
+        std::lock_guard<std::mutex> lock(front_mutex);
+        closing = true;
+    }
+    front_filled.notify_one();
+    writer.join();
+}
+
+void OSP_SolutionStream::NotifyNewBest(const std::string& runner, const OSP_Output& best, const DefaultCostStructure<long>& cost, unsigned long iteration)
+{
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(front_mutex);
+        // the runners notify their own best solutions (the polish and the islands start from solutions already written)
+        if (has_best && (cost.violations > best_cost.violations || (cost.violations == best_cost.violations && cost.total >= best_cost.total)))
+        {
+            return;
+        }
+        has_best = true;
+        best_cost = cost;
+        Record r;
+        r.runner = runner;
+        r.iteration = iteration;
+        r.time = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() / 1000.0;
+        r.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        r.cost = cost;
+        r.job_to_batch_position.resize(best.Jobs());
+        for (int j = 0; j < best.Jobs(); ++j)
+        {
+            r.job_to_batch_position[j] = best.GetJobToBatchPosition(j);
+        }
+        front.push_back(std::move(r));
+    }
+    front_filled.notify_one();
+}
+
+void OSP_SolutionStream::Write()
+{
+    while (true)
+    {
+        bool last;
+        {
+            std::unique_lock<std::mutex> lock(front_mutex);
+            front_filled.wait(lock, [this]() { return closing || !front.empty(); });
+            std::swap(front, back);
+            last = closing;
+        }
+        // the back buffer is written without the lock, meanwhile the runners keep filling the front one
+        {
+            std::unique_lock<std::mutex> os_lock;
+            if (os_mutex != nullptr)
+            {
+                os_lock = std::unique_lock<std::mutex>(*os_mutex);
+            }
+            for (const Record& r : back)
+            {
+                WriteRecord(r);
+            }
+            os.flush();
+        }
+        back.clear();
+        if (last)
+        {
+            return;
+        }
+    }
+}
+
+void OSP_SolutionStream::WriteRecord(const Record& r)
+{
+    os << "{" << fields << "\"runner\": \"" << r.runner << "\", "
+        << "\"iteration\": " << r.iteration << ", "
+        << "\"time\": " << r.time << ", "
+        << "\"timestamp\": " << r.timestamp << ", "
+        << "\"total_cost\": " << r.cost.total << ", "
+        << "\"violations\": " << r.cost.violations << ", "
+        << "\"objective\": " << r.cost.objective << ", "
+        << "\"cost_components\": {";
+    for (size_t i = 0; i < component_names.size() && i < r.cost.all_components.size(); ++i)
+    {
+        os << (i > 0 ? ", " : "") << "\"" << component_names[i] << "\": " << r.cost.all_components[i];
+    }
+    os << "}, \"batch_for_job\": [";
+    for (size_t j = 0; j < r.job_to_batch_position.size(); ++j)
+    {
+        os << (j > 0 ? ", " : "") << r.job_to_batch_position[j].second + 1;
+    }
+    os << "], \"machine_for_job\": [";
+    for (size_t j = 0; j < r.job_to_batch_position.size(); ++j)
+    {
+        os << (j > 0 ? ", " : "") << r.job_to_batch_position[j].first + 1;
+    }
+    os << "]}\n";
+    written++;
+}
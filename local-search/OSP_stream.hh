@@ -0,0 +1,61 @@
+#pragma once
+
+#include "OSP_helpers.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// an output shared by several writers (e.g., the responses of the server to its requests): the lines are written under the mutex, and
+// each one starts with the given fields (e.g., the id of a request)
+struct OSP_SharedOutput
+{
+    std::ostream& os;
+    std::mutex& mutex;
+    std::string fields;
+};
+
+// appends each new best solution of the runners to a file, one JSON line per solution (an anytime stream: the file always holds
+// the best solution found so far). The runners only copy the solution into the front buffer, a background thread swaps it with the
+// back buffer and writes the lines, so the search never waits for the disk
+class OSP_SolutionStream : public RunnerObserver<OSP_Input,OSP_Output,DefaultCostStructure<long>>
+{
+public:
+    OSP_SolutionStream(std::string file_name, const SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm);
+    OSP_SolutionStream(const OSP_SharedOutput& output, const SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm);
+    ~OSP_SolutionStream(); // writes the pending solutions and closes the file
+    // the stream is attached to all the runners, only the solutions better than all the previous ones are written
+    void NotifyNewBest(const std::string& runner, const OSP_Output& best, const DefaultCostStructure<long>& cost, unsigned long iteration) override;
+    unsigned long Written() const { return written; }
+private:
+    struct Record
+    {
+        std::string runner;
+        unsigned long iteration;
+        double time; // seconds since the stream was opened
+        long long timestamp; // milliseconds since the epoch
+        DefaultCostStructure<long> cost;
+        std::vector<std::pair<int,int>> job_to_batch_position;
+    };
+    void Write(); // body of the writer thread
+    void WriteRecord(const Record& r);
+    std::ofstream file;
+    std::ostream& os; // the file, or a shared output
+    std::mutex* os_mutex; // of the shared output
+    std::string fields;
+    std::vector<std::string> component_names;
+    std::vector<Record> front, back; // the runners fill the front buffer, the writer empties the back one
+    std::mutex front_mutex;
+    std::condition_variable front_filled;
+    bool closing;
+    bool has_best;
+    DefaultCostStructure<long> best_cost;
+    unsigned long written; // touched only by the writer thread (and read after it has been joined)
+    std::chrono::steady_clock::time_point start;
+    std::thread writer;
+};
@@ -0,0 +1,107 @@
+#include "OSP_telemetry.hh"
+
+std::atomic<unsigned long> OSP_Telemetry::next_id{1};
+thread_local OSP_Telemetry::LastMove OSP_Telemetry::last_move{0, 0};
+
+OSP_Telemetry::OSP_Telemetry(bool e, unsigned long s_p, std::ostream& s_os)
+    : enabled(e), evaluations(0), snapshot_period(s_p), snapshot_os(s_os), start(std::chrono::steady_clock::now()), id(next_id++)
+{}
+
+size_t OSP_Telemetry::AddNeighborhood(std::string name)
+{
+    neighborhoods.emplace_back(name);
+    return neighborhoods.size() - 1;
+}
+
+void OSP_Telemetry::Clear()
+{
+    for (NeighborhoodTelemetry& n : neighborhoods)
+    {
+        for (std::atomic<unsigned long>* counter : {&n.drawn, &n.rejected, &n.empty, &n.evaluated, &n.accepted, &n.improving, &n.new_best})
+        {
+            *counter = 0;
+        }
+        for (std::atomic<long long>* time : {&n.random_move_ns, &n.evaluation_ns, &n.make_move_ns})
+        {
+            *time = 0;
+        }
+    }
+    evaluations = 0;
+    start = std::chrono::steady_clock::now();
+    id = next_id++;
+}
+
+void OSP_Telemetry::AddRandomMove(size_t i, bool empty, std::chrono::nanoseconds time)
+{
+    if (empty)
+    {
+        neighborhoods[i].empty++;
+    }
+    neighborhoods[i].random_move_ns += time.count();
+}
+
+void OSP_Telemetry::AddEvaluation(size_t i, std::chrono::nanoseconds time)
+{
+    neighborhoods[i].evaluated++;
+    neighborhoods[i].evaluation_ns += time.count();
+    unsigned long e = ++evaluations;
+    if (snapshot_period > 0 && e % snapshot_period == 0)
+    {
+        PrintSnapshot();
+    }
+}
+
+void OSP_Telemetry::AddMove(size_t i, long delta, std::chrono::nanoseconds time)
+{
+    neighborhoods[i].accepted++;
+    neighborhoods[i].make_move_ns += time.count();
+    if (delta < 0)
+    {
+        neighborhoods[i].improving++;
+    }
+    last_move = {id, i};
+}
+
+void OSP_Telemetry::NotifyNewBest(const std::string&, const OSP_Output&, const DefaultCostStructure<long>&, unsigned long iteration)
+{
+    // the first notification of a run is its initial state, not a move
+    if (iteration > 0 && last_move.telemetry == id)
+    {
+        neighborhoods[last_move.neighborhood].new_best++;
+    }
+    last_move.telemetry = 0;
+}
+
+void OSP_Telemetry::PrintSnapshot() const
+{
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    snapshot_os << "{\"evaluations\": " << evaluations << ", "
+        << "\"time\": " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 << ", "
+        << "\"neighborhoods\": " << *this << "}" << std::endl;
+}
+
+std::ostream& operator<<(std::ostream& os, const OSP_Telemetry& t)
+{
+    os << "[";
+    for (size_t i = 0; i < t.neighborhoods.size(); ++i)
+    {
+        const NeighborhoodTelemetry& n = t.neighborhoods[i];
+        os << "{\"name\": \"" << n.name << "\", "
+            << "\"drawn\": " << n.drawn << ", "
+            << "\"rejected\": " << n.rejected << ", "
+            << "\"empty\": " << n.empty << ", "
+            << "\"evaluated\": " << n.evaluated << ", "
+            << "\"accepted\": " << n.accepted << ", "
+            << "\"improving\": " << n.improving << ", "
+            << "\"new_best\": " << n.new_best << ", "
+            << "\"random_move_ns\": " << n.random_move_ns << ", "
+            << "\"evaluation_ns\": " << n.evaluation_ns << ", "
+            << "\"make_move_ns\": " << n.make_move_ns << "}";
+        if (i < t.neighborhoods.size() - 1)
+        {
+            os << ", ";
+        }
+    }
+    os << "]";
+    return os;
+}
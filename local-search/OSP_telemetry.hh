@@ -0,0 +1,176 @@
+#pragma once
+
+#include "OSP_helpers.hh"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+// counters of a single neighborhood, all the times are cumulative. The counters are atomic, since the parallel runners
+// share the neighborhood explorers among their threads
+class NeighborhoodTelemetry
+{
+public:
+    NeighborhoodTelemetry(std::string n = "") { name = n; }
+    std::string name;
+    std::atomic<unsigned long> drawn{0}; // moves generated inside RandomMove (feasible or not)
+    std::atomic<unsigned long> rejected{0}; // moves discarded by FeasibleMove inside RandomMove
+    std::atomic<unsigned long> empty{0}; // RandomMove calls ended with an EmptyNeighborhood
+    std::atomic<unsigned long> evaluated{0};
+    std::atomic<unsigned long> accepted{0};
+    std::atomic<unsigned long> improving{0};
+    std::atomic<unsigned long> new_best{0};
+    std::atomic<long long> random_move_ns{0};
+    std::atomic<long long> evaluation_ns{0};
+    std::atomic<long long> make_move_ns{0};
+};
+
+// the telemetry observes the runners too: a new best state is charged to the last move made in the thread of the runner
+class OSP_Telemetry : public RunnerObserver<OSP_Input, OSP_Output, DefaultCostStructure<long>>
+{
+    // prints the counters of all the neighborhoods as a JSON array
+    friend std::ostream& operator<<(std::ostream& os, const OSP_Telemetry& t);
+public:
+    // a disabled telemetry records nothing: the monitored explorers go straight to their base explorers
+    OSP_Telemetry(bool enabled = true, unsigned long snapshot_period = 0, std::ostream& snapshot_os = std::cerr);
+    bool Enabled() const { return enabled; }
+    size_t AddNeighborhood(std::string name);
+    // the counters start again from 0, for a new run of the same explorers (the moves made before are no longer charged)
+    void Clear();
+    size_t Neighborhoods() const { return neighborhoods.size(); }
+    NeighborhoodTelemetry& operator[](size_t i) { return neighborhoods[i]; }
+    const NeighborhoodTelemetry& operator[](size_t i) const { return neighborhoods[i]; }
+
+    void AddRandomMove(size_t i, bool empty, std::chrono::nanoseconds time);
+    void AddEvaluation(size_t i, std::chrono::nanoseconds time);
+    // a move made, with the delta of its cost
+    void AddMove(size_t i, long delta, std::chrono::nanoseconds time);
+    void NotifyNewBest(const std::string& runner, const OSP_Output& best, const DefaultCostStructure<long>& cost, unsigned long iteration) override;
+    // a snapshot is a JSON line with the elapsed time and the counters, it is printed every snapshot_period evaluations (0 = never)
+    void PrintSnapshot() const;
+private:
+    std::deque<NeighborhoodTelemetry> neighborhoods; // a deque, since the counters cannot be moved
+    bool enabled;
+    std::atomic<unsigned long> evaluations;
+    unsigned long snapshot_period;
+    std::ostream& snapshot_os;
+    mutable std::mutex snapshot_mutex;
+    std::chrono::steady_clock::time_point start;
+    // the last move made in each thread, by the telemetry with the given id (the ids are never reused, unlike the addresses)
+    struct LastMove
+    {
+        unsigned long telemetry;
+        size_t neighborhood;
+    };
+    unsigned long id;
+    static std::atomic<unsigned long> next_id;
+    static thread_local LastMove last_move;
+};
+
+// wraps an OSP neighborhood explorer and records its counters in an OSP_Telemetry
+template <class BaseNeighborhoodExplorer>
+class OSP_MonitoredNeighborhoodExplorer : public BaseNeighborhoodExplorer
+{
+public:
+    typedef typename BaseNeighborhoodExplorer::MoveType MoveType;
+    OSP_MonitoredNeighborhoodExplorer(const OSP_Input & pin, SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& psm, OSP_Telemetry& t, std::string name)
+        : BaseNeighborhoodExplorer(pin, psm), telemetry(t), index(t.AddNeighborhood(name)) {}
+
+    void RandomMove(const OSP_Output& st, MoveType& mv) const override
+    {
+        if (!telemetry.Enabled())
+        {
+            BaseNeighborhoodExplorer::RandomMove(st, mv);
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        in_random_move = true;
+        try
+        {
+            BaseNeighborhoodExplorer::RandomMove(st, mv);
+        }
+        catch (EmptyNeighborhood&)
+        {
+            in_random_move = false;
+            telemetry.AddRandomMove(index, true, std::chrono::steady_clock::now() - start);
+            throw;
+        }
+        in_random_move = false;
+        telemetry.AddRandomMove(index, false, std::chrono::steady_clock::now() - start);
+    }
+
+    // the exhaustive exploration is not monitored, these are redefined only because the SetUnionNeighborhoodExplorer takes the method pointers from this class
+    void FirstMove(const OSP_Output& st, MoveType& mv) const override { BaseNeighborhoodExplorer::FirstMove(st, mv); }
+    bool NextMove(const OSP_Output& st, MoveType& mv) const override { return BaseNeighborhoodExplorer::NextMove(st, mv); }
+
+    bool FeasibleMove(const OSP_Output& st, const MoveType& mv) const override
+    {
+        bool feasible = BaseNeighborhoodExplorer::FeasibleMove(st, mv);
+        if (in_random_move)
+        {
+            telemetry[index].drawn++;
+            if (!feasible)
+            {
+                telemetry[index].rejected++;
+            }
+        }
+        return feasible;
+    }
+
+    DefaultCostStructure<long> DeltaCostFunctionComponents(const OSP_Output& st, const MoveType& mv, const std::vector<double>& weights = std::vector<double>(0)) const override
+    {
+        if (!telemetry.Enabled())
+        {
+            return BaseNeighborhoodExplorer::DeltaCostFunctionComponents(st, mv, weights);
+        }
+        auto start = std::chrono::steady_clock::now();
+        in_evaluation = true; // the evaluation may simulate the move on a copy of the state, that is not an actual move
+        DefaultCostStructure<long> cost = BaseNeighborhoodExplorer::DeltaCostFunctionComponents(st, mv, weights);
+        in_evaluation = false;
+        last_evaluation = {this, mv, cost.total};
+        telemetry.AddEvaluation(index, std::chrono::steady_clock::now() - start);
+        return cost;
+    }
+
+    // the delta of a move made is the one of its evaluation, that the runners do just before the move (only the moves made without
+    // it, as the best one of an exhaustive exploration, are evaluated again)
+    void MakeMove(OSP_Output& st, const MoveType& mv) const override
+    {
+        if (in_evaluation || !telemetry.Enabled())
+        {
+            BaseNeighborhoodExplorer::MakeMove(st, mv);
+            return;
+        }
+        long delta;
+        if (last_evaluation.explorer == this && last_evaluation.move == mv)
+        {
+            delta = last_evaluation.delta;
+        }
+        else
+        {
+            in_evaluation = true;
+            delta = BaseNeighborhoodExplorer::DeltaCostFunctionComponents(st, mv).total;
+            in_evaluation = false;
+        }
+        last_evaluation.explorer = nullptr;
+        auto start = std::chrono::steady_clock::now();
+        BaseNeighborhoodExplorer::MakeMove(st, mv);
+        telemetry.AddMove(index, delta, std::chrono::steady_clock::now() - start);
+    }
+protected:
+    OSP_Telemetry& telemetry;
+    size_t index;
+    // the calls of the explorers do not nest, so the flags can be per thread rather than per object
+    inline static thread_local bool in_random_move = false, in_evaluation = false;
+    // the last move evaluated in the thread, by the given explorer
+    struct LastEvaluation
+    {
+        const OSP_MonitoredNeighborhoodExplorer* explorer;
+        MoveType move;
+        long delta;
+    };
+    inline static thread_local LastEvaluation last_evaluation{nullptr, MoveType(), 0};
+};
@@ -1,6 +1,22 @@
 #include "OSP_helpers.hh"
-
+#include "OSP_telemetry.hh"
+#include "OSP_stream.hh"
+#include "OSP_checkpoint.hh"
+#include "OSP_cache.hh"
+#include "OSP_rolling.hh"
+#include "OSP_reoptimize.hh"
+#include "OSP_batch.hh"
+#include "OSP_serve.hh"
+
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 #include <string>
 #include <cmath>
 
@@ -12,10 +28,328 @@ double round_to(double value, double precision = 0.01)
     return std::round(value / precision) * precision;
 }
 
-int main(int argc, const char* argv[])
+typedef Runner<OSP_Input, OSP_Output, DefaultCostStructure<long>> OSP_Runner;
+// the normalized rates of the neighborhoods, in the order of multi_all
+typedef std::array<double, 13> OSP_Rates;
+
+// the rates of a union of neighborhoods become its biases; as in its constructor, all the neighborhoods are equally likely if
+// their rates are all 0
+template <class Multi, size_t N>
+void SetRates(Multi& multi, const std::array<double, N>& rates)
+{
+    bool all_zero = std::all_of(rates.begin(), rates.end(), [](double rate) { return rate == 0.0; });
+    for (size_t i = 0; i < N; i++)
+    {
+        multi.SetBias(i, all_zero ? 1.0 / N : rates[i]);
+    }
+}
+
+// the objects of a method on an instance, from the cost components to the runners: a worker of a batch or a server keeps them for
+// its next runs with the same instance and the same options of the graph, each run prepares them with its own (the copy of the
+// instance, the rates and the options of the neighborhoods) and the parameters of the runners are back to their defaults. All the
+// helpers are bound to in, where the rolling horizon and the reoptimizer write their instances
+class OSP_MethodGraph : public OSP_RunnerGraph
+{
+public:
+    OSP_MethodGraph(const OSP_Input& instance, unsigned int initial_solution, const std::string& method, bool polish, unsigned int islands,
+        bool counters, unsigned long snapshot_period, size_t delta_cache_size);
+    // the key of the graphs built with these options (the options of the runners and of the neighborhoods are set by each run)
+    static std::string Key(const std::string& instance, unsigned int initial_solution, const std::string& method, bool polish, unsigned int islands,
+        bool counters, unsigned long snapshot_period, size_t delta_cache_size);
+    // the state of a new run: nothing is left of the previous one (the instance changed by the rolling horizon, the counters, the
+    // learned biases, the observers and the checkpointer of the run). The islands draw the perturbation of their rates here, as the
+    // build of the graph did before, so that a run gives the same result on a new graph or on a kept one
+    void Prepare(OSP_Input instance, const OSP_Rates& rates, unsigned int min_ruin_size, unsigned int max_ruin_size, unsigned int resequence_window,
+        double focus_probability);
+    // an observer of the runners of the method only for the current run
+    void AttachRunObserver(RunnerObserver<OSP_Input, OSP_Output, DefaultCostStructure<long>>& o);
+
+    OSP_Input in;
+
+    // cost components: 
+    // second parameter is the cost, third is the type (true -> hard, false -> soft)
+    OSP_TotalSetUpCost cc1;
+    OSP_NumberOfTardyJobs cc2;
+    OSP_CumulativeBatchProcessingTime cc3;
+    OSP_NotScheduledBatches cc4;
+
+    // counters of the neighborhoods (unless disabled), they are printed with the final results
+    OSP_Telemetry telemetry;
+    // evaluations of the moves, shared by all the neighborhoods
+    OSP_DeltaCache delta_cache;
+
+    // solution manager: the initial solution is built by the heuristic (1), at random (2) or grouped by attribute (3)
+    OSP_SolutionManager OSP_sm_heuristic;
+    OSP_SolutionManagerRandom OSP_sm_random;
+    OSP_SolutionManagerGrouped OSP_sm_grouped;
+    SolutionManager<OSP_Input, OSP_Output, DefaultCostStructure<long>>& OSP_sm;
+
+    // neighborhood
+    template <class NeighborhoodExplorer>
+    using Cached = OSP_MonitoredNeighborhoodExplorer<OSP_CachedNeighborhoodExplorer<NeighborhoodExplorer>>;
+    Cached<OSP_SwapBatchesNeighborhoodExplorer> SwapNeighb;
+    Cached<OSP_BatchToNewPositionNeighborhoodExplorer> InsertNeighb;
+    Cached<OSP_InvertBatchesInMachineNeighborhoodExplorer> InverseNeighb;
+    Cached<OSP_JobToNewBatchNeighborhoodExplorer> SingleNewBatch;
+    Cached<Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer> MoreNewBatchNeighb;
+    Cached<OSP_JobToExistingBatchNeighborhoodExplorer> JobExistingBarchNeighb;
+    Cached<OSP_SwapJobsBetweenBatchesNeighborhoodExplorer> SwapJobsNeighb;
+    Cached<OSP_MergeBatchesNeighborhoodExplorer> MergeNeighb;
+    Cached<OSP_SplitBatchNeighborhoodExplorer> SplitNeighb;
+    Cached<OSP_EjectionChainNeighborhoodExplorer> EjectionChainNeighb;
+    // the ruin and recreate moves change too many machines to be cached
+    OSP_MonitoredNeighborhoodExplorer<OSP_RuinAndRecreateNeighborhoodExplorer> RuinAndRecreateNeighb;
+    Cached<OSP_ResequenceBatchesNeighborhoodExplorer> ResequenceNeighb;
+    Cached<OSP_RegroupBatchesNeighborhoodExplorer> RegroupNeighb;
+
+    // the multi-neighborhood, its biases are the rates of each run
+    typedef SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
+    decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb),decltype(SwapJobsNeighb),decltype(MergeNeighb),decltype(SplitNeighb),decltype(EjectionChainNeighb),decltype(RuinAndRecreateNeighb),decltype(ResequenceNeighb),decltype(RegroupNeighb)> MultiAll;
+    typedef MultiAll::MoveType MultiMove;
+    MultiAll multi_all;
+
+    SimpleLocalSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> OSP_solver;
+    IslandSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> OSP_island_solver;
+    LocalSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>>* used_solver;
+    OSP_Runner* used_runner;
+    OSP_Runner* SD_polish;
+    // the runners built for the method (the polish too)
+    std::vector<OSP_Runner*> runners;
+    std::vector<std::function<void()>> on_parameters_parsed;
+private:
+    // the objects built for the method are kept alive in method_objects
+    std::vector<std::shared_ptr<void>> method_objects;
+    // the biases of the unions built for the method, from the rates of a run
+    std::vector<std::function<void(const OSP_Rates&)>> rate_setters;
+    std::vector<RunnerObserver<OSP_Input, OSP_Output, DefaultCostStructure<long>>*> run_observers;
+};
+
+OSP_MethodGraph::OSP_MethodGraph(const OSP_Input& instance, unsigned int initial_solution, const std::string& method, bool polish, unsigned int islands,
+    bool counters, unsigned long snapshot_period, size_t delta_cache_size)
+    : in(instance),
+    cc1(in, in.MultFactorTotalSetUpCosts(), false),
+    cc2(in, in.MultFactorFinishedTooLate(), false),
+    cc3(in, in.MultFactorTotalRunTime(), false),
+    cc4(in, 2 * in.UpperBoundIntegerObjective(), true),
+    telemetry(counters, snapshot_period),
+    delta_cache(delta_cache_size),
+    OSP_sm_heuristic(in),
+    OSP_sm_random(in),
+    OSP_sm_grouped(in),
+    OSP_sm(initial_solution == 1
+        ? static_cast<SolutionManager<OSP_Input, OSP_Output, DefaultCostStructure<long>>&>(OSP_sm_heuristic)
+        : initial_solution == 2 ? static_cast<SolutionManager<OSP_Input, OSP_Output, DefaultCostStructure<long>>&>(OSP_sm_random) : OSP_sm_grouped),
+    SwapNeighb(in,OSP_sm,telemetry,"swap"),
+    InsertNeighb(in,OSP_sm,telemetry,"insert"),
+    InverseNeighb(in,OSP_sm,telemetry,"inverse"),
+    SingleNewBatch(in,OSP_sm,telemetry,"single_job_to_new_batch"),
+    MoreNewBatchNeighb(in,OSP_sm,telemetry,"more_jobs_to_new_batch"),
+    JobExistingBarchNeighb(in,OSP_sm,telemetry,"job_to_existing_batch"),
+    SwapJobsNeighb(in,OSP_sm,telemetry,"swap_jobs_between_batches"),
+    MergeNeighb(in,OSP_sm,telemetry,"merge_batches"),
+    SplitNeighb(in,OSP_sm,telemetry,"split_batch"),
+    EjectionChainNeighb(in,OSP_sm,telemetry,"ejection_chain"),
+    RuinAndRecreateNeighb(in,OSP_sm,telemetry,"ruin_and_recreate"),
+    ResequenceNeighb(in,OSP_sm,telemetry,"resequence"),
+    RegroupNeighb(in,OSP_sm,telemetry,"regroup"),
+    multi_all(in, OSP_sm, "multi_all",
+        SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb, SwapJobsNeighb, MergeNeighb, SplitNeighb, EjectionChainNeighb, RuinAndRecreateNeighb, ResequenceNeighb, RegroupNeighb, OSP_Rates{}),
+    OSP_solver(in, OSP_sm, "OSP_solver"),
+    OSP_island_solver(in, OSP_sm, "OSP_island_solver"),
+    used_solver(&OSP_solver),
+    used_runner(nullptr),
+    SD_polish(nullptr)
+{
+    size_t first_runner = OSP_Runner::runners.size();
+
+    // attach cost to solution manager
+    OSP_sm.AddCostComponent(cc1);
+    OSP_sm.AddCostComponent(cc2);
+    OSP_sm.AddCostComponent(cc3);
+    OSP_sm.AddCostComponent(cc4);
+
+    // attach cost to neighborhoods
+    auto add_cost_components = [&](auto&... nhes)
+    {
+        for (CostComponent<OSP_Input, OSP_Output, long>* cc : std::initializer_list<CostComponent<OSP_Input, OSP_Output, long>*>{&cc1, &cc2, &cc3, &cc4})
+        {
+            (nhes.AddCostComponent(*cc), ...);
+        }
+    };
+    add_cost_components(SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb, SwapJobsNeighb, MergeNeighb, SplitNeighb, EjectionChainNeighb, RuinAndRecreateNeighb, ResequenceNeighb, RegroupNeighb);
+    for (OSP_CachedEvaluation* ne : std::initializer_list<OSP_CachedEvaluation*>{&SwapNeighb, &InsertNeighb, &InverseNeighb, &SingleNewBatch, &MoreNewBatchNeighb, &JobExistingBarchNeighb, &SwapJobsNeighb, &MergeNeighb, &SplitNeighb, &EjectionChainNeighb, &ResequenceNeighb, &RegroupNeighb})
+    {
+        ne->SetDeltaCache(&delta_cache);
+    }
+
+    // registry of the methods: only the runner of the selected one is built (with its helpers), so that the parameters of the
+    // others are not registered
+    auto own = [this](auto p) { method_objects.push_back(p); return p.get(); };
+    // simulated annealing on a subset of the neighborhoods, the rates of the union are the ones of multi_all at the given indices
+    auto sa_on_union = [&](const std::string& name, const std::string& multi_name, std::array<size_t, 5> indices, auto&... nhes) -> OSP_Runner*
+    {
+        typedef SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, std::remove_reference_t<decltype(nhes)>...> Multi;
+        Multi* multi = own(std::make_shared<Multi>(in, OSP_sm, multi_name, nhes..., std::array<double, 5>{}));
+        rate_setters.push_back([multi, indices](const OSP_Rates& rates)
+        {
+            std::array<double, 5> multi_rates;
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                multi_rates[i] = rates[indices[i]];
+            }
+            SetRates(*multi, multi_rates);
+        });
+        return own(std::make_shared<SimulatedAnnealing<OSP_Input, OSP_Output, typename Multi::MoveType, DefaultCostStructure<long>>>(in, OSP_sm, *multi, name));
+    };
+    std::map<std::string, std::function<OSP_Runner*()>> runner_registry = {
+        {"HC_all", [&]() { return own(std::make_shared<HillClimbing<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>>(in, OSP_sm, multi_all, "HC_all")); }},
+        {"LAHC_all", [&]() { return own(std::make_shared<LateAcceptanceHillClimbing<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>>(in, OSP_sm, multi_all, "LAHC_all")); }},
+        {"SA_all", [&]() { return own(std::make_shared<SimulatedAnnealing<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>>(in, OSP_sm, multi_all, "SA_all")); }},
+        {"SA_adaptive", [&]() { return own(std::make_shared<SimulatedAnnealingWithLearning<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>>(in, OSP_sm, multi_all, "SA_adaptive")); }},
+        // the cooling schedule of SA_timebased spans its allowed_running_time (in seconds) rather than a number of evaluations
+        {"SA_timebased", [&]() { return own(std::make_shared<SimulatedAnnealingTimeBased<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>>(in, OSP_sm, multi_all, "SA_timebased")); }},
+        {"SA_reheating", [&]() { return own(std::make_shared<SimulatedAnnealingWithReheating<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>>(in, OSP_sm, multi_all, "SA_reheating")); }},
+        // the replicas of the parallel tempering share the neighborhoods
+        {"PT_all", [&]() { return own(std::make_shared<ParallelTempering<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>>(in, OSP_sm, multi_all, "PT_all")); }},
+        // the islands of simulated annealing: the first one uses the given rates, the others perturb them (at each run); all of them
+        // take the parameters of SA_islands
+        {"SA_islands", [&]()
+        {
+            typedef Island<SimulatedAnnealing<OSP_Input, OSP_Output, MultiMove, DefaultCostStructure<long>>> SA_Island;
+            SA_Island* SA_islands = own(std::make_shared<SA_Island>(in, OSP_sm, multi_all, "SA_islands"));
+            OSP_island_solver.AddIsland(*SA_islands);
+            std::vector<MultiAll*> island_multis;
+            for (unsigned int i = 1; i < islands; i++)
+            {
+                MultiAll* island_multi_all = own(std::make_shared<MultiAll>(in, OSP_sm, "multi_all_" + std::to_string(i),
+                    SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb, SwapJobsNeighb, MergeNeighb, SplitNeighb, EjectionChainNeighb, RuinAndRecreateNeighb, ResequenceNeighb, RegroupNeighb, OSP_Rates{}));
+                island_multis.push_back(island_multi_all);
+                SA_Island* island = own(std::make_shared<SA_Island>(in, OSP_sm, *island_multi_all, "SA_islands_" + std::to_string(i)));
+                OSP_island_solver.AddIsland(*island);
+                on_parameters_parsed.push_back([island, SA_islands]() { island->CopyParameterValues(*SA_islands); });
+            }
+            rate_setters.push_back([island_multis](const OSP_Rates& rates)
+            {
+                for (MultiAll* island_multi_all : island_multis)
+                {
+                    OSP_Rates island_rates = rates;
+                    for (double& rate : island_rates)
+                    {
+                        rate *= Random::Uniform<double>(0.5, 1.5);
+                    }
+                    SetRates(*island_multi_all, island_rates);
+                }
+            });
+            used_solver = &OSP_island_solver;
+            // the iterations printed are those of the first island
+            return SA_islands;
+        }},
+        // large neighborhood searches: the ruin and recreate moves with the acceptance of SA and LAHC
+        {"SA_lns", [&]() { return own(std::make_shared<SimulatedAnnealing<OSP_Input, OSP_Output, RuinAndRecreate, DefaultCostStructure<long>>>(in, OSP_sm, RuinAndRecreateNeighb, "SA_lns")); }},
+        {"LAHC_lns", [&]() { return own(std::make_shared<LateAcceptanceHillClimbing<OSP_Input, OSP_Output, RuinAndRecreate, DefaultCostStructure<long>>>(in, OSP_sm, RuinAndRecreateNeighb, "LAHC_lns")); }},
+        {"SA_noSwap", [&]() { return sa_on_union("SA_noSwap", "multi_noSwap", {1, 2, 3, 4, 5},
+            InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb); }},
+        {"SA_noInsert", [&]() { return sa_on_union("SA_noInsert", "multi_noInsert", {0, 2, 3, 4, 5},
+            SwapNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb); }},
+        {"SA_noInverse", [&]() { return sa_on_union("SA_noInverse", "multi_noInverse", {0, 1, 3, 4, 5},
+            SwapNeighb, InsertNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb); }},
+        {"SA_noSingleNewBatch", [&]() { return sa_on_union("SA_noSingleNewBatch", "multi_noSingleNewBatch", {0, 1, 2, 4, 5},
+            SwapNeighb, InsertNeighb, InverseNeighb, MoreNewBatchNeighb, JobExistingBarchNeighb); }},
+        {"SA_noMoreNewBatch", [&]() { return sa_on_union("SA_noMoreNewBatch", "multi_noMoreNewBatch", {0, 1, 2, 3, 5},
+            SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, JobExistingBarchNeighb); }},
+        {"SA_noExistingBatch", [&]() { return sa_on_union("SA_noExistingBatch", "multi_noExistingBatch", {0, 1, 2, 3, 4},
+            SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb); }}
+    };
+
+    if (runner_registry.find(method) == runner_registry.end())
+    {
+        throw std::invalid_argument("unknown --metaheuristic::method " + method);
+    }
+    used_runner = runner_registry[method]();
+
+    // the final polish is a steepest descent from the best solution of the method, on the neighborhoods that can be explored
+    // exhaustively (swap, insert, inverse, more_jobs_to_new_batch and ejection_chain
+    // have only random moves), the resequencing replaces the random swaps and inversions of batches
+    typedef SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
+    decltype(SingleNewBatch), decltype(JobExistingBarchNeighb), decltype(SwapJobsNeighb), decltype(MergeNeighb), decltype(SplitNeighb), decltype(ResequenceNeighb)> PolishMulti;
+    if (polish)
+    {
+        PolishMulti* multi_polish = own(std::make_shared<PolishMulti>(in, OSP_sm, "multi_polish",
+            SingleNewBatch, JobExistingBarchNeighb, SwapJobsNeighb, MergeNeighb, SplitNeighb, ResequenceNeighb,
+            std::array<double, 6>{1.0, 1.0, 1.0, 1.0, 1.0, 1.0}));
+        SD_polish = own(std::make_shared<SteepestDescent<OSP_Input, OSP_Output, PolishMulti::MoveType, DefaultCostStructure<long>>>(in, OSP_sm, *multi_polish, "SD_polish"));
+    }
+
+    runners.assign(OSP_Runner::runners.begin() + first_runner, OSP_Runner::runners.end());
+    // the telemetry charges the new best states of all the runners to the neighborhoods of their moves
+    if (telemetry.Enabled())
+    {
+        for (OSP_Runner* r : runners)
+        {
+            r->AttachObserver(telemetry);
+        }
+    }
+}
+
+std::string OSP_MethodGraph::Key(const std::string& instance, unsigned int initial_solution, const std::string& method, bool polish, unsigned int islands,
+    bool counters, unsigned long snapshot_period, size_t delta_cache_size)
+{
+    return instance + "|" + std::to_string(initial_solution) + "|" + method + "|" + std::to_string(polish) + "|" + std::to_string(islands)
+        + "|" + std::to_string(counters) + "|" + std::to_string(snapshot_period) + "|" + std::to_string(delta_cache_size);
+}
+
+void OSP_MethodGraph::Prepare(OSP_Input instance, const OSP_Rates& rates, unsigned int min_ruin_size, unsigned int max_ruin_size, unsigned int resequence_window,
+    double focus_probability)
+{
+    in = std::move(instance);
+    cc4.SetWeight(2 * in.UpperBoundIntegerObjective());
+    telemetry.Clear();
+    delta_cache.Clear();
+    delta_cache.ClearCounters();
+
+    RuinAndRecreateNeighb.SetRuinSize(min_ruin_size, max_ruin_size);
+    ResequenceNeighb.SetWindow(resequence_window);
+    // bias the random moves of the job and batch neighborhoods towards the costly parts of the solution
+    for (OSP_FocusedSampling* ne : std::initializer_list<OSP_FocusedSampling*>{&InsertNeighb, &SingleNewBatch, &MoreNewBatchNeighb, &JobExistingBarchNeighb, &SwapJobsNeighb, &MergeNeighb, &RuinAndRecreateNeighb})
+    {
+        ne->SetFocusProbability(focus_probability);
+    }
+    // the biases learned by SA_adaptive in the previous run are replaced too
+    SetRates(multi_all, rates);
+    for (auto& set_rates : rate_setters)
+    {
+        set_rates(rates);
+    }
+
+    // the polish of the previous run replaced the runner of the solver
+    OSP_solver.SetRunner(*used_runner);
+    used_runner->DetachCheckpointer();
+    for (auto o : run_observers)
+    {
+        for (OSP_Runner* r : runners)
+        {
+            r->DetachObserver(*o);
+        }
+    }
+    run_observers.clear();
+}
+
+void OSP_MethodGraph::AttachRunObserver(RunnerObserver<OSP_Input, OSP_Output, DefaultCostStructure<long>>& o)
+{
+    for (OSP_Runner* r : runners)
+    {
+        r->AttachObserver(o);
+    }
+    run_observers.push_back(&o);
+}
+
+// a run of the program on its command line options, written on results, and its diagnostics (as the errors of the options) on
+// messages; instances are the ones cached by the batch or the server of the run (nullptr if alone), and solutions is where its improving
+// solutions are sent (nullptr if not, or only to --main::solution_stream)
+int run(int argc, const char* argv[], std::ostream& results, std::ostream& messages, OSP_InstanceCache* instances, const OSP_SharedOutput* solutions)
 {
 #if !defined(NDEBUG)
-    std::cout << "This code is running in DEBUG mode" << std::endl;
+    std::cerr << "This code is running in DEBUG mode" << std::endl;
 #endif
 
     // define the parameters of the main program
@@ -25,12 +359,28 @@ int main(int argc, const char* argv[])
     Parameter<unsigned int> seed("seed", "Random seed", main_parameters); 
     Parameter<unsigned int> solution_method("solution_method", "Solution method could be 1: heuristic, 2: local search, 3: random", main_parameters);
     Parameter<std::string> output_file("output_file", "Name of the output file, otherwise the output is only printed", main_parameters);
+    Parameter<std::string> warm_start("warm_start", "Solution file (JSON, as written by this program) the local search starts from, instead of the initial solution", main_parameters);
+    Parameter<std::string> instance_delta("instance_delta", "Changes of the instance (jobs added, removed or with a new latest end): the solution of the warm start is updated to them, the method runs only on the region of the changes", main_parameters);
+    Parameter<std::string> solution_stream("solution_stream", "Name of the file where each new best solution is appended as a JSON line", main_parameters);
     
     ParameterBox tuning_parameters("tuning", "Tuning options");
     Parameter<bool> irace("irace", "Irace version, means that the output (only the cost) will be printed", tuning_parameters);
 
+    ParameterBox telemetry_parameters("telemetry", "Telemetry options");
+    Parameter<bool> telemetry_counters("counters", "Record the counters of the neighborhoods, printed with the results (on by default)", telemetry_parameters);
+    Parameter<unsigned int> snapshot_period("snapshot_period", "Number of evaluations between two snapshots of the neighborhood counters printed on the standard error (0: no snapshots), it needs the counters", telemetry_parameters);
+
+    ParameterBox checkpoint_parameters("checkpoint", "Checkpoint options");
+    Parameter<std::string> checkpoint_file("file", "Name of the file of the checkpoints of the run, otherwise there are no checkpoints", checkpoint_parameters);
+    Parameter<unsigned long> checkpoint_period("period", "Number of iterations between two checkpoints", checkpoint_parameters);
+    Parameter<bool> resume("resume", "Resume the run from the checkpoint, if the file exists", checkpoint_parameters);
+
+    ParameterBox rolling_parameters("rolling", "Rolling horizon options");
+    Parameter<unsigned int> rolling_window("window", "Length of the windows of the release times solved one after the other by the method (0: the whole instance at once), the stitched solution is then polished", rolling_parameters);
+    Parameter<unsigned int> rolling_overlap("overlap", "Overlap of two consecutive windows (default: a quarter of the window)", rolling_parameters);
+
     ParameterBox metaheuristic_parameters("metaheuristic", "Metaheuristic options");
-    Parameter<unsigned int> initial_solution("initial_solution", "Type of initial solution you want (1: heuristic, 2: random)", metaheuristic_parameters);
+    Parameter<unsigned int> initial_solution("initial_solution", "Type of initial solution you want (1: heuristic, 2: random, 3: grouped by attribute)", metaheuristic_parameters);
     Parameter<std::string> method("method", "Type of metaheuristics methods you want", metaheuristic_parameters);
     
     Parameter<double> swap_rate("swap_rate", "Rate for the swap move", metaheuristic_parameters);
@@ -39,22 +389,48 @@ int main(int argc, const char* argv[])
     Parameter<double> single_job_to_new_batch_rate("single_job_to_new_batch_rate", "Rate for the insertion of just one job in a new batch", metaheuristic_parameters);
     Parameter<double> more_jobs_to_new_batch_rate("more_jobs_to_new_batch_rate", "Rate for the insertion of more than one job in a new batch", metaheuristic_parameters); 
     Parameter<double> job_to_existing_batch_rate("job_to_existing_batch_rate", "Rate for the insertion of one job in a new batch", metaheuristic_parameters);
+    Parameter<double> swap_jobs_between_batches_rate("swap_jobs_between_batches_rate", "Rate for the exchange of two jobs between two batches (optional, default 0)", metaheuristic_parameters);
+    Parameter<double> merge_batches_rate("merge_batches_rate", "Rate for the merge of two batches (optional, default 0)", metaheuristic_parameters);
+    Parameter<double> split_batch_rate("split_batch_rate", "Rate for the split of a batch in two (optional, default 0)", metaheuristic_parameters);
+    Parameter<double> ejection_chain_rate("ejection_chain_rate", "Rate for the ejection chains from tardy jobs (optional, default 0)", metaheuristic_parameters);
+    Parameter<double> ruin_and_recreate_rate("ruin_and_recreate_rate", "Rate for the ruin and recreate of a group of jobs (optional, default 0)", metaheuristic_parameters);
+    Parameter<unsigned int> min_ruin_size("min_ruin_size", "Minimum number of jobs removed by a ruin and recreate move", metaheuristic_parameters);
+    Parameter<unsigned int> max_ruin_size("max_ruin_size", "Maximum number of jobs removed by a ruin and recreate move", metaheuristic_parameters);
+    Parameter<double> resequence_rate("resequence_rate", "Rate for the exact resequencing of a window of batches of a machine (optional, default 0)", metaheuristic_parameters);
+    Parameter<double> regroup_rate("regroup_rate", "Rate for the grouping by attribute of a segment of batches of a machine (optional, default 0)", metaheuristic_parameters);
+    Parameter<unsigned int> resequence_window("resequence_window", "Number of batches of the window of the resequencing move (at most 8)", metaheuristic_parameters);
+    Parameter<double> focus_probability("focus_probability", "Probability of drawing the jobs and batches of the random moves among the tardy jobs and the batches past the horizon", metaheuristic_parameters);
+    Parameter<unsigned int> islands("islands", "Number of islands of SA_islands (default: the number of hardware threads)", metaheuristic_parameters);
+    Parameter<unsigned int> delta_cache_size("delta_cache_size", "Number of entries of the cache of the move evaluations (0: no cache)", metaheuristic_parameters);
+    Parameter<bool> polish("polish", "Polish the solution of the method with a steepest descent on the job and batch neighborhoods and the resequencing (its budget is --SD_polish::max_evaluations)", metaheuristic_parameters);
 
     seed = 42; 
     irace = false; 
+    telemetry_counters = true;
+    snapshot_period = 0;
+    checkpoint_period = 1000000;
+    resume = false;
+    rolling_window = 0;
+    focus_probability = 0.0;
+    delta_cache_size = 0;
+    polish = false;
+    min_ruin_size = 5;
+    max_ruin_size = 20;
+    resequence_window = 6;
+    islands = std::max(2u, std::thread::hardware_concurrency());
     solution_method = 100;
 
     // parse the command line parameters
-    CommandLineParameters::Parse(argc, argv, false, true);
+    CommandLineParameters::Parse(argc, argv, false, true, messages);
 
     if (!instance.IsSet())
     {
-        std::cout << "Error: --main::instance filename option must always be set" << std::endl;
+        messages << "Error: --main::instance filename option must always be set" << std::endl;
         return 1;
     }  
     if (!solution_method.IsSet() || solution_method > 3)
     {
-        std::cout << "Error: --main::solution_method solution method option must always be set and should be one of the allowed options" << std::endl;
+        messages << "Error: --main::solution_method solution method option must always be set and should be one of the allowed options" << std::endl;
         return 1;
     }
     if (seed.IsSet())
@@ -62,13 +438,13 @@ int main(int argc, const char* argv[])
         Random::SetSeed(seed);
     }
     
-    OSP_Input in(instance);
+    OSP_Input loaded_in = instances != nullptr ? instances->Instance(instance) : OSP_Input(instance);
 
     // if the solution method is 1 or 3, this means you don't want to run one of the two greedy algorithms
     if (solution_method == 1)
     {
-        OSP_SolutionManager OSP_sm(in);
-        OSP_Output st(in);
+        OSP_SolutionManager OSP_sm(loaded_in);
+        OSP_Output st(loaded_in);
         auto start = high_resolution_clock::now();
         OSP_sm.GreedyState(st);
         auto stop = high_resolution_clock::now();
@@ -89,19 +465,19 @@ int main(int argc, const char* argv[])
         }
         else
         {
-            std::cout << "{\"solution\": {" << st <<  "}, "
+            results << "{\"solution\": {" << st <<  "}, "
             << "\"total_cost\": " <<  cost  <<  ", "
             << "\"time_seconds\": " << duration.count() << "} " << std::endl;
         }
 #if !defined(NDEBUG)
-        std::cout << "This code is running in DEBUG mode" << std::endl;
+        std::cerr << "This code is running in DEBUG mode" << std::endl;
 #endif
         return 0;
     }
     else if (solution_method == 3)
     {
-        OSP_SolutionManagerRandom OSP_sm(in);
-        OSP_Output st(in);
+        OSP_SolutionManagerRandom OSP_sm(loaded_in);
+        OSP_Output st(loaded_in);
         auto start = high_resolution_clock::now();
         OSP_sm.GreedyState(st);
         auto stop = high_resolution_clock::now();
@@ -122,32 +498,65 @@ int main(int argc, const char* argv[])
         }
         else
         {
-            std::cout << "{\"solution\": {" << st <<  "}, "
+            results << "{\"solution\": {" << st <<  "}, "
             << "\"total_cost\": " <<  cost  <<  ", "
             << "\"time_seconds\": " << duration.count() << "} " << std::endl;
         }
 #if !defined(NDEBUG)
-        std::cout << "This code is running in DEBUG mode" << std::endl;
+        std::cerr << "This code is running in DEBUG mode" << std::endl;
 #endif
         return 0;
     }
 
-    // if you reach this point, it means you need to run a local search method
-    if (!initial_solution.IsSet() || (initial_solution!= 1 && initial_solution != 2))
+    // if you reach this point, it means you need to run a local search method (the warm start replaces the initial solution)
+    if (warm_start.IsSet() && !initial_solution.IsSet())
+    {
+        initial_solution = 1;
+    }
+    if (!initial_solution.IsSet() || (initial_solution!= 1 && initial_solution != 2 && initial_solution != 3))
     {
-        std::cout << "Error: --metaheuristic::initial_solution initial_solution option must always be set when you select the local search solution method or you should look at the values" << std::endl;
+        messages << "Error: --metaheuristic::initial_solution initial_solution option must always be set when you select the local search solution method or you should look at the values" << std::endl;
         return 1;
     }
     if (!method.IsSet())
     {
-        std::cout << "Error: --metaheuristic::method method option must always be set when you select the local search solution method" << std::endl;
+        messages << "Error: --metaheuristic::method method option must always be set when you select the local search solution method" << std::endl;
+        return 1;
+    }
+    if (instance_delta.IsSet() && (!warm_start.IsSet() || solution_stream.IsSet() || solutions != nullptr || checkpoint_file.IsSet()))
+    {
+        messages << "Error: --main::instance_delta needs the solution to update in --main::warm_start, and it does not support the solution stream and the checkpoints" << std::endl;
         return 1;
     }
+    // the windows of the rolling horizon are stitched together by the polish
+    if (rolling_window > 0)
+    {
+        if (!rolling_overlap.IsSet())
+        {
+            rolling_overlap = rolling_window / 4;
+        }
+        if (rolling_overlap >= rolling_window)
+        {
+            messages << "Error: --rolling::overlap should be below --rolling::window" << std::endl;
+            return 1;
+        }
+        if (warm_start.IsSet() || solution_stream.IsSet() || solutions != nullptr || checkpoint_file.IsSet())
+        {
+            messages << "Error: the rolling horizon does not support the warm start, the solution stream and the checkpoints" << std::endl;
+            return 1;
+        }
+        polish = true;
+    }
 
     
     if ((method == std::string("SA_all") ||
         method == std::string("HC_all") || 
-        method == std::string("LAHC_all") ||) 
+        method == std::string("LAHC_all") || 
+        method == std::string("PT_all") || 
+        method == std::string("SA_islands") || 
+        method == std::string("SA_timebased") || 
+        method == std::string("SA_reheating") ||
+        method == std::string("SA_adaptive")) 
         && 
         (!swap_rate.IsSet() || 
         !insert_rate.IsSet() || 
@@ -156,7 +565,49 @@ int main(int argc, const char* argv[])
         !more_jobs_to_new_batch_rate.IsSet() || 
         !job_to_existing_batch_rate.IsSet()))
     {
-        std::cout << "Error: missing one of the neighborhoods rate" << std::endl;
+        messages << "Error: missing one of the neighborhoods rate" << std::endl;
+        return 1;
+    }
+
+    if (snapshot_period > 0 && !telemetry_counters)
+    {
+        messages << "Error: --telemetry::snapshot_period needs the counters, disabled by --telemetry::counters-disable" << std::endl;
+        return 1;
+    }
+    if (focus_probability < 0.0 || focus_probability > 1.0)
+    {
+        messages << "Error: --metaheuristic::focus_probability should be a value in the interval [0, 1]" << std::endl;
+        return 1;
+    }
+
+    // the large neighborhood searches use only the ruin and recreate neighborhood
+    if (method == std::string("SA_lns") || method == std::string("LAHC_lns"))
+    {
+        for (Parameter<double>* rate : {&swap_rate, &insert_rate, &inverse_rate, &single_job_to_new_batch_rate, &more_jobs_to_new_batch_rate, &job_to_existing_batch_rate})
+        {
+            if (!rate->IsSet())
+            {
+                *rate = 0.0;
+            }
+        }
+        if (!ruin_and_recreate_rate.IsSet())
+        {
+            ruin_and_recreate_rate = 1.0;
+        }
+        else if (ruin_and_recreate_rate <= 0.0)
+        {
+            messages << "Error: --metaheuristic::ruin_and_recreate_rate should be positive for " << std::string(method) << ", which uses only the ruin and recreate neighborhood" << std::endl;
+            return 1;
+        }
+    }
+    if (min_ruin_size < 1 || max_ruin_size < min_ruin_size)
+    {
+        messages << "Error: --metaheuristic::min_ruin_size should be at least 1 and not above --metaheuristic::max_ruin_size" << std::endl;
+        return 1;
+    }
+    if (resequence_window < 2 || resequence_window > (unsigned int) ResequenceBatches::MaxLength)
+    {
+        messages << "Error: --metaheuristic::resequence_window should be between 2 and " << ResequenceBatches::MaxLength << std::endl;
         return 1;
     }
 
@@ -168,7 +619,7 @@ int main(int argc, const char* argv[])
         !more_jobs_to_new_batch_rate.IsSet() ||
         !job_to_existing_batch_rate.IsSet()))
     {
-        std::cout << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
+        messages << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
         return 1;
     }
     else if (method == std::string("SA_noSwap"))
@@ -184,7 +635,7 @@ int main(int argc, const char* argv[])
         !more_jobs_to_new_batch_rate.IsSet() ||
         !job_to_existing_batch_rate.IsSet()))
     {
-        std::cout << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
+        messages << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
         return 1;
     }
     else if (method == std::string("SA_noInsert"))
@@ -200,7 +651,7 @@ int main(int argc, const char* argv[])
         !more_jobs_to_new_batch_rate.IsSet() ||
         !job_to_existing_batch_rate.IsSet()))
     {
-        std::cout << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
+        messages << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
         return 1;
     }
     else if (method == std::string("SA_noInverse"))
@@ -216,7 +667,7 @@ int main(int argc, const char* argv[])
         !more_jobs_to_new_batch_rate.IsSet() ||
         !job_to_existing_batch_rate.IsSet()))
     {
-        std::cout << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
+        messages << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
         return 1;
     }
     else if (method == std::string("SA_noSingleNewBatch"))
@@ -232,7 +683,7 @@ int main(int argc, const char* argv[])
         more_jobs_to_new_batch_rate.IsSet() ||
         !job_to_existing_batch_rate.IsSet()))
     {
-        std::cout << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
+        messages << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
         return 1;
     }
     else if (method == std::string("SA_noMoreNewBatch"))
@@ -248,7 +699,7 @@ int main(int argc, const char* argv[])
         !more_jobs_to_new_batch_rate.IsSet() ||
         job_to_existing_batch_rate.IsSet()))
     {
-        std::cout << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
+        messages << "Error: missing one of the neighborhoods rate or a wrong one is set" << std::endl;
         return 1;
     }
     else if (method == std::string("SA_noExistingBatch"))
@@ -256,14 +707,38 @@ int main(int argc, const char* argv[])
         job_to_existing_batch_rate = 0.0;
     }
 
+    // the other methods (and the unknown ones) need all the rates too
+    if (!swap_rate.IsSet() || !insert_rate.IsSet() || !inverse_rate.IsSet() || !single_job_to_new_batch_rate.IsSet() || !more_jobs_to_new_batch_rate.IsSet() || !job_to_existing_batch_rate.IsSet())
+    {
+        messages << "Error: missing one of the neighborhoods rate" << std::endl;
+        return 1;
+    }
+
     // normalization    
-    double total = swap_rate + insert_rate + inverse_rate + single_job_to_new_batch_rate + more_jobs_to_new_batch_rate + job_to_existing_batch_rate; 
+    // the neighborhoods with an optional rate are used only by the methods on all the neighborhoods, and only if their rates are given
+    for (Parameter<double>* rate : {&swap_jobs_between_batches_rate, &merge_batches_rate, &split_batch_rate, &ejection_chain_rate, &ruin_and_recreate_rate, &resequence_rate, &regroup_rate})
+    {
+        if (!rate->IsSet())
+        {
+            *rate = 0.0;
+        }
+    }
+
+    double total = swap_rate + insert_rate + inverse_rate + single_job_to_new_batch_rate + more_jobs_to_new_batch_rate + job_to_existing_batch_rate
+        + swap_jobs_between_batches_rate + merge_batches_rate + split_batch_rate + ejection_chain_rate + ruin_and_recreate_rate + resequence_rate + regroup_rate; 
     swap_rate = round_to(swap_rate / total);
     insert_rate = round_to(insert_rate / total); 
     inverse_rate = round_to(inverse_rate / total);
     single_job_to_new_batch_rate = round_to(single_job_to_new_batch_rate / total);
     more_jobs_to_new_batch_rate = round_to(more_jobs_to_new_batch_rate / total);
     job_to_existing_batch_rate = round_to(job_to_existing_batch_rate / total);
+    swap_jobs_between_batches_rate = round_to(swap_jobs_between_batches_rate / total);
+    merge_batches_rate = round_to(merge_batches_rate / total);
+    split_batch_rate = round_to(split_batch_rate / total);
+    ejection_chain_rate = round_to(ejection_chain_rate / total);
+    ruin_and_recreate_rate = round_to(ruin_and_recreate_rate / total);
+    resequence_rate = round_to(resequence_rate / total);
+    regroup_rate = round_to(regroup_rate / total);
 
     // std::cout << swap_rate << "--" << 
     //  insert_rate << "--" <<
@@ -272,477 +747,210 @@ int main(int argc, const char* argv[])
     //  more_jobs_to_new_batch_rate << "--" << 
     //  job_to_existing_batch_rate << ";" << std::endl; 
 
-    // cost components: 
-    // second parameter is the cost, third is the type (true -> hard, false -> soft)
-    OSP_TotalSetUpCost cc1(in, in.MultFactorTotalSetUpCosts(), false);
-    OSP_NumberOfTardyJobs cc2(in, in.MultFactorFinishedTooLate(), false);
-    OSP_CumulativeBatchProcessingTime cc3(in, in.MultFactorTotalRunTime(), false);
-    OSP_NotScheduledBatches cc4(in, 2 * in.UpperBoundIntegerObjective(), true);
-
-    if (initial_solution == 1)
-    {
-        // solution manager:
-        OSP_SolutionManager OSP_sm(in);
-
-        // attach cost to solution manager
-        OSP_sm.AddCostComponent(cc1);
-        OSP_sm.AddCostComponent(cc2);
-        OSP_sm.AddCostComponent(cc3);
-        OSP_sm.AddCostComponent(cc4);
-
-        // neighborhood
-        OSP_SwapBatchesNeighborhoodExplorer SwapNeighb(in,OSP_sm);
-        OSP_BatchToNewPositionNeighborhoodExplorer InsertNeighb(in,OSP_sm);
-        OSP_InvertBatchesInMachineNeighborhoodExplorer InverseNeighb(in,OSP_sm);
-        OSP_JobToNewBatchNeighborhoodExplorer SingleNewBatch(in,OSP_sm);
-        Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer MoreNewBatchNeighb(in,OSP_sm);
-        OSP_JobToExistingBatchNeighborhoodExplorer JobExistingBarchNeighb(in,OSP_sm);    
-       
-        // attach cost to neighborhoods
-        SwapNeighb.AddCostComponent(cc1);
-        SwapNeighb.AddCostComponent(cc2);
-        SwapNeighb.AddCostComponent(cc3);
-        SwapNeighb.AddCostComponent(cc4);
-
-        InsertNeighb.AddCostComponent(cc1);
-        InsertNeighb.AddCostComponent(cc2);
-        InsertNeighb.AddCostComponent(cc3);
-        InsertNeighb.AddCostComponent(cc4);
-
-        InverseNeighb.AddCostComponent(cc1);
-        InverseNeighb.AddCostComponent(cc2);
-        InverseNeighb.AddCostComponent(cc3);
-        InverseNeighb.AddCostComponent(cc4);
-
-        SingleNewBatch.AddCostComponent(cc1);
-        SingleNewBatch.AddCostComponent(cc2);
-        SingleNewBatch.AddCostComponent(cc3);
-        SingleNewBatch.AddCostComponent(cc4);
-
-        MoreNewBatchNeighb.AddCostComponent(cc1);
-        MoreNewBatchNeighb.AddCostComponent(cc2);
-        MoreNewBatchNeighb.AddCostComponent(cc3);
-        MoreNewBatchNeighb.AddCostComponent(cc4);
-
-        JobExistingBarchNeighb.AddCostComponent(cc1);
-        JobExistingBarchNeighb.AddCostComponent(cc2);
-        JobExistingBarchNeighb.AddCostComponent(cc3);
-        JobExistingBarchNeighb.AddCostComponent(cc4);
-
-        // create the multi-neighborhood
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_all
-        (in, OSP_sm, 
-        "multi_all", 
-        SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noSwap
-        (in, OSP_sm, 
-        "multi_noSwap", 
-        InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            insert_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noInsert
-        (in, OSP_sm, 
-        "multi_noInsert", 
-        SwapNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noInverse
-        (in, OSP_sm, 
-        "multi_noInverse", 
-        SwapNeighb, InsertNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noSingleNewBatch
-        (in, OSP_sm, 
-        "multi_noSingleNewBatch", 
-        SwapNeighb, InsertNeighb, InverseNeighb, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(JobExistingBarchNeighb)>
-        multi_noMoreNewBatch
-        (in, OSP_sm, 
-        "multi_noMoreNewBatch", 
-        SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, single_job_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb)>
-        multi_noExistingBatch
-        (in, OSP_sm, 
-        "multi_noExistingBatch", 
-        SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate
-        });
-
-        // create hill climbing
-        HillClimbing<OSP_Input, OSP_Output, decltype(multi_all)::MoveType, DefaultCostStructure<long>> HC_all(in, OSP_sm, multi_all, "HC_all");
-        LateAcceptanceHillClimbing<OSP_Input, OSP_Output, decltype(multi_all)::MoveType, DefaultCostStructure<long>> LAHC_all(in, OSP_sm, multi_all, "LAHC_all");
-        
-        // create the simulated annealing
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_all)::MoveType, DefaultCostStructure<long>> SA_all(in, OSP_sm, multi_all, "SA_all");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noSwap)::MoveType, DefaultCostStructure<long>> SA_noSwap(in, OSP_sm, multi_noSwap, "SA_noSwap");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noInsert)::MoveType, DefaultCostStructure<long>> SA_noInsert(in, OSP_sm, multi_noInsert, "SA_noInsert");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noInverse)::MoveType, DefaultCostStructure<long>> SA_noInverse(in, OSP_sm, multi_noInverse, "SA_noInverse");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noSingleNewBatch)::MoveType, DefaultCostStructure<long>> SA_noSingleNewBatch(in, OSP_sm, multi_noSingleNewBatch, "SA_noSingleNewBatch");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noMoreNewBatch)::MoveType, DefaultCostStructure<long>> SA_noMoreNewBatch(in, OSP_sm, multi_noMoreNewBatch, "SA_noMoreNewBatch");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noExistingBatch)::MoveType, DefaultCostStructure<long>> SA_noExistingBatch(in, OSP_sm, multi_noExistingBatch, "SA_noExistingBatch");
-
-        SimpleLocalSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> OSP_solver(in, OSP_sm, "OSP_solver");
-        if (!CommandLineParameters::Parse(argc, argv, true, false))
-        {
-            return 1;
-        }
-
-        Runner<OSP_Input, OSP_Output, DefaultCostStructure<long>> *used_runner = nullptr;
-        
-        if (method ==  std::string("SA_all"))
-        {
-            used_runner = &SA_all;
-            OSP_solver.SetRunner(SA_all);
-        }
-        else if (method ==  std::string("HC_all"))
-        {
-            used_runner = &HC_all;
-            OSP_solver.SetRunner(HC_all);
-        }
-        else if (method ==  std::string("LAHC_all"))
-        {
-            used_runner = &LAHC_all;
-            OSP_solver.SetRunner(LAHC_all);
-        }
-        else if (method ==  std::string("SA_noSwap"))
-        {
-            used_runner = &SA_noSwap;
-            OSP_solver.SetRunner(SA_noSwap);
-        }
-        else if (method ==  std::string("SA_noInsert"))
-        {
-            used_runner = &SA_noInsert;
-            OSP_solver.SetRunner(SA_noInsert);
-        }
-        else if (method ==  std::string("SA_noInverse"))
-        {
-            used_runner = &SA_noInverse;
-            OSP_solver.SetRunner(SA_noInverse);
-        }
-        else if (method ==  std::string("SA_noSingleNewBatch"))
-        {
-            used_runner = &SA_noSingleNewBatch;
-            OSP_solver.SetRunner(SA_noSingleNewBatch);
-        }
-        else if (method ==  std::string("SA_noMoreNewBatch"))
-        {
-            used_runner = &SA_noMoreNewBatch;
-            OSP_solver.SetRunner(SA_noMoreNewBatch);
-        }
-        else if (method ==  std::string("SA_noExistingBatch"))
+    // the runner graph of the method: a worker of a batch or a server keeps it for its next runs with the same key, a run alone
+    // builds its own
+    std::function<std::unique_ptr<OSP_MethodGraph>()> build = [&]()
+    {
+        return std::make_unique<OSP_MethodGraph>(loaded_in, initial_solution, method, polish, islands, telemetry_counters, snapshot_period, delta_cache_size);
+    };
+    std::unique_ptr<OSP_MethodGraph> own_graph;
+    OSP_MethodGraph* graph;
+    try
+    {
+        if (OSP_WorkerGraphs::Current() != nullptr)
         {
-            used_runner = &SA_noExistingBatch;
-            OSP_solver.SetRunner(SA_noExistingBatch);
+            graph = &OSP_WorkerGraphs::Current()->Use(OSP_MethodGraph::Key(instance, initial_solution, method, polish, islands, telemetry_counters, snapshot_period, delta_cache_size), build);
         }
         else
         {
-            throw std::invalid_argument("Unknown method" + std::string(method));
-        }
-
-        // now perform the search
-        SolverResult<OSP_Input,OSP_Output,DefaultCostStructure<long>> result(in);
-        result = OSP_solver.Solve();
-        // result is a tuple: 0: solution, 1: number of violations, 2: total cost, 3: computing time
-        OSP_Output out = result.output;
-
-        // output
-        if (irace)
-        {
-            std::cout << (double)result.cost.total / in.UpperBoundIntegerObjective() << std::endl;
-        }
-        else if (output_file.IsSet())
-        {
-            std::ofstream os(static_cast<std::string>(output_file).c_str());
-            os 
-                // << "{\"solution\": {" << out <<  "}, "
-                << "{\"total_cost\": " <<  result.cost.total <<  ", "
-                << "\"time_seconds\": " << result.running_time << ", "
-                << "\"total_iterations\": " << used_runner->Iteration() << ", "
-                << "\"iteration_of_best\": " << used_runner->IterationOfBest() << ", "
-                << "\"seed\": " << Random::GetSeed() << "} " << std::endl;
-            os.flush();
-            os.close();
-        }
-        else
-        {
-            std::cout << "{\"total_cost\": " <<  result.cost.total <<  ", "
-                << "\"time\": " << result.running_time << ", "
-                << "\"total_iterations\": " << used_runner->Iteration() << ", "
-                << "\"iteration_of_best\": " << used_runner->IterationOfBest() << ", "
-                << "\"seed\": " << Random::GetSeed() << "} " << std::endl;
+            own_graph = build();
+            graph = own_graph.get();
         }
     }
-    else if(initial_solution == 2)
-    {
-        // solution manager:
-        OSP_SolutionManagerRandom OSP_sm(in);
-
-        // attach cost to solution manager
-        OSP_sm.AddCostComponent(cc1);
-        OSP_sm.AddCostComponent(cc2);
-        OSP_sm.AddCostComponent(cc3);
-        OSP_sm.AddCostComponent(cc4);
-
-        // neighborhood
-        OSP_SwapBatchesNeighborhoodExplorer SwapNeighb(in,OSP_sm);
-        OSP_BatchToNewPositionNeighborhoodExplorer InsertNeighb(in,OSP_sm);
-        OSP_InvertBatchesInMachineNeighborhoodExplorer InverseNeighb(in,OSP_sm);
-        OSP_JobToNewBatchNeighborhoodExplorer SingleNewBatch(in,OSP_sm);
-        Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer MoreNewBatchNeighb(in,OSP_sm);
-        OSP_JobToExistingBatchNeighborhoodExplorer JobExistingBarchNeighb(in,OSP_sm);    
-       
-        // attach cost to neighborhoods
-        SwapNeighb.AddCostComponent(cc1);
-        SwapNeighb.AddCostComponent(cc2);
-        SwapNeighb.AddCostComponent(cc3);
-        SwapNeighb.AddCostComponent(cc4);
-
-        InsertNeighb.AddCostComponent(cc1);
-        InsertNeighb.AddCostComponent(cc2);
-        InsertNeighb.AddCostComponent(cc3);
-        InsertNeighb.AddCostComponent(cc4);
-
-        InverseNeighb.AddCostComponent(cc1);
-        InverseNeighb.AddCostComponent(cc2);
-        InverseNeighb.AddCostComponent(cc3);
-        InverseNeighb.AddCostComponent(cc4);
-
-        SingleNewBatch.AddCostComponent(cc1);
-        SingleNewBatch.AddCostComponent(cc2);
-        SingleNewBatch.AddCostComponent(cc3);
-        SingleNewBatch.AddCostComponent(cc4);
-
-        MoreNewBatchNeighb.AddCostComponent(cc1);
-        MoreNewBatchNeighb.AddCostComponent(cc2);
-        MoreNewBatchNeighb.AddCostComponent(cc3);
-        MoreNewBatchNeighb.AddCostComponent(cc4);
-
-        JobExistingBarchNeighb.AddCostComponent(cc1);
-        JobExistingBarchNeighb.AddCostComponent(cc2);
-        JobExistingBarchNeighb.AddCostComponent(cc3);
-        JobExistingBarchNeighb.AddCostComponent(cc4);
-
-        // create the multi-neighborhood
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_all
-        (in, OSP_sm, 
-        "multi_all", 
-        SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noSwap
-        (in, OSP_sm, 
-        "multi_noSwap", 
-        InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            insert_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noInsert
-        (in, OSP_sm, 
-        "multi_noInsert", 
-        SwapNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noInverse
-        (in, OSP_sm, 
-        "multi_noInverse", 
-        SwapNeighb, InsertNeighb, SingleNewBatch, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(MoreNewBatchNeighb),decltype(JobExistingBarchNeighb)>
-        multi_noSingleNewBatch
-        (in, OSP_sm, 
-        "multi_noSingleNewBatch", 
-        SwapNeighb, InsertNeighb, InverseNeighb, MoreNewBatchNeighb, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(JobExistingBarchNeighb)>
-        multi_noMoreNewBatch
-        (in, OSP_sm, 
-        "multi_noMoreNewBatch", 
-        SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, JobExistingBarchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, single_job_to_new_batch_rate, job_to_existing_batch_rate
-        });
-
-        SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>,
-        decltype(SwapNeighb), decltype(InsertNeighb), decltype(InverseNeighb), decltype(SingleNewBatch),decltype(MoreNewBatchNeighb)>
-        multi_noExistingBatch
-        (in, OSP_sm, 
-        "multi_noExistingBatch", 
-        SwapNeighb, InsertNeighb, InverseNeighb, SingleNewBatch, MoreNewBatchNeighb,
-        {
-            swap_rate, insert_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate
-        });
-
-        HillClimbing<OSP_Input, OSP_Output, decltype(multi_all)::MoveType, DefaultCostStructure<long>> HC_all(in, OSP_sm, multi_all, "HC_all");
-        LateAcceptanceHillClimbing<OSP_Input, OSP_Output, decltype(multi_all)::MoveType, DefaultCostStructure<long>> LAHC_all(in, OSP_sm, multi_all, "LAHC_all");
-        
-        // create the simulated annealing
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_all)::MoveType, DefaultCostStructure<long>> SA_all(in, OSP_sm, multi_all, "SA_all");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noSwap)::MoveType, DefaultCostStructure<long>> SA_noSwap(in, OSP_sm, multi_noSwap, "SA_noSwap");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noInsert)::MoveType, DefaultCostStructure<long>> SA_noInsert(in, OSP_sm, multi_noInsert, "SA_noInsert");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noInverse)::MoveType, DefaultCostStructure<long>> SA_noInverse(in, OSP_sm, multi_noInverse, "SA_noInverse");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noSingleNewBatch)::MoveType, DefaultCostStructure<long>> SA_noSingleNewBatch(in, OSP_sm, multi_noSingleNewBatch, "SA_noSingleNewBatch");
-
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noMoreNewBatch)::MoveType, DefaultCostStructure<long>> SA_noMoreNewBatch(in, OSP_sm, multi_noMoreNewBatch, "SA_noMoreNewBatch");
+    catch (const std::invalid_argument& e)
+    {
+        messages << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    graph->Prepare(std::move(loaded_in),
+        {swap_rate, insert_rate, inverse_rate, single_job_to_new_batch_rate, more_jobs_to_new_batch_rate, job_to_existing_batch_rate, swap_jobs_between_batches_rate, merge_batches_rate, split_batch_rate, ejection_chain_rate, ruin_and_recreate_rate, resequence_rate, regroup_rate},
+        min_ruin_size, max_ruin_size, resequence_window, focus_probability);
+    OSP_Input& in = graph->in;
 
-        SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi_noExistingBatch)::MoveType, DefaultCostStructure<long>> SA_noExistingBatch(in, OSP_sm, multi_noExistingBatch, "SA_noExistingBatch");
+    if (!CommandLineParameters::Parse(argc, argv, true, false, messages))
+    {
+        return 1;
+    }
+    for (auto& f : graph->on_parameters_parsed)
+    {
+        f();
+    }
+    // the stream is attached to all the runners built for the method (for this run only), and it is closed (after its last write)
+    // at the end
+    std::unique_ptr<OSP_SolutionStream> best_stream;
+    if (solution_stream.IsSet() || solutions != nullptr)
+    {
+        best_stream = solutions != nullptr ? std::make_unique<OSP_SolutionStream>(*solutions, graph->OSP_sm) : std::make_unique<OSP_SolutionStream>(solution_stream, graph->OSP_sm);
+        graph->AttachRunObserver(*best_stream);
+    }
 
-        SimpleLocalSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> OSP_solver(in, OSP_sm, "OSP_solver");
-        if (!CommandLineParameters::Parse(argc, argv, true, false))
+    // the checkpoints are taken by the runner of the method (not by the polish), which must run in a single thread
+    std::unique_ptr<OSP_Checkpointer> checkpointer;
+    if (checkpoint_file.IsSet())
+    {
+        if (graph->used_solver != &graph->OSP_solver || method == "PT_all")
         {
+            messages << "Error: the checkpoints are not supported by the method " << std::string(method) << std::endl;
             return 1;
         }
+        checkpointer = std::make_unique<OSP_Checkpointer>(checkpoint_file, in, checkpoint_period, resume);
+        graph->used_runner->AttachCheckpointer(*checkpointer);
+    }
 
-        Runner<OSP_Input, OSP_Output, DefaultCostStructure<long>> *used_runner = nullptr;
-        
-        if (method ==  std::string("SA_all"))
-        {
-            used_runner = &SA_all;
-            OSP_solver.SetRunner(SA_all);
-        }
-        else if (method ==  std::string("HC_all"))
-        {
-            used_runner = &HC_all;
-            OSP_solver.SetRunner(HC_all);
-        }
-        else if (method ==  std::string("LAHC_all"))
-        {
-            used_runner = &LAHC_all;
-            OSP_solver.SetRunner(LAHC_all);
-        }
-        else if (method ==  std::string("SA_noSwap"))
-        {
-            used_runner = &SA_noSwap;
-            OSP_solver.SetRunner(SA_noSwap);
-        }
-        else if (method ==  std::string("SA_noInsert"))
-        {
-            used_runner = &SA_noInsert;
-            OSP_solver.SetRunner(SA_noInsert);
-        }
-        else if (method ==  std::string("SA_noInverse"))
-        {
-            used_runner = &SA_noInverse;
-            OSP_solver.SetRunner(SA_noInverse);
-        }
-        else if (method ==  std::string("SA_noSingleNewBatch"))
-        {
-            used_runner = &SA_noSingleNewBatch;
-            OSP_solver.SetRunner(SA_noSingleNewBatch);
-        }
-        else if (method ==  std::string("SA_noMoreNewBatch"))
-        {
-            used_runner = &SA_noMoreNewBatch;
-            OSP_solver.SetRunner(SA_noMoreNewBatch);
-        }
-        else if (method ==  std::string("SA_noExistingBatch"))
-        {
-            used_runner = &SA_noExistingBatch;
-            OSP_solver.SetRunner(SA_noExistingBatch);
-        }
-        else
+    // now perform the search
+    SolverResult<OSP_Input,OSP_Output,DefaultCostStructure<long>> result(in);
+    if (rolling_window > 0)
+    {
+        // the window instances are written in in, to which all the helpers are bound
+        OSP_RollingHorizon rolling_horizon(in, *graph->used_solver, graph->OSP_sm, graph->delta_cache, rolling_window, rolling_overlap);
+        result = rolling_horizon.Solve();
+    }
+    else if (instance_delta.IsSet())
+    {
+        // the solution of the warm start and its instance are updated by the reoptimizer, whose region instances are written in in
+        OSP_Input current_in(in);
+        OSP_Output current(current_in);
+        graph->OSP_sm_heuristic.WarmState(current, warm_start);
+        OSP_InstanceDelta delta(instance_delta);
+        // the weight of the batches not scheduled follows the upper bound of the updated instance
+        graph->cc4.SetWeight(2 * OSP_Input(current_in, delta).UpperBoundIntegerObjective());
+        OSP_Reoptimizer reoptimizer(in, *graph->used_solver, graph->OSP_sm, graph->RuinAndRecreateNeighb, graph->delta_cache);
+        auto start = high_resolution_clock::now();
+        DefaultCostStructure<long> cost = reoptimizer.Update(current_in, current, delta);
+        result = SolverResult<OSP_Input,OSP_Output,DefaultCostStructure<long>>(current, cost, duration_cast<duration<double>>(high_resolution_clock::now() - start).count());
+    }
+    else if (warm_start.IsSet())
+    {
+        OSP_Output warm(in);
+        int left_out = graph->OSP_sm_heuristic.WarmState(warm, warm_start);
+        if (left_out > 0)
         {
-            throw std::invalid_argument("Unknown method" + std::string(method));
+            messages << "Warning: " << left_out << " jobs of the warm start do not fit in their batches any more, they have been put in new batches" << std::endl;
         }
+        result = graph->used_solver->Resolve(warm);
+    }
+    else
+    {
+        result = graph->used_solver->Solve();
+    }
+    if (polish)
+    {
+        double method_time = result.running_time;
+        graph->OSP_solver.SetRunner(*graph->SD_polish);
+        result = graph->OSP_solver.Resolve(result.output);
+        result.running_time += method_time;
+    }
+    // result is a tuple: 0: solution, 1: number of violations, 2: total cost, 3: computing time
+    OSP_Output out = result.output;
 
-        // now perform the search
-        SolverResult<OSP_Input,OSP_Output,DefaultCostStructure<long>> result(in);
-        result = OSP_solver.Solve();
-        // result is a tuple: 0: solution, 1: number of violations, 2: total cost, 3: computing time
-        OSP_Output out = result.output;
-
-        // output
-        if (irace)
-        {
-            std::cout << (double)result.cost.total / in.UpperBoundIntegerObjective() << std::endl;
-        }
-        else if (output_file.IsSet())
-        {
-            std::ofstream os(static_cast<std::string>(output_file).c_str());
-            os 
-                // << "{\"solution\": {" << out <<  "}, "
-                << "{\"total_cost\": " <<  result.cost.total <<  ", "
-                << "\"time_seconds\": " << result.running_time << ", "
-                << "\"total_iterations\": " << used_runner->Iteration() << ", "
-                << "\"iteration_of_best\": " << used_runner->IterationOfBest() << ", "
-                << "\"seed\": " << Random::GetSeed() << "} " << std::endl;
-            os.flush();
-            os.close();
-        }
-        else
+    // output
+    if (irace)
+    {
+        results << (double)result.cost.total / in.UpperBoundIntegerObjective() << std::endl;
+    }
+    else if (output_file.IsSet())
+    {
+        std::ofstream os(static_cast<std::string>(output_file).c_str());
+        os << "{";
+        // the updated solution is the warm start of the next changes
+        if (instance_delta.IsSet())
+        {
+            os << "\"solution\": {" << out <<  "}, ";
+        }
+        os 
+            // << "{\"solution\": {" << out <<  "}, "
+            << "\"total_cost\": " <<  result.cost.total <<  ", "
+            << "\"lower_bound\": " << in.LowerBoundObjective() << ", "
+            << "\"time_seconds\": " << result.running_time << ", "
+            << "\"total_iterations\": " << graph->used_runner->Iteration() << ", "
+            << "\"iteration_of_best\": " << graph->used_runner->IterationOfBest() << ", "
+            << "\"seed\": " << Random::GetSeed() << ", ";
+        if (graph->telemetry.Enabled())
+        {
+            os << "\"telemetry\": " << graph->telemetry << ", ";
+        }
+        os << "\"delta_cache\": " << graph->delta_cache << "} " << std::endl;
+        os.flush();
+        os.close();
+    }
+    else
+    {
+        results << "{\"total_cost\": " <<  result.cost.total <<  ", "
+            << "\"lower_bound\": " << in.LowerBoundObjective() << ", "
+            << "\"time\": " << result.running_time << ", "
+            << "\"total_iterations\": " << graph->used_runner->Iteration() << ", "
+            << "\"iteration_of_best\": " << graph->used_runner->IterationOfBest() << ", "
+            << "\"seed\": " << Random::GetSeed() << ", ";
+        if (graph->telemetry.Enabled())
         {
-            std::cout << "{\"total_cost\": " <<  result.cost.total <<  ", "
-                << "\"time\": " << result.running_time << ", "
-                << "\"total_iterations\": " << used_runner->Iteration() << ", "
-                << "\"iteration_of_best\": " << used_runner->IterationOfBest() << ", "
-                << "\"seed\": " << Random::GetSeed() << "} " << std::endl;
+            results << "\"telemetry\": " << graph->telemetry << ", ";
         }
+        results << "\"delta_cache\": " << graph->delta_cache << "} " << std::endl;
     }
 
 #if !defined(NDEBUG)
-    std::cout << "This code is running in DEBUG mode" << std::endl;
+    std::cerr << "This code is running in DEBUG mode" << std::endl;
 #endif
     return 0; 
-}
\ No newline at end of file
+}
+int main(int argc, const char* argv[])
+{
+    // the server mode (osp serve [options]) solves the requests read on the standard input, its responses are the standard output
+    if (argc > 1 && std::string(argv[1]) == "serve")
+    {
+        ParameterBox serve_parameters("serve", "Server mode options");
+        Parameter<unsigned int> serve_workers("workers", "Number of requests solved in parallel (default: the number of hardware threads)", serve_parameters);
+        serve_workers = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<const char*> serve_argv(argv, argv + argc);
+        serve_argv.erase(serve_argv.begin() + 1);
+        CommandLineParameters::Parse((int) serve_argv.size(), serve_argv.data(), false, true);
+        OSP_Server server(argv[0], std::vector<std::string>(argv + 2, argv + argc));
+        // what the runs print besides their results goes to the standard error, so that the output holds only the responses
+        std::ostream responses(std::cout.rdbuf());
+        std::streambuf* cout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+        unsigned int failed = server.Serve([&server](int run_argc, const char* run_argv[], std::ostream& results, std::ostream& messages, const OSP_SharedOutput* solutions)
+            { return run(run_argc, run_argv, results, messages, &server.Instances(), solutions); }, serve_workers, std::cin, responses);
+        std::cout.rdbuf(cout_buffer);
+        return failed > 0 ? 1 : 0;
+    }
+
+    // the batch mode runs the lines of a manifest, each one with its own options, instead of the options of the command line
+    ParameterBox batch_parameters("batch", "Batch mode options");
+    Parameter<std::string> manifest("manifest", "Manifest of the runs of the batch mode: one line of command line options for each run", batch_parameters);
+    Parameter<unsigned int> workers("workers", "Number of runs of the batch in parallel (default: the number of hardware threads)", batch_parameters);
+    Parameter<std::string> batch_results("results", "Name of the file where the result of each run of the batch is appended as a JSON line, otherwise they are printed", batch_parameters);
+    workers = std::max(1u, std::thread::hardware_concurrency());
+    CommandLineParameters::Parse(argc, argv, false, true);
+    if (!manifest.IsSet())
+    {
+        return run(argc, argv, std::cout, std::cout, nullptr, nullptr);
+    }
+
+    OSP_Batch batch(manifest, argv[0]);
+    std::ofstream results_file;
+    if (batch_results.IsSet())
+    {
+        results_file.open(static_cast<std::string>(batch_results).c_str(), std::ios::app);
+        if (!results_file)
+        {
+            std::cout << "Error: cannot open the results file " << static_cast<std::string>(batch_results) << std::endl;
+            return 1;
+        }
+    }
+    auto start = high_resolution_clock::now();
+    unsigned int failed = batch.Run([&batch](int run_argc, const char* run_argv[], std::ostream& results, std::ostream& messages, const OSP_SharedOutput* solutions)
+        { return run(run_argc, run_argv, results, messages, &batch.Instances(), solutions); },
+        workers, batch_results.IsSet() ? results_file : std::cout);
+    std::cerr << "Batch: " << batch.Runs() << " runs (" << failed << " failed) in " << duration_cast<duration<double>>(high_resolution_clock::now() - start).count() << " seconds" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
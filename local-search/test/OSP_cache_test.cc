@@ -0,0 +1,127 @@
+#include "OSP_test.hh"
+#include "OSP_cache.hh"
+
+#include <cstring>
+#include <new>
+
+// the deltas read from the cache are the ones of the evaluation, along a walk that changes the machine schedules (the moves are made
+// when they do not worsen the cost, or one time out of four)
+template <class Explorer>
+static void CheckCachedDeltas(const std::string& name)
+{
+    OSP_Input in(TestInstancePath(name));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    Explorer ne(in, sm);
+    OSP_CachedNeighborhoodExplorer<Explorer> cached_ne(in, sm);
+    costs.AttachToExplorers(ne, cached_ne);
+    OSP_DeltaCache cache(1 << 12);
+    cached_ne.SetDeltaCache(&cache);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    typename Explorer::MoveType mv;
+    unsigned long hits = 0;
+    for (int i = 0; i < 300; ++i)
+    {
+        ne.RandomMove(st, mv);
+        DefaultCostStructure<long> delta = ne.DeltaCostFunctionComponents(st, mv);
+        // the first evaluation may be a miss (or a hit, if the move was evaluated on the same machine schedules), the second one is a hit
+        for (int k = 0; k < 2; ++k)
+        {
+            DefaultCostStructure<long> cached_delta = cached_ne.DeltaCostFunctionComponents(st, mv);
+            OSP_CHECK_EQUAL(delta.total, cached_delta.total);
+            OSP_CHECK_EQUAL(delta.violations, cached_delta.violations);
+            OSP_CHECK_EQUAL(delta.objective, cached_delta.objective);
+            OSP_CHECK(delta.all_components == cached_delta.all_components);
+        }
+        OSP_CHECK(cache.Hits() > hits);
+        hits = cache.Hits();
+        if (delta.total <= 0 || Random::Uniform<int>(0, 3) == 0)
+        {
+            ne.MakeMove(st, mv);
+        }
+    }
+    OSP_CHECK_EQUAL(600UL, cache.Lookups());
+}
+
+OSP_TEST(cache_job_to_existing_batch)
+{
+    CheckCachedDeltas<OSP_JobToExistingBatchNeighborhoodExplorer>("use-case-3/61NewRandomOvenSchedulingInstance-n100-k2-a2--2904-16.41.19.dzn");
+}
+
+OSP_TEST(cache_swap_batches)
+{
+    CheckCachedDeltas<OSP_SwapBatchesNeighborhoodExplorer>("use-case-3/56NewRandomOvenSchedulingInstance-n50-k5-a5--2904-16.02.13.dzn");
+}
+
+// a cache that is not enabled is not looked up
+OSP_TEST(cache_disabled)
+{
+    OSP_Input in(TestInstancePath("use-case-3/56NewRandomOvenSchedulingInstance-n50-k5-a5--2904-16.02.13.dzn"));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_CachedNeighborhoodExplorer<OSP_JobToNewBatchNeighborhoodExplorer> cached_ne(in, sm);
+    costs.AttachToExplorers(cached_ne);
+    OSP_DeltaCache cache(0);
+    cached_ne.SetDeltaCache(&cache);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    JobToNewBatch mv;
+    cached_ne.RandomMove(st, mv);
+    cached_ne.DeltaCostFunctionComponents(st, mv);
+    OSP_CHECK(!cache.Enabled());
+    OSP_CHECK_EQUAL(0UL, cache.Lookups());
+}
+
+// the key of a move depends on its fields only, not on the padding of the move or on the entries of its arrays past its length
+OSP_TEST(cache_key_fields)
+{
+    OSP_Input in(TestInstancePath("use-case-3/56NewRandomOvenSchedulingInstance-n50-k5-a5--2904-16.02.13.dzn"));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    const int job = 0;
+    const MachinePosition position = st.GetJobToBatchPosition(job);
+    // the same moves, built on memory filled with different garbage
+    alignas(8) unsigned char memory[2][sizeof(EjectionChain) + sizeof(JobToNewBatch)];
+    std::memset(memory[0], 0x00, sizeof(memory[0]));
+    std::memset(memory[1], 0xA5, sizeof(memory[1]));
+    OSP_DeltaCache::MoveKey keys[2][2];
+    for (int k = 0; k < 2; ++k)
+    {
+        EjectionChain* chain = new (memory[k]) EjectionChain();
+        chain->length = 1;
+        chain->jobs[0] = job;
+        chain->targets[0] = position;
+        JobToNewBatch* new_batch = new (memory[k] + sizeof(EjectionChain)) JobToNewBatch(job, position, MachinePosition(position.first, 0), true);
+        keys[k][0] = OSP_DeltaCache::Key(st, *chain, 1);
+        keys[k][1] = OSP_DeltaCache::Key(st, *new_batch, 2);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        OSP_CHECK_EQUAL(keys[0][i].index, keys[1][i].index);
+        OSP_CHECK_EQUAL(keys[0][i].check, keys[1][i].check);
+    }
+    // a different field, or a different neighborhood, makes a different key
+    JobToNewBatch mv(job, position, MachinePosition(position.first, 0), false);
+    OSP_CHECK(OSP_DeltaCache::Key(st, mv, 2).index != keys[0][1].index);
+    OSP_CHECK(OSP_DeltaCache::Key(st, mv, 3).index != OSP_DeltaCache::Key(st, mv, 2).index);
+}
+
+// the index of a key only chooses the entry, a hit needs the check of the key: another check on the same entry is a miss
+OSP_TEST(cache_key_check)
+{
+    OSP_DeltaCache cache(16);
+    DefaultCostStructure<long> delta(5, 0, 5, std::vector<long>{2, 3}), found;
+    OSP_DeltaCache::MoveKey key = {7, 11}, same_entry = {7 + 16, 11}, other_check = {7, 12};
+    cache.Insert(key, delta);
+    OSP_CHECK(cache.Find(same_entry, 2, found));
+    OSP_CHECK(!cache.Find(other_check, 2, found));
+    OSP_CHECK(cache.Find(key, 2, found));
+    OSP_CHECK_EQUAL(5L, found.total);
+    OSP_CHECK(found.all_components == std::vector<long>({2, 3}));
+}
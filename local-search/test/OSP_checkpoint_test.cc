@@ -0,0 +1,103 @@
+#include "OSP_test.hh"
+#include "OSP_checkpoint.hh"
+
+#include <cstdio>
+#include <sstream>
+
+static const std::string checkpoint_instance = "use-case-3/61NewRandomOvenSchedulingInstance-n100-k2-a2--2904-16.41.19.dzn";
+
+// a state read back from its binary dump is the same state, and the random moves drawn from it are the same (they sample lists whose
+// order depends on the history of the moves)
+OSP_TEST(checkpoint_state_round_trip)
+{
+    OSP_Input in(TestInstancePath(checkpoint_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManagerRandom sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    OSP_JobToNewBatchNeighborhoodExplorer new_batch(in, sm);
+    costs.AttachToExplorers(existing, new_batch);
+    OSP_Output st(in);
+    sm.RandomState(st);
+    JobToExistingBatch existing_mv;
+    JobToNewBatch new_batch_mv;
+    for (int i = 0; i < 100; ++i)
+    {
+        existing.RandomMove(st, existing_mv);
+        existing.MakeMove(st, existing_mv);
+        new_batch.RandomMove(st, new_batch_mv);
+        new_batch.MakeMove(st, new_batch_mv);
+    }
+
+    std::stringstream dump;
+    st.Write(dump);
+    OSP_Output read(in);
+    read.Read(dump);
+    CheckAgainstScratch(in, read);
+    OSP_CHECK(read == st);
+    OSP_CHECK_EQUAL(sm.CostFunctionComponents(st).total, sm.CostFunctionComponents(read).total);
+
+    JobToExistingBatch read_mv;
+    for (int i = 0; i < 100; ++i)
+    {
+        Random::SetSeed(i);
+        existing.RandomMove(st, existing_mv);
+        Random::SetSeed(i);
+        existing.RandomMove(read, read_mv);
+        OSP_CHECK(existing_mv == read_mv);
+        existing.MakeMove(st, existing_mv);
+        existing.MakeMove(read, read_mv);
+    }
+    OSP_CHECK(read == st);
+}
+
+// a run resumed from the last checkpoint of another run ends as that run: same best cost and iterations
+OSP_TEST(checkpoint_resume_round_trip)
+{
+    const std::string checkpoint_file = "osp_test_checkpoint.bin";
+    std::remove(checkpoint_file.c_str());
+    OSP_Input in(TestInstancePath(checkpoint_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    OSP_JobToNewBatchNeighborhoodExplorer new_batch(in, sm);
+    costs.AttachToExplorers(existing, new_batch);
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(new_batch)>
+        multi(in, sm, "multi", existing, new_batch, {0.5, 0.5});
+    SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi)::MoveType, DefaultCostStructure<long>> runner(in, sm, multi, "SA");
+    runner.SetParameter("max_evaluations", 20000UL);
+    runner.SetParameter("start_temperature", 10.0);
+    runner.SetParameter("min_temperature", 0.1);
+    runner.SetParameter("cooling_rate", 0.9);
+    runner.SetParameter("neighbors_accepted_ratio", 0.1);
+    OSP_Output greedy(in);
+    sm.GreedyState(greedy);
+
+    // the last checkpoint of the first run is taken well before its end
+    OSP_Output first_st(greedy);
+    DefaultCostStructure<long> first_cost;
+    {
+        OSP_Checkpointer checkpointer(checkpoint_file, in, 7000, false);
+        runner.AttachCheckpointer(checkpointer);
+        first_cost = runner.Go(first_st);
+    }
+    unsigned long first_iteration = runner.Iteration(), first_iteration_of_best = runner.IterationOfBest();
+    OSP_CHECK(first_iteration > 14000);
+
+    // the engine is restored from the checkpoint, not from the seed
+    Random::SetSeed(2);
+    OSP_Output resumed_st(greedy);
+    DefaultCostStructure<long> resumed_cost;
+    {
+        OSP_Checkpointer checkpointer(checkpoint_file, in, 7000, true);
+        runner.AttachCheckpointer(checkpointer);
+        resumed_cost = runner.Go(resumed_st);
+    }
+    std::remove(checkpoint_file.c_str());
+    CheckAgainstScratch(in, resumed_st);
+    OSP_CHECK_EQUAL(first_cost.total, resumed_cost.total);
+    OSP_CHECK(resumed_st == first_st);
+    OSP_CHECK_EQUAL(first_iteration, runner.Iteration());
+    OSP_CHECK_EQUAL(first_iteration_of_best, runner.IterationOfBest());
+}
@@ -0,0 +1,402 @@
+#include "OSP_test.hh"
+#include "OSP_reoptimize.hh"
+#include "OSP_stream.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+static const std::string delta_instance = "use-case-2/03NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.42.41-mergedMachineIntervals.dzn";
+
+// the delta read from a file with the given text
+static OSP_InstanceDelta ReadDelta(const std::string& text)
+{
+    const std::string file_name = "osp_test_delta.dzn";
+    {
+        std::ofstream os(file_name);
+        os << text;
+    }
+    try
+    {
+        OSP_InstanceDelta delta(file_name);
+        std::remove(file_name.c_str());
+        return delta;
+    }
+    catch (...)
+    {
+        std::remove(file_name.c_str());
+        throw;
+    }
+}
+
+// an added job equal to job j of the instance
+static OSP_InstanceDelta::Job CopyOfJob(const OSP_Input& in, int j)
+{
+    OSP_InstanceDelta::Job job;
+    job.eligible_machines = in.EligibleMachineSet(j);
+    job.earliest_start = in.EarliestStartJob(j);
+    job.latest_end = in.LatestEndJob(j);
+    job.min_time = in.MinTimeJob(j);
+    job.max_time = in.MaxTimeJob(j);
+    job.size = in.SizeJob(j);
+    job.attribute = in.AttributeJob(j);
+    return job;
+}
+
+OSP_TEST(instance_delta_parses_entries)
+{
+    OSP_InstanceDelta delta = ReadDelta("removed_jobs=[2,5];\nchanged_jobs=[1];\nchanged_latest_end=[40];\n"
+        "added_jobs=2;\neligible_machine=[{1},{1,2}];\nearliest_start=[0,3];\nlatest_end=[20,30];\nmin_time=[2,4];\nmax_time=[5,6];\n"
+        "size=[3,4];\nattribute=[1,2];\n");
+    OSP_CHECK(delta.removed_jobs == std::vector<int>({1, 4}));
+    OSP_CHECK_EQUAL((size_t) 1, delta.changed_latest_ends.size());
+    OSP_CHECK(delta.changed_latest_ends[0] == std::make_pair(0, 40));
+    OSP_CHECK_EQUAL((size_t) 2, delta.added_jobs.size());
+    OSP_CHECK(delta.added_jobs[1].eligible_machines == std::set<int>({0, 1}));
+    OSP_CHECK_EQUAL(1, delta.added_jobs[1].attribute);
+    OSP_CHECK_EQUAL(6, delta.added_jobs[1].max_time);
+}
+
+OSP_TEST(instance_delta_parse_errors)
+{
+    OSP_CHECK_THROWS(OSP_InstanceDelta("osp_test_missing_delta.dzn"));
+    // a changed job without its latest end
+    OSP_CHECK_THROWS(ReadDelta("changed_jobs=[1,2];\nchanged_latest_end=[40];\n"));
+    // a field without a value for each added job
+    OSP_CHECK_THROWS(ReadDelta("added_jobs=2;\neligible_machine=[{1},{1}];\nearliest_start=[0,3];\nlatest_end=[20,30];\nmin_time=[2];\n"
+        "max_time=[5,6];\nsize=[3,4];\nattribute=[1,2];\n"));
+    // a field missing
+    OSP_CHECK_THROWS(ReadDelta("added_jobs=1;\neligible_machine=[{1}];\nearliest_start=[0];\nlatest_end=[20];\nmin_time=[2];\n"
+        "max_time=[5];\nattribute=[1];\n"));
+    // the eligible machines missing
+    OSP_CHECK_THROWS(ReadDelta("added_jobs=1;\nearliest_start=[0];\nlatest_end=[20];\nmin_time=[2];\nmax_time=[5];\nsize=[3];\nattribute=[1];\n"));
+}
+
+// the jobs of a delta that do not fit the instance are rejected when the instance is updated
+OSP_TEST(instance_delta_invalid_jobs)
+{
+    OSP_Input in(TestInstancePath(delta_instance));
+    OSP_InstanceDelta removed_out_of_range;
+    removed_out_of_range.removed_jobs = {in.Jobs()};
+    OSP_CHECK_THROWS(OSP_Input(in, removed_out_of_range));
+    OSP_InstanceDelta changed_removed;
+    changed_removed.removed_jobs = {0};
+    changed_removed.changed_latest_ends = {{0, 10}};
+    OSP_CHECK_THROWS(OSP_Input(in, changed_removed));
+    OSP_InstanceDelta changed_out_of_range;
+    changed_out_of_range.changed_latest_ends = {{-1, 10}};
+    OSP_CHECK_THROWS(OSP_Input(in, changed_out_of_range));
+    OSP_InstanceDelta added;
+    added.added_jobs = {CopyOfJob(in, 0)};
+    OSP_CHECK_EQUAL(in.Jobs() + 1, OSP_Input(in, added).Jobs());
+    added.added_jobs[0].attribute = in.Attributes();
+    OSP_CHECK_THROWS(OSP_Input(in, added));
+    added.added_jobs[0] = CopyOfJob(in, 0);
+    added.added_jobs[0].eligible_machines = {in.Machines()};
+    OSP_CHECK_THROWS(OSP_Input(in, added));
+    added.added_jobs[0].eligible_machines.clear();
+    OSP_CHECK_THROWS(OSP_Input(in, added));
+    added.added_jobs[0] = CopyOfJob(in, 0);
+    added.added_jobs[0].min_time = added.added_jobs[0].max_time + 1;
+    OSP_CHECK_THROWS(OSP_Input(in, added));
+}
+
+// the upper bound follows the jobs: a job added raises it as much as the same job removed lowers it, the due dates do not change it
+OSP_TEST(instance_delta_upper_bound)
+{
+    OSP_Input in(TestInstancePath(delta_instance));
+    long upper_bound = in.UpperBoundIntegerObjective();
+    OSP_CHECK_EQUAL(upper_bound, OSP_Input(in, OSP_InstanceDelta()).UpperBoundIntegerObjective());
+    OSP_InstanceDelta changed;
+    changed.changed_latest_ends = {{0, in.LatestEndJob(0) + 10}};
+    OSP_CHECK_EQUAL(upper_bound, OSP_Input(in, changed).UpperBoundIntegerObjective());
+
+    OSP_InstanceDelta added, removed, replaced;
+    added.added_jobs = {CopyOfJob(in, 0)};
+    removed.removed_jobs = {0};
+    replaced.removed_jobs = {0};
+    replaced.added_jobs = {CopyOfJob(in, 0)};
+    long added_upper_bound = OSP_Input(in, added).UpperBoundIntegerObjective(), removed_upper_bound = OSP_Input(in, removed).UpperBoundIntegerObjective();
+    // the job alone in a tardy batch
+    OSP_CHECK(added_upper_bound - upper_bound >= in.MinTimeJob(0) * in.MultFactorTotalRunTime() + in.MultFactorFinishedTooLate());
+    OSP_CHECK_EQUAL(added_upper_bound - upper_bound, upper_bound - removed_upper_bound);
+    OSP_CHECK_EQUAL(upper_bound, OSP_Input(in, replaced).UpperBoundIntegerObjective());
+}
+
+// the lower bounds of an instance are below the costs of each solution that schedules all its batches
+static void CheckLowerBounds(const OSP_Input& in, const OSP_Output& st, int& checked)
+{
+    if (st.GetNotScheduledBatches() > 0)
+    {
+        return;
+    }
+    OSP_CHECK(in.LowerBoundTotalSetUpCost() <= st.GetTotalSetUpCost());
+    OSP_CHECK(in.LowerBoundTardyJobs() <= st.GetNumberOfTardyJobs());
+    OSP_CHECK(in.LowerBoundCumulativeBatchProcessingTime() <= st.GetCumulativeBatchProcessingTime());
+    OSP_CHECK(in.LowerBoundObjective() <= st.GetTotalSetUpCost() * in.MultFactorTotalSetUpCosts()
+        + st.GetNumberOfTardyJobs() * in.MultFactorFinishedTooLate() + st.GetCumulativeBatchProcessingTime() * in.MultFactorTotalRunTime());
+    checked++;
+}
+
+// the solutions of the heuristic, random ones and the ones improved by an annealing, on instances of the three use cases and on a part
+// of an instance (as the windows of the rolling horizon)
+OSP_TEST(instance_lower_bounds_valid)
+{
+    const std::vector<std::string> bound_instances = {
+        "use-case-1/21RandomOvenSchedulingInstance-n25-k2-a2-WithInitialStates.dzn",
+        "use-case-2/03NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.42.41-mergedMachineIntervals.dzn",
+        "use-case-3/56NewRandomOvenSchedulingInstance-n50-k5-a5--2904-16.02.13.dzn",
+        "use-case-3/61NewRandomOvenSchedulingInstance-n100-k2-a2--2904-16.41.19.dzn"
+    };
+    int checked = 0;
+    for (const std::string& name : bound_instances)
+    {
+        OSP_Input whole(TestInstancePath(name));
+        std::vector<int> part_jobs, part_machines, ready_times(whole.Machines(), 0);
+        for (int j = 0; j < whole.Jobs(); j += 2)
+        {
+            part_jobs.push_back(j);
+        }
+        for (int m = 0; m < whole.Machines(); ++m)
+        {
+            part_machines.push_back(m);
+        }
+        OSP_Input part(whole, part_jobs, part_machines, ready_times, whole.InitialStatuses());
+        for (const OSP_Input* p_in : {&whole, &part})
+        {
+            const OSP_Input& in = *p_in;
+            OSP_TestCosts costs(in);
+            OSP_SolutionManager sm(in);
+            OSP_SolutionManagerRandom sm_random(in);
+            costs.AttachTo(sm);
+            costs.AttachTo(sm_random);
+            OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+            OSP_JobToNewBatchNeighborhoodExplorer new_batch(in, sm);
+            OSP_SwapBatchesNeighborhoodExplorer swap(in, sm);
+            costs.AttachToExplorers(existing, new_batch, swap);
+            SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(new_batch), decltype(swap)>
+                multi(in, sm, "multi", existing, new_batch, swap, {0.4, 0.3, 0.3});
+            SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi)::MoveType, DefaultCostStructure<long>> runner(in, sm, multi, "SA");
+            runner.SetParameter("max_evaluations", 5000UL);
+            runner.SetParameter("start_temperature", 10.0);
+            runner.SetParameter("min_temperature", 0.1);
+            runner.SetParameter("cooling_rate", 0.9);
+            runner.SetParameter("neighbors_accepted_ratio", 0.1);
+            OSP_Output greedy_st(in), random_st(in);
+            sm.GreedyState(greedy_st);
+            sm_random.RandomState(random_st);
+            CheckLowerBounds(in, greedy_st, checked);
+            CheckLowerBounds(in, random_st, checked);
+            runner.Go(greedy_st);
+            runner.Go(random_st);
+            CheckLowerBounds(in, greedy_st, checked);
+            CheckLowerBounds(in, random_st, checked);
+        }
+    }
+    OSP_CHECK(checked > 0);
+}
+
+// the warm start read from a file with the given text (the jobs left out of their batches are returned)
+static int WarmStateOf(const OSP_SolutionManager& sm, const std::string& text, OSP_Output& st)
+{
+    const std::string file_name = "osp_test_warm_start.json";
+    {
+        std::ofstream os(file_name);
+        os << text;
+    }
+    try
+    {
+        int left_out = sm.WarmState(st, file_name);
+        std::remove(file_name.c_str());
+        return left_out;
+    }
+    catch (...)
+    {
+        std::remove(file_name.c_str());
+        throw;
+    }
+}
+
+// the batches and machines of the jobs of a solution (1-based, as the program writes them), with a comma after the last ones if asked
+static std::string SolutionText(const std::vector<int>& batch_for_job, const std::vector<int>& machine_for_job, bool trailing_commas)
+{
+    std::ostringstream os;
+    os << "{\"batch_for_job\": [";
+    for (size_t j = 0; j < batch_for_job.size(); ++j)
+    {
+        os << (j > 0 ? ", " : "") << batch_for_job[j];
+    }
+    os << (trailing_commas ? ",], " : "], ") << "\"machine_for_job\": [";
+    for (size_t j = 0; j < machine_for_job.size(); ++j)
+    {
+        os << (j > 0 ? ", " : "") << machine_for_job[j];
+    }
+    os << (trailing_commas ? ",]}" : "]}") << std::endl;
+    return os.str();
+}
+
+// a solution written by a solution stream is read back as it was, from the last line of the file, and so are the arrays with trailing
+// commas
+OSP_TEST(instance_warm_state_round_trip)
+{
+    OSP_Input in(TestInstancePath(delta_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    OSP_SolutionManagerRandom sm_random(in);
+    costs.AttachTo(sm);
+    costs.AttachTo(sm_random);
+    OSP_Output random_st(in), greedy_st(in), warm(in);
+    sm_random.RandomState(random_st);
+    sm.GreedyState(greedy_st);
+    const std::string stream_file = "osp_test_warm_stream.jsonl";
+    std::remove(stream_file.c_str());
+    {
+        OSP_SolutionStream stream(stream_file, sm);
+        stream.NotifyNewBest("random", random_st, DefaultCostStructure<long>(20, 1, 0, std::vector<long>(sm.CostComponents(), 0)), 0);
+        stream.NotifyNewBest("greedy", greedy_st, DefaultCostStructure<long>(10, 0, 10, std::vector<long>(sm.CostComponents(), 0)), 1);
+    }
+    OSP_CHECK_EQUAL(0, sm.WarmState(warm, stream_file));
+    std::remove(stream_file.c_str());
+    OSP_CHECK(warm == greedy_st);
+
+    std::vector<int> batch_for_job, machine_for_job;
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        batch_for_job.push_back(random_st.GetJobToBatchPosition(j).second + 1);
+        machine_for_job.push_back(random_st.GetJobToBatchPosition(j).first + 1);
+    }
+    OSP_Output trailing(in);
+    OSP_CHECK_EQUAL(0, WarmStateOf(sm, SolutionText(batch_for_job, machine_for_job, true), trailing));
+    OSP_CHECK(trailing == random_st);
+    OSP_CHECK_THROWS(WarmStateOf(sm, SolutionText(batch_for_job, std::vector<int>(machine_for_job.begin() + 1, machine_for_job.end()), false), trailing));
+}
+
+// the jobs that no longer fit in their batch (here, a job put in the batch of a job of another attribute) or that are on a machine
+// not eligible for them go alone in a new batch on an eligible machine, the other jobs keep their batches
+OSP_TEST(instance_warm_state_left_out)
+{
+    OSP_Input in(TestInstancePath(delta_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    std::vector<int> batch_for_job, machine_for_job;
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        batch_for_job.push_back(st.GetJobToBatchPosition(j).second + 1);
+        machine_for_job.push_back(st.GetJobToBatchPosition(j).first + 1);
+    }
+    // the batch of the first job takes a later job of another attribute; another job goes on a machine not eligible for it
+    int moved = -1, ineligible = -1;
+    for (int j = 1; j < in.Jobs() && moved == -1; ++j)
+    {
+        if (in.AttributeJob(j) != in.AttributeJob(0) && in.IsMachineEligible(st.GetJobToBatchPosition(0).first, j))
+        {
+            moved = j;
+        }
+    }
+    for (int j = 0; j < in.Jobs() && ineligible == -1; ++j)
+    {
+        if (j != 0 && j != moved && (int) in.EligibleMachineSet(j).size() < in.Machines())
+        {
+            ineligible = j;
+        }
+    }
+    OSP_CHECK(moved != -1 && ineligible != -1);
+    if (moved == -1 || ineligible == -1)
+    {
+        return;
+    }
+    batch_for_job[moved] = batch_for_job[0];
+    machine_for_job[moved] = machine_for_job[0];
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        if (!in.IsMachineEligible(m, ineligible))
+        {
+            machine_for_job[ineligible] = m + 1;
+        }
+    }
+    OSP_Output warm(in);
+    OSP_CHECK_EQUAL(2, WarmStateOf(sm, SolutionText(batch_for_job, machine_for_job, false), warm));
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        MachinePosition position = warm.GetJobToBatchPosition(j);
+        OSP_CHECK(in.IsMachineEligible(position.first, j));
+        std::set<int> mates = st.GetJobsAtBatchPosition(st.GetJobToBatchPosition(j).first, st.GetJobToBatchPosition(j).second);
+        mates.erase(moved);
+        mates.erase(ineligible);
+        if (j == moved || j == ineligible)
+        {
+            mates = {j};
+        }
+        OSP_CHECK(warm.GetJobsAtBatchPosition(position.first, position.second) == mates);
+    }
+}
+
+// a job left out with no eligible machine (on a part of the instance without its machines) cannot be placed
+OSP_TEST(instance_warm_state_no_eligible_machine)
+{
+    OSP_Input whole(TestInstancePath(delta_instance));
+    int job = -1;
+    for (int j = 0; j < whole.Jobs() && job == -1; ++j)
+    {
+        if (!whole.IsMachineEligible(0, j))
+        {
+            job = j;
+        }
+    }
+    OSP_CHECK(job != -1);
+    std::vector<int> part_jobs(whole.Jobs());
+    std::iota(part_jobs.begin(), part_jobs.end(), 0);
+    OSP_Input in(whole, part_jobs, {0}, {0}, {whole.InitialStateMachine(0)});
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Output warm(in);
+    OSP_CHECK_THROWS(WarmStateOf(sm, SolutionText(std::vector<int>(in.Jobs(), 1), std::vector<int>(in.Jobs(), 1), false), warm));
+}
+
+// a delta that adds a job without eligible machine is rejected before the instance and the solution change; a job that can be placed
+// is inserted in a feasible solution of the updated instance
+OSP_TEST(instance_reoptimizer_added_jobs)
+{
+    const OSP_Input whole(TestInstancePath(delta_instance));
+    OSP_Input search_in(whole), current_in(whole);
+    OSP_TestCosts costs(search_in);
+    OSP_SolutionManager sm(search_in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(search_in, sm);
+    OSP_RuinAndRecreateNeighborhoodExplorer repair(search_in, sm);
+    costs.AttachToExplorers(existing, repair);
+    SimulatedAnnealing<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>> runner(search_in, sm, existing, "SA_reoptimize");
+    runner.SetParameter("max_evaluations", 2000UL);
+    runner.SetParameter("start_temperature", 10.0);
+    runner.SetParameter("min_temperature", 0.1);
+    runner.SetParameter("cooling_rate", 0.9);
+    runner.SetParameter("neighbors_accepted_ratio", 0.1);
+    SimpleLocalSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> solver(search_in, sm, "solver_reoptimize");
+    solver.SetRunner(runner);
+    OSP_DeltaCache delta_cache(0);
+    OSP_Reoptimizer reoptimizer(search_in, solver, sm, repair, delta_cache);
+    OSP_Output current(current_in);
+    sm.GreedyState(current);
+    const OSP_Output before(current);
+
+    OSP_InstanceDelta no_machine;
+    no_machine.added_jobs = {CopyOfJob(whole, 0)};
+    no_machine.added_jobs[0].eligible_machines.clear();
+    OSP_CHECK_THROWS(reoptimizer.Update(current_in, current, no_machine));
+    OSP_CHECK_EQUAL(whole.Jobs(), current_in.Jobs());
+    OSP_CHECK(current == before);
+
+    OSP_InstanceDelta added;
+    added.added_jobs = {CopyOfJob(whole, 0)};
+    DefaultCostStructure<long> cost = reoptimizer.Update(current_in, current, added);
+    OSP_CHECK_EQUAL(whole.Jobs() + 1, current_in.Jobs());
+    OSP_CHECK_EQUAL(whole.Jobs() + 1, current.Jobs());
+    CheckAgainstScratch(current_in, current);
+    OSP_CHECK_EQUAL(sm.CostFunctionComponents(current).total, cost.total);
+    MachinePosition position = current.GetJobToBatchPosition(whole.Jobs());
+    OSP_CHECK(current_in.IsMachineEligible(position.first, whole.Jobs()));
+}
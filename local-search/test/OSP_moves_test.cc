@@ -0,0 +1,899 @@
+#include "OSP_test.hh"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+// small instances of the three use cases, with few and many machines and attributes
+static const std::vector<std::string> move_instances = {
+    "use-case-1/21RandomOvenSchedulingInstance-n25-k2-a2-WithInitialStates.dzn",
+    "use-case-2/03NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.42.41-mergedMachineIntervals.dzn",
+    "use-case-3/56NewRandomOvenSchedulingInstance-n50-k5-a5--2904-16.02.13.dzn",
+    "use-case-3/61NewRandomOvenSchedulingInstance-n100-k2-a2--2904-16.41.19.dzn"
+};
+
+// checks the moves of the explorer on each instance, from the heuristic and from a random initial solution (setup sets the parameters
+// of the explorer, if any)
+template <class Explorer>
+static void CheckNeighborhood(int random_moves, int enumerated_moves, std::function<void(Explorer&)> setup = nullptr)
+{
+    int checked = 0;
+    for (const std::string& name : move_instances)
+    {
+        OSP_Input in(TestInstancePath(name));
+        OSP_TestCosts costs(in);
+        OSP_SolutionManager sm(in);
+        OSP_SolutionManagerRandom sm_random(in);
+        costs.AttachTo(sm);
+        costs.AttachTo(sm_random);
+        Explorer ne(in, sm);
+        costs.AttachToExplorers(ne);
+        if (setup)
+        {
+            setup(ne);
+        }
+        // the states are populated from scratch, so each initial solution is built on a new one
+        OSP_Output greedy_st(in), random_st(in);
+        sm.GreedyState(greedy_st);
+        checked += CheckMoves(in, greedy_st, ne, sm, random_moves, enumerated_moves);
+        sm_random.RandomState(random_st);
+        checked += CheckMoves(in, random_st, ne, sm, random_moves, enumerated_moves);
+    }
+    // on some instances the neighborhood may be empty, but not on all of them
+    OSP_CHECK(checked > 0);
+}
+
+// a batch respects the constraints of the problem: a single attribute, a machine eligible for all its jobs, the capacity of the machine
+// and a processing time (the largest minimal time of the jobs) within the maximal times of all of them
+static bool IsFeasibleBatch(const OSP_Input& in, int m, const std::set<int>& jobs)
+{
+    int size = 0, processing_time = 0, max_time = std::numeric_limits<int>::max();
+    for (int j : jobs)
+    {
+        if (in.AttributeJob(j) != in.AttributeJob(*jobs.begin()) || !in.IsMachineEligible(m, j))
+        {
+            return false;
+        }
+        size += in.SizeJob(j);
+        processing_time = std::max(processing_time, in.MinTimeJob(j));
+        max_time = std::min(max_time, in.MaxTimeJob(j));
+    }
+    return !jobs.empty() && size <= in.MaxCapacityMachine(m) && processing_time <= max_time;
+}
+
+static void CheckFeasibleBatches(const OSP_Input& in, const OSP_Output& st)
+{
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
+        {
+            OSP_CHECK(IsFeasibleBatch(in, m, st.GetJobsAtBatchPosition(m, p)));
+        }
+    }
+}
+
+// checks the random moves of the explorer along a walk from the heuristic and from a random solution of each instance, as CheckMoves,
+// and that each move leaves feasible batches with the effect expected on its jobs (effect gets the states before and after the move).
+// The explorers that evaluate the moves on the machines they change must not compute the full costs
+template <class Explorer>
+static void CheckMoveEffects(int random_moves, std::function<void(const OSP_Output&, const typename Explorer::MoveType&, const OSP_Output&)> effect)
+{
+    const bool on_changed_machines = std::is_base_of<OSP_BatchChangesNeighborhoodExplorer<typename Explorer::MoveType>, Explorer>::value;
+    int checked = 0;
+    for (const std::string& name : move_instances)
+    {
+        OSP_Input in(TestInstancePath(name));
+        OSP_TestCosts costs(in);
+        OSP_SolutionManager sm(in);
+        OSP_SolutionManagerRandom sm_random(in);
+        costs.AttachTo(sm);
+        costs.AttachTo(sm_random);
+        Explorer ne(in, sm);
+        costs.AttachToExplorers(ne);
+        OSP_Output greedy_st(in), random_st(in);
+        sm.GreedyState(greedy_st);
+        sm_random.RandomState(random_st);
+        for (OSP_Output st : {greedy_st, random_st})
+        {
+            CheckFeasibleBatches(in, st);
+            typename Explorer::MoveType mv;
+            OSP_Output after(in);
+            for (int i = 0; i < random_moves; ++i)
+            {
+                // the random moves may be evaluated as well, as the ejection chains are
+                int computed = costs.Computed();
+                try
+                {
+                    ne.RandomMove(st, mv);
+                }
+                catch (EmptyNeighborhood&)
+                {
+                    continue;
+                }
+                ne.DeltaCostFunctionComponents(st, mv);
+                OSP_CHECK(!on_changed_machines || costs.Computed() == computed);
+                DefaultCostStructure<long> delta = CheckMove(in, st, ne, sm, mv, after);
+                CheckFeasibleBatches(in, after);
+                effect(st, mv, after);
+                checked++;
+                if (delta.total <= 0 || Random::Uniform<int>(0, 3) == 0)
+                {
+                    st = after;
+                }
+            }
+        }
+    }
+    OSP_CHECK(checked > 0);
+}
+
+// the exhaustive exploration of the explorer (without don't-look bits) goes once through each move given by all_moves, and through no
+// other, from the heuristic and from a random solution of each instance
+template <class Explorer>
+static void CheckEnumeration(std::function<std::set<typename Explorer::MoveType>(const OSP_Input&, const OSP_Output&)> all_moves)
+{
+    size_t moves = 0;
+    for (const std::string& name : move_instances)
+    {
+        OSP_Input in(TestInstancePath(name));
+        OSP_TestCosts costs(in);
+        OSP_SolutionManager sm(in);
+        OSP_SolutionManagerRandom sm_random(in);
+        costs.AttachTo(sm);
+        costs.AttachTo(sm_random);
+        Explorer ne(in, sm);
+        costs.AttachToExplorers(ne);
+        ne.SetDontLookBits(false);
+        OSP_Output greedy_st(in), random_st(in);
+        sm.GreedyState(greedy_st);
+        sm_random.RandomState(random_st);
+        for (const OSP_Output& st : {greedy_st, random_st})
+        {
+            std::set<typename Explorer::MoveType> expected = all_moves(in, st), enumerated;
+            typename Explorer::MoveType mv;
+            try
+            {
+                ne.FirstMove(st, mv);
+                do
+                {
+                    OSP_CHECK(enumerated.insert(mv).second);
+                }
+                while (ne.NextMove(st, mv));
+            }
+            catch (EmptyNeighborhood&)
+            {}
+            OSP_CHECK(enumerated == expected);
+            moves += expected.size();
+        }
+    }
+    OSP_CHECK(moves > 0);
+}
+
+OSP_TEST(moves_swap_batches)
+{
+    CheckNeighborhood<OSP_SwapBatchesNeighborhoodExplorer>(200, 0);
+}
+
+OSP_TEST(moves_batch_to_new_position)
+{
+    CheckNeighborhood<OSP_BatchToNewPositionNeighborhoodExplorer>(200, 0);
+}
+
+OSP_TEST(moves_invert_batches)
+{
+    CheckNeighborhood<OSP_InvertBatchesInMachineNeighborhoodExplorer>(200, 0);
+}
+
+OSP_TEST(moves_job_to_existing_batch)
+{
+    CheckNeighborhood<OSP_JobToExistingBatchNeighborhoodExplorer>(200, 200);
+}
+
+OSP_TEST(moves_job_to_new_batch)
+{
+    CheckNeighborhood<OSP_JobToNewBatchNeighborhoodExplorer>(200, 200);
+}
+
+OSP_TEST(moves_batch_to_new_machine)
+{
+    CheckNeighborhood<OSP_BatchToNewMachineNeighborhoodExplorer>(200, 0);
+    CheckNeighborhood<Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer>(200, 0);
+}
+
+// a swap exchanges its two jobs, the other jobs stay where they are
+OSP_TEST(moves_swap_jobs_between_batches_exchange)
+{
+    CheckMoveEffects<OSP_SwapJobsBetweenBatchesNeighborhoodExplorer>(200, [](const OSP_Output& st, const SwapJobsBetweenBatches& mv, const OSP_Output& after)
+    {
+        OSP_CHECK(st.GetJobToBatchPosition(mv.job_1) == mv.position_1);
+        OSP_CHECK(st.GetJobToBatchPosition(mv.job_2) == mv.position_2);
+        OSP_CHECK(after.GetJobToBatchPosition(mv.job_1) == mv.position_2);
+        OSP_CHECK(after.GetJobToBatchPosition(mv.job_2) == mv.position_1);
+        for (int j = 0; j < st.Jobs(); ++j)
+        {
+            OSP_CHECK(j == mv.job_1 || j == mv.job_2 || after.GetJobToBatchPosition(j) == st.GetJobToBatchPosition(j));
+        }
+    });
+}
+
+// the swaps are all the pairs of jobs with the same attribute in different batches whose batches are still feasible once the jobs are exchanged
+OSP_TEST(moves_swap_jobs_between_batches_enumeration)
+{
+    CheckEnumeration<OSP_SwapJobsBetweenBatchesNeighborhoodExplorer>([](const OSP_Input& in, const OSP_Output& st)
+    {
+        std::set<SwapJobsBetweenBatches> moves;
+        for (int j_1 = 0; j_1 < in.Jobs(); ++j_1)
+        {
+            for (int j_2 = j_1 + 1; j_2 < in.Jobs(); ++j_2)
+            {
+                MachinePosition p_1 = st.GetJobToBatchPosition(j_1), p_2 = st.GetJobToBatchPosition(j_2);
+                if (p_1 == p_2 || in.AttributeJob(j_1) != in.AttributeJob(j_2))
+                {
+                    continue;
+                }
+                std::set<int> jobs_1 = st.GetJobsAtBatchPosition(p_1.first, p_1.second), jobs_2 = st.GetJobsAtBatchPosition(p_2.first, p_2.second);
+                jobs_1.erase(j_1);
+                jobs_1.insert(j_2);
+                jobs_2.erase(j_2);
+                jobs_2.insert(j_1);
+                if (IsFeasibleBatch(in, p_1.first, jobs_1) && IsFeasibleBatch(in, p_2.first, jobs_2))
+                {
+                    moves.insert(SwapJobsBetweenBatches(j_1, p_1, j_2, p_2));
+                }
+            }
+        }
+        return moves;
+    });
+}
+
+// a merge leaves the jobs of the source and of the target together in a batch of the target machine, one batch less, and the other jobs
+// on their machines
+OSP_TEST(moves_merge_batches_union)
+{
+    CheckMoveEffects<OSP_MergeBatchesNeighborhoodExplorer>(200, [](const OSP_Output& st, const MergeBatches& mv, const OSP_Output& after)
+    {
+        std::set<int> merged = st.GetJobsAtBatchPosition(mv.source_position.first, mv.source_position.second);
+        const std::set<int>& target = st.GetJobsAtBatchPosition(mv.target_position.first, mv.target_position.second);
+        merged.insert(target.begin(), target.end());
+        MachinePosition position = after.GetJobToBatchPosition(*target.begin());
+        OSP_CHECK_EQUAL(mv.target_position.first, position.first);
+        OSP_CHECK(after.GetJobsAtBatchPosition(position.first, position.second) == merged);
+        int batches = 0, batches_after = 0;
+        for (int m = 0; m < st.Machines(); ++m)
+        {
+            batches += st.GetBatchesPerMachine(m);
+            batches_after += after.GetBatchesPerMachine(m);
+        }
+        OSP_CHECK_EQUAL(batches - 1, batches_after);
+        for (int j = 0; j < st.Jobs(); ++j)
+        {
+            OSP_CHECK(merged.count(j) == 1 || after.GetJobToBatchPosition(j).first == st.GetJobToBatchPosition(j).first);
+        }
+    });
+}
+
+// the merges are all the pairs of batches whose union is a feasible batch on the machine of the target
+OSP_TEST(moves_merge_batches_enumeration)
+{
+    CheckEnumeration<OSP_MergeBatchesNeighborhoodExplorer>([](const OSP_Input& in, const OSP_Output& st)
+    {
+        std::set<MergeBatches> moves;
+        for (int s_m = 0; s_m < in.Machines(); ++s_m)
+        {
+            for (int s_p = 0; s_p < st.GetBatchesPerMachine(s_m); ++s_p)
+            {
+                for (int t_m = 0; t_m < in.Machines(); ++t_m)
+                {
+                    for (int t_p = 0; t_p < st.GetBatchesPerMachine(t_m); ++t_p)
+                    {
+                        std::set<int> merged = st.GetJobsAtBatchPosition(s_m, s_p);
+                        merged.insert(st.GetJobsAtBatchPosition(t_m, t_p).begin(), st.GetJobsAtBatchPosition(t_m, t_p).end());
+                        if ((s_m != t_m || s_p != t_p) && IsFeasibleBatch(in, t_m, merged))
+                        {
+                            moves.insert(MergeBatches(MachinePosition(s_m, s_p), MachinePosition(t_m, t_p)));
+                        }
+                    }
+                }
+            }
+        }
+        return moves;
+    });
+}
+
+// a split keeps in the batch its split jobs with the earliest due dates, the others go in a new batch right after it
+OSP_TEST(moves_split_batch_due_dates)
+{
+    CheckMoveEffects<OSP_SplitBatchNeighborhoodExplorer>(200, [](const OSP_Output& st, const SplitBatch& mv, const OSP_Output& after)
+    {
+        const std::set<int>& kept = after.GetJobsAtBatchPosition(mv.position.first, mv.position.second);
+        const std::set<int>& moved = after.GetJobsAtBatchPosition(mv.position.first, mv.position.second + 1);
+        OSP_CHECK_EQUAL((size_t) mv.split, kept.size());
+        OSP_CHECK_EQUAL(st.GetJobsAtBatchPosition(mv.position.first, mv.position.second).size(), kept.size() + moved.size());
+        for (int j_1 : kept)
+        {
+            OSP_CHECK_EQUAL(1, (int) st.GetJobsAtBatchPosition(mv.position.first, mv.position.second).count(j_1));
+            for (int j_2 : moved)
+            {
+                OSP_CHECK(st.LatestEndJob(j_1) <= st.LatestEndJob(j_2));
+            }
+        }
+        OSP_CHECK_EQUAL(st.GetBatchesPerMachine(mv.position.first) + 1, after.GetBatchesPerMachine(mv.position.first));
+    });
+}
+
+// the splits are all the ones of the batches with at least two jobs, after any number of their jobs but the last one
+OSP_TEST(moves_split_batch_enumeration)
+{
+    CheckEnumeration<OSP_SplitBatchNeighborhoodExplorer>([](const OSP_Input& in, const OSP_Output& st)
+    {
+        std::set<SplitBatch> moves;
+        for (int m = 0; m < in.Machines(); ++m)
+        {
+            for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
+            {
+                for (int split = 1; split < (int) st.GetJobsAtBatchPosition(m, p).size(); ++split)
+                {
+                    moves.insert(SplitBatch(MachinePosition(m, p), split));
+                }
+            }
+        }
+        return moves;
+    });
+}
+
+// a chain starts from a tardy job and anticipates it; each job of the chain joins its target with the jobs that stay there, the other
+// jobs stay on their machines
+OSP_TEST(moves_ejection_chain_targets)
+{
+    CheckMoveEffects<OSP_EjectionChainNeighborhoodExplorer>(100, [](const OSP_Output& st, const EjectionChain& mv, const OSP_Output& after)
+    {
+        OSP_CHECK(mv.length >= 1 && mv.length <= EjectionChain::MaxLength);
+        OSP_CHECK(st.IsJobTardy(mv.jobs[0]));
+        MachinePosition source = st.GetJobToBatchPosition(mv.jobs[0]);
+        OSP_CHECK(st.GetBatchCharacteristics(mv.targets[0].first, mv.targets[0].second).end_time < st.GetBatchCharacteristics(source.first, source.second).end_time);
+        std::set<int> chain;
+        for (int i = 0; i < mv.length; ++i)
+        {
+            std::set<int> joined = st.GetJobsAtBatchPosition(mv.targets[i].first, mv.targets[i].second);
+            joined.insert(mv.jobs[i]);
+            if (i < mv.length - 1)
+            {
+                joined.erase(mv.jobs[i + 1]);
+            }
+            MachinePosition position = after.GetJobToBatchPosition(mv.jobs[i]);
+            OSP_CHECK_EQUAL(mv.targets[i].first, position.first);
+            OSP_CHECK(after.GetJobsAtBatchPosition(position.first, position.second) == joined);
+            chain.insert(mv.jobs[i]);
+        }
+        for (int j = 0; j < st.Jobs(); ++j)
+        {
+            OSP_CHECK(chain.count(j) == 1 || after.GetJobToBatchPosition(j).first == st.GetJobToBatchPosition(j).first);
+        }
+    });
+}
+
+// a ruin takes out at most the jobs of its size and the repair reinserts them in feasible batches; the other jobs keep their machines
+// and stay with the jobs of their batches that are not taken out
+OSP_TEST(moves_ruin_and_recreate_keeps_the_rest)
+{
+    CheckMoveEffects<OSP_RuinAndRecreateNeighborhoodExplorer>(50, [](const OSP_Output& st, const RuinAndRecreate& mv, const OSP_Output& after)
+    {
+        std::vector<int> removed_jobs = mv.RemovedJobs(st);
+        std::set<int> removed(removed_jobs.begin(), removed_jobs.end());
+        OSP_CHECK_EQUAL(removed_jobs.size(), removed.size());
+        OSP_CHECK(!removed.empty() && (int) removed.size() <= mv.size);
+        for (int j = 0; j < st.Jobs(); ++j)
+        {
+            if (removed.count(j) == 1)
+            {
+                continue;
+            }
+            MachinePosition position = st.GetJobToBatchPosition(j);
+            OSP_CHECK_EQUAL(position.first, after.GetJobToBatchPosition(j).first);
+            for (int k : st.GetJobsAtBatchPosition(position.first, position.second))
+            {
+                OSP_CHECK(removed.count(k) == 1 || after.GetJobToBatchPosition(k) == after.GetJobToBatchPosition(j));
+            }
+        }
+    });
+}
+
+// a resequencing permutes the batches of its window (position first + i gets the batch of first + order[i]) and leaves the other batches
+// where they are
+OSP_TEST(moves_resequence_permutes_its_window)
+{
+    CheckMoveEffects<OSP_ResequenceBatchesNeighborhoodExplorer>(200, [](const OSP_Output& st, const ResequenceBatches& mv, const OSP_Output& after)
+    {
+        std::vector<bool> taken(mv.length, false);
+        bool identity = true;
+        for (int i = 0; i < mv.length; ++i)
+        {
+            OSP_CHECK(mv.order[i] >= 0 && mv.order[i] < mv.length && !taken[mv.order[i]]);
+            taken[mv.order[i]] = true;
+            identity = identity && mv.order[i] == i;
+        }
+        OSP_CHECK(!identity);
+        for (int m = 0; m < st.Machines(); ++m)
+        {
+            OSP_CHECK_EQUAL(st.GetBatchesPerMachine(m), after.GetBatchesPerMachine(m));
+            for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
+            {
+                int source = m == mv.machine && p >= mv.first && p < mv.first + mv.length ? mv.first + mv.order[p - mv.first] : p;
+                OSP_CHECK(after.GetJobsAtBatchPosition(m, p) == st.GetJobsAtBatchPosition(m, source));
+            }
+        }
+    });
+}
+
+// the order of a window found by the dynamic program of the resequencing is the best of all the permutations of the window, and the
+// windows where no permutation improves the cost are not moves
+OSP_TEST(moves_resequence_best_order)
+{
+    const int window = 5;
+    int improved = 0;
+    for (const std::string& name : move_instances)
+    {
+        OSP_Input in(TestInstancePath(name));
+        OSP_TestCosts costs(in);
+        OSP_SolutionManagerRandom sm(in);
+        costs.AttachTo(sm);
+        OSP_ResequenceBatchesNeighborhoodExplorer ne(in, sm);
+        costs.AttachToExplorers(ne);
+        ne.SetWindow(window);
+        ne.SetDontLookBits(false);
+        OSP_Output st(in);
+        sm.RandomState(st);
+        // the deltas of the moves of the exploration, by machine and first batch of their window
+        std::map<std::pair<int,int>, long> move_deltas;
+        ResequenceBatches mv;
+        try
+        {
+            ne.FirstMove(st, mv);
+            do
+            {
+                move_deltas[{mv.machine, mv.first}] = ne.DeltaCostFunctionComponents(st, mv).total;
+            }
+            while (ne.NextMove(st, mv));
+        }
+        catch (EmptyNeighborhood&)
+        {
+        }
+        for (int m = 0; m < st.Machines(); ++m)
+        {
+            int length = std::min(window, st.GetBatchesPerMachine(m));
+            for (int first = 0; length > 1 && first + length <= st.GetBatchesPerMachine(m); ++first)
+            {
+                ResequenceBatches permutation(m, first, length);
+                long best_delta = 0;
+                while (std::next_permutation(permutation.order, permutation.order + length))
+                {
+                    best_delta = std::min(best_delta, ne.DeltaCostFunctionComponents(st, permutation).total);
+                }
+                auto move = move_deltas.find({m, first});
+                if (best_delta < 0)
+                {
+                    OSP_CHECK(move != move_deltas.end());
+                    if (move != move_deltas.end())
+                    {
+                        OSP_CHECK_EQUAL(best_delta, move->second);
+                    }
+                    improved++;
+                }
+                else
+                {
+                    OSP_CHECK(move == move_deltas.end());
+                }
+            }
+        }
+    }
+    OSP_CHECK(improved > 0);
+}
+
+// a regrouping permutes the batches of its segment so that each attribute is in a single group, the batches of a group in their order
+// before the move, and leaves the other batches where they are
+OSP_TEST(moves_regroup_groups_its_segment)
+{
+    CheckMoveEffects<OSP_RegroupBatchesNeighborhoodExplorer>(200, [](const OSP_Output& st, const RegroupBatches& mv, const OSP_Output& after)
+    {
+        std::map<int, std::vector<std::set<int>>> groups, groups_after;
+        std::set<int> closed;
+        for (int i = 0; i < mv.length; ++i)
+        {
+            int a = st.GetBatchCharacteristics(mv.machine, mv.first + i).attribute;
+            int a_after = after.GetBatchCharacteristics(mv.machine, mv.first + i).attribute;
+            groups[a].push_back(st.GetJobsAtBatchPosition(mv.machine, mv.first + i));
+            groups_after[a_after].push_back(after.GetJobsAtBatchPosition(mv.machine, mv.first + i));
+            if (i > 0 && after.GetBatchCharacteristics(mv.machine, mv.first + i - 1).attribute != a_after)
+            {
+                closed.insert(after.GetBatchCharacteristics(mv.machine, mv.first + i - 1).attribute);
+            }
+            OSP_CHECK(closed.count(a_after) == 0);
+        }
+        OSP_CHECK(groups == groups_after);
+        for (int m = 0; m < st.Machines(); ++m)
+        {
+            OSP_CHECK_EQUAL(st.GetBatchesPerMachine(m), after.GetBatchesPerMachine(m));
+            for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
+            {
+                OSP_CHECK((m == mv.machine && p >= mv.first && p < mv.first + mv.length) || after.GetJobsAtBatchPosition(m, p) == st.GetJobsAtBatchPosition(m, p));
+            }
+        }
+    });
+}
+
+// the regroupings are all the segments of at least two batches that are not yet grouped in the order of the sequencer
+OSP_TEST(moves_regroup_enumeration)
+{
+    CheckEnumeration<OSP_RegroupBatchesNeighborhoodExplorer>([](const OSP_Input& in, const OSP_Output& st)
+    {
+        OSP_AttributeSequencer sequencer(in);
+        std::set<RegroupBatches> moves;
+        for (int m = 0; m < st.Machines(); ++m)
+        {
+            for (int first = 0; first < st.GetBatchesPerMachine(m); ++first)
+            {
+                int start_attribute = first > 0 ? st.GetBatchCharacteristics(m, first - 1).attribute : in.InitialStateMachine(m);
+                std::vector<int> attributes;
+                for (int p = first; p < st.GetBatchesPerMachine(m); ++p)
+                {
+                    attributes.push_back(st.GetBatchCharacteristics(m, p).attribute);
+                    if (attributes.size() < 2)
+                    {
+                        continue;
+                    }
+                    std::vector<bool> present(in.Attributes(), false);
+                    for (int a : attributes)
+                    {
+                        present[a] = true;
+                    }
+                    std::vector<int> grouped;
+                    for (int a : sequencer.Sequence(start_attribute, present))
+                    {
+                        grouped.insert(grouped.end(), std::count(attributes.begin(), attributes.end(), a), a);
+                    }
+                    if (grouped != attributes)
+                    {
+                        moves.insert(RegroupBatches(m, first, (int) attributes.size()));
+                    }
+                }
+            }
+        }
+        return moves;
+    });
+}
+
+// the order of the attributes of the regrouping (Held-Karp) has the least setup costs, then the least setup times, of all the orders
+// of the attributes, for every start and set of attributes
+OSP_TEST(moves_regroup_sequence_is_shortest)
+{
+    int sequences = 0;
+    for (const std::string& name : move_instances)
+    {
+        OSP_Input in(TestInstancePath(name));
+        int attributes = in.Attributes();
+        if (attributes > 6)
+        {
+            continue;
+        }
+        OSP_AttributeSequencer sequencer(in);
+        // setup costs and times along a path
+        auto path_setups = [&in](int start, const std::vector<int>& path) {
+            std::pair<long,long> setups(0, 0);
+            for (int a : path)
+            {
+                setups.first += (long) in.SetUpCost(start, a) * in.MultFactorTotalSetUpCosts();
+                setups.second += in.SetUpTime(start, a);
+                start = a;
+            }
+            return setups;
+        };
+        for (int start = 0; start < attributes; ++start)
+        {
+            for (int subset = 1; subset < (1 << attributes); ++subset)
+            {
+                std::vector<bool> present(attributes);
+                std::vector<int> path;
+                for (int a = 0; a < attributes; ++a)
+                {
+                    present[a] = subset & (1 << a);
+                    if (present[a])
+                    {
+                        path.push_back(a);
+                    }
+                }
+                std::pair<long,long> best = path_setups(start, path);
+                while (std::next_permutation(path.begin(), path.end()))
+                {
+                    best = std::min(best, path_setups(start, path));
+                }
+                std::vector<int> sequence = sequencer.Sequence(start, present);
+                std::vector<int> sorted_sequence(sequence);
+                std::sort(sorted_sequence.begin(), sorted_sequence.end());
+                OSP_CHECK(sorted_sequence == path);
+                OSP_CHECK(path_setups(start, sequence) == best);
+                sequences++;
+            }
+        }
+    }
+    OSP_CHECK(sequences > 0);
+}
+
+// the jobs of a move of more jobs to a new batch are a mask over the jobs of its batch
+OSP_TEST(moves_batch_to_new_machine_mask)
+{
+    OSP_Input in(TestInstancePath(move_instances.back()));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer ne(in, sm);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    BatchToNewMachine mv;
+    for (int i = 0; i < 200; ++i)
+    {
+        try
+        {
+            ne.RandomMove(st, mv);
+        }
+        catch (EmptyNeighborhood&)
+        {
+            continue;
+        }
+        std::set<int> jobs = mv.JobsToMove(st);
+        OSP_CHECK_EQUAL((size_t) mv.NumberOfJobsToMove(), jobs.size());
+        const std::set<int>& batch = st.GetJobsAtBatchPosition(mv.old_machine_position.first, mv.old_machine_position.second);
+        for (int j : jobs)
+        {
+            OSP_CHECK(batch.count(j) == 1);
+        }
+    }
+}
+
+// a batch larger than the window of the moves of more jobs to a new batch: all its jobs can be moved
+OSP_TEST(moves_batch_to_new_machine_large_batch)
+{
+    OSP_Input in(TestInstancePath("use-case-1/112RandomOvenSchedulingInstance-n500-k5-a2--2312-10.35.09.dzn"));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    Decoupled_OSP_BatchToNewMachineNeighborhoodExplorer ne(in, sm);
+    costs.AttachToExplorers(ne);
+    // the largest batch of jobs of the same attribute (the smallest first) on a machine, the other jobs alone in their batches
+    std::vector<int> largest_batch;
+    int largest_machine = 0;
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        for (int a = 0; a < in.Attributes(); ++a)
+        {
+            std::vector<int> jobs;
+            for (int j = 0; j < in.Jobs(); ++j)
+            {
+                if (in.AttributeJob(j) == a && in.IsMachineEligible(m, j))
+                {
+                    jobs.push_back(j);
+                }
+            }
+            std::sort(jobs.begin(), jobs.end(), [&in](int j1, int j2) { return in.SizeJob(j1) < in.SizeJob(j2); });
+            std::vector<int> batch;
+            int size = 0;
+            for (int j : jobs)
+            {
+                if (size + in.SizeJob(j) <= in.MaxCapacityMachine(m))
+                {
+                    batch.push_back(j);
+                    size += in.SizeJob(j);
+                }
+            }
+            if (batch.size() > largest_batch.size())
+            {
+                largest_batch = batch;
+                largest_machine = m;
+            }
+        }
+    }
+    OSP_CHECK((int) largest_batch.size() > BatchToNewMachine::MaxJobs);
+    OSP_Output st(in);
+    std::vector<int> batches(in.Machines(), 0);
+    std::vector<bool> in_largest_batch(in.Jobs(), false);
+    for (int j : largest_batch)
+    {
+        st.ModifyJobToBatchPosition(j, largest_machine, 0);
+        in_largest_batch[j] = true;
+    }
+    batches[largest_machine] = 1;
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        if (!in_largest_batch[j])
+        {
+            int m = *in.EligibleMachineSet(j).begin();
+            st.ModifyJobToBatchPosition(j, m, batches[m]++);
+        }
+    }
+    st.PopulateAllFromScratch();
+    st.CalculateAllCostsFromScratch();
+
+    // the other batches have a single job, so the moves are all drawn from the largest one
+    BatchToNewMachine mv;
+    OSP_Output after(in);
+    bool beyond_first_jobs = false;
+    for (int i = 0; i < 100; ++i)
+    {
+        ne.RandomMove(st, mv);
+        OSP_CHECK(mv.old_machine_position == MachinePosition(largest_machine, 0));
+        OSP_CHECK(mv.window_start + BatchToNewMachine::MaxJobs <= (int) largest_batch.size());
+        for (int b = 0; b < BatchToNewMachine::MaxJobs; ++b)
+        {
+            beyond_first_jobs = beyond_first_jobs || (mv.IsJobToMove(b) && mv.window_start + b >= BatchToNewMachine::MaxJobs);
+        }
+        CheckMove(in, st, ne, sm, mv, after);
+    }
+    OSP_CHECK(beyond_first_jobs);
+}
+
+// a job is hot when it is tardy or in a batch past the horizon
+static bool IsHotJob(const OSP_Output& st, int j)
+{
+    MachinePosition position = st.GetJobToBatchPosition(j);
+    return st.IsJobTardy(j) || st.GetBatchCharacteristics(position.first, position.second).start_time > st.Horizon();
+}
+
+// with focus probability 1 the random moves take only hot jobs, with 0 they take any job
+OSP_TEST(moves_focused_sampling_hot_jobs)
+{
+    OSP_Input in(TestInstancePath(move_instances.front()));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManagerRandom sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer ne(in, sm);
+    OSP_Output st(in);
+    sm.RandomState(st);
+    int hot_jobs = 0;
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        hot_jobs += IsHotJob(st, j);
+    }
+    OSP_CHECK_EQUAL(hot_jobs, st.NumberOfHotJobs());
+    OSP_CHECK(hot_jobs > 0 && hot_jobs < in.Jobs());
+    for (double focus : {1.0, 0.0})
+    {
+        ne.SetFocusProbability(focus);
+        int drawn = 0, hot = 0;
+        JobToExistingBatch mv;
+        for (int i = 0; i < 500; ++i)
+        {
+            try
+            {
+                ne.RandomMove(st, mv);
+            }
+            catch (EmptyNeighborhood&)
+            {
+                continue;
+            }
+            drawn++;
+            hot += IsHotJob(st, mv.job);
+        }
+        OSP_CHECK(drawn > 0);
+        OSP_CHECK(focus == 0.0 || hot == drawn);
+        OSP_CHECK(focus == 1.0 || hot < drawn);
+    }
+}
+
+// with focus probability 1 the random moves of the batches take only batches past the horizon, with 0 they take any batch
+OSP_TEST(moves_focused_sampling_hot_batches)
+{
+    OSP_Input in(TestInstancePath("use-case-3/20NewRandomOvenSchedulingInstance-n10-k5-a5--2904-12.21.16.dzn"));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_BatchToNewPositionNeighborhoodExplorer ne(in, sm);
+    // each job alone in a batch on its first eligible machine, the latest released first, so that some of the batches that follow
+    // them are past the horizon
+    OSP_Output st(in);
+    std::vector<int> jobs(in.Jobs());
+    std::iota(jobs.begin(), jobs.end(), 0);
+    std::sort(jobs.begin(), jobs.end(), [&in](int j1, int j2) { return in.EarliestStartJob(j1) > in.EarliestStartJob(j2); });
+    std::vector<int> batches(in.Machines(), 0);
+    for (int j : jobs)
+    {
+        int m = *in.EligibleMachineSet(j).begin();
+        st.ModifyJobToBatchPosition(j, m, batches[m]++);
+    }
+    st.PopulateAllFromScratch();
+    st.CalculateAllCostsFromScratch();
+    OSP_CHECK(st.NumberOfMachinesWithUnscheduledBatches() > 0);
+    for (int i = 0; i < st.NumberOfMachinesWithUnscheduledBatches(); ++i)
+    {
+        // so that the hot batch can always be moved
+        OSP_CHECK(st.GetBatchesPerMachine(st.GetMachineWithUnscheduledBatches(i)) > 1);
+    }
+    for (double focus : {1.0, 0.0})
+    {
+        ne.SetFocusProbability(focus);
+        int hot = 0;
+        const int moves = 500;
+        BatchToNewPositionMove mv;
+        for (int i = 0; i < moves; ++i)
+        {
+            ne.RandomMove(st, mv);
+            hot += st.GetBatchCharacteristics(mv.machine, mv.old_position).start_time > st.Horizon();
+        }
+        OSP_CHECK(focus == 0.0 || hot == moves);
+        OSP_CHECK(focus == 1.0 || hot < moves);
+    }
+}
+
+// the machines (jobs) of the moves enumerated by FirstMove/NextMove, none if the neighborhood is empty
+template <class Explorer>
+static std::set<int> EnumeratedMoves(const Explorer& ne, const OSP_Output& st, std::function<int(const typename Explorer::MoveType&)> key)
+{
+    std::set<int> keys;
+    typename Explorer::MoveType mv;
+    try
+    {
+        ne.FirstMove(st, mv);
+        do
+        {
+            keys.insert(key(mv));
+        }
+        while (ne.NextMove(st, mv));
+    }
+    catch (EmptyNeighborhood&)
+    {
+    }
+    return keys;
+}
+
+// once all the moves of a machine have been enumerated the machine is skipped, until a move changes it; without the bits every
+// machine is enumerated again
+OSP_TEST(moves_dont_look_bits_machines)
+{
+    OSP_Input in(TestInstancePath(move_instances.front()));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManagerRandom sm(in);
+    costs.AttachTo(sm);
+    OSP_SwapConsecutiveBatchesMoveNeighborhoodExplorer ne(in, sm);
+    OSP_Output st(in);
+    sm.RandomState(st);
+    std::function<int(const SwapConsecutiveBatchesMove&)> machine = [](const SwapConsecutiveBatchesMove& mv) { return mv.machine; };
+    std::set<int> machines = EnumeratedMoves(ne, st, machine);
+    OSP_CHECK(machines.size() > 1);
+    OSP_CHECK(EnumeratedMoves(ne, st, machine).empty());
+    SwapConsecutiveBatchesMove mv;
+    ne.RandomMove(st, mv);
+    ne.MakeMove(st, mv);
+    OSP_CHECK(EnumeratedMoves(ne, st, machine) == std::set<int>{mv.machine});
+    OSP_CHECK(EnumeratedMoves(ne, st, machine).empty());
+    ne.SetDontLookBits(false);
+    OSP_CHECK(EnumeratedMoves(ne, st, machine) == machines);
+    OSP_CHECK(EnumeratedMoves(ne, st, machine) == machines);
+}
+
+// the same for the jobs: a move looks again only at the jobs of the machines it changes, and the bits of an explorer are its own
+OSP_TEST(moves_dont_look_bits_jobs)
+{
+    OSP_Input in(TestInstancePath(move_instances.front()));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManagerRandom sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer ne(in, sm), other(in, sm);
+    OSP_Output st(in);
+    sm.RandomState(st);
+    std::function<int(const JobToExistingBatch&)> job = [](const JobToExistingBatch& mv) { return mv.job; };
+    std::set<int> jobs = EnumeratedMoves(ne, st, job);
+    OSP_CHECK(!jobs.empty());
+    OSP_CHECK(EnumeratedMoves(ne, st, job).empty());
+    OSP_CHECK(EnumeratedMoves(other, st, job) == jobs);
+    JobToExistingBatch mv;
+    ne.RandomMove(st, mv);
+    ne.MakeMove(st, mv);
+    std::set<int> looked_again = EnumeratedMoves(ne, st, job);
+    OSP_CHECK(!looked_again.empty());
+    for (int j : looked_again)
+    {
+        int m = st.GetJobToBatchPosition(j).first;
+        OSP_CHECK(m == mv.old_machine || m == mv.new_machine);
+    }
+    OSP_CHECK(EnumeratedMoves(ne, st, job).empty());
+}
@@ -0,0 +1,452 @@
+#include "OSP_test.hh"
+#include "OSP_batch.hh"
+#include "OSP_serve.hh"
+#include "OSP_stream.hh"
+
+#include <utils/json.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+// a run that only parses its options, as the runs of main, and ends as its outcome asks: with its result, with an error of its
+// options, with an exception or with a warning
+static int ProtocolRun(int argc, const char* argv[], std::ostream& os, std::ostream& messages, const OSP_SharedOutput*)
+{
+    ParameterBox main_parameters("main", "Main Program options");
+    Parameter<std::string> instance("instance", "Input instance", main_parameters);
+    Parameter<std::string> outcome("outcome", "Outcome of the run", main_parameters);
+    if (!CommandLineParameters::Parse(argc, argv, true, false, messages))
+    {
+        return 1;
+    }
+    if (outcome == "fail")
+    {
+        messages << "Error: --main::outcome fails" << std::endl;
+        return 1;
+    }
+    if (outcome == "throw")
+    {
+        throw std::invalid_argument("The run throws");
+    }
+    if (outcome == "warn")
+    {
+        messages << "Warning: the run warns" << std::endl;
+    }
+    os << "{\"total_cost\": 0}" << std::endl;
+    return 0;
+}
+
+// the standard streams written while it is alive
+class CapturedStandardStreams
+{
+public:
+    CapturedStandardStreams() : cout_buffer(std::cout.rdbuf(out.rdbuf())), cerr_buffer(std::cerr.rdbuf(err.rdbuf())) {}
+    ~CapturedStandardStreams()
+    {
+        std::cout.rdbuf(cout_buffer);
+        std::cerr.rdbuf(cerr_buffer);
+    }
+    std::ostringstream out, err;
+private:
+    std::streambuf* cout_buffer;
+    std::streambuf* cerr_buffer;
+};
+
+// the JSON lines of a stream, each one indexed by the value of its field key
+static std::map<int, nlohmann::json> JsonLines(const std::string& text, const std::string& key)
+{
+    std::map<int, nlohmann::json> lines;
+    std::istringstream is(text);
+    std::string line;
+    while (std::getline(is, line))
+    {
+        OSP_CHECK(nlohmann::json::accept(line));
+        nlohmann::json value = nlohmann::json::parse(line);
+        lines[value[key].get<int>()] = value;
+    }
+    return lines;
+}
+
+// the diagnostics of the runs of a batch are in the error of their results (or on the standard error for a run that succeeds), the
+// standard output is left to the results
+OSP_TEST(protocol_batch_diagnostics)
+{
+    const std::string manifest_file = "osp_test_manifest.txt";
+    {
+        std::ofstream os(manifest_file);
+        os << "--main::outcome succeed\n--main::outcome fail\n--main::outcome throw\n--main::bogus 3\n--main::outcome warn\n";
+    }
+    std::ostringstream results;
+    unsigned int failed;
+    std::string out, err;
+    {
+        OSP_Batch batch(manifest_file, "osp");
+        CapturedStandardStreams captured;
+        failed = batch.Run(ProtocolRun, 2, results);
+        out = captured.out.str();
+        err = captured.err.str();
+    }
+    std::remove(manifest_file.c_str());
+
+    OSP_CHECK_EQUAL(3u, failed);
+    OSP_CHECK_EQUAL(std::string(), out);
+    std::map<int, nlohmann::json> lines = JsonLines(results.str(), "line");
+    OSP_CHECK_EQUAL((size_t) 5, lines.size());
+    for (int line : {1, 5})
+    {
+        OSP_CHECK_EQUAL(0, lines[line]["exit_code"].get<int>());
+        OSP_CHECK_EQUAL(0, lines[line]["result"]["total_cost"].get<int>());
+        OSP_CHECK(lines[line].count("error") == 0);
+    }
+    for (int line : {2, 3, 4})
+    {
+        OSP_CHECK_EQUAL(1, lines[line]["exit_code"].get<int>());
+        OSP_CHECK(lines[line]["result"].is_null());
+    }
+    OSP_CHECK_EQUAL(std::string("Error: --main::outcome fails"), lines[2]["error"].get<std::string>());
+    OSP_CHECK_EQUAL(std::string("The run throws"), lines[3]["error"].get<std::string>());
+    OSP_CHECK(lines[4]["error"].get<std::string>().find("Unrecognized options: --main::bogus 3") == 0);
+    OSP_CHECK(err.find("Warning: the run warns") != std::string::npos);
+}
+
+// the options of a manifest are split as by a shell: the quoted text (with its blanks) and the escaped characters are parts of a token,
+// the comments are skipped, and a quote left open is an error of the manifest
+OSP_TEST(protocol_batch_manifest_quoting)
+{
+    const std::string manifest_file = "osp_test_manifest_quoting.txt";
+    {
+        std::ofstream os(manifest_file);
+        os << "--main::instance \"my instances/a.dzn\" --main::note 'it''s \"here\"'\n"
+            << "  # --main::instance commented.dzn\n"
+            << "--main::instance a\\ b.dzn --main::note \"\" \t\n";
+    }
+    OSP_RunFunction echo = [](int argc, const char* argv[], std::ostream& os, std::ostream&, const OSP_SharedOutput*)
+    {
+        nlohmann::json arguments = nlohmann::json::array();
+        for (int i = 1; i < argc; ++i)
+        {
+            arguments.push_back(argv[i]);
+        }
+        os << arguments.dump() << std::endl;
+        return 0;
+    };
+    std::ostringstream results;
+    OSP_Batch batch(manifest_file, "osp");
+    OSP_CHECK_EQUAL(2u, batch.Runs());
+    OSP_CHECK_EQUAL(0u, batch.Run(echo, 1, results));
+    std::map<int, nlohmann::json> lines = JsonLines(results.str(), "line");
+    OSP_CHECK(lines[1]["result"] == nlohmann::json({"--main::instance", "my instances/a.dzn", "--main::note", "its \"here\""}));
+    OSP_CHECK(lines[3]["result"] == nlohmann::json({"--main::instance", "a b.dzn", "--main::note", ""}));
+
+    {
+        std::ofstream os(manifest_file);
+        os << "--main::instance a.dzn\n--main::instance \"b.dzn\n";
+    }
+    OSP_CHECK_THROWS(OSP_Batch(manifest_file, "osp"));
+    std::remove(manifest_file.c_str());
+}
+
+// the diagnostics of the requests of a server are in the error of their responses, the standard output is left to the responses
+OSP_TEST(protocol_serve_diagnostics)
+{
+    const std::string instance = TestInstancePath("use-case-2/03NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.42.41-mergedMachineIntervals.dzn");
+    std::ostringstream responses;
+    unsigned int failed;
+    std::string out;
+    {
+        std::istringstream requests(
+            "{\"id\": 1, \"instance\": \"" + instance + "\"}\n"
+            "{\"id\": 2, \"instance\": \"" + instance + "\", \"options\": [\"--main::outcome\", \"fail\"]}\n"
+            "{\"id\": 3, \"instance\": \"" + instance + "\", \"options\": [\"--main::outcome\", \"throw\"]}\n"
+            "{\"id\": 4, \"instance\": \"" + instance + "\", \"options\": [\"--main::bogus\", \"3\"]}\n"
+            "{\"id\": 5, \"instance\": \"" + instance + "\", \"options\": [\"--main::outcome\", \"warn\"]}\n");
+        OSP_Server server("osp", {"--main::outcome", "succeed"});
+        CapturedStandardStreams captured;
+        failed = server.Serve(ProtocolRun, 2, requests, responses);
+        out = captured.out.str();
+    }
+
+    OSP_CHECK_EQUAL(3u, failed);
+    OSP_CHECK_EQUAL(std::string(), out);
+    std::map<int, nlohmann::json> lines = JsonLines(responses.str(), "id");
+    OSP_CHECK_EQUAL((size_t) 5, lines.size());
+    for (int id : {1, 5})
+    {
+        OSP_CHECK_EQUAL(std::string("result"), lines[id]["event"].get<std::string>());
+        OSP_CHECK_EQUAL(0, lines[id]["exit_code"].get<int>());
+        OSP_CHECK_EQUAL(0, lines[id]["result"]["total_cost"].get<int>());
+        OSP_CHECK(lines[id].count("error") == 0);
+    }
+    for (int id : {2, 3, 4})
+    {
+        OSP_CHECK_EQUAL(1, lines[id]["exit_code"].get<int>());
+        OSP_CHECK(lines[id]["result"].is_null());
+    }
+    OSP_CHECK_EQUAL(std::string("Error: --main::outcome fails"), lines[2]["error"].get<std::string>());
+    OSP_CHECK_EQUAL(std::string("The run throws"), lines[3]["error"].get<std::string>());
+    OSP_CHECK(lines[4]["error"].get<std::string>().find("Unrecognized options: --main::bogus 3") == 0);
+}
+
+// the explorers of a run of a worker number their don't-look bits from the first set, whatever the runs before it on the worker
+OSP_TEST(protocol_worker_dont_look_bits_sets)
+{
+    OSP_RunFunction run = [](int, const char*[], std::ostream& os, std::ostream&, const OSP_SharedOutput*)
+    {
+        os << OSP_Output::NewDontLookBitsSet() << OSP_Output::NewDontLookBitsSet();
+        return 0;
+    };
+    for (int i = 0; i < 2; ++i)
+    {
+        std::string output, error;
+        OSP_CHECK_EQUAL(0, OSP_RunOnWorker(run, "osp", {}, nullptr, output, error));
+        OSP_CHECK_EQUAL(std::string("01"), output);
+    }
+}
+
+// a solution stream writes the solutions in the order of their notifications, only the ones better than all the previous ones (fewer
+// violations, or as many and a lower total), with their costs and their batches and machines numbered from 1
+OSP_TEST(protocol_solution_stream)
+{
+    const std::string stream_file = "osp_test_stream.jsonl";
+    std::remove(stream_file.c_str());
+    OSP_Input in(TestInstancePath("use-case-2/03NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.42.41-mergedMachineIntervals.dzn"));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Output greedy_st(in), random_st(in);
+    sm.GreedyState(greedy_st);
+    sm.RandomState(random_st);
+    std::vector<long> components(sm.CostComponents(), 0);
+    // the costs notified (total, violations, objective), and whether each one is written
+    std::vector<std::pair<DefaultCostStructure<long>, bool>> notified = {
+        {DefaultCostStructure<long>(30, 2, 10, components), true},
+        {DefaultCostStructure<long>(20, 2, 0, components), true},
+        {DefaultCostStructure<long>(20, 2, 0, components), false},
+        {DefaultCostStructure<long>(10, 3, 0, components), false},
+        {DefaultCostStructure<long>(50, 0, 50, components), true},
+        {DefaultCostStructure<long>(60, 0, 60, components), false},
+        {DefaultCostStructure<long>(40, 0, 40, components), true}
+    };
+    {
+        OSP_SolutionStream stream(stream_file, sm);
+        for (size_t i = 0; i < notified.size(); ++i)
+        {
+            stream.NotifyNewBest("runner" + std::to_string(i), i % 2 == 0 ? greedy_st : random_st, notified[i].first, i);
+        }
+        // the pending solutions are written when the stream is closed
+    }
+    std::ifstream is(stream_file);
+    std::vector<nlohmann::json> lines;
+    std::string line;
+    while (std::getline(is, line))
+    {
+        OSP_CHECK(nlohmann::json::accept(line));
+        lines.push_back(nlohmann::json::parse(line));
+    }
+    is.close();
+    std::remove(stream_file.c_str());
+
+    size_t k = 0;
+    for (size_t i = 0; i < notified.size(); ++i)
+    {
+        if (!notified[i].second)
+        {
+            continue;
+        }
+        OSP_CHECK(k < lines.size());
+        if (k >= lines.size())
+        {
+            return;
+        }
+        const nlohmann::json& value = lines[k++];
+        const OSP_Output& st = i % 2 == 0 ? greedy_st : random_st;
+        OSP_CHECK_EQUAL("runner" + std::to_string(i), value["runner"].get<std::string>());
+        OSP_CHECK_EQUAL((unsigned long) i, value["iteration"].get<unsigned long>());
+        OSP_CHECK_EQUAL(notified[i].first.total, value["total_cost"].get<long>());
+        OSP_CHECK_EQUAL(notified[i].first.violations, value["violations"].get<long>());
+        OSP_CHECK_EQUAL(notified[i].first.objective, value["objective"].get<long>());
+        OSP_CHECK_EQUAL(sm.CostComponents(), value["cost_components"].size());
+        OSP_CHECK_EQUAL((size_t) in.Jobs(), value["batch_for_job"].size());
+        OSP_CHECK_EQUAL((size_t) in.Jobs(), value["machine_for_job"].size());
+        for (int j = 0; j < in.Jobs() && j < (int) value["batch_for_job"].size() && j < (int) value["machine_for_job"].size(); ++j)
+        {
+            OSP_CHECK_EQUAL(st.GetJobToBatchPosition(j).second + 1, value["batch_for_job"][j].get<int>());
+            OSP_CHECK_EQUAL(st.GetJobToBatchPosition(j).first + 1, value["machine_for_job"][j].get<int>());
+        }
+    }
+    OSP_CHECK_EQUAL((size_t) 4, lines.size());
+}
+
+// on a shared output, each line of a solution stream starts with the fields of the output
+OSP_TEST(protocol_solution_stream_shared_output)
+{
+    OSP_Input in(TestInstancePath("use-case-2/03NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.42.41-mergedMachineIntervals.dzn"));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    std::ostringstream os;
+    std::mutex mutex;
+    {
+        OSP_SolutionStream stream(OSP_SharedOutput{os, mutex, "\"id\": 7, \"event\": \"solution\", "}, sm);
+        stream.NotifyNewBest("runner", st, sm.CostFunctionComponents(st), 1);
+    }
+    std::map<int, nlohmann::json> lines = JsonLines(os.str(), "id");
+    OSP_CHECK_EQUAL((size_t) 1, lines.size());
+    OSP_CHECK_EQUAL(std::string("solution"), lines[7]["event"].get<std::string>());
+    OSP_CHECK_EQUAL(std::string("runner"), lines[7]["runner"].get<std::string>());
+}
+
+// a runner graph of the tests: a simulated annealing on the insertion of jobs in existing batches, and its solver
+class TestRunnerGraph : public OSP_RunnerGraph
+{
+public:
+    TestRunnerGraph(const std::string& instance)
+        : in(TestInstancePath(instance)), costs(in), sm(in), existing(in, sm), runner(in, sm, existing, "SA_graph"), solver(in, sm, "solver_graph")
+    {
+        costs.AttachTo(sm);
+        costs.AttachToExplorers(existing);
+        solver.SetRunner(runner);
+    }
+    // the value of a parameter of the runner, 0 if it is not set
+    unsigned long MaxEvaluations()
+    {
+        unsigned long max_evaluations = 0;
+        try
+        {
+            runner.GetParameterValue("max_evaluations", max_evaluations);
+        }
+        catch (const std::logic_error&)
+        {
+            max_evaluations = 0;
+        }
+        return max_evaluations;
+    }
+    OSP_Input in;
+    OSP_TestCosts costs;
+    OSP_SolutionManager sm;
+    OSP_JobToExistingBatchNeighborhoodExplorer existing;
+    SimulatedAnnealing<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>> runner;
+    SimpleLocalSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> solver;
+};
+
+static const std::string graph_instances[] = {
+    "use-case-2/01NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.37.39.dzn",
+    "use-case-2/02NewRandomOvenSchedulingInstance-n10-k2-a2--2904-10.40.26.dzn"
+};
+
+// a worker builds the graph of a key once, and takes it back for the later runs with the key; a build that throws leaves nothing
+OSP_TEST(protocol_worker_graphs_reuse)
+{
+    OSP_CHECK(OSP_WorkerGraphs::Current() == nullptr);
+    size_t registered = ParameterBox::OverallParameters().size();
+    {
+        OSP_WorkerGraphs graphs;
+        OSP_CHECK(OSP_WorkerGraphs::Current() == &graphs);
+        int builds = 0;
+        auto build = [&builds](const std::string& instance)
+        {
+            return std::function<std::unique_ptr<TestRunnerGraph>()>([&builds, instance]()
+            {
+                builds++;
+                return std::make_unique<TestRunnerGraph>(instance);
+            });
+        };
+        TestRunnerGraph& first = graphs.Use(graph_instances[0], build(graph_instances[0]));
+        OSP_CHECK(&first == &graphs.Use(graph_instances[0], build(graph_instances[0])));
+        TestRunnerGraph& second = graphs.Use(graph_instances[1], build(graph_instances[1]));
+        OSP_CHECK(&first != &second);
+        OSP_CHECK(&first == &graphs.Use(graph_instances[0], build(graph_instances[0])));
+        OSP_CHECK_EQUAL(2, builds);
+        OSP_CHECK_EQUAL(2u, graphs.Built());
+
+        std::function<std::unique_ptr<TestRunnerGraph>()> failing = []() -> std::unique_ptr<TestRunnerGraph>
+        {
+            TestRunnerGraph graph(graph_instances[0]);
+            throw std::invalid_argument("The build fails");
+        };
+        OSP_CHECK_THROWS(graphs.Use("failing", failing));
+        OSP_CHECK_EQUAL(2u, graphs.Built());
+        OSP_CHECK(&second == &graphs.Use(graph_instances[1], build(graph_instances[1])));
+        // only the boxes of the graph in use are registered
+        OSP_CHECK_EQUAL(registered + 2, ParameterBox::OverallParameters().size());
+    }
+    OSP_CHECK(OSP_WorkerGraphs::Current() == nullptr);
+    OSP_CHECK_EQUAL(registered, ParameterBox::OverallParameters().size());
+}
+
+// the parameters of a graph taken back are the ones after its build, and the options of a run set only the graph in use (the graphs
+// have runners with the same names)
+OSP_TEST(protocol_worker_graphs_parameters)
+{
+    OSP_WorkerGraphs graphs;
+    auto build = [](const std::string& instance)
+    {
+        return std::function<std::unique_ptr<TestRunnerGraph>()>([instance]() { return std::make_unique<TestRunnerGraph>(instance); });
+    };
+    std::ostringstream messages;
+    TestRunnerGraph& first = graphs.Use(graph_instances[0], build(graph_instances[0]));
+    const char* first_argv[] = {"osp", "--SA_graph::max_evaluations", "100", "--solver_graph::init_trials", "3", "--solver_graph::random_state-disable"};
+    OSP_CHECK(CommandLineParameters::Parse(6, first_argv, true, false, messages));
+    OSP_CHECK_EQUAL(100ul, first.MaxEvaluations());
+
+    TestRunnerGraph& second = graphs.Use(graph_instances[1], build(graph_instances[1]));
+    const char* second_argv[] = {"osp", "--SA_graph::max_evaluations", "200"};
+    OSP_CHECK(CommandLineParameters::Parse(3, second_argv, true, false, messages));
+    OSP_CHECK_EQUAL(200ul, second.MaxEvaluations());
+    OSP_CHECK_EQUAL(100ul, first.MaxEvaluations());
+    OSP_CHECK_EQUAL(std::string(), messages.str());
+
+    OSP_CHECK(&first == &graphs.Use(graph_instances[0], build(graph_instances[0])));
+    OSP_CHECK_EQUAL(0ul, first.MaxEvaluations());
+    unsigned int init_trials = 0;
+    bool random_state = false;
+    first.solver.GetParameterValue("init_trials", init_trials);
+    first.solver.GetParameterValue("random_state", random_state);
+    OSP_CHECK_EQUAL(1u, init_trials);
+    OSP_CHECK(random_state);
+}
+
+// the runs of a batch on a worker share the graph of their instance, each one with the parameters of its own options
+OSP_TEST(protocol_batch_graph_reuse)
+{
+    const std::string manifest_file = "osp_test_manifest_graphs.txt";
+    {
+        std::ofstream os(manifest_file);
+        os << "--main::instance " << graph_instances[0] << " --SA_graph::max_evaluations 100\n"
+            << "--main::instance " << graph_instances[0] << "\n"
+            << "--main::instance " << graph_instances[1] << " --SA_graph::max_evaluations 200\n"
+            << "--main::instance " << graph_instances[0] << " --SA_graph::max_evaluations 300\n";
+    }
+    OSP_RunFunction run = [](int argc, const char* argv[], std::ostream& os, std::ostream& messages, const OSP_SharedOutput*)
+    {
+        ParameterBox main_parameters("main", "Main Program options");
+        Parameter<std::string> instance("instance", "Input instance", main_parameters);
+        CommandLineParameters::Parse(argc, argv, false, true, messages);
+        OSP_WorkerGraphs* graphs = OSP_WorkerGraphs::Current();
+        TestRunnerGraph& graph = graphs->Use(instance, std::function<std::unique_ptr<TestRunnerGraph>()>([&instance]()
+        {
+            return std::make_unique<TestRunnerGraph>(instance);
+        }));
+        if (!CommandLineParameters::Parse(argc, argv, true, false, messages))
+        {
+            return 1;
+        }
+        os << "{\"built\": " << graphs->Built() << ", \"max_evaluations\": " << graph.MaxEvaluations() << "}" << std::endl;
+        return 0;
+    };
+    std::ostringstream results;
+    OSP_Batch batch(manifest_file, "osp");
+    OSP_CHECK_EQUAL(0u, batch.Run(run, 1, results));
+    std::remove(manifest_file.c_str());
+    std::map<int, nlohmann::json> lines = JsonLines(results.str(), "line");
+    OSP_CHECK_EQUAL((size_t) 4, lines.size());
+    std::map<int, std::pair<unsigned int, unsigned long>> expected = {{1, {1, 100}}, {2, {1, 0}}, {3, {2, 200}}, {4, {2, 300}}};
+    for (const auto& e : expected)
+    {
+        OSP_CHECK_EQUAL(e.second.first, lines[e.first]["result"]["built"].get<unsigned int>());
+        OSP_CHECK_EQUAL(e.second.second, lines[e.first]["result"]["max_evaluations"].get<unsigned long>());
+    }
+}
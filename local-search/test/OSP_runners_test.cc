@@ -0,0 +1,540 @@
+#include "OSP_test.hh"
+#include "OSP_telemetry.hh"
+#include "OSP_rolling.hh"
+
+#include <array>
+#include <chrono>
+
+static const std::string runner_instance = "use-case-3/61NewRandomOvenSchedulingInstance-n100-k2-a2--2904-16.41.19.dzn";
+
+// the adaptive runner never switches on a neighborhood with bias 0, and min_bias is spread over the enabled neighborhoods only
+OSP_TEST(runners_adaptive_keeps_disabled_neighborhoods)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    OSP_JobToNewBatchNeighborhoodExplorer new_batch(in, sm);
+    OSP_CountingExplorer<OSP_SwapBatchesNeighborhoodExplorer> swap(in, sm);
+    costs.AttachToExplorers(existing, new_batch, swap);
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(new_batch), decltype(swap)>
+        multi(in, sm, "multi", existing, new_batch, swap, {0.5, 0.5, 0.0});
+    SimulatedAnnealingWithLearning<OSP_Input, OSP_Output, decltype(multi)::MoveType, DefaultCostStructure<long>> runner(in, sm, multi, "SA_adaptive");
+    runner.SetParameter("max_evaluations", 20000UL);
+    runner.SetParameter("start_temperature", 10.0);
+    runner.SetParameter("min_temperature", 0.1);
+    runner.SetParameter("cooling_rate", 0.9);
+    runner.SetParameter("neighbors_accepted_ratio", 0.1);
+    // 0.4 is below 1/2 (two neighborhoods are enabled), but not below 1/3
+    runner.SetParameter("min_bias", 0.4);
+    runner.SetParameter("learning_rate", 0.5);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    runner.Go(st);
+    OSP_CHECK_EQUAL(0, swap.drawn);
+    OSP_CHECK_EQUAL(0.0, multi.GetBias(2));
+    OSP_CHECK(multi.GetBias(0) >= 0.4 - 1e-9 && multi.GetBias(1) >= 0.4 - 1e-9);
+    OSP_CHECK(std::abs(multi.GetBias(0) + multi.GetBias(1) - 1.0) < 1e-9);
+}
+
+// a disabled telemetry records nothing, an enabled one counts the moves drawn, evaluated and made
+OSP_TEST(runners_telemetry_only_when_enabled)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Telemetry off(false), on(true);
+    OSP_MonitoredNeighborhoodExplorer<OSP_JobToExistingBatchNeighborhoodExplorer> off_ne(in, sm, off, "job_to_existing_batch"), on_ne(in, sm, on, "job_to_existing_batch");
+    costs.AttachToExplorers(off_ne, on_ne);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    JobToExistingBatch mv;
+    unsigned long improving = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        off_ne.RandomMove(st, mv);
+        off_ne.DeltaCostFunctionComponents(st, mv);
+        if (on_ne.DeltaCostFunctionComponents(st, mv).total < 0)
+        {
+            improving++;
+        }
+        on_ne.MakeMove(st, mv);
+    }
+    // a move made without its evaluation just before is evaluated again
+    JobToExistingBatch other_mv;
+    off_ne.RandomMove(st, mv);
+    off_ne.RandomMove(st, other_mv);
+    bool improves = on_ne.DeltaCostFunctionComponents(st, mv).total < 0;
+    on_ne.DeltaCostFunctionComponents(st, other_mv);
+    on_ne.MakeMove(st, mv);
+    OSP_CHECK_EQUAL(0UL, off[0].drawn + off[0].evaluated + off[0].accepted);
+    OSP_CHECK_EQUAL(0LL, off[0].random_move_ns + off[0].evaluation_ns + off[0].make_move_ns);
+    OSP_CHECK_EQUAL(12UL, on[0].evaluated.load());
+    OSP_CHECK_EQUAL(11UL, on[0].accepted.load());
+    OSP_CHECK_EQUAL(improving + (improves ? 1 : 0), on[0].improving.load());
+}
+
+// the new best states notified by a runner are charged to the neighborhoods of the moves that reached them
+OSP_TEST(runners_telemetry_new_best_from_the_runner)
+{
+    class NewBestCounter : public RunnerObserver<OSP_Input, OSP_Output, DefaultCostStructure<long>>
+    {
+    public:
+        void NotifyNewBest(const std::string&, const OSP_Output&, const DefaultCostStructure<long>&, unsigned long iteration) override
+        {
+            if (iteration > 0)
+            {
+                new_best++;
+            }
+        }
+        unsigned long new_best = 0;
+    };
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Telemetry telemetry;
+    OSP_MonitoredNeighborhoodExplorer<OSP_JobToExistingBatchNeighborhoodExplorer> existing(in, sm, telemetry, "job_to_existing_batch");
+    OSP_MonitoredNeighborhoodExplorer<OSP_JobToNewBatchNeighborhoodExplorer> new_batch(in, sm, telemetry, "single_job_to_new_batch");
+    costs.AttachToExplorers(existing, new_batch);
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(new_batch)>
+        multi(in, sm, "multi", existing, new_batch, {0.5, 0.5});
+    SimulatedAnnealing<OSP_Input, OSP_Output, decltype(multi)::MoveType, DefaultCostStructure<long>> runner(in, sm, multi, "SA");
+    runner.SetParameter("max_evaluations", 20000UL);
+    runner.SetParameter("start_temperature", 10.0);
+    runner.SetParameter("min_temperature", 0.1);
+    runner.SetParameter("cooling_rate", 0.9);
+    runner.SetParameter("neighbors_accepted_ratio", 0.1);
+    NewBestCounter counter;
+    runner.AttachObserver(telemetry);
+    runner.AttachObserver(counter);
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    runner.Go(st);
+    OSP_CHECK(counter.new_best > 0);
+    OSP_CHECK_EQUAL(counter.new_best, telemetry[0].new_best + telemetry[1].new_best);
+    for (size_t i = 0; i < 2; ++i)
+    {
+        OSP_CHECK(telemetry[i].improving >= telemetry[i].new_best);
+        OSP_CHECK(telemetry[i].accepted >= telemetry[i].improving);
+    }
+}
+
+// the parallel tempering computes the temperatures not given, and its workers are started again by each run
+OSP_TEST(runners_parallel_tempering_reruns)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    OSP_JobToNewBatchNeighborhoodExplorer new_batch(in, sm);
+    costs.AttachToExplorers(existing, new_batch);
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(new_batch)>
+        multi(in, sm, "multi", existing, new_batch, {0.5, 0.5});
+    ParallelTempering<OSP_Input, OSP_Output, decltype(multi)::MoveType, DefaultCostStructure<long>> runner(in, sm, multi, "PT");
+    runner.SetParameter("max_evaluations", 12000UL);
+    runner.SetParameter("replicas", 3U);
+    runner.SetParameter("steps_per_exchange", 500U);
+    OSP_Output greedy(in);
+    sm.GreedyState(greedy);
+    std::array<DefaultCostStructure<long>, 2> run_costs;
+    for (DefaultCostStructure<long>& cost : run_costs)
+    {
+        Random::SetSeed(1);
+        OSP_Output st(greedy);
+        cost = runner.Go(st);
+        CheckAgainstScratch(in, st);
+        OSP_CHECK_EQUAL(sm.CostFunctionComponents(st).total, cost.total);
+        OSP_CHECK(cost.total <= sm.CostFunctionComponents(greedy).total);
+    }
+    OSP_CHECK_EQUAL(run_costs[0].total, run_costs[1].total);
+    OSP_CHECK(runner.Temperature(0) > 0.0 && runner.Temperature(0) < runner.Temperature(2));
+}
+
+// the ladder of the parallel tempering is geometric between the temperatures given (the coldest one is a thousandth of the hottest
+// one by default), and replicas at the same temperature always exchange their states
+OSP_TEST(runners_parallel_tempering_ladder_and_exchanges)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    costs.AttachToExplorers(existing);
+    OSP_Output greedy(in);
+    sm.GreedyState(greedy);
+    typedef ParallelTempering<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>> PT;
+    PT given(in, sm, existing, "PT_given"), computed(in, sm, existing, "PT_computed"), same(in, sm, existing, "PT_same");
+    for (PT* runner : {&given, &computed, &same})
+    {
+        runner->SetParameter("max_evaluations", 4000UL);
+        runner->SetParameter("replicas", 4U);
+        runner->SetParameter("steps_per_exchange", 100U);
+    }
+    given.SetParameter("min_temperature", 1.0);
+    given.SetParameter("max_temperature", 1000.0);
+    same.SetParameter("min_temperature", 5.0);
+    same.SetParameter("max_temperature", 5.0);
+    for (PT* runner : {&given, &computed, &same})
+    {
+        OSP_Output st(greedy);
+        runner->Go(st);
+    }
+    for (size_t i = 0; i < 4; ++i)
+    {
+        OSP_CHECK(std::abs(given.Temperature(i) - std::pow(10.0, (double) i)) < 1e-9 * given.Temperature(i));
+        OSP_CHECK_EQUAL(5.0, same.Temperature(i));
+    }
+    OSP_CHECK(computed.Temperature(0) > 0.0);
+    OSP_CHECK(std::abs(computed.Temperature(0) - computed.Temperature(3) / 1000.0) < 1e-9 * computed.Temperature(0));
+    OSP_CHECK(std::abs(computed.Temperature(1) / computed.Temperature(0) - computed.Temperature(3) / computed.Temperature(2)) < 1e-9);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        OSP_CHECK_EQUAL(1.0, same.ExchangeRatio(i));
+        OSP_CHECK(given.ExchangeRatio(i) >= 0.0 && given.ExchangeRatio(i) <= 1.0);
+    }
+}
+
+// a mailbox keeps only the last solution sent, and each solution is received once
+OSP_TEST(runners_island_mailbox)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_Output greedy(in), random(in);
+    sm.GreedyState(greedy);
+    sm.RandomState(random);
+    Mailbox<OSP_Output, DefaultCostStructure<long>> mailbox;
+    OSP_CHECK(!mailbox.Receive());
+    mailbox.Send(random, sm.CostFunctionComponents(random));
+    mailbox.Send(greedy, sm.CostFunctionComponents(greedy));
+    std::unique_ptr<Mailbox<OSP_Output, DefaultCostStructure<long>>::Message> message = mailbox.Receive();
+    OSP_CHECK(message && message->solution == greedy);
+    OSP_CHECK_EQUAL(sm.CostFunctionComponents(greedy).total, message->cost.total);
+    OSP_CHECK(!mailbox.Receive());
+}
+
+// an island whose search only wanders adopts the better states that migrate from the island before it in the ring
+OSP_TEST(runners_island_migration)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    costs.AttachToExplorers(existing);
+    typedef Island<SimulatedAnnealing<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>>> SA_Island;
+    SA_Island cold(in, sm, existing, "SA_cold"), hot(in, sm, existing, "SA_hot");
+    for (SA_Island* island : {&cold, &hot})
+    {
+        island->SetParameter("max_evaluations", 20000UL);
+        island->SetParameter("cooling_rate", 0.9);
+        island->SetParameter("neighbors_accepted_ratio", 0.1);
+        island->SetParameter("migration_period", 100U);
+    }
+    cold.SetParameter("start_temperature", 10.0);
+    cold.SetParameter("min_temperature", 0.1);
+    // every move is accepted
+    hot.SetParameter("start_temperature", 1e12);
+    hot.SetParameter("min_temperature", 1e11);
+    IslandSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> solver(in, sm, "islands");
+    solver.AddIsland(cold);
+    solver.AddIsland(hot);
+    OSP_Output greedy(in);
+    sm.GreedyState(greedy);
+    SolverResult<OSP_Input, OSP_Output, DefaultCostStructure<long>> result = solver.Resolve(greedy);
+    OSP_CHECK(hot.MigrationsAdopted() > 0);
+    CheckAgainstScratch(in, result.output);
+    OSP_CHECK_EQUAL(sm.CostFunctionComponents(result.output).total, result.cost.total);
+    OSP_CHECK(result.cost.total <= sm.CostFunctionComponents(greedy).total);
+}
+
+// simulated annealing with a direct access to its Metropolis criterion
+class MetropolisProbe : public SimulatedAnnealing<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>>
+{
+public:
+    using SimulatedAnnealing<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>>::SimulatedAnnealing;
+    // as a run does, a table of table_size deltas (0: no table)
+    void SetTable(unsigned int table_size)
+    {
+        acceptance_thresholds.assign(table_size, 0);
+        acceptance_stamps.assign(table_size, 0);
+        acceptance_stamp = 0;
+        acceptance_temperature = 0.0;
+    }
+    bool Accepts(long delta, double t)
+    {
+        temperature = t;
+        current_move.cost = DefaultCostStructure<long>(delta, 0, delta, std::vector<long>{delta});
+        return MetropolisCriterion();
+    }
+    uint64_t Threshold(long delta) const { return acceptance_thresholds[delta]; }
+};
+
+// the thresholds of the acceptance table are exp(-delta/T) 2^32, computed again when the temperature changes, and the worsening
+// moves are accepted with probability exp(-delta/T), with or without the table
+OSP_TEST(runners_metropolis_acceptance_table)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    costs.AttachToExplorers(existing);
+    MetropolisProbe runner(in, sm, existing, "SA_probe");
+    const int draws = 20000;
+    for (unsigned int table_size : {64u, 0u})
+    {
+        runner.SetTable(table_size);
+        for (double temperature : {5.0, 50.0})
+        {
+            for (long delta : {1L, 5L, 20L, 100L})
+            {
+                double p = std::exp(-delta / temperature);
+                int accepted = 0;
+                for (int i = 0; i < draws; ++i)
+                {
+                    accepted += runner.Accepts(delta, temperature);
+                }
+                if (delta < (long) table_size)
+                {
+                    OSP_CHECK_EQUAL((uint64_t) (p * 4294967296.0), runner.Threshold(delta));
+                }
+                // within 5 standard deviations
+                OSP_CHECK(std::abs((double) accepted / draws - p) <= 5.0 * std::sqrt(p * (1.0 - p) / draws) + 1e-4);
+            }
+        }
+    }
+}
+
+// the time-based annealing stops when its allowed running time is over, whatever its evaluations
+OSP_TEST(runners_sa_timebased_running_time)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    costs.AttachToExplorers(existing);
+    SimulatedAnnealingTimeBased<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>> runner(in, sm, existing, "SA_timebased");
+    runner.SetParameter("allowed_running_time", 0.3);
+    runner.SetParameter("start_temperature", 10.0);
+    runner.SetParameter("min_temperature", 0.1);
+    runner.SetParameter("cooling_rate", 0.9);
+    runner.SetParameter("neighbors_accepted_ratio", 0.1);
+    OSP_Output greedy(in);
+    sm.GreedyState(greedy);
+    OSP_Output st(greedy);
+    auto start = std::chrono::steady_clock::now();
+    DefaultCostStructure<long> cost = runner.Go(st);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    OSP_CHECK(seconds >= 0.3 && seconds < 3.0);
+    OSP_CHECK(runner.Iteration() > 1000);
+    CheckAgainstScratch(in, st);
+    OSP_CHECK_EQUAL(sm.CostFunctionComponents(st).total, cost.total);
+    OSP_CHECK(cost.total <= sm.CostFunctionComponents(greedy).total);
+}
+
+// simulated annealing with reheating, with a direct access to its reheats
+class ReheatingProbe : public SimulatedAnnealingWithReheating<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>>
+{
+public:
+    using SimulatedAnnealingWithReheating<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>>::SimulatedAnnealingWithReheating;
+    unsigned int Reheats() const { return reheats; }
+};
+
+// the annealing with reheating restarts its schedule at each reheat, up to max_reheats, and a run leaves the schedule as it was
+// given, so that the next run is the same
+OSP_TEST(runners_sa_reheating_reheats)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    costs.AttachToExplorers(existing);
+    ReheatingProbe runner(in, sm, existing, "SA_reheating");
+    runner.SetParameter("max_evaluations", 30000UL);
+    runner.SetParameter("start_temperature", 10.0);
+    runner.SetParameter("min_temperature", 0.1);
+    runner.SetParameter("cooling_rate", 0.9);
+    runner.SetParameter("neighbors_accepted_ratio", 0.1);
+    runner.SetParameter("max_reheats", 2U);
+    runner.SetParameter("reheat_ratio", 0.5);
+    runner.SetParameter("first_descent_evaluations_share", 0.5);
+    OSP_Output greedy(in);
+    sm.GreedyState(greedy);
+    std::array<DefaultCostStructure<long>, 2> run_costs;
+    for (DefaultCostStructure<long>& cost : run_costs)
+    {
+        Random::SetSeed(1);
+        OSP_Output st(greedy);
+        cost = runner.Go(st);
+        OSP_CHECK(runner.Reheats() >= 2);
+        CheckAgainstScratch(in, st);
+        OSP_CHECK_EQUAL(sm.CostFunctionComponents(st).total, cost.total);
+        OSP_CHECK(cost.total <= sm.CostFunctionComponents(greedy).total);
+    }
+    OSP_CHECK_EQUAL(run_costs[0].total, run_costs[1].total);
+}
+
+// whether one of the moves of the neighborhood improves the state (the moves skipped by the don't-look bits, if on, are not looked at)
+template <class Explorer>
+static bool HasImprovingMove(const Explorer& ne, const OSP_Output& st)
+{
+    typename Explorer::MoveType mv;
+    try
+    {
+        ne.FirstMove(st, mv);
+        do
+        {
+            if (ne.DeltaCostFunctionComponents(st, mv).total < 0)
+            {
+                return true;
+            }
+        }
+        while (ne.NextMove(st, mv));
+    }
+    catch (EmptyNeighborhood&)
+    {
+    }
+    return false;
+}
+
+// the polish (a steepest descent on the union of the neighborhoods that can be enumerated) ends in a state that none of their
+// moves improves; with the don't-look bits, none of the moves still looked at
+OSP_TEST(runners_polish_local_optimum)
+{
+    OSP_Input in(TestInstancePath(runner_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToNewBatchNeighborhoodExplorer new_batch(in, sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    OSP_MergeBatchesNeighborhoodExplorer merge(in, sm);
+    OSP_SplitBatchNeighborhoodExplorer split(in, sm);
+    costs.AttachToExplorers(new_batch, existing, merge, split);
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(new_batch), decltype(existing), decltype(merge), decltype(split)>
+        multi(in, sm, "multi_polish", new_batch, existing, merge, split, {1.0, 1.0, 1.0, 1.0});
+    SteepestDescent<OSP_Input, OSP_Output, decltype(multi)::MoveType, DefaultCostStructure<long>> runner(in, sm, multi, "SD_polish");
+    runner.SetParameter("max_evaluations", std::numeric_limits<unsigned long>::max());
+    OSP_Output random(in);
+    sm.RandomState(random);
+    for (bool dont_look_bits : {true, false})
+    {
+        new_batch.SetDontLookBits(dont_look_bits);
+        existing.SetDontLookBits(dont_look_bits);
+        merge.SetDontLookBits(dont_look_bits);
+        split.SetDontLookBits(dont_look_bits);
+        OSP_Output st(random);
+        DefaultCostStructure<long> cost = runner.Go(st);
+        CheckAgainstScratch(in, st);
+        OSP_CHECK_EQUAL(sm.CostFunctionComponents(st).total, cost.total);
+        OSP_CHECK(cost.total < sm.CostFunctionComponents(random).total);
+        OSP_CHECK(!HasImprovingMove(new_batch, st));
+        OSP_CHECK(!HasImprovingMove(existing, st));
+        OSP_CHECK(!HasImprovingMove(merge, st));
+        OSP_CHECK(!HasImprovingMove(split, st));
+    }
+}
+
+// a solution manager that records the instances of the initial solutions it builds (the windows of the rolling horizon): their jobs and
+// the latest release of their jobs
+class WindowRecorder : public OSP_SolutionManager
+{
+public:
+    using OSP_SolutionManager::OSP_SolutionManager;
+    void GreedyState(OSP_Output& st) override
+    {
+        int release = 0;
+        for (int j = 0; j < in.Jobs(); ++j)
+        {
+            release = std::max(release, in.EarliestStartJob(j));
+        }
+        window_jobs.push_back(in.Jobs());
+        window_releases.push_back(release);
+        OSP_SolutionManager::GreedyState(st);
+    }
+    std::vector<int> window_jobs, window_releases;
+};
+
+// the windows of the rolling horizon follow the release times: each one but the last has only jobs released before the last release,
+// together they solve every job, and the stitched solution places every job in a feasible batch of the whole instance, which is given
+// back to the solver. A window longer than the release times solves the whole instance at once
+OSP_TEST(runners_rolling_horizon_windows)
+{
+    const OSP_Input whole(TestInstancePath(runner_instance));
+    int last_release = 0;
+    for (int j = 0; j < whole.Jobs(); ++j)
+    {
+        last_release = std::max(last_release, whole.EarliestStartJob(j));
+    }
+    for (int window : {last_release / 4 + 1, last_release + 1})
+    {
+        OSP_Input search_in(whole);
+        OSP_TestCosts costs(search_in);
+        WindowRecorder sm(search_in);
+        costs.AttachTo(sm);
+        OSP_JobToExistingBatchNeighborhoodExplorer existing(search_in, sm);
+        costs.AttachToExplorers(existing);
+        SimulatedAnnealing<OSP_Input, OSP_Output, JobToExistingBatch, DefaultCostStructure<long>> runner(search_in, sm, existing, "SA_rolling_" + std::to_string(window));
+        runner.SetParameter("max_evaluations", 2000UL);
+        runner.SetParameter("start_temperature", 10.0);
+        runner.SetParameter("min_temperature", 0.1);
+        runner.SetParameter("cooling_rate", 0.9);
+        runner.SetParameter("neighbors_accepted_ratio", 0.1);
+        SimpleLocalSearch<OSP_Input, OSP_Output, DefaultCostStructure<long>> solver(search_in, sm, "solver_rolling_" + std::to_string(window));
+        solver.SetParameter("random_state", false);
+        solver.SetRunner(runner);
+        OSP_DeltaCache delta_cache(0);
+        OSP_CHECK_THROWS(OSP_RollingHorizon overlapping(search_in, solver, sm, delta_cache, window, window));
+        OSP_RollingHorizon rolling_horizon(search_in, solver, sm, delta_cache, window, window / 4);
+        SolverResult<OSP_Input, OSP_Output, DefaultCostStructure<long>> result = rolling_horizon.Solve();
+
+        OSP_CHECK_EQUAL(whole.Jobs(), search_in.Jobs());
+        OSP_CHECK_EQUAL((size_t) rolling_horizon.Windows(), sm.window_jobs.size());
+        if (window > last_release)
+        {
+            OSP_CHECK_EQUAL(1, rolling_horizon.Windows());
+            OSP_CHECK_EQUAL(whole.Jobs(), sm.window_jobs.front());
+        }
+        else
+        {
+            OSP_CHECK(rolling_horizon.Windows() > 1);
+        }
+        int solved = 0;
+        for (size_t w = 0; w < sm.window_jobs.size(); ++w)
+        {
+            OSP_CHECK(w + 1 == sm.window_jobs.size() || sm.window_releases[w] < last_release);
+            OSP_CHECK(w == 0 || sm.window_releases[w - 1] <= sm.window_releases[w]);
+            solved += sm.window_jobs[w];
+        }
+        OSP_CHECK(solved >= whole.Jobs());
+
+        const OSP_Output& out = result.output;
+        CheckAgainstScratch(search_in, out);
+        OSP_CHECK_EQUAL(sm.CostFunctionComponents(out).total, result.cost.total);
+        int placed = 0;
+        for (int m = 0; m < whole.Machines(); ++m)
+        {
+            for (int p = 0; p < out.GetBatchesPerMachine(m); ++p)
+            {
+                const std::set<int>& jobs = out.GetJobsAtBatchPosition(m, p);
+                int size = 0;
+                for (int j : jobs)
+                {
+                    OSP_CHECK(whole.IsMachineEligible(m, j));
+                    OSP_CHECK_EQUAL(whole.AttributeJob(*jobs.begin()), whole.AttributeJob(j));
+                    size += whole.SizeJob(j);
+                }
+                OSP_CHECK(size <= whole.MaxCapacityMachine(m));
+                placed += (int) jobs.size();
+            }
+        }
+        OSP_CHECK_EQUAL(whole.Jobs(), placed);
+    }
+}
@@ -0,0 +1,127 @@
+#include "OSP_test.hh"
+
+#include <map>
+
+static std::map<std::string, std::function<void()>>& Tests()
+{
+    static std::map<std::string, std::function<void()>> tests;
+    return tests;
+}
+
+int OSP_TestRegistry::Add(const std::string& name, std::function<void()> test)
+{
+    Tests()[name] = test;
+    return (int) Tests().size();
+}
+
+int OSP_TestRegistry::Run(const std::string& prefix, std::ostream& os)
+{
+    int run = 0, failed = 0;
+    for (const std::pair<const std::string, std::function<void()>>& t : Tests())
+    {
+        if (t.first.compare(0, prefix.size(), prefix) != 0)
+        {
+            continue;
+        }
+        run++;
+        // each test draws its moves from the same seed, whatever the tests run before it
+        Random::SetSeed(1);
+        try
+        {
+            t.second();
+            os << "[ok] " << t.first << std::endl;
+        }
+        catch (const std::exception& e)
+        {
+            failed++;
+            os << "[failed] " << t.first << ": " << e.what() << std::endl;
+        }
+    }
+    return run == 0 ? -1 : failed;
+}
+
+std::string TestInstancePath(const std::string& name)
+{
+    return std::string(OSP_INSTANCES_DIR) + "/" + name;
+}
+
+OSP_TestCosts::OSP_TestCosts(const OSP_Input& in)
+    : cc1(in, in.MultFactorTotalSetUpCosts(), false), cc2(in, in.MultFactorFinishedTooLate(), false), cc3(in, in.MultFactorTotalRunTime(), false),
+    cc4(in, 2 * in.UpperBoundIntegerObjective(), true)
+{}
+
+void OSP_TestCosts::AttachTo(SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm)
+{
+    sm.AddCostComponent(cc1);
+    sm.AddCostComponent(cc2);
+    sm.AddCostComponent(cc3);
+    sm.AddCostComponent(cc4);
+}
+
+void CheckAgainstScratch(const OSP_Input& in, const OSP_Output& st)
+{
+    // the jobs of the batches and the positions of the jobs agree
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
+        {
+            for (int j : st.GetJobsAtBatchPosition(m, p))
+            {
+                OSP_CHECK(st.GetJobToBatchPosition(j) == MachinePosition(m, p));
+            }
+        }
+    }
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        MachinePosition position = st.GetJobToBatchPosition(j);
+        OSP_CHECK(position.second < st.GetBatchesPerMachine(position.first));
+        OSP_CHECK(st.GetJobsAtBatchPosition(position.first, position.second).count(j) == 1);
+    }
+    OSP_Output scratch(in);
+    for (int j = 0; j < in.Jobs(); ++j)
+    {
+        scratch.ModifyJobToBatchPosition(j, st.GetJobToBatchPosition(j).first, st.GetJobToBatchPosition(j).second);
+    }
+    scratch.PopulateAllFromScratch();
+    scratch.CalculateAllCostsFromScratch();
+    for (int m = 0; m < in.Machines(); ++m)
+    {
+        OSP_CHECK_EQUAL(scratch.GetBatchesPerMachine(m), st.GetBatchesPerMachine(m));
+        for (int p = 0; p < st.GetBatchesPerMachine(m); ++p)
+        {
+            OSP_CHECK(scratch.GetJobsAtBatchPosition(m, p) == st.GetJobsAtBatchPosition(m, p));
+            Batch b1 = scratch.GetBatchCharacteristics(m, p), b2 = st.GetBatchCharacteristics(m, p);
+            OSP_CHECK_EQUAL(b1.size, b2.size);
+            OSP_CHECK_EQUAL(b1.attribute, b2.attribute);
+            OSP_CHECK_EQUAL(b1.batch_processing_time, b2.batch_processing_time);
+            OSP_CHECK_EQUAL(b1.start_time, b2.start_time);
+            OSP_CHECK_EQUAL(b1.end_time, b2.end_time);
+            OSP_CHECK_EQUAL(b1.setup_cost, b2.setup_cost);
+            OSP_CHECK_EQUAL(b1.setup_time, b2.setup_time);
+        }
+        OSP_CHECK_EQUAL(scratch.GetMachineFingerprint(m), st.GetMachineFingerprint(m));
+        OSP_CHECK_EQUAL(scratch.GetFirstUnscheduledPosition(m), st.GetFirstUnscheduledPosition(m));
+    }
+    for (int a = 0; a < in.Attributes(); ++a)
+    {
+        OSP_CHECK(scratch.GetBatchesPerAttribute(a) == st.GetBatchesPerAttribute(a));
+    }
+    OSP_CHECK_EQUAL(scratch.GetTotalSetUpTime(), st.GetTotalSetUpTime());
+    OSP_CHECK_EQUAL(scratch.GetTotalSetUpCost(), st.GetTotalSetUpCost());
+    OSP_CHECK_EQUAL(scratch.GetNumberOfTardyJobs(), st.GetNumberOfTardyJobs());
+    OSP_CHECK_EQUAL(scratch.GetCumulativeBatchProcessingTime(), st.GetCumulativeBatchProcessingTime());
+    OSP_CHECK_EQUAL(scratch.GetNotScheduledBatches(), st.GetNotScheduledBatches());
+    OSP_CHECK_EQUAL(scratch.NumberOfHotJobs(), st.NumberOfHotJobs());
+}
+
+// osp_test [prefix]: runs the tests whose name starts with the prefix (all of them by default)
+int main(int argc, const char* argv[])
+{
+    int failed = OSP_TestRegistry::Run(argc > 1 ? argv[1] : "", std::cout);
+    if (failed < 0)
+    {
+        std::cout << "No test starts with " << argv[1] << std::endl;
+        return 1;
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "OSP_helpers.hh"
+
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// a minimal test harness: each test registers itself by name, a failed check throws and fails its test (the other tests go on)
+class OSP_TestFailure : public std::runtime_error
+{
+public:
+    OSP_TestFailure(const std::string& message) : std::runtime_error(message) {}
+};
+
+class OSP_TestRegistry
+{
+public:
+    static int Add(const std::string& name, std::function<void()> test);
+    // runs the tests whose name starts with prefix, returns the number of failed tests (-1 if no test has the prefix)
+    static int Run(const std::string& prefix, std::ostream& os);
+};
+
+#define OSP_TEST(name) \
+    static void name(); \
+    [[maybe_unused]] static int name##_registration = OSP_TestRegistry::Add(#name, name); \
+    static void name()
+
+#define OSP_CHECK(condition) \
+    do { if (!(condition)) throw OSP_TestFailure(std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": " + #condition); } while (false)
+
+#define OSP_CHECK_EQUAL(expected, actual) \
+    do \
+    { \
+        auto osp_expected = (expected); \
+        auto osp_actual = (actual); \
+        if (!(osp_expected == osp_actual)) \
+        { \
+            std::ostringstream osp_message; \
+            osp_message << __FILE__ << ":" << __LINE__ << ": " << #actual << " is " << osp_actual << ", expected " << osp_expected; \
+            throw OSP_TestFailure(osp_message.str()); \
+        } \
+    } while (false)
+
+#define OSP_CHECK_THROWS(statement) \
+    do \
+    { \
+        bool osp_thrown = false; \
+        try { statement; } catch (const std::exception&) { osp_thrown = true; } \
+        if (!osp_thrown) throw OSP_TestFailure(std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": " + #statement + " does not throw"); \
+    } while (false)
+
+// the path of an instance of the repository, relative to the instances directory
+std::string TestInstancePath(const std::string& name);
+
+// a cost component that counts the computations of its full cost
+template <class Component>
+class OSP_CountingCost : public Component
+{
+public:
+    using Component::Component;
+    long ComputeCost(const OSP_Output& st) const override
+    {
+        computed++;
+        return Component::ComputeCost(st);
+    }
+    mutable int computed = 0;
+};
+
+// the cost components of main, with its weights
+class OSP_TestCosts
+{
+public:
+    OSP_TestCosts(const OSP_Input& in);
+    void AttachTo(SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm);
+    template <class... Explorers>
+    void AttachToExplorers(Explorers&... nhes)
+    {
+        for (CostComponent<OSP_Input,OSP_Output,long>* cc : std::initializer_list<CostComponent<OSP_Input,OSP_Output,long>*>{&cc1, &cc2, &cc3, &cc4})
+        {
+            (nhes.AddCostComponent(*cc), ...);
+        }
+    }
+    // the full costs computed so far
+    int Computed() const { return cc1.computed + cc2.computed + cc3.computed + cc4.computed; }
+    OSP_CountingCost<OSP_TotalSetUpCost> cc1;
+    OSP_CountingCost<OSP_NumberOfTardyJobs> cc2;
+    OSP_CountingCost<OSP_CumulativeBatchProcessingTime> cc3;
+    OSP_CountingCost<OSP_NotScheduledBatches> cc4;
+};
+
+// an explorer that counts the random moves drawn from it (the union of explorers takes the member functions of the class itself, so
+// they are all redefined)
+template <class Explorer>
+class OSP_CountingExplorer : public Explorer
+{
+public:
+    using Explorer::Explorer;
+    void RandomMove(const OSP_Output& st, typename Explorer::MoveType& mv) const override
+    {
+        drawn++;
+        Explorer::RandomMove(st, mv);
+    }
+    void FirstMove(const OSP_Output& st, typename Explorer::MoveType& mv) const override { Explorer::FirstMove(st, mv); }
+    bool NextMove(const OSP_Output& st, typename Explorer::MoveType& mv) const override { return Explorer::NextMove(st, mv); }
+    void MakeMove(OSP_Output& st, const typename Explorer::MoveType& mv) const override { Explorer::MakeMove(st, mv); }
+    mutable int drawn = 0;
+};
+
+// the state st (kept by the modifiers of the moves) is the one rebuilt from scratch from its job positions: batches, characteristics,
+// attributes, fingerprints and costs
+void CheckAgainstScratch(const OSP_Input& in, const OSP_Output& st);
+
+// a move is feasible, its delta cost is the difference of the costs of the states before and after it (both checked from scratch).
+// The state after the move is returned in after
+template <class Explorer>
+DefaultCostStructure<long> CheckMove(const OSP_Input& in, const OSP_Output& st, const Explorer& ne, const SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm,
+    const typename Explorer::MoveType& mv, OSP_Output& after)
+{
+    OSP_CHECK(ne.FeasibleMove(st, mv));
+    DefaultCostStructure<long> delta = ne.DeltaCostFunctionComponents(st, mv);
+    after = st;
+    ne.MakeMove(after, mv);
+    CheckAgainstScratch(in, after);
+    DefaultCostStructure<long> cost_before = sm.CostFunctionComponents(st), cost_after = sm.CostFunctionComponents(after);
+    OSP_CHECK_EQUAL(cost_after.total - cost_before.total, delta.total);
+    OSP_CHECK_EQUAL(cost_after.violations - cost_before.violations, delta.violations);
+    OSP_CHECK_EQUAL(cost_after.objective - cost_before.objective, delta.objective);
+    for (size_t i = 0; i < cost_before.all_components.size(); ++i)
+    {
+        OSP_CHECK_EQUAL(cost_after.all_components[i] - cost_before.all_components[i], delta.all_components[i]);
+    }
+    return delta;
+}
+
+// checks the random moves of the explorer along a walk from st (a move is made when it does not worsen the cost, or one time out of
+// four), then the first moves of its exhaustive exploration (if enumerated_moves is not 0); returns the number of moves checked
+template <class Explorer>
+int CheckMoves(const OSP_Input& in, OSP_Output st, const Explorer& ne, const SolutionManager<OSP_Input,OSP_Output,DefaultCostStructure<long>>& sm,
+    int random_moves, int enumerated_moves)
+{
+    typename Explorer::MoveType mv;
+    OSP_Output after(in);
+    int checked = 0;
+    CheckAgainstScratch(in, st);
+    for (int i = 0; i < random_moves; ++i)
+    {
+        try
+        {
+            ne.RandomMove(st, mv);
+        }
+        catch (EmptyNeighborhood&)
+        {
+            continue;
+        }
+        DefaultCostStructure<long> delta = CheckMove(in, st, ne, sm, mv, after);
+        checked++;
+        if (delta.total <= 0 || Random::Uniform<int>(0, 3) == 0)
+        {
+            st = after;
+        }
+    }
+    if (enumerated_moves == 0)
+    {
+        return checked;
+    }
+    try
+    {
+        ne.FirstMove(st, mv);
+        int enumerated = 0;
+        do
+        {
+            // some enumerations also go through the moves that leave a batch where it is, which are not feasible
+            if (ne.FeasibleMove(st, mv))
+            {
+                CheckMove(in, st, ne, sm, mv, after);
+                checked++;
+            }
+        }
+        while (++enumerated < enumerated_moves && ne.NextMove(st, mv));
+    }
+    catch (EmptyNeighborhood&)
+    {}
+    return checked;
+}
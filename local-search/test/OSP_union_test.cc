@@ -0,0 +1,156 @@
+#include "OSP_test.hh"
+
+#include <cmath>
+
+static const std::string union_instance = "use-case-3/61NewRandomOvenSchedulingInstance-n100-k2-a2--2904-16.41.19.dzn";
+
+// an explorer whose neighborhood is always empty
+class OSP_EmptyNeighborhoodExplorer : public OSP_SwapBatchesNeighborhoodExplorer
+{
+public:
+    using OSP_SwapBatchesNeighborhoodExplorer::OSP_SwapBatchesNeighborhoodExplorer;
+    void RandomMove(const OSP_Output& st, SwapBatches& mv) const override { throw EmptyNeighborhood(); }
+    void FirstMove(const OSP_Output& st, SwapBatches& mv) const override { throw EmptyNeighborhood(); }
+    bool NextMove(const OSP_Output& st, SwapBatches& mv) const override { return false; }
+    void MakeMove(OSP_Output& st, const SwapBatches& mv) const override { OSP_SwapBatchesNeighborhoodExplorer::MakeMove(st, mv); }
+};
+
+// a neighborhood with bias 0 in a union is never drawn: neither along the random moves of the union, nor when the neighborhoods with a
+// positive bias are empty and the union falls back on the other ones (setup sets the parameters of the explorer, if any)
+template <class Explorer>
+static void CheckNeverDrawnWhenDisabled(std::function<void(Explorer&)> setup = nullptr)
+{
+    OSP_Input in(TestInstancePath(union_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    OSP_EmptyNeighborhoodExplorer empty(in, sm);
+    OSP_CountingExplorer<Explorer> disabled(in, sm);
+    costs.AttachToExplorers(existing, empty, disabled);
+    if (setup)
+    {
+        setup(disabled);
+    }
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(disabled)>
+        multi(in, sm, "multi", existing, disabled, {1.0, 0.0});
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(empty), decltype(disabled)>
+        multi_empty(in, sm, "multi_empty", empty, disabled, {1.0, 0.0});
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    typename decltype(multi)::MoveType mv;
+    for (int i = 0; i < 200; ++i)
+    {
+        multi.RandomMove(st, mv);
+        multi.MakeMove(st, mv);
+    }
+    typename decltype(multi_empty)::MoveType empty_mv;
+    for (int i = 0; i < 20; ++i)
+    {
+        OSP_CHECK_THROWS(multi_empty.RandomMove(st, empty_mv));
+    }
+    OSP_CHECK_EQUAL(0, disabled.drawn);
+}
+
+// the property is the one of the union, whatever the neighborhood disabled
+OSP_TEST(union_disabled_never_drawn)
+{
+    CheckNeverDrawnWhenDisabled<OSP_SwapJobsBetweenBatchesNeighborhoodExplorer>();
+}
+
+// in a union, the ruin and recreate moves are drawn at their rate, and they leave the states consistent with the other moves
+OSP_TEST(union_ruin_and_recreate_rate)
+{
+    OSP_Input in(TestInstancePath(union_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    OSP_CountingExplorer<OSP_RuinAndRecreateNeighborhoodExplorer> ruin(in, sm);
+    costs.AttachToExplorers(existing, ruin);
+    ruin.SetRuinSize(2, 6);
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(ruin)>
+        multi(in, sm, "multi", existing, ruin, {0.75, 0.25});
+    OSP_Output st(in);
+    sm.GreedyState(st);
+    decltype(multi)::MoveType mv;
+    const int draws = 2000;
+    for (int i = 0; i < draws; ++i)
+    {
+        multi.RandomMove(st, mv);
+        multi.MakeMove(st, mv);
+    }
+    CheckAgainstScratch(in, st);
+    // within 5 standard deviations
+    OSP_CHECK(std::abs(ruin.drawn - 0.25 * draws) <= 5.0 * std::sqrt(draws * 0.25 * 0.75));
+}
+
+// the moves of the exploration of an explorer (without don't-look bits), with their deltas
+template <class Explorer>
+static std::vector<std::pair<typename Explorer::MoveType, long>> EnumeratedDeltas(const Explorer& ne, const OSP_Output& st)
+{
+    std::vector<std::pair<typename Explorer::MoveType, long>> moves;
+    typename Explorer::MoveType mv;
+    try
+    {
+        ne.FirstMove(st, mv);
+        do
+        {
+            moves.push_back(std::make_pair(mv, ne.DeltaCostFunctionComponents(st, mv).total));
+        }
+        while (ne.NextMove(st, mv));
+    }
+    catch (EmptyNeighborhood&)
+    {
+    }
+    return moves;
+}
+
+// the exploration of a union goes through the moves of its first neighborhood, then through the ones of the second, with the same
+// deltas as the neighborhoods alone
+template <class Explorer>
+static void CheckUnionEnumeration()
+{
+    OSP_Input in(TestInstancePath(union_instance));
+    OSP_TestCosts costs(in);
+    OSP_SolutionManager sm(in);
+    costs.AttachTo(sm);
+    OSP_JobToExistingBatchNeighborhoodExplorer existing(in, sm);
+    Explorer ne(in, sm);
+    costs.AttachToExplorers(existing, ne);
+    existing.SetDontLookBits(false);
+    ne.SetDontLookBits(false);
+    SetUnionNeighborhoodExplorer<OSP_Input, OSP_Output, DefaultCostStructure<long>, decltype(existing), decltype(ne)>
+        multi(in, sm, "multi", existing, ne, {1.0, 1.0});
+    OSP_Output st(in);
+    sm.RandomState(st);
+    auto existing_moves = EnumeratedDeltas(existing, st);
+    auto moves = EnumeratedDeltas(ne, st);
+    auto union_moves = EnumeratedDeltas(multi, st);
+    OSP_CHECK(!existing_moves.empty() && !moves.empty());
+    OSP_CHECK_EQUAL(existing_moves.size() + moves.size(), union_moves.size());
+    for (size_t i = 0; i < union_moves.size() && i < existing_moves.size() + moves.size(); ++i)
+    {
+        const auto& mv = union_moves[i].first;
+        if (i < existing_moves.size())
+        {
+            OSP_CHECK(std::get<0>(mv).active && std::get<0>(mv).RawMove() == existing_moves[i].first);
+            OSP_CHECK_EQUAL(existing_moves[i].second, union_moves[i].second);
+        }
+        else
+        {
+            OSP_CHECK(std::get<1>(mv).active && std::get<1>(mv).RawMove() == moves[i - existing_moves.size()].first);
+            OSP_CHECK_EQUAL(moves[i - existing_moves.size()].second, union_moves[i].second);
+        }
+    }
+}
+
+OSP_TEST(union_enumeration_resequence)
+{
+    CheckUnionEnumeration<OSP_ResequenceBatchesNeighborhoodExplorer>();
+}
+
+OSP_TEST(union_enumeration_regroup)
+{
+    CheckUnionEnumeration<OSP_RegroupBatchesNeighborhoodExplorer>();
+}